@@ -0,0 +1,133 @@
+# Sources of the display, shared by RLIDisplay.pro and the benchmarks in bench/
+
+QT       += core gui opengl concurrent network
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+# using GDAL library
+win32:QMAKE_LIBDIR += C:/GDAL/lib
+unix:QMAKE_LIBDIR += /usr/local/lib/
+
+unix:QMAKE_CXXFLAGS += -Wno-write-strings
+unix:QMAKE_CXXFLAGS += -Wno-unused-variable
+unix:QMAKE_CXXFLAGS += -std=gnu++11
+
+win32:INCLUDEPATH += C:/GDAL/include
+unix:INCLUDEPATH += /usr/local/include/
+
+unix:LIBS += -lgdal  -lrt
+win32:LIBS += -lgdal_i -lgeos_i
+
+SOURCES += \
+    $$PWD/mainwindow.cpp \
+    $$PWD/rlicontrolwidget.cpp \
+    $$PWD/rlidisplaywidget.cpp \
+    $$PWD/layers/asmfonts.cpp \
+    $$PWD/layers/radarengine.cpp \
+    $$PWD/layers/infoengine.cpp \
+    $$PWD/datasources/infocontrollers.cpp \
+    $$PWD/layers/maskengine.cpp \
+    $$PWD/layers/controlsengine.cpp \
+    $$PWD/layers/menuengine.cpp \
+    $$PWD/s52/chartmanager.cpp \
+    $$PWD/s52/chartcache.cpp \
+    $$PWD/s52/s52assets.cpp \
+    $$PWD/s52/s52chart.cpp \
+    $$PWD/s52/s52references.cpp \
+    $$PWD/common/earclip.cpp \
+    $$PWD/common/simplify.cpp \
+    $$PWD/layers/chartengine.cpp \
+    $$PWD/layers/chartindex.cpp \
+    $$PWD/layers/chartlayers.cpp \
+    $$PWD/layers/chartshaders.cpp \
+    $$PWD/layers/targetengine.cpp \
+    $$PWD/common/rlimath.cpp \
+    $$PWD/layers/routeengine.cpp \
+    $$PWD/datasources/nmeadata.cpp \
+    $$PWD/datasources/nmeaprocessor.cpp \
+    $$PWD/datasources/radardatasource.cpp \
+    $$PWD/datasources/bearingsync.cpp \
+    $$PWD/datasources/bearingring.cpp \
+    $$PWD/datasources/bearingrecorder.cpp \
+    $$PWD/datasources/clutterfilter.cpp \
+    $$PWD/datasources/gainestimator.cpp \
+    $$PWD/datasources/guardzone.cpp \
+    $$PWD/datasources/landmask.cpp \
+    $$PWD/datasources/asterix240.cpp \
+    $$PWD/datasources/cat240sender.cpp \
+    $$PWD/datasources/cat240receiver.cpp \
+    $$PWD/datasources/regqueue.cpp \
+    $$PWD/datasources/azimuthstab.cpp \
+    $$PWD/datasources/radarscene.cpp \
+    $$PWD/datasources/targetassoc.cpp \
+    $$PWD/datasources/targetfusion.cpp \
+    $$PWD/datasources/rotationrate.cpp \
+    $$PWD/datasources/radarscale.cpp \
+    $$PWD/datasources/targetdatasource.cpp \
+    $$PWD/datasources/shipdatasource.cpp \
+    $$PWD/datasources/boardpultcontroller.cpp \
+    $$PWD/layers/magnifierengine.cpp \
+    $$PWD/rliconfig.cpp
+
+HEADERS  += $$PWD/mainwindow.h \
+    $$PWD/rlicontrolwidget.h \
+    $$PWD/rlidisplaywidget.h \
+    $$PWD/layers/asmfonts.h \
+    $$PWD/layers/radarengine.h \
+    $$PWD/layers/infoengine.h \
+    $$PWD/datasources/infocontrollers.h \
+    $$PWD/layers/maskengine.h \
+    $$PWD/layers/controlsengine.h \
+    $$PWD/layers/menuengine.h \
+    $$PWD/s52/chartmanager.h \
+    $$PWD/s52/chartcache.h \
+    $$PWD/s52/s52assets.h \
+    $$PWD/s52/s52chart.h \
+    $$PWD/s52/polygoncontours.h \
+    $$PWD/s52/s52references.h \
+    $$PWD/common/earclip.h \
+    $$PWD/common/simplify.h \
+    $$PWD/layers/chartengine.h \
+    $$PWD/layers/chartindex.h \
+    $$PWD/layers/chartlayers.h \
+    $$PWD/layers/chartshaders.h \
+    $$PWD/datasources/apctrl.h \
+    $$PWD/common/rlistrings.h \
+    $$PWD/layers/targetengine.h \
+    $$PWD/common/rlimath.h \
+    $$PWD/layers/routeengine.h \
+    $$PWD/datasources/xpmon_be.h \
+    $$PWD/datasources/nmeadata.h \
+    $$PWD/datasources/nmeaprocessor.h \
+    $$PWD/datasources/radarscale.h \
+    $$PWD/datasources/radardatasource.h \
+    $$PWD/datasources/bearingsync.h \
+    $$PWD/datasources/bearingring.h \
+    $$PWD/datasources/bearingrecorder.h \
+    $$PWD/datasources/clutterfilter.h \
+    $$PWD/datasources/gainestimator.h \
+    $$PWD/datasources/guardzone.h \
+    $$PWD/datasources/landmask.h \
+    $$PWD/datasources/asterix240.h \
+    $$PWD/datasources/cat240sender.h \
+    $$PWD/datasources/cat240receiver.h \
+    $$PWD/datasources/regqueue.h \
+    $$PWD/datasources/azimuthstab.h \
+    $$PWD/datasources/radarscene.h \
+    $$PWD/datasources/targetassoc.h \
+    $$PWD/datasources/targetfusion.h \
+    $$PWD/datasources/rotationrate.h \
+    $$PWD/datasources/targetdatasource.h \
+    $$PWD/datasources/shipdatasource.h \
+    $$PWD/datasources/boardpultcontroller.h \
+    $$PWD/layers/magnifierengine.h \
+    $$PWD/rliconfig.h
+
+
+FORMS    += \
+    $$PWD/rlicontrolwidget.ui
+
+RESOURCES += \
+    $$PWD/icons.qrc \
+    $$PWD/shaders.qrc \
+    $$PWD/cursors.qrc
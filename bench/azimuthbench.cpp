@@ -0,0 +1,103 @@
+#include "bench.h"
+#include "../datasources/azimuthstab.h"
+
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Heading of a ship turning at a steady rate with yaw on top, degrees
+static double benchHeading(double t) {
+  return 30.0 + 6.0 * t + 4.0 * sin(2.0 * M_PI * 0.125 * t);
+}
+
+static double angleDiff(double a, double b) {
+  double d = a - b;
+  d -= 360.0 * floor((d + 180.0) / 360.0);
+  return fabs(d);
+}
+
+int runAzimuthStabBench(FILE* f) {
+  const uint32_t brg_count = 8192;
+  const uint32_t brg_size  = 800;
+  const double   rev_s     = 2.5;    // 24 rpm
+  const double   hdt_s     = 0.1;    // 10 Hz heading
+  const double   hdt_lag_s = 0.02;   // Sentence delivery delay
+  const uint32_t batch     = 256;    // Bearings per DMA batch
+  const uint32_t revs      = 8;
+  const double   target    = 120.0;  // True bearing of a fixed target
+
+  AzimuthStabiliser stab(brg_count, brg_size);
+  std::vector<float> amps(brg_size, 0.f);
+
+  double   brg_s  = rev_s / brg_count;
+  double   next_h = 0;
+  double   shift_sum = 0, shift_max = 0, stab_sum = 0, stab_max = 0;
+  uint64_t hits = 0;
+  double   place_ns = 0;
+
+  fprintf(f, "Azimuth stabilisation (%.0f rpm, 6 deg/s turn with 4 deg yaw, %.0f Hz heading, %u bearings per batch)\n"
+          , 60.0 / rev_s, 1.0 / hdt_s, batch);
+
+  // Times are simulated, the stabiliser only sees them as nanoseconds
+  const uint64_t base = 1000000000ull;
+  double last_hdg = benchHeading(0);
+
+  for (uint32_t b0 = 0; b0 < revs * brg_count; b0 += batch) {
+    double t_end = (b0 + batch) * brg_s;
+
+    // Heading sentences delivered before the batch
+    while (next_h + hdt_lag_s <= t_end) {
+      last_hdg = benchHeading(next_h);
+      stab.addHeading(base + (uint64_t)((next_h + hdt_lag_s) * 1e9), fmod(last_hdg, 360.0));
+      next_h += hdt_s;
+    }
+
+    stab.beginBatch(base + (uint64_t)(t_end * 1e9), batch);
+
+    uint64_t t1 = nowNs();
+    for (uint32_t i = 0; i < batch; i++) {
+      uint32_t n   = b0 + i;
+      double   t   = n * brg_s;
+      uint32_t rel = n % brg_count;
+      uint32_t first;
+      uint32_t r = stab.place(rel, &amps[0], true, &first);
+
+      // The target echo: relative bearing matching its true bearing now
+      double rel_deg = rel * 360.0 / brg_count;
+      double true_now = fmod(rel_deg + benchHeading(t), 360.0);
+      if (angleDiff(true_now, target) > 360.0 / brg_count)
+        continue;
+
+      // Whole-picture shift draws it with the heading of the moment, worst
+      // just before the next sweep refreshes it
+      double shifted = rel_deg + benchHeading(t + rev_s);
+      double e_shift = angleDiff(shifted, target);
+      double e_stab  = angleDiff(r * 360.0 / brg_count, target);
+
+      shift_sum += e_shift;
+      stab_sum  += e_stab;
+      if (e_shift > shift_max) shift_max = e_shift;
+      if (e_stab > stab_max) stab_max = e_stab;
+      hits++;
+    }
+    place_ns += nowNs() - t1;
+  }
+
+  if (hits == 0)
+    return -1;
+
+  fprintf(f, "  whole-picture shift: target error before refresh mean %.2f deg, max %.2f deg\n", shift_sum / hits, shift_max);
+  fprintf(f, "  per-bearing:         target error mean %.3f deg, max %.3f deg (bearing %.3f deg)\n"
+          , stab_sum / hits, stab_max, 360.0 / brg_count);
+  fprintf(f, "  place: %.1f ns per bearing\n", place_ns / (revs * brg_count));
+  fprintf(f, "  ");
+  stab.printStats(f);
+
+  return 0;
+}
@@ -0,0 +1,184 @@
+#include "bench.h"
+#include "bearingfeeder.h"
+#include "../datasources/bearingsync.h"
+
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+BearingFeeder::BearingFeeder(uint32_t brg_count, const BearingFeederConfig& cfg, uint32_t seed) {
+  _brg_count = brg_count;
+  _cfg       = cfg;
+  _state     = seed ? seed : 1;
+  _src       = 0;
+  _src_end   = (uint64_t)cfg.revolutions * brg_count;
+  _dropped   = 0;
+}
+
+uint32_t BearingFeeder::rnd() {
+  // xorshift32: the stream must be the same on every run and platform
+  _state ^= _state << 13;
+  _state ^= _state >> 17;
+  _state ^= _state << 5;
+  return _state;
+}
+
+double BearingFeeder::rndUnit() {
+  return rnd() / 4294967296.0;
+}
+
+bool BearingFeeder::next(uint32_t* brg) {
+  while (_queue.size() < _cfg.swap_max + 2 && _src < _src_end) {
+    uint32_t b = _src++ % _brg_count;
+
+    if (rndUnit() < _cfg.drop_prob) {
+      _dropped++;
+      continue;
+    }
+
+    if (_cfg.burst_max > 1 && rndUnit() < _cfg.burst_prob) {
+      uint32_t len = 2 + rnd() % (_cfg.burst_max - 1);
+      _src     += len - 1;
+      _dropped += len;
+      continue;
+    }
+
+    _queue.push_back(b);
+  }
+
+  if (_queue.empty())
+    return false;
+
+  if (_cfg.swap_max > 0 && _queue.size() > 1 && rndUnit() < _cfg.swap_prob) {
+    size_t k = 1 + rnd() % std::min<size_t>(_cfg.swap_max, _queue.size() - 1);
+    std::swap(_queue[0], _queue[k]);
+  }
+
+  *brg = _queue.front();
+  _queue.pop_front();
+  return true;
+}
+
+
+// Synchronization as it was done by RadarDataSource before BearingSync:
+// wait for bearing 0, then require a whole clean revolution, any gap
+// or reordering restarts the process
+class LegacyBearingSync {
+public:
+  LegacyBearingSync(uint32_t brg_count) : _brg_count(brg_count), _synced(false), _wait(false), _last(0)
+                                        , resyncs(0), unsynced(0), since_loss(0), max_recovery(0) { }
+
+  bool push(uint32_t brg) {
+    bool ok = false;
+
+    if (_synced) {
+      if (brg == (_last + 1) % _brg_count) {
+        ok = true;
+      } else {
+        _synced = false;
+        _wait   = false;
+        resyncs++;
+        since_loss = 0;
+      }
+    } else if (!_wait) {
+      _wait = (brg == 0);
+    } else if (brg == 0) {
+      if (_last == _brg_count - 1) {
+        _synced = true;
+        ok = true;
+      } else {
+        _wait = false;
+      }
+    } else if (brg != _last + 1) {
+      _wait = false;
+    }
+
+    _last = brg;
+
+    if (!_synced) {
+      since_loss++;
+      unsynced++;
+    } else if (ok && since_loss) {
+      max_recovery = std::max(max_recovery, since_loss + 1);
+      since_loss = 0;
+    }
+
+    return ok;
+  }
+
+private:
+  uint32_t _brg_count;
+  bool     _synced;
+  bool     _wait;
+  uint32_t _last;
+
+public:
+  uint64_t resyncs;
+  uint64_t unsynced;
+  uint32_t since_loss;
+  uint32_t max_recovery;
+};
+
+
+static double elapsedNs(const struct timespec& t1, const struct timespec& t2) {
+  return (double)(t2.tv_sec - t1.tv_sec) * 1e9 + (double)(t2.tv_nsec - t1.tv_nsec);
+}
+
+int runBearingFeeder(FILE* f, uint32_t seed) {
+  const uint32_t brg_count = 8192;
+
+  static const BearingFeederConfig scenarios[] = {
+    //  name          revs  drop    burst   bmax  swap    smax
+    { "clean",        20,   0,      0,      0,    0,      0 },
+    { "sparse drops", 20,   1e-4,   0,      0,    0,      0 },
+    { "bursts",       20,   0,      2e-4,   96,   0,      0 },
+    { "long bursts",  20,   0,      5e-5,   1024, 0,      0 },
+    { "reordering",   20,   0,      0,      0,    1e-3,   4 },
+    { "mixed",        20,   1e-4,   1e-4,   256,  1e-3,   6 }
+  };
+
+  fprintf(f, "Bearing feeder (seed %u, %u bearings per revolution)\n", seed, brg_count);
+
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    const BearingFeederConfig& cfg = scenarios[i];
+
+    BearingFeeder feeder(brg_count, cfg, seed + i);
+    BearingSync sync(brg_count);
+    LegacyBearingSync legacy(brg_count);
+
+    std::vector<uint32_t> stream;
+    uint32_t brg;
+    while (feeder.next(&brg))
+      stream.push_back(brg);
+
+    uint64_t pushed = stream.size(), held = 0;
+    struct timespec t1, t2;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    for (size_t j = 0; j < stream.size(); j++)
+      if (sync.push(stream[j]) == BearingSync::BSR_HOLD)
+        held++;
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    double sync_ns = elapsedNs(t1, t2);
+
+    for (size_t j = 0; j < stream.size(); j++)
+      legacy.push(stream[j]);
+
+    const BearingSyncStats& st = sync.stats();
+
+    // Bearings of the stable run are published at sync, so only the ones
+    // pushed before the run started stay blank
+    fprintf(f, "\n[%s] %llu bearings pushed, %llu lost at source\n", cfg.name
+            , (unsigned long long)pushed, (unsigned long long)feeder.dropped());
+    fprintf(f, "  legacy: %llu resyncs, %llu bearings blank, max recovery %u bearings\n"
+            , (unsigned long long)legacy.resyncs, (unsigned long long)legacy.unsynced, legacy.max_recovery);
+    fprintf(f, "  fast:   %llu resyncs, %llu bearings held, %llu missing, %llu late, %llu dup, max recovery %u bearings, %.1f ns per bearing\n"
+            , (unsigned long long)st.resyncs, (unsigned long long)held
+            , (unsigned long long)st.missing, (unsigned long long)st.late
+            , (unsigned long long)st.duplicates, st.max_recovery
+            , pushed ? sync_ns / pushed : 0.0);
+    sync.printStats(f);
+  }
+
+  return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef BEARINGFEEDER_H
+#define BEARINGFEEDER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+
+// Disturbances applied to the synthetic bearing stream
+struct BearingFeederConfig {
+  const char* name;
+  uint32_t    revolutions;  // Stream length in antenna revolutions
+  double      drop_prob;    // Probability to lose a single bearing
+  double      burst_prob;   // Probability to lose a burst of bearings
+  uint32_t    burst_max;    // Longest burst
+  double      swap_prob;    // Probability to swap a bearing with one of the next ones
+  uint32_t    swap_max;     // Farthest swap distance
+};
+
+// Deterministic generator of bearing numbers as they come from the
+// radar controller, with drops, bursts and reordering
+class BearingFeeder {
+public:
+  BearingFeeder(uint32_t brg_count, const BearingFeederConfig& cfg, uint32_t seed);
+
+  bool next(uint32_t* brg);
+
+  inline uint64_t dropped() const { return _dropped; }
+
+private:
+  uint32_t rnd();
+  double   rndUnit();
+
+  uint32_t            _brg_count;
+  BearingFeederConfig _cfg;
+  uint32_t            _state;
+  uint64_t            _src;       // Next bearing of the source stream
+  uint64_t            _src_end;
+  uint64_t            _dropped;
+  std::deque<uint32_t> _queue;
+};
+
+#endif // BEARINGFEEDER_H
@@ -0,0 +1,92 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Self-checks and benchmarks of the processing stages, run by RLIBench.
+// Each prints its report to f and returns the exit code of the run
+
+// Runs the feeder scenarios through the bearing synchronizer and through
+// the legacy full revolution synchronization and prints the comparison
+int runBearingFeeder(FILE* f, uint32_t seed);
+
+// Measures filter throughput for a grid of wave/rain levels
+int runClutterBench(FILE* f);
+
+// Measures the cost of the histogram pass per bearing
+int runGainEstimatorBench(FILE* f);
+
+// Measures evaluation cost against the number of zones
+int runGuardZoneBench(FILE* f);
+
+// Measures build time against scale and the cost of applying the mask
+int runLandMaskBench(FILE* f);
+
+// Encoding cost and loopback round trip for each cell format
+int runCat240Bench(FILE* f);
+
+// Sends revolutions through a local Cat240Sender as fast as the receiver
+// takes them and reports throughput, losses and content errors
+int runCat240LoadTest(FILE* f);
+
+// Scale changes and heading updates against a simulated card, submitted
+// synchronously as before and through the queue
+int runRegQueueBench(FILE* f);
+
+// Target at a fixed true bearing seen from a turning ship: placement error
+// of the whole-picture north shift against per-bearing stabilisation, and
+// the cost of place()
+int runAzimuthStabBench(FILE* f);
+
+// Generation and cache cost per scenario and the cost of the processing
+// stages on the synthetic video
+int runRadarSceneBench(FILE* f);
+
+// Association time and quality for 2000 AIS targets and 500 radar tracks
+// against comparing every pair
+int runTargetAssocBench(FILE* f);
+
+// Estimate accuracy against a simulated antenna with batch jitter and the
+// cost per batch and per stamped bearing at full rate
+int runRotationBench(FILE* f);
+
+// Triangulates every area polygon of res/charts with a fresh context per
+// polygon, with one reused context and on worker threads with a context
+// each, every result must match the baseline triangles in bench/golden
+int runTriangulateCheck(FILE* f);
+
+// Triangles/s, rejected and badly covered polygons and chart load time of
+// the Seidel triangulator and the ear clipper on every chart of res/charts
+int runTriangulateBench(FILE* f);
+
+// Cold start of a set of cells, one loader against the thread pool
+int runChartLoadBench(FILE* f);
+
+// Builds the caches of every chart in dir, each is read back and checked
+// against the ingested chart, and must not match once an update file is added
+int runChartCacheBuild(FILE* f, const char* dir);
+
+// Draw calls and vertices per render at a range of scales over every chart
+// of res/charts, with and without the index, a call per layer and range
+// against a batch per engine. Areas and lines are drawn at the level of
+// detail of the scale, against their full vertex counts
+int runChartCullBench(FILE* f);
+
+// Time spent on the levels of detail and their vertices on every chart of res/charts
+int runChartLodBench(FILE* f);
+
+// Chart renders per minute of a simulated transit at a range of scales,
+// with the overscanned FBO against re-rendering on every 0.0005 degrees
+int runChartTransitBench(FILE* f);
+
+// Bytes the engines keep in buffers for every chart of res/charts, with a
+// quad per segment, mark and sounding digit against four vertices each
+int runChartMemoryBench(FILE* f);
+
+// Vertex tiles of every chart of res/charts: coordinate memory, position
+// error of the float and the tiled shader math in views at harbour scale,
+// and draw calls and split time per render at a range of scales
+int runChartTileBench(FILE* f);
+
+#endif // BENCH_H
@@ -0,0 +1,39 @@
+# Self-checks and benchmarks of the processing stages, built against the
+# same sources as the display
+
+TARGET = RLIBench
+TEMPLATE = app
+
+include(../RLIDisplay.pri)
+
+SOURCES += \
+    main.cpp \
+    bearingfeeder.cpp \
+    clutterbench.cpp \
+    gainbench.cpp \
+    guardbench.cpp \
+    landmaskbench.cpp \
+    cat240bench.cpp \
+    cat240loadtest.cpp \
+    regqueuebench.cpp \
+    azimuthbench.cpp \
+    scenebench.cpp \
+    fusionbench.cpp \
+    rotationbench.cpp \
+    benchcharts.cpp \
+    triangulate.cpp \
+    triangulatecheck.cpp \
+    triangulatebench.cpp \
+    chartloadbench.cpp \
+    chartcachebuild.cpp \
+    chartcullbench.cpp \
+    chartlodbench.cpp \
+    charttransitbench.cpp \
+    chartmemorybench.cpp \
+    charttilebench.cpp
+
+HEADERS += \
+    bench.h \
+    bearingfeeder.h \
+    benchcharts.h \
+    triangulate.h
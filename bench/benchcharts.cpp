@@ -0,0 +1,65 @@
+#include "benchcharts.h"
+
+#include <math.h>
+#include <ogrsf_frmts.h>
+
+#include "../s52/polygoncontours.h"
+
+void benchLayOut(std::vector<BenchLayer>& layers) {
+  int next[BENCH_ENGINES] = { 0, 0, 0, 0, 0 };
+  for (size_t l = 0; l < layers.size(); l++) {
+    BenchLayer& layer = layers[l];
+    for (size_t k = 0; k < layer.levels.size(); k++) {
+      layer.firsts.push_back(next[layer.engine]);
+      next[layer.engine] += layer.levels[k].vertexCount();
+    }
+  }
+}
+
+ChartView benchView(S52Chart* chart, int grid, int gx, int gy, float scale) {
+  ChartView view;
+  view.lat = chart->getMinLat() + (chart->getMaxLat() - chart->getMinLat()) * (gy + 0.5f) / grid;
+  view.lon = chart->getMinLon() + (chart->getMaxLon() - chart->getMinLon()) * (gx + 0.5f) / grid;
+  view.scale = scale;
+  view.angle = 0;
+  view.radius_px = 512 * sqrt(2.0);   // Corner of a 1025 px square FBO
+  return view;
+}
+
+QStringList chartFiles(QDir& dir) {
+  dir.setNameFilters(QStringList("*.000"));
+  dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+  RegisterOGRS57();
+  return dir.entryList();
+}
+
+bool readChartPolygons(const QByteArray& path, std::vector<TriangulateInput>& inputs) {
+  OGRDataSource* poDS = OGRSFDriverRegistrar::Open(path.constData(), FALSE, NULL);
+  if (poDS == NULL)
+    return false;
+
+  for (int iLayer = 0; iLayer < poDS->GetLayerCount(); iLayer++) {
+    OGRLayer* poLayer = poDS->GetLayer(iLayer);
+    if (QString(poLayer->GetName()) == "SOUNDG")
+      continue;
+
+    OGRFeature* poFeature = NULL;
+    poLayer->ResetReading();
+    while ((poFeature = poLayer->GetNextFeature()) != NULL) {
+      for (int j = 0; j < poFeature->GetGeomFieldCount(); j++) {
+        OGRGeometry* geom = poFeature->GetGeomFieldRef(j);
+        if (geom == NULL || geom->getGeometryType() != wkbPolygon)
+          continue;
+
+        TriangulateInput in;
+        if (polygonContours((OGRPolygon*) geom, in.cntr, in.geoPt))
+          inputs.push_back(in);
+      }
+
+      OGRFeature::DestroyFeature(poFeature);
+    }
+  }
+
+  OGRDataSource::DestroyDataSource(poDS);
+  return true;
+}
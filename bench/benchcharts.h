@@ -0,0 +1,51 @@
+#ifndef BENCHCHARTS_H
+#define BENCHCHARTS_H
+
+#include <QByteArray>
+#include <QDir>
+#include <QStringList>
+
+#include <vector>
+
+#include "../s52/polygoncontours.h"
+#include "../layers/chartindex.h"
+
+#define BENCH_ENGINES 5   // Area, line, mark, text and sounding engines
+
+// Indices of a layer per level of detail, as the engines keep them, and
+// where the levels start in the buffers of the engine
+struct BenchLayer {
+  int engine;
+  std::vector<ChartIndex> levels;
+  std::vector<float> scales;
+  std::vector<int> firsts;
+
+  int level(float scale) const {
+    size_t l = 0;
+    while (l + 1 < levels.size() && scales[l+1] <= scale)
+      l++;
+    return l;
+  }
+
+  const ChartIndex& at(float scale) const { return levels[level(scale)]; }
+};
+
+// Layers of an engine one after another in its buffers, as ChartEngine lays them out
+void benchLayOut(std::vector<BenchLayer>& layers);
+
+// View at the center of cell gx, gy of a grid over the chart
+ChartView benchView(S52Chart* chart, int grid, int gx, int gy, float scale);
+
+// Chart files of dir, with the S-57 driver registered to read them
+QStringList chartFiles(QDir& dir);
+
+// Contours and vertices of an area polygon as the triangulator takes them
+struct TriangulateInput {
+  std::vector<int> cntr;
+  std::vector<ContourPoint> geoPt;
+};
+
+// Area polygons of a chart as S52Chart triangulates them
+bool readChartPolygons(const QByteArray& path, std::vector<TriangulateInput>& inputs);
+
+#endif // BENCHCHARTS_H
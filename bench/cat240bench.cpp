@@ -0,0 +1,150 @@
+#include "bench.h"
+#include "../datasources/cat240sender.h"
+#include "../datasources/radardatasource.h"
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#ifndef Q_OS_WIN
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif // !Q_OS_WIN
+
+static double elapsedNs(const struct timespec& t1, const struct timespec& t2) {
+  return (double)(t2.tv_sec - t1.tv_sec) * 1e9 + (double)(t2.tv_nsec - t1.tv_nsec);
+}
+
+// Radar-like bearing: noise floor, a few echoes and empty stretches
+static void makeBearing(uint32_t brg, float* amps, uint32_t n, uint32_t* rnd) {
+  for (uint32_t i = 0; i < n; i++) {
+    *rnd ^= *rnd << 13;
+    *rnd ^= *rnd >> 17;
+    *rnd ^= *rnd << 5;
+
+    float a = (i < n / 3) ? (float)(*rnd % 48) : 0.f;
+    if ((i + brg / 16) % 97 < 6)
+      a = 200.f + (*rnd % 56);
+    amps[i] = a;
+  }
+}
+
+int runCat240Bench(FILE* f) {
+#ifdef Q_OS_WIN
+  fprintf(f, "CAT-240 bench is not supported\n");
+  return -1;
+#else
+  struct variant_t {
+    const char* name;
+    uint8_t     res;
+    bool        compress;
+    uint32_t    datagram;
+  };
+
+  static const variant_t variants[] = {
+    { "8 bit",             CAT240_RES_8BIT, false, C240_DATAGRAM },
+    { "8 bit packbits",    CAT240_RES_8BIT, true,  C240_DATAGRAM },
+    { "4 bit",             CAT240_RES_4BIT, false, C240_DATAGRAM },
+    { "4 bit packbits",    CAT240_RES_4BIT, true,  C240_DATAGRAM },
+    { "8 bit, 512 octets", CAT240_RES_8BIT, false, 512 }
+  };
+
+  const uint32_t brg_count = BEARINGS_PER_CYCLE;
+  const uint32_t brg_size  = PELENG_SIZE;
+
+  // Loopback receiver
+  int rs = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in sin;
+  socklen_t slen = sizeof(sin);
+  memset(&sin, 0, sizeof(sin));
+  sin.sin_family      = AF_INET;
+  sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  int rcvbuf = 8 << 20;
+  setsockopt(rs, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  if (rs < 0 || bind(rs, (struct sockaddr*)&sin, sizeof(sin)) < 0 || getsockname(rs, (struct sockaddr*)&sin, &slen) < 0) {
+    fprintf(f, "CAT-240 bench: loopback socket failed: %s\n", strerror(errno));
+    return -1;
+  }
+  fcntl(rs, F_SETFL, O_NONBLOCK);
+
+  char address[32];
+  snprintf(address, sizeof(address), "127.0.0.1:%u", ntohs(sin.sin_port));
+
+  std::vector<float> amps((size_t)brg_count * brg_size);
+  uint32_t rnd = 7;
+  for (uint32_t b = 0; b < brg_count; b++)
+    makeBearing(b, &amps[(size_t)b * brg_size], brg_size, &rnd);
+
+  std::vector<float>   rcvd((size_t)brg_count * brg_size);
+  std::vector<uint8_t> dgram(65536), tmp(brg_size);
+
+  fprintf(f, "CAT-240 output (%u bearings of %u cells over %s)\n", brg_count, brg_size, address);
+  fprintf(f, "  format             octets/brg  datagrams  ns/bearing  received  mismatches\n");
+
+  BearingRing ring(16, brg_size);
+
+  for (size_t k = 0; k < sizeof(variants) / sizeof(variants[0]); k++) {
+    const variant_t& var = variants[k];
+
+    Cat240Sender snd(&ring, var.datagram);
+    snd.setResolution(var.res);
+    snd.setCompression(var.compress);
+    snd.setRange(6.f);
+    if (!snd.open(address))
+      return -1;
+
+    std::fill(rcvd.begin(), rcvd.end(), -1.f);
+    uint64_t cells_rcvd = 0;
+    double ns = 0;
+    struct timespec t1, t2;
+
+    for (uint32_t b = 0; b < brg_count; b++) {
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      snd.send(b, &amps[(size_t)b * brg_size]);
+      if (b % 64 == 63 || b == brg_count - 1)
+        snd.flush();
+      clock_gettime(CLOCK_MONOTONIC, &t2);
+      ns += elapsedNs(t1, t2);
+
+      // Drain the receiver so its buffer never overflows
+      ssize_t len;
+      while ((len = recv(rs, &dgram[0], dgram.size(), 0)) > 0) {
+        uint32_t off = 0, blen;
+        Cat240Video v;
+        while (off < (uint32_t)len && (blen = cat240DecodeBlock(&dgram[off], len - off, &v)) > 0) {
+          off += blen;
+          uint32_t rb = ((uint32_t)v.start_az * brg_count + 32768) >> 16;
+          if (v.cells == 0 || rb >= brg_count || v.start_rg + v.cells > brg_size)
+            continue;
+          int n = cat240UnpackCells(v, &rcvd[(size_t)rb * brg_size + v.start_rg], v.cells, &tmp[0], tmp.size());
+          if (n > 0)
+            cells_rcvd += n;
+        }
+      }
+    }
+
+    // 4-bit cells come back as multiples of 17
+    uint64_t mismatches = 0;
+    for (size_t i = 0; i < amps.size(); i++) {
+      float a = amps[i] < 0.f ? 0.f : (amps[i] > 255.f ? 255.f : amps[i]);
+      uint32_t q = (uint32_t)(a + 0.5f);
+      float expect = (var.res == CAT240_RES_8BIT) ? (float)q : (float)((q >> 4) * 17);
+      if (rcvd[i] != expect)
+        mismatches++;
+    }
+
+    fprintf(f, "  %-17s  %10.1f  %9llu  %10.1f  %8.1f%%  %10llu\n", var.name
+            , (double)snd.octets() / brg_count, (unsigned long long)snd.datagrams()
+            , ns / brg_count, 100.0 * cells_rcvd / amps.size(), (unsigned long long)mismatches);
+  }
+
+  ::close(rs);
+  return 0;
+#endif // Q_OS_WIN
+}
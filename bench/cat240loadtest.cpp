@@ -0,0 +1,100 @@
+#include "bench.h"
+#include "../datasources/cat240receiver.h"
+#include "../datasources/cat240sender.h"
+
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+static double elapsedNs(const struct timespec& t1, const struct timespec& t2) {
+  return (double)(t2.tv_sec - t1.tv_sec) * 1e9 + (double)(t2.tv_nsec - t1.tv_nsec);
+}
+
+int runCat240LoadTest(FILE* f) {
+  const uint32_t brg_count = 8192;
+  const uint32_t brg_size  = 800;
+  const uint32_t revs      = 8;
+  const char*    address   = "127.0.0.1:40240";
+
+  struct variant_t {
+    const char* name;
+    uint8_t     res;
+    bool        compress;
+    uint32_t    datagram;
+  };
+
+  static const variant_t variants[] = {
+    { "8 bit",             CAT240_RES_8BIT, false, C240_DATAGRAM },
+    { "4 bit packbits",    CAT240_RES_4BIT, true,  C240_DATAGRAM },
+    { "8 bit, 512 octets", CAT240_RES_8BIT, false, 512 }
+  };
+
+  // Echoes on a noise floor, amplitudes representable in 4 bits
+  std::vector<float> amps((size_t)brg_count * brg_size);
+  uint32_t rnd = 11;
+  for (size_t i = 0; i < amps.size(); i++) {
+    rnd ^= rnd << 13;
+    rnd ^= rnd >> 17;
+    rnd ^= rnd << 5;
+    amps[i] = (float)((((i % brg_size) < brg_size / 3 ? rnd % 3 : 0) + ((i / 7) % 61 == 0 ? 13 : 0)) * 17);
+  }
+
+  fprintf(f, "CAT-240 input load test (%u revolutions of %u bearings over %s)\n", revs, brg_count, address);
+  fprintf(f, "  format             bearings/s  recv calls  partial  lost  errors\n");
+
+  BearingRing ring(16, brg_size);
+
+  for (size_t k = 0; k < sizeof(variants) / sizeof(variants[0]); k++) {
+    const variant_t& var = variants[k];
+
+    Cat240Receiver rcv(brg_count, brg_size);
+    if (!rcv.open(address))
+      return -1;
+
+    Cat240Sender snd(&ring, var.datagram);
+    snd.setResolution(var.res);
+    snd.setCompression(var.compress);
+    if (!snd.open(address))
+      return -1;
+
+    uint64_t errors = 0, got = 0;
+    struct timespec t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    for (uint32_t n = 0; n < revs * brg_count; n++) {
+      uint32_t b = n % brg_count;
+      snd.send(b, &amps[(size_t)b * brg_size]);
+
+      if (n % 32 != 31)
+        continue;
+      snd.flush();
+
+      while (rcv.receive(0) > 0) {
+        for (uint32_t i = 0; i < rcv.count(); i++) {
+          const uint32_t* p = rcv.packet(i);
+          const float* a = &amps[(size_t)p[0] * brg_size];
+          for (uint32_t j = 0; j < brg_size; j++)
+            if (p[j + 3] != (uint32_t)a[j])
+              errors++;
+        }
+        got += rcv.count();
+      }
+    }
+
+    // Whatever is still queued in the socket
+    for (uint64_t dgrams = ~0ull; dgrams != rcv.stats().datagrams; ) {
+      dgrams = rcv.stats().datagrams;
+      rcv.receive(10);
+      got += rcv.count();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    const Cat240ReceiverStats& st = rcv.stats();
+    fprintf(f, "  %-17s  %10.0f  %10llu  %7llu  %4llu  %6llu\n", var.name
+            , got / (elapsedNs(t1, t2) * 1e-9), (unsigned long long)st.calls
+            , (unsigned long long)st.partial, (unsigned long long)st.lost, (unsigned long long)errors);
+  }
+
+  return 0;
+}
@@ -0,0 +1,143 @@
+#include "bench.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include <ogrsf_frmts.h>
+
+#include "../s52/chartcache.h"
+#include "../s52/chartmanager.h"
+
+static bool sameContents(const QString& path1, const QString& path2) {
+  QFile f1(path1), f2(path2);
+  if (!f1.open(QIODevice::ReadOnly) || !f2.open(QIODevice::ReadOnly))
+    return false;
+  return f1.readAll() == f2.readAll();
+}
+
+// A copy of the cell and its updates in the cache folder matches the cache,
+// the copy with one more update file must not
+static bool updateInvalidates(const QString& path, const QString& cache_path, uint64_t refs_hash, S52References* refs) {
+  QString copy_path = QFileInfo(cache_path).dir().filePath(QFileInfo(path).fileName());
+  QStringList copies;
+
+  QFile::remove(copy_path);
+  bool ok = QFile::copy(path, copy_path);
+  if (ok)
+    copies << copy_path;
+
+  int update = 1;
+  for (; ok && QFile::exists(chartUpdatePath(path, update)); update++) {
+    QFile::remove(chartUpdatePath(copy_path, update));
+    ok = QFile::copy(chartUpdatePath(path, update), chartUpdatePath(copy_path, update));
+    if (ok)
+      copies << chartUpdatePath(copy_path, update);
+  }
+
+  ChartCacheKey key;
+  S52Chart* cached = NULL;
+  if (ok && chartCacheKey(copy_path, refs_hash, &key)) {
+    cached = S52Chart::fromCache(cache_path, key, refs);
+    ok = cached != NULL;
+    delete cached;
+  } else {
+    ok = false;
+  }
+
+  QFile upd(chartUpdatePath(copy_path, update));
+  if (ok && upd.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    copies << upd.fileName();
+    ok = upd.write("update") == 6;
+    upd.close();
+  } else {
+    ok = false;
+  }
+
+  if (ok && chartCacheKey(copy_path, refs_hash, &key)) {
+    cached = S52Chart::fromCache(cache_path, key, refs);
+    ok = cached == NULL;
+    delete cached;
+  } else {
+    ok = false;
+  }
+
+  for (int i = 0; i < copies.count(); i++)
+    QFile::remove(copies[i]);
+
+  return ok;
+}
+
+int runChartCacheBuild(FILE* f, const char* dir_path) {
+  QDir dir(dir_path);
+  dir.setNameFilters(QStringList("*.000"));
+  dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+
+  QStringList fileList = dir.entryList();
+  if (fileList.count() == 0) {
+    fprintf(f, "No charts found in %s\n", dir_path);
+    return -1;
+  }
+
+  uint64_t refs_hash = 0;
+  if (!chartCacheHash(CM_REFS_FILE, &refs_hash)) {
+    fprintf(f, "Cannot read %s\n", CM_REFS_FILE);
+    return -1;
+  }
+
+  RegisterOGRS57();
+  S52References refs(CM_REFS_FILE);
+  refs.setColorScheme("DAY_BRIGHT");
+
+  fprintf(f, "Chart caches of %s, format %d\n", dir_path, CC_VERSION);
+
+  int failed = 0;
+  for (int i = 0; i < fileList.count(); i++) {
+    QString path = dir.filePath(fileList[i]);
+    QString cache_path = chartCachePath(path);
+    QByteArray name = fileList[i].toLatin1();
+
+    ChartCacheKey key;
+    if (!chartCacheKey(path, refs_hash, &key)) {
+      fprintf(f, "  %s: cannot read\n", name.constData());
+      failed++;
+      continue;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    QByteArray c_chart_path = path.toLatin1();
+    S52Chart* chart = new S52Chart(c_chart_path.data(), &refs);
+    double ingest_ms = clock.nsecsElapsed() * 1e-6;
+
+    bool saved = chart->saveCache(cache_path, key);
+    delete chart;
+    if (!saved) {
+      fprintf(f, "  %s: not cached, the chart could not be read or the cache written\n", name.constData());
+      failed++;
+      continue;
+    }
+
+    clock.restart();
+    S52Chart* cached = S52Chart::fromCache(cache_path, key, &refs);
+    double cache_ms = clock.nsecsElapsed() * 1e-6;
+
+    // Written again from what was read back, the two must match byte for byte
+    QString check_path = cache_path + ".check";
+    bool same = cached != NULL && cached->saveCache(check_path, key) && sameContents(cache_path, check_path);
+    QFile::remove(check_path);
+    delete cached;
+
+    bool updated = updateInvalidates(path, cache_path, refs_hash, &refs);
+
+    fprintf(f, "  %s: ingest %8.1f ms, from cache %6.1f ms (%5.1fx), %7.1f KB%s%s\n"
+            , name.constData(), ingest_ms, cache_ms, cache_ms > 0 ? ingest_ms / cache_ms : 0
+            , QFileInfo(cache_path).size() / 1024.0, same ? "" : ", READ BACK DIFFERS"
+            , updated ? "" : ", UPDATE NOT DETECTED");
+
+    if (!same || !updated)
+      failed++;
+  }
+
+  return failed == 0 ? 0 : -1;
+}
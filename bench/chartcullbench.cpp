@@ -0,0 +1,169 @@
+#include "bench.h"
+#include "benchcharts.h"
+
+#include <QElapsedTimer>
+
+#include "../s52/chartmanager.h"
+
+// Renders of a chart at one scale over a grid of view centers
+static void benchScale(FILE* f, const std::vector<BenchLayer>& layers, S52Chart* chart, float scale) {
+  const int grid = 5;
+
+  uint64_t total = 0;
+  int unculled = 0;
+  for (size_t l = 0; l < layers.size(); l++) {
+    total += layers[l].levels[0].vertexCount();
+    if (layers[l].at(scale).vertexCount() > 0)
+      unculled++;
+  }
+
+  std::vector<int> firsts, counts;
+  uint64_t calls = 0, verts = 0;
+  int renders = 0;
+
+  QElapsedTimer clock;
+  clock.start();
+
+  for (int gy = 0; gy < grid; gy++) {
+    for (int gx = 0; gx < grid; gx++) {
+      ChartView view = benchView(chart, grid, gx, gy, scale);
+
+      for (size_t l = 0; l < layers.size(); l++) {
+        verts += layers[l].at(scale).query(view, firsts, counts);
+        calls += counts.size();
+      }
+      renders++;
+    }
+  }
+
+  double query_us = clock.nsecsElapsed() * 1e-3 / renders;
+
+  // The same views batched: a multi-draw call per engine
+  ChartBatch batches[BENCH_ENGINES];
+  uint64_t batch_calls = 0, batch_ranges = 0;
+  clock.restart();
+
+  for (int gy = 0; gy < grid; gy++) {
+    for (int gx = 0; gx < grid; gx++) {
+      ChartView view = benchView(chart, grid, gx, gy, scale);
+
+      for (int e = 0; e < BENCH_ENGINES; e++)
+        batches[e].clear();
+
+      for (size_t l = 0; l < layers.size(); l++) {
+        int k = layers[l].level(scale);
+        batches[layers[l].engine].add(layers[l].levels[k], layers[l].firsts[k], layers[l].levels[k].vertexCount(), view);
+      }
+
+      for (int e = 0; e < BENCH_ENGINES; e++) {
+        if (!batches[e].empty()) {
+          batch_calls++;
+          batch_ranges += batches[e].size();
+        }
+      }
+    }
+  }
+
+  double batch_us = clock.nsecsElapsed() * 1e-3 / renders;
+
+  fprintf(f, "    %6.0f m/px: %6.1f draw calls (%d unculled), batched %3.1f calls of %6.1f ranges, %9.0f of %9llu vertices (%5.1f%%), query %6.1f us, batched %6.1f us\n"
+          , scale, (double)calls / renders, unculled, (double)batch_calls / renders, (double)batch_ranges / renders
+          , (double)verts / renders, (unsigned long long)total
+          , total > 0 ? 100.0 * verts / renders / total : 0, query_us, batch_us);
+}
+
+int runChartCullBench(FILE* f) {
+  QDir dir("res/charts");
+  dir.setNameFilters(QStringList("*.000"));
+  dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+
+  QStringList fileList = dir.entryList();
+  if (fileList.count() == 0) {
+    fprintf(f, "No charts found in %s\n", dir.path().toLatin1().constData());
+    return -1;
+  }
+
+  S52References refs(CM_REFS_FILE);
+  refs.setColorScheme("DAY_BRIGHT");
+
+  const float scales[] = { 2, 5, 10, 25, 50, 100, 250, 1000 };
+
+  fprintf(f, "Chart viewport culling and levels of detail, 5x5 views over each chart, buckets of up to %d vertices\n", CI_BUCKET_VERTS);
+
+  for (int i = 0; i < fileList.count(); i++) {
+    QByteArray path = dir.filePath(fileList[i]).toLatin1();
+    S52Chart* chart = new S52Chart(path.data(), &refs);
+
+    std::vector<BenchLayer> layers;
+    QElapsedTimer clock;
+    clock.start();
+
+    QList<QString> names = chart->getAreaLayerNames();
+    for (int k = 0; k < names.size(); k++) {
+      S52AreaLayer* layer = chart->getAreaLayer(names[k]);
+      layers.push_back(BenchLayer());
+      layers.back().engine = 0;
+      layers.back().levels.resize(layer->lods.size() + 1);
+      layers.back().scales.push_back(0);
+      for (size_t l = 0; l <= layer->lods.size(); l++) {
+        indexAreaLayer(layer, l, &layers.back().levels[l]);
+        if (l > 0)
+          layers.back().scales.push_back(layer->lods[l-1].min_scale);
+      }
+    }
+    names = chart->getLineLayerNames();
+    for (int k = 0; k < names.size(); k++) {
+      S52LineLayer* layer = chart->getLineLayer(names[k]);
+      layers.push_back(BenchLayer());
+      layers.back().engine = 1;
+      layers.back().levels.resize(layer->lods.size() + 1);
+      layers.back().scales.push_back(0);
+      for (size_t l = 0; l <= layer->lods.size(); l++) {
+        indexLineLayer(layer, l, &layers.back().levels[l]);
+        if (l > 0)
+          layers.back().scales.push_back(layer->lods[l-1].min_scale);
+      }
+    }
+    names = chart->getMarkLayerNames();
+    for (int k = 0; k < names.size(); k++) {
+      layers.push_back(BenchLayer());
+      layers.back().engine = 2;
+      layers.back().levels.resize(1);
+      layers.back().scales.push_back(0);
+      indexMarkLayer(chart->getMarkLayer(names[k]), &refs, &layers.back().levels[0]);
+    }
+    names = chart->getTextLayerNames();
+    for (int k = 0; k < names.size(); k++) {
+      layers.push_back(BenchLayer());
+      layers.back().engine = 3;
+      layers.back().levels.resize(1);
+      layers.back().scales.push_back(0);
+      indexTextLayer(chart->getTextLayer(names[k]), &layers.back().levels[0]);
+    }
+    if (chart->getSndgLayer() != NULL) {
+      layers.push_back(BenchLayer());
+      layers.back().engine = 4;
+      layers.back().levels.resize(1);
+      layers.back().scales.push_back(0);
+      indexSndgLayer(chart->getSndgLayer(), &refs, &layers.back().levels[0]);
+    }
+
+    benchLayOut(layers);
+    double build_ms = clock.nsecsElapsed() * 1e-6;
+
+    int buckets = 0;
+    for (size_t l = 0; l < layers.size(); l++)
+      for (size_t k = 0; k < layers[l].levels.size(); k++)
+        buckets += layers[l].levels[k].bucketCount();
+
+    fprintf(f, "  %s: %d layers, %d buckets, indexed in %.1f ms\n"
+            , fileList[i].toLatin1().constData(), (int)layers.size(), buckets, build_ms);
+
+    for (size_t s = 0; s < sizeof(scales) / sizeof(scales[0]); s++)
+      benchScale(f, layers, chart, scales[s]);
+
+    delete chart;
+  }
+
+  return 0;
+}
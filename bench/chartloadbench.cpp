@@ -0,0 +1,66 @@
+#include "bench.h"
+
+#include <QDir>
+#include <QThread>
+
+#include "../s52/chartmanager.h"
+
+#define CM_BENCH_CELLS  50   // Cells loaded by the benchmark, taken round-robin from res/charts
+
+int runChartLoadBench(FILE* f) {
+  QDir dir("res/charts");
+  dir.setNameFilters(QStringList("*.000"));
+  dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+
+  QStringList fileList = dir.entryList();
+  if (fileList.count() == 0) {
+    fprintf(f, "No charts found in %s\n", dir.path().toLatin1().constData());
+    return -1;
+  }
+
+  // The same file loaded as several cells still gets a dataset per cell
+  QStringList names, paths;
+  for (int i = 0; i < CM_BENCH_CELLS; i++) {
+    names << QString("%1#%2").arg(fileList[i % fileList.count()]).arg(i);
+    paths << dir.path() + "/" + fileList[i % fileList.count()];
+  }
+
+  int pool = qMax(1, QThread::idealThreadCount());
+  fprintf(f, "Chart loading: %d cells from %d files in %s, %d cores\n"
+          , CM_BENCH_CELLS, fileList.count(), dir.path().toLatin1().constData(), pool);
+
+  double single_ms = 0;
+  auto run = [&](int loaders, bool use_cache, const char* label) -> bool {
+    ChartManager* mngr = new ChartManager();
+    mngr->setUseCache(use_cache);
+    mngr->loadFiles(names, paths, loaders);
+
+    double all_ms = mngr->loadingMs();
+    if (single_ms == 0)
+      single_ms = all_ms;
+
+    fprintf(f, "  %2d loaders%s: first chart after %6lld ms, all %d in %7.0f ms, %5.1f charts/s, %.2fx\n"
+            , loaders, label, (long long)mngr->firstChartMs(), mngr->loadedCount(), all_ms
+            , all_ms > 0 ? mngr->loadedCount() * 1e3 / all_ms : 0, all_ms > 0 ? single_ms / all_ms : 0);
+
+    bool ok = (mngr->loadedCount() == CM_BENCH_CELLS);
+    delete mngr;
+    return ok;
+  };
+
+  // Full ingest, one loader first as it sees the files cold
+  int counts[] = { 1, 2, CM_MAX_LOADERS, pool };
+  for (int i = 0; i < 4; i++) {
+    if (i > 0 && counts[i] <= counts[i - 1])
+      continue;
+    if (!run(counts[i], false, ""))
+      return -1;
+  }
+
+  // From the caches, written by the first pass where missing or stale
+  int loaders = qMin(CM_MAX_LOADERS, pool);
+  if (!run(loaders, true, ", caching") || !run(loaders, true, ", cached "))
+    return -1;
+
+  return 0;
+}
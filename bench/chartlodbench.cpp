@@ -0,0 +1,100 @@
+#include "bench.h"
+#include "benchcharts.h"
+
+#include <stdint.h>
+#include <time.h>
+
+#include "../s52/chartmanager.h"
+#include "../s52/s52chart.h"
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Scale level k of CHART_LOD_LEVELS is drawn from, as S52Chart builds them
+static float lodScale(int k) {
+  return CHART_LOD_SCALE * (1 << (2 * k));
+}
+
+int runChartLodBench(FILE* f) {
+  QDir dir("res/charts");
+  QStringList fileList = chartFiles(dir);
+  if (fileList.count() == 0) {
+    fprintf(f, "No charts found in %s\n", dir.path().toLatin1().constData());
+    return -1;
+  }
+
+  S52References refs(CM_REFS_FILE);
+  refs.setColorScheme("DAY_BRIGHT");
+
+  fprintf(f, "Chart levels of detail, tolerance %.2f px, from %.0f m/px in steps of 4x\n", CHART_LOD_TOLERANCE, CHART_LOD_SCALE);
+
+  uint64_t load_total = 0, lod_total = 0;
+
+  for (int i = 0; i < fileList.count(); i++) {
+    QByteArray path = dir.filePath(fileList[i]).toLatin1();
+
+    uint64_t t0 = nowNs();
+    S52Chart* chart = new S52Chart(path.data(), &refs);
+    uint64_t load_ns = nowNs() - t0;
+
+    QList<QString> area_names = chart->getAreaLayerNames();
+    QList<QString> line_names = chart->getLineLayerNames();
+    if (area_names.isEmpty() && line_names.isEmpty()) {
+      fprintf(f, "Cannot open %s\n", path.constData());
+      delete chart;
+      return -1;
+    }
+
+    // Layers without a level reuse the finer geometry at that scale
+    size_t area_full = 0, line_full = 0;
+    size_t area_verts[CHART_LOD_LEVELS] = { 0 };
+    size_t line_verts[CHART_LOD_LEVELS] = { 0 };
+
+    for (int n = 0; n < area_names.size(); n++) {
+      const S52AreaLayer* l = chart->getAreaLayer(area_names[n]);
+      if (l == NULL)
+        continue;
+
+      area_full += l->triangles.size() / 2;
+      for (int k = 0; k < CHART_LOD_LEVELS; k++) {
+        size_t n = l->triangles.size() / 2;
+        for (size_t m = 0; m < l->lods.size() && l->lods[m].min_scale <= lodScale(k); m++)
+          n = l->lods[m].triangles.size() / 2;
+        area_verts[k] += n;
+      }
+    }
+
+    for (int n = 0; n < line_names.size(); n++) {
+      const S52LineLayer* l = chart->getLineLayer(line_names[n]);
+      if (l == NULL)
+        continue;
+
+      line_full += l->points.size() / 2;
+      for (int k = 0; k < CHART_LOD_LEVELS; k++) {
+        size_t n = l->points.size() / 2;
+        for (size_t m = 0; m < l->lods.size() && l->lods[m].min_scale <= lodScale(k); m++)
+          n = l->lods[m].points.size() / 2;
+        line_verts[k] += n;
+      }
+    }
+
+    fprintf(f, "%s: load %.1f ms, levels of detail %.1f ms, %u area vertices, %u line points\n"
+            , fileList[i].toLatin1().constData(), load_ns * 1e-6, chart->lodNs() * 1e-6, (uint)area_full, (uint)line_full);
+    for (int k = 0; k < CHART_LOD_LEVELS; k++)
+      fprintf(f, "  %6.0f m/px: %8u area vertices (%5.1f%%), %8u line points (%5.1f%%)\n", lodScale(k)
+              , (uint)area_verts[k], area_full ? 100.0 * area_verts[k] / area_full : 0
+              , (uint)line_verts[k], line_full ? 100.0 * line_verts[k] / line_full : 0);
+
+    load_total += load_ns;
+    lod_total += chart->lodNs();
+    delete chart;
+  }
+
+  fprintf(f, "All charts: load %.1f ms, levels of detail %.1f ms (%.1f%%)\n"
+          , load_total * 1e-6, lod_total * 1e-6, load_total ? 100.0 * lod_total / load_total : 0);
+
+  return 0;
+}
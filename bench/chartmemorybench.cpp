@@ -0,0 +1,103 @@
+#include "bench.h"
+
+#include <QDir>
+
+#include "../layers/chartlayers.h"
+#include "../s52/chartmanager.h"
+
+// Vertices of all the levels of a layer as its engine lays them out
+static uint64_t levelVertices(const std::vector<ChartIndex>& levels) {
+  uint64_t verts = 0;
+  for (size_t l = 0; l < levels.size(); l++)
+    verts += levels[l].vertexCount();
+  return verts;
+}
+
+int runChartMemoryBench(FILE* f) {
+  QDir dir("res/charts");
+  dir.setNameFilters(QStringList("*.000"));
+  dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+
+  QStringList fileList = dir.entryList();
+  if (fileList.count() == 0) {
+    fprintf(f, "No charts found in %s\n", dir.path().toLatin1().constData());
+    return -1;
+  }
+
+  S52References refs(CM_REFS_FILE);
+  refs.setColorScheme("DAY_BRIGHT");
+
+  const char* names[] = { "lines", "marks", "sndgs" };
+  const int quad_floats[] = { LINE_QUAD_FLOATS, MARK_QUAD_FLOATS, SNDG_QUAD_FLOATS };
+
+  fprintf(f, "Chart buffer memory, four vertices a quad against a record a quad\n");
+
+  for (int i = 0; i < fileList.count(); i++) {
+    QByteArray path = dir.filePath(fileList[i]).toLatin1();
+    S52Chart* chart = new S52Chart(path.data(), &refs);
+
+    uint64_t area_verts = 0, text_verts = 0;
+    uint64_t quads[3] = { 0, 0, 0 };
+    std::vector<ChartIndex> levels;
+
+    QList<QString> layer_names = chart->getAreaLayerNames();
+    for (int k = 0; k < layer_names.size(); k++) {
+      S52AreaLayer* layer = chart->getAreaLayer(layer_names[k]);
+      levels.assign(layer->lods.size() + 1, ChartIndex());
+      for (size_t l = 0; l < levels.size(); l++)
+        indexAreaLayer(layer, l, &levels[l]);
+      area_verts += levelVertices(levels);
+    }
+    layer_names = chart->getLineLayerNames();
+    for (int k = 0; k < layer_names.size(); k++) {
+      S52LineLayer* layer = chart->getLineLayer(layer_names[k]);
+      levels.assign(layer->lods.size() + 1, ChartIndex());
+      for (size_t l = 0; l < levels.size(); l++)
+        indexLineLayer(layer, l, &levels[l]);
+      quads[0] += levelVertices(levels) / 4;
+    }
+    layer_names = chart->getMarkLayerNames();
+    for (int k = 0; k < layer_names.size(); k++) {
+      levels.assign(1, ChartIndex());
+      indexMarkLayer(chart->getMarkLayer(layer_names[k]), &refs, &levels[0]);
+      quads[1] += levelVertices(levels) / 4;
+    }
+    layer_names = chart->getTextLayerNames();
+    for (int k = 0; k < layer_names.size(); k++) {
+      levels.assign(1, ChartIndex());
+      indexTextLayer(chart->getTextLayer(layer_names[k]), &levels[0]);
+      text_verts += levelVertices(levels);
+    }
+    if (chart->getSndgLayer() != NULL) {
+      levels.assign(1, ChartIndex());
+      indexSndgLayer(chart->getSndgLayer(), &refs, &levels[0]);
+      quads[2] += levelVertices(levels) / 4;
+    }
+
+    // Areas and texts are drawn per vertex either way
+    uint64_t shared = (area_verts * AREA_VERTEX_FLOATS + text_verts * TEXT_VERTEX_FLOATS) * sizeof(GLfloat);
+    uint64_t total_before = shared, total_after = shared;
+
+    fprintf(f, "  %s: areas %.1f KB, texts %.1f KB\n", fileList[i].toLatin1().constData()
+            , area_verts * AREA_VERTEX_FLOATS * sizeof(GLfloat) / 1024.0
+            , text_verts * TEXT_VERTEX_FLOATS * sizeof(GLfloat) / 1024.0);
+
+    for (int e = 0; e < 3; e++) {
+      // A vertex repeats the record and adds its corner, instances share four corners
+      uint64_t before = 4 * quads[e] * (quad_floats[e] + 1) * sizeof(GLfloat);
+      uint64_t after = (quads[e] * quad_floats[e] + 4) * sizeof(GLfloat);
+      total_before += before;
+      total_after += after;
+
+      fprintf(f, "    %s: %llu quads, %.1f KB -> %.1f KB\n", names[e], (unsigned long long) quads[e]
+              , before / 1024.0, after / 1024.0);
+    }
+
+    fprintf(f, "    total: %.1f KB -> %.1f KB (%.0f%%)\n", total_before / 1024.0, total_after / 1024.0
+            , total_before > 0 ? 100.0 * total_after / total_before : 100.0);
+
+    delete chart;
+  }
+
+  return 0;
+}
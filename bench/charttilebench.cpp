@@ -0,0 +1,274 @@
+#include "bench.h"
+#include "benchcharts.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <math.h>
+
+#include "../common/rlimath.h"
+#include "../s52/chartmanager.h"
+
+using namespace RLIMath;
+
+#define BENCH_TILE_SCALE  1.f   // Harbour scale of the precision views, m/px
+
+// Positions an engine quantizes, in layout order: a point per vertex of
+// areas and texts, per quad of marks and soundings and two per quad of
+// lines, their ends
+struct BenchTiles {
+  ChartTiles tiles;
+  int stride;                  // Vertices per point
+  int next;                    // Vertex the next item starts at
+  std::vector<float> points;
+  std::vector<float> ends;     // Second ends of line segments
+};
+
+static void benchTileItems(BenchTiles& bt, const ChartIndex& index, float min_scale
+                         , const float* coords, int kind, const S52SndgLayer* sndg) {
+  const std::vector<ChartIndexItem>& items = index.items();
+  const std::vector<int>& order = index.order();
+  double side = ChartTiles::side(min_scale);
+
+  for (size_t o = 0; o < order.size(); o++) {
+    const ChartIndexItem& it = items[order[o]];
+    bt.tiles.add(bt.next, it, side);
+    bt.next += it.verts;
+
+    switch (kind) {
+    case 0:   // Area triangle vertices
+      bt.points.insert(bt.points.end(), coords + 2*it.first, coords + 2*(it.first + it.count));
+      break;
+    case 1:   // Line segments
+      for (int j = 2*it.first; j < 2*(it.first + it.count); j += 2) {
+        bt.points.insert(bt.points.end(), coords + j, coords + j + 2);
+        bt.ends.insert(bt.ends.end(), coords + j + 2, coords + j + 4);
+      }
+      break;
+    default:  // A point per mark, text char or sounding digit
+      int n = (kind == 4) ? soundingSymbols(sndg->depths[it.first]) : it.verts / bt.stride;
+      for (int k = 0; k < n; k++)
+        bt.points.insert(bt.points.end(), coords + 2*it.first, coords + 2*it.first + 2);
+      break;
+    }
+  }
+}
+
+// Errors in meters of the float shader math and of the tiled one against
+// double math, over the points of the engine within the view
+static void benchTileErrors(const BenchTiles& bt, const std::vector<float>& points, const std::vector<uint16_t>& offsets
+                          , const ChartView& view, double max_m, double* err_float, double* err_tiled, double* sum2_float, double* sum2_tiled, uint64_t* n) {
+  const float rads = 3.14159265f / 180.f;
+  float cos_f = cosf(view.lat * rads);
+  double cos_d = cos(radians(view.lat));
+
+  float origin[2], step[2];
+  int tile = -1;
+
+  for (size_t p = 0; 2*p < points.size(); p++) {
+    double x = EARTH_RADIUS * cos_d * radians(points[2*p+1] - static_cast<double>(view.lon));
+    double y = -EARTH_RADIUS * radians(points[2*p+0] - static_cast<double>(view.lat));
+    if (x * x + y * y > max_m * max_m)
+      continue;
+
+    float xf = 6378137.f * cos_f * ((points[2*p+1] - view.lon) * rads);
+    float yf = -6378137.f * ((points[2*p+0] - view.lat) * rads);
+
+    int t = bt.tiles.tileAt(p * bt.stride);
+    if (t != tile) {
+      bt.tiles.frame(t, view, origin, step);
+      tile = t;
+    }
+    float xt = origin[0] + step[0] * static_cast<float>(offsets[2*p+1]);
+    float yt = origin[1] + step[1] * static_cast<float>(offsets[2*p+0]);
+
+    double ef = sqrt((xf - x) * (xf - x) + (yf - y) * (yf - y));
+    double et = sqrt((xt - x) * (xt - x) + (yt - y) * (yt - y));
+    *err_float = std::max(*err_float, ef);
+    *err_tiled = std::max(*err_tiled, et);
+    *sum2_float += ef * ef;
+    *sum2_tiled += et * et;
+    (*n)++;
+  }
+}
+
+int runChartTileBench(FILE* f) {
+  QDir dir("res/charts");
+  dir.setNameFilters(QStringList("*.000"));
+  dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+
+  QStringList fileList = dir.entryList();
+  if (fileList.count() == 0) {
+    fprintf(f, "No charts found in %s\n", dir.path().toLatin1().constData());
+    return -1;
+  }
+
+  S52References refs(CM_REFS_FILE);
+  refs.setColorScheme("DAY_BRIGHT");
+
+  const float scales[] = { 1, 2, 5, 10, 25, 50, 100, 250, 1000 };
+  const int strides[BENCH_ENGINES] = { 1, 4, 4, 1, 4 };
+  const int grid = 5;
+
+  fprintf(f, "Chart vertex tiles, %d steps over up to %.4f deg of full detail geometry, 5x5 views over each chart\n"
+          , CI_TILE_STEPS, CI_TILE_DEG);
+
+  for (int i = 0; i < fileList.count(); i++) {
+    QByteArray path = dir.filePath(fileList[i]).toLatin1();
+    S52Chart* chart = new S52Chart(path.data(), &refs);
+
+    std::vector<BenchLayer> layers;
+    BenchTiles engines[BENCH_ENGINES];
+    for (int e = 0; e < BENCH_ENGINES; e++) {
+      engines[e].stride = strides[e];
+      engines[e].next = 0;
+    }
+
+    QList<QString> names = chart->getAreaLayerNames();
+    for (int k = 0; k < names.size(); k++) {
+      S52AreaLayer* layer = chart->getAreaLayer(names[k]);
+      layers.push_back(BenchLayer());
+      layers.back().engine = 0;
+      layers.back().levels.resize(layer->lods.size() + 1);
+      layers.back().scales.push_back(0);
+      for (size_t l = 0; l <= layer->lods.size(); l++) {
+        const std::vector<float>& triangles = (l == 0) ? layer->triangles : layer->lods[l-1].triangles;
+        indexAreaLayer(layer, l, &layers.back().levels[l]);
+        if (l > 0)
+          layers.back().scales.push_back(layer->lods[l-1].min_scale);
+        benchTileItems(engines[0], layers.back().levels[l], layers.back().scales[l], triangles.data(), 0, NULL);
+      }
+    }
+    names = chart->getLineLayerNames();
+    for (int k = 0; k < names.size(); k++) {
+      S52LineLayer* layer = chart->getLineLayer(names[k]);
+      layers.push_back(BenchLayer());
+      layers.back().engine = 1;
+      layers.back().levels.resize(layer->lods.size() + 1);
+      layers.back().scales.push_back(0);
+      for (size_t l = 0; l <= layer->lods.size(); l++) {
+        const std::vector<float>& points = (l == 0) ? layer->points : layer->lods[l-1].points;
+        indexLineLayer(layer, l, &layers.back().levels[l]);
+        if (l > 0)
+          layers.back().scales.push_back(layer->lods[l-1].min_scale);
+        benchTileItems(engines[1], layers.back().levels[l], layers.back().scales[l], points.data(), 1, NULL);
+      }
+    }
+    names = chart->getMarkLayerNames();
+    for (int k = 0; k < names.size(); k++) {
+      S52MarkLayer* layer = chart->getMarkLayer(names[k]);
+      layers.push_back(BenchLayer());
+      layers.back().engine = 2;
+      layers.back().levels.resize(1);
+      layers.back().scales.push_back(0);
+      indexMarkLayer(layer, &refs, &layers.back().levels[0]);
+      benchTileItems(engines[2], layers.back().levels[0], 0, layer->points.data(), 2, NULL);
+    }
+    names = chart->getTextLayerNames();
+    for (int k = 0; k < names.size(); k++) {
+      S52TextLayer* layer = chart->getTextLayer(names[k]);
+      layers.push_back(BenchLayer());
+      layers.back().engine = 3;
+      layers.back().levels.resize(1);
+      layers.back().scales.push_back(0);
+      indexTextLayer(layer, &layers.back().levels[0]);
+      benchTileItems(engines[3], layers.back().levels[0], 0, layer->points.data(), 3, NULL);
+    }
+    if (chart->getSndgLayer() != NULL) {
+      S52SndgLayer* layer = chart->getSndgLayer();
+      layers.push_back(BenchLayer());
+      layers.back().engine = 4;
+      layers.back().levels.resize(1);
+      layers.back().scales.push_back(0);
+      indexSndgLayer(layer, &refs, &layers.back().levels[0]);
+      benchTileItems(engines[4], layers.back().levels[0], 0, layer->points.data(), 4, layer);
+    }
+
+    benchLayOut(layers);
+
+    // Quantized as the engines upload them
+    std::vector<uint16_t> offsets[BENCH_ENGINES], end_offsets;
+    int tiles = 0;
+    uint64_t points = 0;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    for (int e = 0; e < BENCH_ENGINES; e++) {
+      BenchTiles& bt = engines[e];
+      bt.tiles.build(bt.next);
+      offsets[e].resize(bt.points.size());
+      bt.tiles.quantize(bt.points.empty() ? NULL : &bt.points[0], bt.points.size() / 2, bt.stride, offsets[e].empty() ? NULL : &offsets[e][0]);
+      if (e == 1) {
+        end_offsets.resize(bt.ends.size());
+        bt.tiles.quantize(bt.ends.empty() ? NULL : &bt.ends[0], bt.ends.size() / 2, bt.stride, end_offsets.empty() ? NULL : &end_offsets[0]);
+      }
+      tiles += bt.tiles.tileCount();
+      points += (bt.points.size() + bt.ends.size()) / 2;
+    }
+
+    double quantize_ms = clock.nsecsElapsed() * 1e-6;
+
+    fprintf(f, "  %s: %d tiles, %llu positions, %.1f KB -> %.1f KB, quantized in %.1f ms\n"
+            , fileList[i].toLatin1().constData(), tiles, (unsigned long long) points
+            , points * 2 * sizeof(float) / 1024.0, points * 2 * sizeof(uint16_t) / 1024.0, quantize_ms);
+
+    // Positions within the views at harbour scale
+    double err_float = 0, err_tiled = 0, sum2_float = 0, sum2_tiled = 0;
+    uint64_t n = 0;
+
+    for (int gy = 0; gy < grid; gy++) {
+      for (int gx = 0; gx < grid; gx++) {
+        ChartView view = benchView(chart, grid, gx, gy, BENCH_TILE_SCALE);
+        double max_m = view.radius_px * view.scale;
+
+        for (int e = 0; e < BENCH_ENGINES; e++)
+          benchTileErrors(engines[e], engines[e].points, offsets[e], view, max_m, &err_float, &err_tiled, &sum2_float, &sum2_tiled, &n);
+        benchTileErrors(engines[1], engines[1].ends, end_offsets, view, max_m, &err_float, &err_tiled, &sum2_float, &sum2_tiled, &n);
+      }
+    }
+
+    fprintf(f, "    %.0f m/px, %llu positions: float error max %.1f cm rms %.1f cm, tiled max %.1f cm rms %.1f cm\n"
+            , BENCH_TILE_SCALE, (unsigned long long) n
+            , 100 * err_float, n > 0 ? 100 * sqrt(sum2_float / n) : 0.0
+            , 100 * err_tiled, n > 0 ? 100 * sqrt(sum2_tiled / n) : 0.0);
+
+    // Draw calls of the batches, split per tile
+    for (size_t s = 0; s < sizeof(scales) / sizeof(scales[0]); s++) {
+      ChartBatch batches[BENCH_ENGINES];
+      uint64_t calls = 0, tiled_calls = 0;
+      double split_ns = 0;
+      int renders = 0;
+
+      for (int gy = 0; gy < grid; gy++) {
+        for (int gx = 0; gx < grid; gx++) {
+          ChartView view = benchView(chart, grid, gx, gy, scales[s]);
+
+          for (int e = 0; e < BENCH_ENGINES; e++)
+            batches[e].clear();
+
+          for (size_t l = 0; l < layers.size(); l++) {
+            int k = layers[l].level(scales[s]);
+            batches[layers[l].engine].add(layers[l].levels[k], layers[l].firsts[k], layers[l].levels[k].vertexCount(), view);
+          }
+
+          clock.restart();
+          for (int e = 0; e < BENCH_ENGINES; e++) {
+            engines[e].tiles.split(batches[e]);
+            tiled_calls += engines[e].tiles.partCount();
+            calls += !batches[e].empty();
+          }
+          split_ns += clock.nsecsElapsed();
+          renders++;
+        }
+      }
+
+      fprintf(f, "    %6.0f m/px: %4.1f batched calls, %6.1f tiled, split %6.1f us\n"
+              , scales[s], (double) calls / renders, (double) tiled_calls / renders, split_ns * 1e-3 / renders);
+    }
+
+    delete chart;
+  }
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include "bench.h"
+
+#include <math.h>
+
+#include "../common/rlimath.h"
+#include "../layers/chartengine.h"
+
+int runChartTransitBench(FILE* f) {
+  const float ranges[] = { 0.25f, 0.5f, 1.f, 2.f, 4.f, 8.f, 16.f };   // Miles to the edge of the circle
+  const int   radius_px = 512;
+  const float speed_kn = 15.f;
+  const float course = 30.f;
+  const float update_s = 0.5f;     // ShipDataSource rate
+  const float transit_s = 3600.f;
+
+  fprintf(f, "Chart renders per minute over a %.0f min transit at %.0f kn, %d px radius, position every %.1f s\n"
+          , transit_s / 60, speed_kn, radius_px, update_s);
+
+  for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+    float scale = ranges[r] * RLIMath::METERS_PER_MILE / radius_px;
+
+    QVector2D start(60.f, 28.f);
+    QVector2D old_center = start, fbo_center = start;
+    int old_renders = 1, fbo_renders = 1;
+    float old_error_px = 0;
+
+    double step_m = speed_kn * RLIMath::METERS_PER_MILE / 3600 * update_s;
+    for (int i = 1; i * update_s <= transit_s; i++) {
+      double north_m = i * step_m * cos(RLIMath::radians(course));
+      double east_m = i * step_m * sin(RLIMath::radians(course));
+      QVector2D center(start.x() + RLIMath::degrees(north_m / RLIMath::EARTH_RADIUS)
+                     , start.y() + RLIMath::degrees(east_m / (RLIMath::EARTH_RADIUS * cos(RLIMath::radians(start.x())))));
+
+      // The former rule: a new render past 0.0005 degrees, the chart lagging until then
+      if (fabs(old_center.x() - center.x()) > 0.0005 || fabs(old_center.y() - center.y()) > 0.0005) {
+        old_center = center;
+        old_renders++;
+      }
+      QPoint lag = chartViewOffset(old_center, QPoint(0, 0), center, QPoint(0, 0), scale);
+      old_error_px = qMax(old_error_px, static_cast<float>(sqrt(lag.x() * lag.x() + lag.y() * lag.y())));
+
+      QPoint offset = chartViewOffset(fbo_center, QPoint(0, 0), center, QPoint(0, 0), scale);
+      if (qAbs(offset.x()) > CE_OVERSCAN_PX || qAbs(offset.y()) > CE_OVERSCAN_PX) {
+        fbo_center = center;
+        fbo_renders++;
+      }
+    }
+
+    fprintf(f, "  %5.2f mi (%6.2f m/px): overscan %6.2f renders/min, former %6.2f renders/min lagging up to %4.0f px\n"
+            , ranges[r], scale, fbo_renders * 60 / transit_s, old_renders * 60 / transit_s, old_error_px);
+  }
+
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include "bench.h"
+#include "../datasources/clutterfilter.h"
+
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+static double elapsedSec(const struct timespec& t1, const struct timespec& t2) {
+  return (double)(t2.tv_sec - t1.tv_sec) + (double)(t2.tv_nsec - t1.tv_nsec) * 1e-9;
+}
+
+int runClutterBench(FILE* f) {
+  const uint32_t brg_size  = 800;
+  const uint32_t brg_count = 8192;
+  const uint32_t revs      = 8;
+  const int      levels[]  = { 0, 64, 128, 255 };
+  const int      nlevels   = sizeof(levels) / sizeof(levels[0]);
+
+  // Sea clutter decaying with range, rain patch and a few point targets
+  std::vector<float> src((size_t)brg_count * brg_size);
+  uint32_t rnd = 1;
+  for (uint32_t b = 0; b < brg_count; b++) {
+    for (uint32_t i = 0; i < brg_size; i++) {
+      rnd = rnd * 1103515245 + 12345;
+      float v = (rnd >> 24) * 0.25f + 200.f * expf(-(float)i / 60.f);
+      if (i > 400 && i < 520 && b > 2000 && b < 2600)
+        v += 80.f;
+      if (i % 97 == 0 && b % 512 < 4)
+        v += 150.f;
+      src[(size_t)b * brg_size + i] = v;
+    }
+  }
+
+  std::vector<float> buf(brg_size);
+  struct timespec t1, t2;
+
+  fprintf(f, "Clutter filter throughput (%u samples per bearing, %u bearings)\n", brg_size, brg_count * revs);
+  fprintf(f, "  wave  rain   ns/bearing   Mbearings/s\n");
+
+  for (int w = 0; w <= nlevels; w++) {
+    for (int r = 0; r < nlevels; r++) {
+      ClutterFilter flt(brg_size);
+      bool changing = (w == nlevels);
+
+      if (changing && r > 0)
+        break;
+
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      for (uint32_t n = 0; n < brg_count * revs; n++) {
+        // Last row changes both controls every 64 bearings
+        if (changing && (n % 64) == 0) {
+          flt.setWave(levels[(n / 64) % nlevels]);
+          flt.setRain(levels[(n / 128) % nlevels]);
+        } else if (!changing && n == 0) {
+          flt.setWave(levels[w]);
+          flt.setRain(levels[r]);
+        }
+
+        const float* p = &src[(size_t)(n % brg_count) * brg_size];
+        for (uint32_t i = 0; i < brg_size; i++)
+          buf[i] = p[i];
+
+        flt.apply(&buf[0]);
+      }
+      clock_gettime(CLOCK_MONOTONIC, &t2);
+
+      double ns = elapsedSec(t1, t2) * 1e9 / (brg_count * revs);
+      if (changing)
+        fprintf(f, "  changing %2s %10.1f %13.2f\n", "", ns, 1e3 / ns);
+      else
+        fprintf(f, "  %4d  %4d %12.1f %13.2f\n", levels[w], levels[r], ns, 1e3 / ns);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,142 @@
+#include "bench.h"
+#include "../datasources/targetassoc.h"
+
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Deterministic pseudo-random values of the bench
+static uint32_t benchRand(uint32_t* s) {
+  *s = *s * 1664525u + 1013904223u;
+  return *s >> 8;
+}
+
+static float benchUnit(uint32_t* s) {
+  return benchRand(s) * (1.f / 16777216.f);
+}
+
+static float benchNoise(uint32_t* s) {
+  return benchUnit(s) + benchUnit(s) + benchUnit(s) - 1.5f;
+}
+
+int runTargetAssocBench(FILE* f) {
+  const uint32_t n_ais    = 2000;
+  const uint32_t n_radar  = 500;
+  const uint32_t n_shared = 400;   // Radar tracks of AIS targets
+  const float    area     = 24.f;  // Miles square
+  const uint32_t passes   = 60;    // One a second
+  const float    lat0     = 60.f;
+  const float    lon0     = 25.f;
+  const double   kx       = TA_MILES_PER_DEGREE * cos(lat0 * M_PI / 180.0);
+
+  struct Truth { float x, y, cog, sog; };
+  std::vector<Truth> ships(n_ais + n_radar - n_shared);
+  uint32_t seed = 12345;
+
+  for (size_t i = 0; i < ships.size(); i++) {
+    ships[i].x   = area * (benchUnit(&seed) - 0.5f);
+    ships[i].y   = area * (benchUnit(&seed) - 0.5f);
+    ships[i].cog = 360.f * benchUnit(&seed);
+    ships[i].sog = (i % 5 == 0) ? 0.f : 4.f + 16.f * benchUnit(&seed);
+  }
+
+  // Ships 0 .. n_ais - 1 send AIS, radar tracks ships from n_ais - n_shared on
+  TargetAssociator assoc;
+  double   t_hash = 0, t_brute = 0;
+  uint64_t right = 0, wrong = 0, missed = 0, flips = 0, stray_flips = 0;
+  uint64_t brute_pairs = 0;
+
+  fprintf(f, "Target association (%u AIS, %u radar tracks, %u of them AIS ships, %.0f x %.0f miles)\n"
+          , n_ais, n_radar, n_shared, area, area);
+
+  for (uint32_t p = 0; p < passes; p++) {
+    double t = 100.0 + p;
+
+    for (size_t i = 0; i < ships.size(); i++) {
+      Truth& s = ships[i];
+      float c = s.cog * (float)M_PI / 180.f;
+      float x = s.x + s.sog * (float)t / 3600.f * sinf(c);
+      float y = s.y + s.sog * (float)t / 3600.f * cosf(c);
+      char  tag[32];
+
+      // AIS every 10 seconds in turn, radar every pass with measurement noise
+      if (i < n_ais && (i + p) % 10 == 0) {
+        TrackReport r = { t, (float)(lat0 + y / TA_MILES_PER_DEGREE), (float)(lon0 + x / kx), s.cog, s.sog };
+        snprintf(tag, sizeof(tag), "AIS_%u", (unsigned)(200000000 + i));
+        assoc.update(TargetAssociator::TA_AIS, tag, r);
+      }
+
+      if (i >= n_ais - n_shared) {
+        float rx = x + 0.05f * benchNoise(&seed);
+        float ry = y + 0.05f * benchNoise(&seed);
+        float rc = fmodf(s.cog + 5.f * benchNoise(&seed) + 360.f, 360.f);
+        float rs = std::max(0.f, s.sog + 1.f * benchNoise(&seed));
+        TrackReport r = { t, (float)(lat0 + ry / TA_MILES_PER_DEGREE), (float)(lon0 + rx / kx), rc, rs };
+        snprintf(tag, sizeof(tag), "%u", (unsigned)(i - (n_ais - n_shared) + 1));
+        assoc.update(TargetAssociator::TA_RADAR, tag, r);
+      }
+    }
+
+    assoc.associate(t);
+    t_hash += assoc.stats().last_us;
+    // Every AIS target has reported after the first 10 passes
+    if (p >= 10) {
+      const std::vector<uint32_t>& changed = assoc.changed(TargetAssociator::TA_RADAR);
+      for (size_t k = 0; k < changed.size(); k++) {
+        if ((uint32_t)atoi(assoc.tag(TargetAssociator::TA_RADAR, changed[k]).c_str()) <= n_shared)
+          flips++;
+        else
+          stray_flips++;
+      }
+    }
+
+    // Every pair compared, same gates
+    uint64_t t1 = nowNs();
+    uint64_t gated = assoc.gatedPairs();
+    t_brute += (nowNs() - t1) / 1e3;
+    brute_pairs += gated;
+  }
+
+  // Radar track k + 1 follows ship n_ais - n_shared + k
+  for (uint32_t k = 0; k < n_radar; k++) {
+    char tag[32];
+    snprintf(tag, sizeof(tag), "%u", k + 1);
+    int r = assoc.find(TargetAssociator::TA_RADAR, tag);
+    int a = assoc.partner(TargetAssociator::TA_RADAR, r);
+    uint32_t ship = n_ais - n_shared + k;
+
+    if (a < 0) {
+      missed += (ship < n_ais);
+      continue;
+    }
+
+    snprintf(tag, sizeof(tag), "AIS_%u", (unsigned)(200000000 + ship));
+    if (assoc.tag(TargetAssociator::TA_AIS, a) == tag)
+      right++;
+    else
+      wrong++;
+  }
+
+  if (brute_pairs != assoc.stats().candidates) {
+    fprintf(f, "  gated pairs differ: %llu hashed, %llu compared all\n"
+            , (unsigned long long)assoc.stats().candidates, (unsigned long long)brute_pairs);
+    return -1;
+  }
+
+  fprintf(f, "  spatial hash:   %8.1f us per pass\n", t_hash / passes);
+  fprintf(f, "  every pair:     %8.1f us per pass (gates only)\n", t_brute / passes);
+  fprintf(f, "  associated: %llu right, %llu wrong, %llu AIS ships missed\n"
+          , (unsigned long long)right, (unsigned long long)wrong, (unsigned long long)missed);
+  fprintf(f, "  partner changes once all AIS reported: %llu of AIS ship tracks, %llu of radar-only tracks\n"
+          , (unsigned long long)flips, (unsigned long long)stray_flips);
+  fprintf(f, "  ");
+  assoc.printStats(f);
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "../datasources/gainestimator.h"
+
+#include <time.h>
+#include <vector>
+
+static double elapsedNs(const struct timespec& t1, const struct timespec& t2) {
+  return (double)(t2.tv_sec - t1.tv_sec) * 1e9 + (double)(t2.tv_nsec - t1.tv_nsec);
+}
+
+int runGainEstimatorBench(FILE* f) {
+  const uint32_t brg_count = 8192;
+  const uint32_t brg_size  = 800;
+  const uint32_t revs      = 8;
+
+  // Rayleigh-like noise around 20 with a few strong returns
+  std::vector<uint32_t> src((size_t)brg_count * brg_size);
+  uint32_t rnd = 7;
+  for (size_t i = 0; i < src.size(); i++) {
+    rnd = rnd * 1103515245 + 12345;
+    uint32_t v = 10 + ((rnd >> 16) % 21);
+    if ((rnd >> 8) % 200 == 0)
+      v += 150 + (rnd >> 24) % 300;
+    src[i] = v;
+  }
+
+  GainEstimator est(brg_count, 255);
+  std::vector<uint32_t> buf(brg_size);
+  struct timespec t1, t2;
+  double copy_ns = 0, hist_ns = 0;
+
+  for (uint32_t n = 0; n < brg_count * revs; n++) {
+    uint32_t brg = n % brg_count;
+    const uint32_t* p = &src[(size_t)brg * brg_size];
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    std::copy(p, p + brg_size, buf.begin());
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    copy_ns += elapsedNs(t1, t2);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    est.addBearing(brg, &buf[0], brg_size);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    hist_ns += elapsedNs(t1, t2);
+  }
+
+  fprintf(f, "Gain estimator: %u bearings of %u samples\n", brg_count * revs, brg_size);
+  fprintf(f, "  histogram pass %.1f ns per bearing (bearing copy %.1f ns for comparison)\n"
+          , hist_ns / (brg_count * revs), copy_ns / (brg_count * revs));
+  fprintf(f, "  ");
+  est.printEstimate(f);
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "bench.h"
+#include "../datasources/guardzone.h"
+
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+static double elapsedNs(const struct timespec& t1, const struct timespec& t2) {
+  return (double)(t2.tv_sec - t1.tv_sec) * 1e9 + (double)(t2.tv_nsec - t1.tv_nsec);
+}
+
+int runGuardZoneBench(FILE* f) {
+  const uint32_t brg_count = 8192;
+  const uint32_t brg_size  = 800;
+  const uint32_t revs      = 4;
+  const int      counts[]  = { 1, 4, 16, 32, 64 };
+
+  // Noise below the threshold everywhere: the worst case, nothing exits early
+  std::vector<float> amps((size_t)brg_count * brg_size);
+  uint32_t rnd = 3;
+  for (size_t i = 0; i < amps.size(); i++) {
+    rnd = rnd * 1103515245 + 12345;
+    amps[i] = (float)((rnd >> 16) % 100);
+  }
+
+  fprintf(f, "Guard zone evaluation (%u bearings of %u samples, threshold 128)\n", brg_count * revs, brg_size);
+  fprintf(f, "  zones  intervals  samples/bearing  ns/bearing  build ms\n");
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    std::vector<GuardZone> zones(counts[c]);
+
+    // Half sectors, half polygons, scattered within 6 miles
+    for (int z = 0; z < counts[c]; z++) {
+      GuardZone& gz = zones[z];
+      float a = z * 137.5f;
+      if (z % 2 == 0) {
+        gz.type     = GuardZone::GZ_SECTOR;
+        gz.brg_from = fmodf(a, 360.f);
+        gz.brg_to   = fmodf(a + 20.f, 360.f);
+        gz.rng_from = 1.f + (z % 5);
+        gz.rng_to   = gz.rng_from + 1.f;
+      } else {
+        gz.type = GuardZone::GZ_POLYGON;
+        float cx = 3.f * sinf(a * (float)M_PI / 180.f), cy = 3.f * cosf(a * (float)M_PI / 180.f);
+        float p[] = { cx - .5f, cy - .5f, cx + .5f, cy - .3f, cx + .4f, cy + .6f, cx - .6f, cy + .4f };
+        gz.poly.assign(p, p + 8);
+      }
+    }
+
+    GuardZones gzs(brg_count, brg_size);
+    struct timespec t1, t2;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    gzs.setScale(6.f);
+    gzs.setZones(zones);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    double build_ms = elapsedNs(t1, t2) * 1e-6;
+
+    gzs.test(0, &amps[0]); // Pick up the table
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    for (uint32_t n = 0; n < brg_count * revs; n++) {
+      uint32_t b = n % brg_count;
+      gzs.test(b, &amps[(size_t)b * brg_size]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    const GuardZoneTable* t = gzs.table();
+    uint64_t samples = 0;
+    for (size_t i = 0; i < t->intervals.size(); i++)
+      samples += t->intervals[i].to - t->intervals[i].from;
+
+    fprintf(f, "  %5d  %9lu  %15.1f  %10.1f  %8.1f\n", counts[c], (unsigned long)t->intervals.size()
+            , (double)samples / brg_count, elapsedNs(t1, t2) / (brg_count * revs), build_ms);
+  }
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include "bench.h"
+#include "../datasources/landmask.h"
+
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+static double elapsedNs(const struct timespec& t1, const struct timespec& t2) {
+  return (double)(t2.tv_sec - t1.tv_sec) * 1e9 + (double)(t2.tv_nsec - t1.tv_nsec);
+}
+
+int runLandMaskBench(FILE* f) {
+  const uint32_t brg_count = 8192;
+  const uint32_t brg_size  = 800;
+  const float    lat0      = 60.f;
+  const float    lon0      = 25.f;
+  const float    scales[]  = { 0.25f, 1.f, 3.f, 12.f, 24.f, 48.f };
+
+  // Island coast on a 0.01 degree grid, two triangles per land cell
+  const float cell = 0.01f;
+  const int   n    = 300;
+  std::vector<float> land;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      float la = lat0 - n * cell / 2 + i * cell;
+      float lo = lon0 - n * cell + j * cell * 2;
+      float h = sinf(i * 0.07f) + cosf(j * 0.05f) + 0.5f * sinf((i + j) * 0.13f);
+      if (h < -0.4f || (abs(i - n/2) < 2 && abs(j - n/2) < 2))
+        continue;
+
+      float t[] = { la, lo, la, lo + cell * 2, la + cell, lo + cell * 2
+                  , la, lo, la + cell, lo + cell * 2, la + cell, lo };
+      land.insert(land.end(), t, t + 12);
+    }
+  }
+
+  std::vector<float> amps((size_t)brg_count * brg_size, 100.f);
+
+  fprintf(f, "Land mask (%lu land triangles, %u bearings of %u samples)\n", (unsigned long)(land.size() / 6), brg_count, brg_size);
+  fprintf(f, "  range mi  triangles  land %%  build ms  ns/bearing\n");
+
+  for (size_t s = 0; s < sizeof(scales) / sizeof(scales[0]); s++) {
+    LandMask lm(brg_count, brg_size);
+    lm.setEnabled(true);
+    lm.setHeading(30.f);
+
+    struct timespec t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    LandMaskTable* t = lm.build(land, lat0, lon0, scales[s]);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    double build_ms = elapsedNs(t1, t2) * 1e-6;
+
+    uint32_t tris = t->triangles;
+    double land_pct = 100.0 * t->land / ((double)brg_count * brg_size);
+    delete t;
+
+    // The same table through the rebuild path, picked up by the first apply()
+    lm.addAreas(land);
+    lm.setPosition(lat0, lon0);
+    lm.setScale(scales[s]);
+    if (lm.startRebuild())
+      lm.rebuild();
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    for (uint32_t b = 0; b < brg_count; b++)
+      lm.apply(b, &amps[(size_t)b * brg_size]);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    fprintf(f, "  %8.2f  %9u  %6.1f  %8.1f  %10.1f\n", scales[s], tris, land_pct, build_ms, elapsedNs(t1, t2) / brg_count);
+  }
+
+  return 0;
+}
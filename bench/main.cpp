@@ -0,0 +1,101 @@
+#include "bench.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+static void usage(FILE* f, const char* name) {
+  fprintf(f, "Usage: %s <run>\n", name);
+  fprintf(f, "  --bearing-feeder[=seed]\n");
+  fprintf(f, "  --clutter-bench\n");
+  fprintf(f, "  --gain-bench\n");
+  fprintf(f, "  --guard-bench\n");
+  fprintf(f, "  --landmask-bench\n");
+  fprintf(f, "  --cat240-bench\n");
+  fprintf(f, "  --cat240-load\n");
+  fprintf(f, "  --regq-bench\n");
+  fprintf(f, "  --azimuth-bench\n");
+  fprintf(f, "  --scene-bench\n");
+  fprintf(f, "  --fusion-bench\n");
+  fprintf(f, "  --rotation-bench\n");
+  fprintf(f, "  --triangulate-check\n");
+  fprintf(f, "  --triangulate-bench\n");
+  fprintf(f, "  --chart-load-bench\n");
+  fprintf(f, "  --chart-cache-build[=dir]\n");
+  fprintf(f, "  --chart-cull-bench\n");
+  fprintf(f, "  --chart-lod-bench\n");
+  fprintf(f, "  --chart-transit-bench\n");
+  fprintf(f, "  --chart-memory-bench\n");
+  fprintf(f, "  --chart-tile-bench\n");
+}
+
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--bearing-feeder", 16) == 0) {
+      uint32_t seed = (argv[i][16] == '=') ? strtoul(&argv[i][17], NULL, 10) : 1;
+      return runBearingFeeder(stdout, seed);
+    }
+
+    if (strcmp(argv[i], "--clutter-bench") == 0)
+      return runClutterBench(stdout);
+
+    if (strcmp(argv[i], "--gain-bench") == 0)
+      return runGainEstimatorBench(stdout);
+
+    if (strcmp(argv[i], "--guard-bench") == 0)
+      return runGuardZoneBench(stdout);
+
+    if (strcmp(argv[i], "--landmask-bench") == 0)
+      return runLandMaskBench(stdout);
+
+    if (strcmp(argv[i], "--cat240-bench") == 0)
+      return runCat240Bench(stdout);
+
+    if (strcmp(argv[i], "--cat240-load") == 0)
+      return runCat240LoadTest(stdout);
+
+    if (strcmp(argv[i], "--regq-bench") == 0)
+      return runRegQueueBench(stdout);
+
+    if (strcmp(argv[i], "--azimuth-bench") == 0)
+      return runAzimuthStabBench(stdout);
+
+    if (strcmp(argv[i], "--scene-bench") == 0)
+      return runRadarSceneBench(stdout);
+
+    if (strcmp(argv[i], "--fusion-bench") == 0)
+      return runTargetAssocBench(stdout);
+
+    if (strcmp(argv[i], "--rotation-bench") == 0)
+      return runRotationBench(stdout);
+
+    if (strcmp(argv[i], "--triangulate-check") == 0)
+      return runTriangulateCheck(stdout);
+
+    if (strcmp(argv[i], "--triangulate-bench") == 0)
+      return runTriangulateBench(stdout);
+
+    if (strcmp(argv[i], "--chart-load-bench") == 0)
+      return runChartLoadBench(stdout);
+
+    if (strncmp(argv[i], "--chart-cache-build", 19) == 0)
+      return runChartCacheBuild(stdout, (argv[i][19] == '=') ? &argv[i][20] : "res/charts");
+
+    if (strcmp(argv[i], "--chart-cull-bench") == 0)
+      return runChartCullBench(stdout);
+
+    if (strcmp(argv[i], "--chart-lod-bench") == 0)
+      return runChartLodBench(stdout);
+
+    if (strcmp(argv[i], "--chart-transit-bench") == 0)
+      return runChartTransitBench(stdout);
+
+    if (strcmp(argv[i], "--chart-memory-bench") == 0)
+      return runChartMemoryBench(stdout);
+
+    if (strcmp(argv[i], "--chart-tile-bench") == 0)
+      return runChartTileBench(stdout);
+  }
+
+  usage(stderr, argv[0]);
+  return 2;
+}
@@ -0,0 +1,129 @@
+#include "bench.h"
+#include "../datasources/regqueue.h"
+
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Card with ioctl cost and SPI transfers taking a fixed time
+class SimulatedCard : public RegisterIo {
+public:
+  SimulatedCard(uint32_t io_ns, uint32_t spi_ns) : _io_ns(io_ns), _spi_ns(spi_ns), _spi_start(0), writes(0) {
+    memset(_regs, 0, sizeof(_regs));
+  }
+
+  int regwr(uint32_t addr, uint32_t val) {
+    spin(_io_ns);
+    _regs[addr & 0xFF] = val & ~RQ_SPI_BUSY;
+    _spi_start = nowNs();
+    writes++;
+    return 0;
+  }
+
+  int regrd(uint32_t addr, uint32_t* val) {
+    spin(_io_ns);
+    *val = _regs[addr & 0xFF];
+    if (nowNs() - _spi_start >= _spi_ns)
+      *val |= RQ_SPI_BUSY;
+    return 0;
+  }
+
+private:
+  static void spin(uint32_t ns) {
+    uint64_t end = nowNs() + ns;
+    while (nowNs() < end)
+      ;
+  }
+
+  uint32_t _regs[256];
+  uint32_t _io_ns;
+  uint32_t _spi_ns;
+  uint64_t _spi_start;
+
+public:
+  uint64_t writes;
+};
+
+static void sleepUs(uint32_t us) {
+  struct timespec ts = { 0, (long)us * 1000 };
+  nanosleep(&ts, NULL);
+}
+
+int runRegQueueBench(FILE* f) {
+  const uint32_t io_ns    = 2000;    // One register ioctl
+  const uint32_t spi_ns   = 50000;   // SPI transfer
+  const uint32_t batch_us = 250;     // Acquisition thread wakes up per DMA batch
+  const uint32_t changes  = 200;
+
+  fprintf(f, "Register queue (ioctl %u us, SPI transfer %u us, acquisition pass every %u us)\n"
+          , io_ns / 1000, spi_ns / 1000, batch_us);
+
+  // Scale change as setupScale did it: the caller waits for the SPI transfer
+  {
+    SimulatedCard card(io_ns, spi_ns);
+    uint64_t t1 = nowNs();
+    for (uint32_t i = 0; i < changes; i++) {
+      uint32_t v = 0;
+      card.regwr(0x04, i);
+      card.regwr(0x2c, 0x1f0024);
+      do { card.regrd(0x2c, &v); } while (!(v & RQ_SPI_BUSY));
+      card.regwr(0x2c, 0x1f4007);
+      do { card.regrd(0x2c, &v); } while (!(v & RQ_SPI_BUSY));
+    }
+    fprintf(f, "  synchronous scale change: caller blocked %.1f us\n", (nowNs() - t1) * 1e-3 / changes);
+  }
+
+  // Same through the queue, serviced by a simulated acquisition thread
+  {
+    SimulatedCard card(io_ns, spi_ns);
+    RegisterQueue q(&card);
+    std::atomic<bool> stop(false);
+
+    std::thread acq([&]() {
+      RegResult r;
+      while (!stop.load()) {
+        sleepUs(batch_us);
+        q.service();
+        while (q.takeResult(&r))
+          ;
+      }
+    });
+
+    double submit_ns = 0;
+    for (uint32_t i = 0; i < changes; i++) {
+      uint64_t t1 = nowNs();
+      q.write(0x04, i, "PKID and PKOD");
+      q.spi(0x2c, 0x1f0024, 0x1f4007, "frequency");
+      submit_ns += nowNs() - t1;
+      sleepUs(1000);
+    }
+
+    // Heading sentences faster than the passes: only the latest value is written
+    uint64_t writes = card.writes;
+    for (uint32_t i = 0; i < 1000; i++) {
+      q.write(0x4c, i, "gyro", true);
+      sleepUs(20);
+    }
+
+    while (q.stats().completed < q.stats().submitted)
+      sleepUs(1000);
+    stop.store(true);
+    acq.join();
+
+    RegQueueStats st = q.stats();
+    fprintf(f, "  queued scale change: caller blocked %.1f us\n", submit_ns * 1e-3 / changes);
+    fprintf(f, "  1000 heading writes: %llu coalesced, %llu register writes\n"
+            , (unsigned long long)st.coalesced, (unsigned long long)(card.writes - writes));
+    fprintf(f, "  ");
+    q.printStats(f);
+  }
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include "bench.h"
+#include "../datasources/rotationrate.h"
+
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// One simulated antenna, wobble is the rate variation as a fraction
+static int benchRotation(FILE* f, double wobble) {
+  const uint32_t brg_count = 8192;
+  const double   rpm       = 24.0;
+  const double   wobble_s  = 25.0;   // Variation period
+  const double   late_us   = 100.0;  // Batch completion seen up to this late, uniform
+  const uint32_t revs      = 50;
+
+  RotationEstimator est(brg_count);
+  std::vector<uint64_t> stamps(64);
+
+  double   err_sum = 0, err_max = 0, jit_sum = 0;
+  uint32_t checked = 0;
+  uint64_t batches = 0, bearings = 0;
+  double   add_ns = 0, stamp_ns = 0;
+  uint32_t seed = 1;
+
+  // Bearing b is reached at the time integrating the varying rate
+  double   t_s = 1.0;
+  uint32_t brg = 0;
+  uint64_t total = 0;
+
+  fprintf(f, "Rotation estimator (%.0f rpm +- %.1f%%, batch completion up to %.0f us late, batches of 16..48 bearings)\n"
+          , rpm, wobble * 100, late_us);
+
+  while (total < (uint64_t)revs * brg_count) {
+    seed = seed * 1664525u + 1013904223u;
+    uint32_t n = 16 + (seed >> 8) % 33;
+
+    double rate = rpm / 60.0 * brg_count * (1.0 + wobble * sin(2 * M_PI * t_s / wobble_s));
+    t_s   += n / rate;
+    brg    = (brg + n) % brg_count;
+    total += n;
+
+    seed = seed * 1664525u + 1013904223u;
+    double late = late_us * 1e-6 * ((seed >> 8) * (1.0 / 16777216.0));
+    uint64_t t_ns = (uint64_t)((t_s + late) * 1e9);
+
+    uint64_t t1 = nowNs();
+    uint64_t step = est.bearingStep();
+    for (uint32_t i = 0; i < n; i++)
+      stamps[i] = t_ns - (n - 1 - i) * step;
+    uint64_t t2 = nowNs();
+    bool rev = est.addBatch(t_ns, brg);
+    uint64_t t3 = nowNs();
+
+    stamp_ns += t2 - t1;
+    add_ns   += t3 - t2;
+    batches++;
+    bearings += n;
+
+    // Rate at the middle of the revolution just finished
+    if (rev && est.rate().revolutions > 1) {
+      RotationRate r = est.rate();
+      double mid = t_s - r.period_ms * 0.5e-3;
+      double truth = rpm * (1.0 + wobble * sin(2 * M_PI * mid / wobble_s));
+      double e = fabs(r.rpm - truth);
+
+      err_sum += e;
+      jit_sum += r.jitter_us;
+      if (e > err_max)
+        err_max = e;
+      checked++;
+    }
+  }
+
+  if (checked == 0)
+    return -1;
+
+  // Speed variation within a revolution counts as jitter too
+  fprintf(f, "  rpm error: mean %.4f, max %.4f\n", err_sum / checked, err_max);
+  fprintf(f, "  jitter: %.1f us measured, %.1f us injected (RMS of uniform lateness)\n"
+          , jit_sum / checked, late_us / sqrt(12.0));
+  fprintf(f, "  cost: %.1f ns per batch, %.2f ns per bearing stamped\n", add_ns / batches, stamp_ns / bearings);
+  fprintf(f, "  ");
+  est.printStats(f);
+
+  return 0;
+}
+
+int runRotationBench(FILE* f) {
+  if (benchRotation(f, 0) != 0)
+    return -1;
+  return benchRotation(f, 0.005);
+}
@@ -0,0 +1,109 @@
+#include "bench.h"
+#include "../datasources/radarscene.h"
+#include "../datasources/clutterfilter.h"
+#include "../datasources/gainestimator.h"
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+static double elapsedNs(const struct timespec& t1, const struct timespec& t2) {
+  return (double)(t2.tv_sec - t1.tv_sec) * 1e9 + (double)(t2.tv_nsec - t1.tv_nsec);
+}
+
+int runRadarSceneBench(FILE* f) {
+  const uint32_t brg_count = 8192;
+  const uint32_t brg_size  = 800;
+  const float    range     = 6.f;
+  const float    lat       = 60.f;
+  const float    lon       = 30.f;
+
+  // An island two to four miles to the north-east
+  std::vector<float> island;
+  const float d = 1.f / LM_MILES_PER_DEGREE;
+  const float e = d / cosf(lat * (float)M_PI / 180.f);
+  const float sq[] = { 2.f, 2.f,  2.f, 4.f,  4.f, 4.f,   2.f, 2.f,  4.f, 4.f,  4.f, 2.f };
+  for (size_t i = 0; i < sizeof(sq) / sizeof(sq[0]); i += 2) {
+    island.push_back(lat + sq[i] * d);
+    island.push_back(lon + sq[i + 1] * e);
+  }
+
+  fprintf(f, "Radar scene (%u x %u, %.0f miles, ns per bearing)\n", brg_count, brg_size, range);
+  fprintf(f, "  scene     generate  cached  amplify  cached  clutter  gain est  checksum\n");
+
+  std::vector<float>    famps(brg_size);
+  std::vector<uint32_t> iamps(brg_size);
+
+  for (const RadarSceneConfig* cfg = radarScenes; cfg->name != NULL; cfg++) {
+    if (cfg->rpm == 0.f)
+      continue;  // Same picture as the scene it floods
+
+    RadarScene scene(brg_count, brg_size, *cfg, 1);
+    scene.setRange(range);
+    scene.setPosition(lat, lon);
+    scene.addLand(island);
+
+    uint32_t n = cfg->loop * brg_count;
+    double   t[4];
+    uint32_t sum = 0;
+    struct timespec t1, t2;
+
+    for (int pass = 0; pass < 4; pass++) {
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      for (uint32_t i = 0; i < n; i++) {
+        const uint8_t* a = (pass < 2) ? scene.raw(i / brg_count, i % brg_count)
+                                      : scene.amplified(i / brg_count, i % brg_count, 100, 255);
+        if (pass == 0)
+          for (uint32_t j = 0; j < brg_size; j++)
+            sum = sum * 31 + a[j];
+      }
+      clock_gettime(CLOCK_MONOTONIC, &t2);
+      t[pass] = elapsedNs(t1, t2) / n;
+    }
+
+    // Processing stages fed with the scene
+    ClutterFilter clutter(brg_size);
+    clutter.setWave(128);
+    clutter.setRain(128);
+    GainEstimator gain_est(brg_count, 255);
+
+    double t_clutter = 0, t_gain = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      const uint8_t* a = scene.raw(i / brg_count, i % brg_count);
+      for (uint32_t j = 0; j < brg_size; j++) {
+        famps[j] = a[j];
+        iamps[j] = a[j];
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      clutter.apply(&famps[0]);
+      clock_gettime(CLOCK_MONOTONIC, &t2);
+      t_clutter += elapsedNs(t1, t2);
+
+      gain_est.addBearing(i % brg_count, &iamps[0], brg_size);
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      t_gain += elapsedNs(t2, t1);
+    }
+
+    fprintf(f, "  %-8s  %8.0f  %6.0f  %7.0f  %6.0f  %7.0f  %8.0f  %08x\n", cfg->name
+            , t[0], t[1], t[2], t[3], t_clutter / n, t_gain / n, sum);
+
+    // Same seed, same picture whatever the order bearings are asked in
+    RadarScene again(brg_count, brg_size, *cfg, 1);
+    again.setRange(range);
+    again.setPosition(lat, lon);
+    again.addLand(island);
+
+    std::vector<uint8_t> a(brg_size);
+    for (uint32_t i = n; i-- > 0; i -= std::min(i, 997u)) {
+      again.generate(i / brg_count, i % brg_count, &a[0]);
+      if (memcmp(&a[0], scene.raw(i / brg_count, i % brg_count), brg_size) != 0) {
+        fprintf(f, "  %s: bearing %u of revolution %u differs\n", cfg->name, i % brg_count, i / brg_count);
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
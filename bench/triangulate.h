@@ -16,6 +16,7 @@
 #include <sys/types.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <vector>
 
 //    Short section from old interface.h
 #ifndef TRUE
@@ -101,64 +102,90 @@ typedef struct {
 
 
 
-//    Integer types
-
-typedef struct {
-      int x, y;
-} ipoint_t, ivector_t;
-
-/* Trapezoid attributes */
-typedef struct {
-      int lseg, rseg;       /* two adjoining segments */
-      ipoint_t hi, lo;       /* max/min y-values */
-      int u0, u1;
-      int d0, d1;
-      int sink;             /* pointer to corresponding in Q */
-      int usave, uside;           /* I forgot what this means */
-      int state;
-      int inside;
-      int ase;                // TODO remove debug
-} itrap_t;
-
-/* Segment attributes */
-typedef struct {
-      ipoint_t v0, v1;       /* two endpoints */
-      int is_inserted;            /* inserted in trapezoidation yet ? */
-      int root0, root1;           /* root nodes in Q */
-      int next;             /* Next logical segment */
-      int prev;             /* Previous segment */
-} isegment_t;
-
-
-
-
-typedef struct {
-      int nodetype;               /* Y-node or S-node */
-      int segnum;
-      ipoint_t yval;
-      int trnum;
-      int parent;                 /* doubly linked DAG */
-      int left, right;            /* children */
-} inode_t;
-
-
-
-
-#ifdef __cplusplus
-extern "C" polyout *triangulate_polygon(int, int[], double (*)[2]);
-extern "C" int int_trapezate_polygon(int, int[], double (*)[2], itrap_t **, isegment_t **, int *);
-#else /* __cplusplus */
-extern polyout *triangulate_polygon(int, int[], double (*)[2]);
-extern int int_trapezate_polygon(int, int[], double (*)[2], itrap_t **, isegment_t **, int *);
-#endif
-
-//extern int triangulate_polygon(int, int *, double (*)[2], int (*)[3]);
-extern int is_point_inside_polygon(double *);
-//extern polyout *trapezate_polygon(int, int *, double (*)[2]);
-
-polyout  *do_triangulate_polygon(int ncontours, int cntr[], double (*vertices)[2]);
-
-
+//    Scratch memory and state of the triangulation. A context is owned by
+//    the caller and reused for any number of polygons, its tables only grow.
+//    One context serves one thread at a time, polygons are triangulated
+//    concurrently on separate contexts.
+
+class TriangulateContext {
+public:
+  TriangulateContext();
+  ~TriangulateContext();
+
+  //    Same input and output as triangulate_polygon(). Degenerate input
+  //    gives NULL instead of faulting
+  polyout *triangulate(int ncontours, int cntr[], double (*vertices)[2]);
+
+  //    Point location in the polygon triangulated last
+  int is_point_inside_polygon(double vertex[2]);
+
+private:
+  void alloc_mem(int ncontours, int contours[]);
+  int initialise(int n);
+  int generate_random_ordering(int n);
+  int choose_segment(void);
+
+  //    Trapezoidation
+  int newnode(void);
+  int newtrap(void);
+  int init_query_structure(int segnum);
+  int is_left_of(int segnum, point_t *v);
+  int inserted(int segnum, int whichpt);
+  int locate_endpoint(point_t *v, point_t *vo, int r);
+  int merge_trapezoids(int segnum, int tfirst, int tlast, int side);
+  int add_segment(int segnum);
+  int find_new_roots(int segnum);
+  int construct_trapezoids(int nseg);
+
+  //    Monotone polygons
+  int inside_polygon(trap_t *t);
+  int newmon(void);
+  int new_chain_element(void);
+  int get_vertex_positions(int v0, int v1, int *ip, int *iq);
+  int make_new_monotone_poly(int mcur, int v0, int v1);
+  int monotonate_trapezoids(int n);
+  int traverse_polygon(int mcur, int trnum, int from, int dir);
+  int triangulate_monotone_polygons(int nvert, int nmonpoly, int op[][3]);
+  int triangulate_single_polygon(int nvert, int vcount, int posmax, int side, int op[][3]);
+
+  //    Tables addressed from index -1 into their storage
+  segment_t *seg;                       /* Segment table */
+  trap_t *tr;                           /* Trapezoid structure */
+  node_t *qs;                           /* Query structure */
+  monchain_t *mchain;                   /* Monotone polygons, circularly linked lists */
+  vertexchain_t *vert;                  /* Chain init. information */
+  int *mon;                             /* Position of any vertex in a monotone chain */
+  int *visited;
+
+  std::vector<segment_t> seg_mem;
+  std::vector<trap_t> tr_mem;
+  std::vector<node_t> qs_mem;
+  std::vector<monchain_t> mchain_mem;
+  std::vector<vertexchain_t> vert_mem;
+  std::vector<int> mon_mem;
+  std::vector<int> visited_mem;
+
+  std::vector<int> permute;
+  std::vector<int> triangles;
+  std::vector<int> rc;                  /* Reflex chain */
+
+  int q_idx, tr_idx;
+  int chain_idx, op_idx, mon_idx;
+  int choose_idx;
+  int seg_size;                         /* Segments the tables are sized for */
+  int nrecurse;                         /* Depth of locate_endpoint() */
+  int g_bug;                            /* Inconsistent structure, the result is dropped */
+
+  TriangulateContext(const TriangulateContext&);
+  TriangulateContext& operator=(const TriangulateContext&);
+};
+
+
+//    Triangulation on a temporary context
+polyout *triangulate_polygon(int ncontours, int cntr[], double (*vertices)[2]);
+
+//    Releases a list returned by triangulate_polygon()
+void free_polyout(polyout *top);
 
 
 /* Node types */
@@ -218,40 +245,11 @@ polyout  *do_triangulate_polygon(int ncontours, int cntr[], double (*vertices)[2
 #define FP_EQUAL(s, t) (fabs(s - t) <= C_EPS)
 
 
-/* Global variables */
-
-//extern node_t qs[QSIZE];            /* Query structure */
-//extern trap_t tr[TRSIZE];           /* Trapezoid structure */
-//extern segment_t seg[SEGSIZE];            /* Segment table */
-
-
-/* Functions */
-
-extern int monotonate_trapezoids(int);
-extern int triangulate_monotone_polygons(int, int, int (*)[3]);
+/* Point comparisons with C_EPS tolerance */
 
 extern int _greater_than(point_t *, point_t *);
 extern int _equal_to(point_t *, point_t *);
 extern int _greater_than_equal_to(point_t *, point_t *);
 extern int _less_than(point_t *, point_t *);
-extern int locate_endpoint(point_t *, point_t *, int);
-extern int construct_trapezoids(int);
-
-extern int generate_random_ordering(int);
-extern int choose_segment(void);
-extern int read_segments(char *, int *);
-extern int math_logstar_n(int);
-extern int math_N(int, int);
-
-#if __GNUC__ == 5
-extern inline int int_greater_than(ipoint_t *v0, ipoint_t *v1);
-extern inline int int_equal_to(ipoint_t *v0, ipoint_t *v1);
-extern inline int int_greater_than_equal_to(ipoint_t *v0, ipoint_t *v1);
-extern inline int int_less_than(ipoint_t *v0, ipoint_t *v1);
-#ifndef __clang__
-extern inline int int_locate_endpoint_a(ipoint_t *v, ipoint_t *vo, int r);
-#endif
-extern inline int int_locate_endpoint(ipoint_t *v, ipoint_t *vo, int r);
-#endif
 
 #endif /* triangulate_h */
@@ -0,0 +1,149 @@
+#include "bench.h"
+#include "benchcharts.h"
+#include "triangulate.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../common/earclip.h"
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Area of the polygon minus its holes, taken relative to the first vertex
+// as chart coordinates are large next to small polygons
+static double polygonArea(const TriangulateInput& in) {
+  double ox = in.geoPt[1].x, oy = in.geoPt[1].y;
+  double total = 0;
+  int first = 1;
+
+  for (size_t c = 0; c < in.cntr.size(); c++) {
+    double s = 0;
+    for (int k = 0; k < in.cntr[c]; k++) {
+      const ContourPoint& a = in.geoPt[first + k];
+      const ContourPoint& b = in.geoPt[first + (k + 1) % in.cntr[c]];
+      s += (a.x - ox) * (b.y - oy) - (b.x - ox) * (a.y - oy);
+    }
+    total += (c == 0) ? fabs(s) / 2 : -fabs(s) / 2;
+    first += in.cntr[c];
+  }
+
+  return total;
+}
+
+static double trianglesArea(const TriangulateInput& in, const std::vector<int>& tris) {
+  double total = 0;
+  for (size_t k = 0; k + 2 < tris.size(); k += 3) {
+    const ContourPoint& a = in.geoPt[tris[k]];
+    const ContourPoint& b = in.geoPt[tris[k + 1]];
+    const ContourPoint& c = in.geoPt[tris[k + 2]];
+    total += fabs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) / 2;
+  }
+  return total;
+}
+
+struct TriangulateRun {
+  uint64_t ns;
+  size_t   triangles;
+  size_t   rejected;
+  size_t   uncovered;   // Polygons whose triangles do not add up to their area
+};
+
+static void printRun(FILE* f, const char* name, const TriangulateRun& r, uint64_t read_ns) {
+  fprintf(f, "  %-8s %7u triangles in %8.1f ms, %6.2f M triangles/s, %u rejected, %u uncovered, load %.1f ms\n"
+          , name, (uint)r.triangles, r.ns * 1e-6, r.ns ? r.triangles * 1e3 / r.ns : 0
+          , (uint)r.rejected, (uint)r.uncovered, (read_ns + r.ns) * 1e-6);
+}
+
+int runTriangulateBench(FILE* f) {
+  QDir dir("res/charts");
+  QStringList fileList = chartFiles(dir);
+  if (fileList.count() == 0) {
+    fprintf(f, "No charts found in %s\n", dir.path().toLatin1().constData());
+    return -1;
+  }
+
+  fprintf(f, "Area triangulation of %s: Seidel trapezoidation against ear clipping\n", dir.path().toLatin1().constData());
+
+  TriangulateContext ctx;
+  EarClipper clipper;
+  std::vector<int> tris;
+
+  TriangulateRun seidel_total  = { 0, 0, 0, 0 };
+  TriangulateRun earclip_total = { 0, 0, 0, 0 };
+  uint64_t read_total = 0;
+
+  for (int i = 0; i < fileList.count(); i++) {
+    QByteArray path = (dir.path() + "/" + fileList[i]).toLatin1();
+    std::vector<TriangulateInput> inputs;
+
+    uint64_t t0 = nowNs();
+    if (!readChartPolygons(path, inputs)) {
+      fprintf(f, "Cannot open %s\n", path.constData());
+      return -1;
+    }
+    uint64_t read_ns = nowNs() - t0;
+
+    TriangulateRun seidel  = { 0, 0, 0, 0 };
+    TriangulateRun earclip = { 0, 0, 0, 0 };
+
+    for (size_t j = 0; j < inputs.size(); j++) {
+      TriangulateInput& in = inputs[j];
+      double area = polygonArea(in);
+
+      uint64_t t1 = nowNs();
+      polyout* polys = ctx.triangulate(in.cntr.size(), &in.cntr[0], (double (*)[2])&in.geoPt[0]);
+      uint64_t t2 = nowNs();
+
+      bool rejected = (polys == NULL);
+      tris.clear();
+      for (polyout* pck = polys; pck != NULL; pck = (polyout *)pck->poly_next)
+        if (pck->is_valid && pck->nvert == 3)
+          tris.insert(tris.end(), pck->vertex_index_list, pck->vertex_index_list + 3);
+      free_polyout(polys);
+
+      seidel.ns += t2 - t1;
+      seidel.triangles += tris.size() / 3;
+      if (rejected)
+        seidel.rejected++;
+      else if (fabs(trianglesArea(in, tris) - area) > area * 1e-6)
+        seidel.uncovered++;
+
+      tris.clear();
+      uint64_t t3 = nowNs();
+      int count = clipper.triangulate(in.cntr.size(), &in.cntr[0], (const double (*)[2])&in.geoPt[0], tris);
+      uint64_t t4 = nowNs();
+
+      earclip.ns += t4 - t3;
+      earclip.triangles += tris.size() / 3;
+      if (count < 0)
+        earclip.rejected++;
+      else if (fabs(trianglesArea(in, tris) - area) > area * 1e-6)
+        earclip.uncovered++;
+    }
+
+    fprintf(f, "%s: %u polygons, read %.1f ms\n", fileList[i].toLatin1().constData(), (uint)inputs.size(), read_ns * 1e-6);
+    printRun(f, "seidel", seidel, read_ns);
+    printRun(f, "earclip", earclip, read_ns);
+
+    read_total += read_ns;
+    seidel_total.ns         += seidel.ns;
+    seidel_total.triangles  += seidel.triangles;
+    seidel_total.rejected   += seidel.rejected;
+    seidel_total.uncovered  += seidel.uncovered;
+    earclip_total.ns        += earclip.ns;
+    earclip_total.triangles += earclip.triangles;
+    earclip_total.rejected  += earclip.rejected;
+    earclip_total.uncovered += earclip.uncovered;
+  }
+
+  fprintf(f, "All charts: read %.1f ms\n", read_total * 1e-6);
+  printRun(f, "seidel", seidel_total, read_total);
+  printRun(f, "earclip", earclip_total, read_total);
+
+  return 0;
+}
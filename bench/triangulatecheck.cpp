@@ -0,0 +1,191 @@
+#include "bench.h"
+#include "benchcharts.h"
+#include "triangulate.h"
+
+#include <QFileInfo>
+#include <QtGlobal>
+
+#include <stdint.h>
+#include <time.h>
+#include <thread>
+
+#define TC_GOLDEN_DIR "bench/golden"   // Baseline triangles, a .tri file per chart of res/charts
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t fnv1a(const void* p, size_t n, uint64_t h = 0xcbf29ce484222325ull) {
+  const unsigned char* b = static_cast<const unsigned char*>(p);
+  for (size_t i = 0; i < n; i++) {
+    h ^= b[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+// Triangles of a polygon as the golden files keep them: hashes of the
+// input and of the vertex indices, index count or -1 when rejected
+struct TriangulateDigest {
+  uint64_t input;
+  int      count;
+  uint64_t indices;
+
+  bool operator==(const TriangulateDigest& o) const { return input == o.input && count == o.count && indices == o.indices; }
+  bool operator!=(const TriangulateDigest& o) const { return !(*this == o); }
+};
+
+static uint64_t inputHash(const TriangulateInput& in) {
+  int total = 0;
+  for (size_t c = 0; c < in.cntr.size(); c++)
+    total += in.cntr[c];
+
+  uint64_t h = fnv1a(&in.cntr[0], in.cntr.size() * sizeof(int));
+  return fnv1a(&in.geoPt[1], total * sizeof(ContourPoint), h);
+}
+
+// Triangulates and digests the polygon, -1 alone stands for a rejected one
+static void triangulateInput(TriangulateContext* ctx, TriangulateInput& in, TriangulateDigest& out) {
+  polyout* polys;
+  if (ctx == NULL)
+    polys = triangulate_polygon(in.cntr.size(), &in.cntr[0], (double (*)[2])&in.geoPt[0]);
+  else
+    polys = ctx->triangulate(in.cntr.size(), &in.cntr[0], (double (*)[2])&in.geoPt[0]);
+
+  std::vector<int> inds;
+  if (polys == NULL)
+    inds.push_back(-1);
+
+  for (polyout* pck = polys; pck != NULL; pck = (polyout *)pck->poly_next)
+    if (pck->is_valid)
+      inds.insert(inds.end(), pck->vertex_index_list, pck->vertex_index_list + pck->nvert);
+
+  out.input   = inputHash(in);
+  out.count   = (polys == NULL) ? -1 : (int)inds.size();
+  out.indices = fnv1a(&inds[0], inds.size() * sizeof(int));
+
+  free_polyout(polys);
+}
+
+// Digests of a golden file, lines starting with # are comments
+static bool readGolden(const QByteArray& path, std::vector<TriangulateDigest>& golden) {
+  FILE* gf = fopen(path.constData(), "r");
+  if (gf == NULL)
+    return false;
+
+  char line[256];
+  while (fgets(line, sizeof(line), gf) != NULL) {
+    if (line[0] == '#')
+      continue;
+
+    unsigned long long input, indices;
+    TriangulateDigest d;
+    if (sscanf(line, "%llx %d %llx", &input, &d.count, &indices) != 3)
+      continue;
+
+    d.input   = input;
+    d.indices = indices;
+    golden.push_back(d);
+  }
+
+  fclose(gf);
+  return true;
+}
+
+int runTriangulateCheck(FILE* f) {
+  std::vector<TriangulateInput> inputs;
+  std::vector<TriangulateDigest> golden;
+
+  QDir dir("res/charts");
+  QStringList fileList = chartFiles(dir);
+  for (int i = 0; i < fileList.count(); i++) {
+    QByteArray path = (dir.path() + "/" + fileList[i]).toLatin1();
+    QByteArray golden_path = (QString(TC_GOLDEN_DIR "/") + QFileInfo(fileList[i]).completeBaseName() + ".tri").toLatin1();
+    size_t first = inputs.size();
+
+    if (!readChartPolygons(path, inputs)) {
+      fprintf(f, "Cannot open %s\n", path.constData());
+      return -1;
+    }
+
+    if (!readGolden(golden_path, golden)) {
+      fprintf(f, "Cannot open %s\n", golden_path.constData());
+      return -1;
+    }
+
+    // The same polygons in the same order, or the comparison means nothing
+    if (golden.size() != inputs.size()) {
+      fprintf(f, "%s: %u polygons, %u in %s\n", path.constData(), (uint)(inputs.size() - first)
+              , (uint)(golden.size() - first), golden_path.constData());
+      return -1;
+    }
+
+    for (size_t k = first; k < inputs.size(); k++) {
+      if (inputHash(inputs[k]) != golden[k].input) {
+        fprintf(f, "%s: polygon %u read differently than for %s\n", path.constData(), (uint)(k - first), golden_path.constData());
+        return -1;
+      }
+    }
+
+    fprintf(f, "%s: %u polygons\n", path.constData(), (uint)(inputs.size() - first));
+  }
+
+  size_t n = inputs.size();
+  if (n == 0) {
+    fprintf(f, "No polygons found in %s\n", dir.path().toLatin1().constData());
+    return -1;
+  }
+
+  std::vector<TriangulateDigest> fresh(n), reused(n), threaded(n);
+
+  // A context per polygon, as triangulate_polygon() does
+  uint64_t t0 = nowNs();
+  for (size_t i = 0; i < n; i++)
+    triangulateInput(NULL, inputs[i], fresh[i]);
+
+  // One context for the whole run
+  uint64_t t1 = nowNs();
+  TriangulateContext ctx;
+  for (size_t i = 0; i < n; i++)
+    triangulateInput(&ctx, inputs[i], reused[i]);
+
+  // Interleaved polygons on workers with a context each
+  uint64_t t2 = nowNs();
+  uint nthreads = qBound(2u, std::thread::hardware_concurrency(), 8u);
+  std::vector<std::thread> workers;
+  for (uint w = 0; w < nthreads; w++) {
+    workers.push_back(std::thread([&inputs, &threaded, n, nthreads, w]() {
+      TriangulateContext wctx;
+      for (size_t i = w; i < n; i += nthreads)
+        triangulateInput(&wctx, inputs[i], threaded[i]);
+    }));
+  }
+  for (uint w = 0; w < nthreads; w++)
+    workers[w].join();
+  uint64_t t3 = nowNs();
+
+  size_t triangles = 0, rejected = 0, mismatches = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (golden[i].count < 0)
+      rejected++;
+    else
+      triangles += golden[i].count / 3;
+
+    if (fresh[i] != golden[i] || reused[i] != golden[i] || threaded[i] != golden[i]) {
+      if (mismatches < 10)
+        fprintf(f, "  mismatch on polygon %u:%s%s%s\n", (uint)i, fresh[i] != golden[i] ? " fresh" : ""
+                , reused[i] != golden[i] ? " reused" : "", threaded[i] != golden[i] ? " threaded" : "");
+      mismatches++;
+    }
+  }
+
+  fprintf(f, "Triangulation: %u polygons, %u triangles, %u rejected, against %s\n", (uint)n, (uint)triangles, (uint)rejected, TC_GOLDEN_DIR);
+  fprintf(f, "  context per polygon: %.1f ms\n", (t1 - t0) * 1e-6);
+  fprintf(f, "  reused context:      %.1f ms\n", (t2 - t1) * 1e-6);
+  fprintf(f, "  %u threads:           %.1f ms\n", nthreads, (t3 - t2) * 1e-6);
+  fprintf(f, "  %u mismatches\n", (uint)mismatches);
+
+  return mismatches == 0 ? 0 : -1;
+}
@@ -0,0 +1,661 @@
+#include "earclip.h"
+
+#include <math.h>
+#include <algorithm>
+
+
+struct EarClipper::Node {
+  int    i;              // Index into the vertices
+  double x, y;
+  Node*  prev;           // Ring order
+  Node*  next;
+  uint32_t z;            // Z-order of the position
+  Node*  prevZ;          // Z-order list
+  Node*  nextZ;
+  bool   steiner;        // Single point hole
+};
+
+EarClipper::EarClipper() {
+  _block    = 0;
+  _used     = 0;
+  _min_x    = 0;
+  _min_y    = 0;
+  _inv_size = 0;
+  _splits   = 0;
+  _tris     = 0;
+  _count    = 0;
+}
+
+EarClipper::~EarClipper() {
+  for (size_t i = 0; i < _blocks.size(); i++)
+    delete[] _blocks[i];
+}
+
+EarClipper::Node* EarClipper::newNode(int i, double x, double y) {
+  if (_used == EC_POOL_BLOCK) {
+    _block++;
+    _used = 0;
+  }
+  if (_block == _blocks.size())
+    _blocks.push_back(new Node[EC_POOL_BLOCK]);
+
+  Node* p = &_blocks[_block][_used++];
+  p->i = i;
+  p->x = x;
+  p->y = y;
+  p->prev = p->next = 0;
+  p->z = 0;
+  p->prevZ = p->nextZ = 0;
+  p->steiner = false;
+  return p;
+}
+
+
+// ------------------------------------------------------------------------
+// Geometry
+
+// Twice the signed area of pqr, negative for a convex corner
+static inline double area(const EarClipper::Node* p, const EarClipper::Node* q, const EarClipper::Node* r) {
+  return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+}
+
+static inline bool equals(const EarClipper::Node* a, const EarClipper::Node* b) {
+  return a->x == b->x && a->y == b->y;
+}
+
+static inline bool pointInTriangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py) {
+  return (cx - px) * (ay - py) >= (ax - px) * (cy - py)
+      && (ax - px) * (by - py) >= (bx - px) * (ay - py)
+      && (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+static inline int sign(double v) {
+  return (v > 0) - (v < 0);
+}
+
+// q on the segment pr, given the three are collinear
+static inline bool onSegment(const EarClipper::Node* p, const EarClipper::Node* q, const EarClipper::Node* r) {
+  return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x)
+      && q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+}
+
+static bool intersects(const EarClipper::Node* p1, const EarClipper::Node* q1, const EarClipper::Node* p2, const EarClipper::Node* q2) {
+  int o1 = sign(area(p1, q1, p2));
+  int o2 = sign(area(p1, q1, q2));
+  int o3 = sign(area(p2, q2, p1));
+  int o4 = sign(area(p2, q2, q1));
+
+  if (o1 != o2 && o3 != o4)
+    return true;
+
+  return (o1 == 0 && onSegment(p1, p2, q1))
+      || (o2 == 0 && onSegment(p1, q2, q1))
+      || (o3 == 0 && onSegment(p2, p1, q2))
+      || (o4 == 0 && onSegment(p2, q1, q2));
+}
+
+// The diagonal ab leaves a into the polygon
+static bool locallyInside(const EarClipper::Node* a, const EarClipper::Node* b) {
+  if (area(a->prev, a, a->next) < 0)
+    return area(a, b, a->next) >= 0 && area(a, a->prev, b) >= 0;
+  return area(a, b, a->prev) < 0 || area(a, a->next, b) < 0;
+}
+
+static bool sectorContainsSector(const EarClipper::Node* m, const EarClipper::Node* p) {
+  return area(m->prev, m, p->prev) < 0 && area(p->next, m, m->next) < 0;
+}
+
+
+// ------------------------------------------------------------------------
+// Rings
+
+EarClipper::Node* EarClipper::insertNode(int i, double x, double y, Node* last) {
+  Node* p = newNode(i, x, y);
+
+  if (last == 0) {
+    p->prev = p;
+    p->next = p;
+  } else {
+    p->next = last->next;
+    p->prev = last;
+    last->next->prev = p;
+    last->next = p;
+  }
+
+  return p;
+}
+
+void EarClipper::removeNode(Node* p) {
+  p->next->prev = p->prev;
+  p->prev->next = p->next;
+
+  if (p->prevZ)
+    p->prevZ->nextZ = p->nextZ;
+  if (p->nextZ)
+    p->nextZ->prevZ = p->prevZ;
+}
+
+// Circular list of count vertices from first, in the given orientation
+EarClipper::Node* EarClipper::linkedList(const double (*vertices)[2], int first, int count, bool clockwise) {
+  double sum = 0;
+  for (int i = first, j = first + count - 1; i < first + count; j = i++)
+    sum += (vertices[j][0] - vertices[i][0]) * (vertices[i][1] + vertices[j][1]);
+
+  Node* last = 0;
+  if (clockwise == (sum > 0)) {
+    for (int i = first; i < first + count; i++)
+      last = insertNode(i, vertices[i][0], vertices[i][1], last);
+  } else {
+    for (int i = first + count - 1; i >= first; i--)
+      last = insertNode(i, vertices[i][0], vertices[i][1], last);
+  }
+
+  if (last && equals(last, last->next)) {
+    removeNode(last);
+    last = last->next;
+  }
+
+  return last;
+}
+
+// Drops repeated and collinear vertices between start and end
+EarClipper::Node* EarClipper::filterPoints(Node* start, Node* end) {
+  if (start == 0)
+    return start;
+  if (end == 0)
+    end = start;
+
+  Node* p = start;
+  bool again;
+  do {
+    again = false;
+
+    if (!p->steiner && (equals(p, p->next) || area(p->prev, p, p->next) == 0)) {
+      removeNode(p);
+      p = end = p->prev;
+      if (p == p->next)
+        break;
+      again = true;
+    } else {
+      p = p->next;
+    }
+  } while (again || p != end);
+
+  return end;
+}
+
+static bool leftmostFirst(const EarClipper::Node* a, const EarClipper::Node* b) {
+  return a->x < b->x || (a->x == b->x && a->y < b->y);
+}
+
+// Holes are joined to the exterior ring through a bridge from their
+// leftmost vertex, taken from left to right
+EarClipper::Node* EarClipper::eliminateHoles(const double (*vertices)[2], int ncontours, const int cntr[], Node* outer) {
+  _holes.clear();
+
+  int first = 1 + cntr[0];
+  for (int c = 1; c < ncontours; c++) {
+    int count = cntr[c];
+    if (count > 0) {
+      Node* list = linkedList(vertices, first, count, false);
+      if (list) {
+        if (list == list->next)
+          list->steiner = true;
+
+        Node* leftmost = list;
+        Node* p = list;
+        do {
+          if (leftmostFirst(p, leftmost))
+            leftmost = p;
+          p = p->next;
+        } while (p != list);
+
+        _holes.push_back(leftmost);
+      }
+    }
+    first += count;
+  }
+
+  std::stable_sort(_holes.begin(), _holes.end(), leftmostFirst);
+
+  for (size_t i = 0; i < _holes.size(); i++) {
+    Node* bridge = findHoleBridge(_holes[i], outer);
+    if (bridge == 0)
+      continue;
+
+    Node* reverse = splitPolygon(bridge, _holes[i]);
+    filterPoints(reverse, reverse->next);
+    outer = filterPoints(bridge, bridge->next);
+  }
+
+  return outer;
+}
+
+// Vertex of the outer ring visible from the leftmost vertex of a hole
+EarClipper::Node* EarClipper::findHoleBridge(Node* hole, Node* outer) {
+  Node* p = outer;
+  Node* m = 0;
+  double hx = hole->x;
+  double hy = hole->y;
+  double qx = -HUGE_VAL;
+
+  // Nearest segment crossed by a ray from the hole to the left
+  do {
+    if (hy <= p->y && hy >= p->next->y && p->next->y != p->y) {
+      double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+      if (x <= hx && x > qx) {
+        qx = x;
+        m = p->x < p->next->x ? p : p->next;
+        if (x == hx)
+          return m;
+      }
+    }
+    p = p->next;
+  } while (p != outer);
+
+  if (m == 0)
+    return 0;
+
+  // Reflex vertices inside the triangle of the hole, the crossing and its
+  // segment end would block the bridge, the one of least angle is taken
+  Node* stop = m;
+  double mx = m->x;
+  double my = m->y;
+  double tan_min = HUGE_VAL;
+
+  p = m;
+  do {
+    if (hx >= p->x && p->x >= mx && hx != p->x
+     && pointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y)) {
+      double tan = fabs(hy - p->y) / (hx - p->x);
+
+      if (locallyInside(p, hole)
+       && (tan < tan_min || (tan == tan_min && (p->x > m->x || (p->x == m->x && sectorContainsSector(m, p)))))) {
+        m = p;
+        tan_min = tan;
+      }
+    }
+    p = p->next;
+  } while (p != stop);
+
+  return m;
+}
+
+
+// ------------------------------------------------------------------------
+// Z-order index
+
+uint32_t EarClipper::zOrder(double x, double y) const {
+  uint32_t ix = static_cast<uint32_t>((x - _min_x) * _inv_size);
+  uint32_t iy = static_cast<uint32_t>((y - _min_y) * _inv_size);
+
+  ix = (ix | (ix << 8)) & 0x00FF00FF;
+  ix = (ix | (ix << 4)) & 0x0F0F0F0F;
+  ix = (ix | (ix << 2)) & 0x33333333;
+  ix = (ix | (ix << 1)) & 0x55555555;
+
+  iy = (iy | (iy << 8)) & 0x00FF00FF;
+  iy = (iy | (iy << 4)) & 0x0F0F0F0F;
+  iy = (iy | (iy << 2)) & 0x33333333;
+  iy = (iy | (iy << 1)) & 0x55555555;
+
+  return ix | (iy << 1);
+}
+
+void EarClipper::indexCurve(Node* start) {
+  Node* p = start;
+  do {
+    if (p->z == 0)
+      p->z = zOrder(p->x, p->y);
+    p->prevZ = p->prev;
+    p->nextZ = p->next;
+    p = p->next;
+  } while (p != start);
+
+  p->prevZ->nextZ = 0;
+  p->prevZ = 0;
+
+  sortLinked(p);
+}
+
+// Bottom-up merge sort of the z-order list
+EarClipper::Node* EarClipper::sortLinked(Node* list) {
+  int merges;
+  int in_size = 1;
+
+  do {
+    Node* p = list;
+    Node* tail = 0;
+    list = 0;
+    merges = 0;
+
+    while (p) {
+      merges++;
+
+      Node* q = p;
+      int p_size = 0;
+      for (int i = 0; i < in_size && q; i++) {
+        p_size++;
+        q = q->nextZ;
+      }
+      int q_size = in_size;
+
+      while (p_size > 0 || (q_size > 0 && q)) {
+        Node* e;
+        if (p_size != 0 && (q_size == 0 || q == 0 || p->z <= q->z)) {
+          e = p;
+          p = p->nextZ;
+          p_size--;
+        } else {
+          e = q;
+          q = q->nextZ;
+          q_size--;
+        }
+
+        if (tail)
+          tail->nextZ = e;
+        else
+          list = e;
+
+        e->prevZ = tail;
+        tail = e;
+      }
+
+      p = q;
+    }
+
+    tail->nextZ = 0;
+    in_size *= 2;
+  } while (merges > 1);
+
+  return list;
+}
+
+
+// ------------------------------------------------------------------------
+// Clipping
+
+void EarClipper::addTriangle(Node* a, Node* b, Node* c) {
+  _tris->push_back(a->i);
+  _tris->push_back(b->i);
+  _tris->push_back(c->i);
+  _count++;
+}
+
+void EarClipper::clipEars(Node* ear, int pass) {
+  if (ear == 0)
+    return;
+
+  if (pass == 0 && _inv_size > 0)
+    indexCurve(ear);
+
+  Node* stop = ear;
+
+  while (ear->prev != ear->next) {
+    Node* prev = ear->prev;
+    Node* next = ear->next;
+
+    if (_inv_size > 0 ? isEarHashed(ear) : isEar(ear)) {
+      addTriangle(prev, ear, next);
+      removeNode(ear);
+
+      // Skipping the next vertex leaves fewer sliver triangles
+      ear  = next->next;
+      stop = next->next;
+      continue;
+    }
+
+    ear = next;
+
+    // A whole turn without an ear
+    if (ear == stop) {
+      if (pass == 0) {
+        clipEars(filterPoints(ear), 1);
+      } else if (pass == 1) {
+        ear = cureLocalIntersections(filterPoints(ear));
+        clipEars(ear, 2);
+      } else if (pass == 2) {
+        splitClip(ear);
+      }
+      break;
+    }
+  }
+}
+
+// No other vertex of the ring inside the convex corner
+bool EarClipper::isEar(Node* ear) {
+  Node* a = ear->prev;
+  Node* b = ear;
+  Node* c = ear->next;
+
+  if (area(a, b, c) >= 0)
+    return false;
+
+  double x0 = std::min(a->x, std::min(b->x, c->x));
+  double y0 = std::min(a->y, std::min(b->y, c->y));
+  double x1 = std::max(a->x, std::max(b->x, c->x));
+  double y1 = std::max(a->y, std::max(b->y, c->y));
+
+  for (Node* p = c->next; p != a; p = p->next) {
+    if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1
+     && pointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y)
+     && area(p->prev, p, p->next) >= 0)
+      return false;
+  }
+
+  return true;
+}
+
+// Same, checking only the vertices with z-order in the corner's bounding box
+bool EarClipper::isEarHashed(Node* ear) {
+  Node* a = ear->prev;
+  Node* b = ear;
+  Node* c = ear->next;
+
+  if (area(a, b, c) >= 0)
+    return false;
+
+  double x0 = std::min(a->x, std::min(b->x, c->x));
+  double y0 = std::min(a->y, std::min(b->y, c->y));
+  double x1 = std::max(a->x, std::max(b->x, c->x));
+  double y1 = std::max(a->y, std::max(b->y, c->y));
+
+  uint32_t min_z = zOrder(x0, y0);
+  uint32_t max_z = zOrder(x1, y1);
+
+  Node* p = ear->prevZ;
+  Node* n = ear->nextZ;
+
+  #define EC_BLOCKS(v) ((v)->x >= x0 && (v)->x <= x1 && (v)->y >= y0 && (v)->y <= y1 && (v) != a && (v) != c \
+                        && pointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, (v)->x, (v)->y) \
+                        && area((v)->prev, (v), (v)->next) >= 0)
+
+  // Both directions at once while both are in range
+  while (p && p->z >= min_z && n && n->z <= max_z) {
+    if (EC_BLOCKS(p))
+      return false;
+    p = p->prevZ;
+
+    if (EC_BLOCKS(n))
+      return false;
+    n = n->nextZ;
+  }
+
+  for (; p && p->z >= min_z; p = p->prevZ)
+    if (EC_BLOCKS(p))
+      return false;
+
+  for (; n && n->z <= max_z; n = n->nextZ)
+    if (EC_BLOCKS(n))
+      return false;
+
+  #undef EC_BLOCKS
+
+  return true;
+}
+
+// Clips the triangle off a self intersection a - p - p.next - b
+EarClipper::Node* EarClipper::cureLocalIntersections(Node* start) {
+  Node* p = start;
+
+  do {
+    Node* a = p->prev;
+    Node* b = p->next->next;
+
+    if (!equals(a, b) && intersects(a, p, p->next, b) && locallyInside(a, b) && locallyInside(b, a)) {
+      addTriangle(a, p, b);
+
+      removeNode(p);
+      removeNode(p->next);
+
+      p = start = b;
+    }
+    p = p->next;
+  } while (p != start);
+
+  return filterPoints(p);
+}
+
+// Last resort: two rings along a diagonal, each clipped anew
+void EarClipper::splitClip(Node* start) {
+  if (++_splits > EC_MAX_SPLITS)
+    return;
+
+  Node* a = start;
+  do {
+    for (Node* b = a->next->next; b != a->prev; b = b->next) {
+      if (a->i != b->i && isValidDiagonal(a, b)) {
+        Node* c = splitPolygon(a, b);
+
+        a = filterPoints(a, a->next);
+        c = filterPoints(c, c->next);
+
+        clipEars(a, 0);
+        clipEars(c, 0);
+        return;
+      }
+    }
+    a = a->next;
+  } while (a != start);
+}
+
+bool EarClipper::isValidDiagonal(Node* a, Node* b) {
+  if (a->next->i == b->i || a->prev->i == b->i || intersectsPolygon(a, b))
+    return false;
+
+  if (locallyInside(a, b) && locallyInside(b, a) && middleInside(a, b)
+   && (area(a->prev, a, b->prev) != 0 || area(a, b->prev, b) != 0))
+    return true;
+
+  // Touching vertices of two convex corners
+  return equals(a, b) && area(a->prev, a, a->next) > 0 && area(b->prev, b, b->next) > 0;
+}
+
+bool EarClipper::intersectsPolygon(Node* a, Node* b) {
+  Node* p = a;
+  do {
+    if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i
+     && intersects(p, p->next, a, b))
+      return true;
+    p = p->next;
+  } while (p != a);
+
+  return false;
+}
+
+// Midpoint of the diagonal ab inside the ring, by ray crossings
+bool EarClipper::middleInside(Node* a, Node* b) {
+  Node* p = a;
+  bool inside = false;
+  double px = (a->x + b->x) / 2;
+  double py = (a->y + b->y) / 2;
+
+  do {
+    if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y
+     && (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x))
+      inside = !inside;
+    p = p->next;
+  } while (p != a);
+
+  return inside;
+}
+
+// Links a to b with a diagonal, the ring splits in two, or a hole joins
+// its ring. Returns the copy of b heading the other part
+EarClipper::Node* EarClipper::splitPolygon(Node* a, Node* b) {
+  Node* a2 = newNode(a->i, a->x, a->y);
+  Node* b2 = newNode(b->i, b->x, b->y);
+  Node* an = a->next;
+  Node* bp = b->prev;
+
+  a->next = b;
+  b->prev = a;
+
+  a2->next = an;
+  an->prev = a2;
+
+  b2->next = a2;
+  a2->prev = b2;
+
+  bp->next = b2;
+  b2->prev = bp;
+
+  return b2;
+}
+
+
+// ------------------------------------------------------------------------
+
+int EarClipper::triangulate(int ncontours, const int cntr[], const double (*vertices)[2], std::vector<int>& tris) {
+  if (ncontours < 1 || cntr[0] < 3)
+    return -1;
+
+  int total = 0;
+  for (int c = 0; c < ncontours; c++) {
+    if (cntr[c] < 0)
+      return -1;
+    total += cntr[c];
+  }
+
+  // Positions compared for equality and ordered by z need finite values
+  double min_x = HUGE_VAL, min_y = HUGE_VAL;
+  double max_x = -HUGE_VAL, max_y = -HUGE_VAL;
+  for (int i = 1; i <= total; i++) {
+    double x = vertices[i][0];
+    double y = vertices[i][1];
+    if (!std::isfinite(x) || !std::isfinite(y))
+      return -1;
+
+    min_x = std::min(min_x, x);
+    min_y = std::min(min_y, y);
+    max_x = std::max(max_x, x);
+    max_y = std::max(max_y, y);
+  }
+
+  _block  = 0;
+  _used   = 0;
+  _splits = 0;
+  _tris   = &tris;
+  _count  = 0;
+
+  Node* outer = linkedList(vertices, 1, cntr[0], true);
+  if (outer == 0 || outer->next == outer->prev)
+    return 0;
+
+  if (ncontours > 1)
+    outer = eliminateHoles(vertices, ncontours, cntr, outer);
+
+  // The index pays off on larger rings only
+  _min_x = min_x;
+  _min_y = min_y;
+  _inv_size = 0;
+  if (total > EC_HASH_MIN_VERTS) {
+    double size = std::max(max_x - min_x, max_y - min_y);
+    _inv_size = (size > 0) ? 32767 / size : 0;
+  }
+
+  clipEars(outer, 0);
+
+  _tris = 0;
+  return _count;
+}
@@ -0,0 +1,80 @@
+#ifndef EARCLIP_H
+#define EARCLIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define EC_HASH_MIN_VERTS  80     // Smaller polygons are clipped without the z-order index
+#define EC_POOL_BLOCK      4096   // Vertex nodes per pool block
+#define EC_MAX_SPLITS      1024   // Diagonal splits per polygon before the rest is given up
+
+// Polygon triangulation by ear clipping with holes bridged into the
+// exterior ring. Ears are tested against the vertices inside their bounding
+// box only, found through a z-order index of the ring. Rings that stop
+// yielding ears are filtered of collinear points, cleared of local self
+// intersections and finally split along a valid diagonal, so degenerate
+// input gives fewer triangles instead of failing. The result depends only
+// on the input.
+//
+// Scratch memory is kept between polygons, one clipper serves one thread
+// at a time.
+class EarClipper {
+public:
+  EarClipper();
+  ~EarClipper();
+
+  // Input: ncontours rings of cntr[i] vertices stored one after another
+  // from vertices[1], the exterior ring first. Appends triples of indices
+  // into vertices to tris and returns the number of triangles appended,
+  // -1 if the exterior ring is unusable
+  int triangulate(int ncontours, const int cntr[], const double (*vertices)[2], std::vector<int>& tris);
+
+  struct Node;          // Ring vertex
+
+private:
+  EarClipper(const EarClipper&);
+  EarClipper& operator=(const EarClipper&);
+
+  Node* newNode(int i, double x, double y);
+  Node* insertNode(int i, double x, double y, Node* last);
+  void  removeNode(Node* p);
+
+  Node* linkedList(const double (*vertices)[2], int first, int count, bool clockwise);
+  Node* filterPoints(Node* start, Node* end = 0);
+  Node* eliminateHoles(const double (*vertices)[2], int ncontours, const int cntr[], Node* outer);
+  Node* findHoleBridge(Node* hole, Node* outer);
+
+  void  clipEars(Node* ear, int pass);
+  bool  isEar(Node* ear);
+  bool  isEarHashed(Node* ear);
+  Node* cureLocalIntersections(Node* start);
+  void  splitClip(Node* start);
+
+  uint32_t zOrder(double x, double y) const;
+  void  indexCurve(Node* start);
+  Node* sortLinked(Node* list);
+
+  bool  isValidDiagonal(Node* a, Node* b);
+  bool  intersectsPolygon(Node* a, Node* b);
+  bool  middleInside(Node* a, Node* b);
+  Node* splitPolygon(Node* a, Node* b);
+
+  void  addTriangle(Node* a, Node* b, Node* c);
+
+  // Node pool, blocks are kept and refilled from the start for each polygon
+  std::vector<Node*> _blocks;
+  size_t _block;
+  size_t _used;
+
+  std::vector<Node*> _holes;
+
+  // Z-order frame of the current polygon, 0 scale for no index
+  double _min_x, _min_y, _inv_size;
+  int    _splits;
+
+  std::vector<int>* _tris;
+  int _count;
+};
+
+#endif // EARCLIP_H
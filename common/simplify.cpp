@@ -0,0 +1,323 @@
+#include "simplify.h"
+
+#include <algorithm>
+#include <math.h>
+
+static double segmentDistance2(const double* p, const double* a, const double* b) {
+  double dx = b[0] - a[0];
+  double dy = b[1] - a[1];
+  double t = 0;
+
+  double len2 = dx * dx + dy * dy;
+  if (len2 > 0) {
+    t = ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / len2;
+    t = std::max(0.0, std::min(1.0, t));
+  }
+
+  double ex = a[0] + t * dx - p[0];
+  double ey = a[1] + t * dy - p[1];
+  return ex * ex + ey * ey;
+}
+
+static double orient(const double* a, const double* b, const double* c) {
+  return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+// Proper crossings only, touching and collinear spans are fine for the triangulator
+static bool crosses(const double* a, const double* b, const double* c, const double* d) {
+  double o1 = orient(a, b, c);
+  double o2 = orient(a, b, d);
+  double o3 = orient(c, d, a);
+  double o4 = orient(c, d, b);
+  return ((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0))
+      && ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0));
+}
+
+
+Simplifier::Simplifier() {
+  _grid_x = _grid_y = 0;
+  _cell = 1;
+  _cell_mask = 0;
+}
+
+int Simplifier::farthest(const double (*pts)[2], int first, int n, int a, int b, double* d2) const {
+  const double* pa = pts[first + a % n];
+  const double* pb = pts[first + b % n];
+
+  int k = -1;
+  *d2 = -1;
+  for (int p = a + 1; p < b; p++) {
+    double d = segmentDistance2(pts[first + p % n], pa, pb);
+    if (d > *d2) {
+      *d2 = d;
+      k = p;
+    }
+  }
+  return k;
+}
+
+void Simplifier::douglasPeucker(const double (*pts)[2], int first, int n, bool closed, double tol2, char* keep) {
+  if (n < (closed ? 3 : 2))
+    return;
+
+  // Rings are split at the point farthest from their first one
+  int end = n - 1;
+  double d2 = 0;
+  if (closed) {
+    end = farthest(pts, first, n, 0, n, &d2);
+  } else {
+    for (int p = 1; p < n; p++) {
+      double dx = pts[first + p][0] - pts[first][0];
+      double dy = pts[first + p][1] - pts[first][1];
+      d2 = std::max(d2, dx * dx + dy * dy);
+    }
+  }
+
+  if (d2 < tol2)
+    return;
+
+  keep[0] = 1;
+  keep[end] = 1;
+
+  _stack.clear();
+  _stack.push_back(0);
+  _stack.push_back(end);
+  if (closed) {
+    _stack.push_back(end);
+    _stack.push_back(n);
+  }
+
+  while (!_stack.empty()) {
+    int b = _stack.back(); _stack.pop_back();
+    int a = _stack.back(); _stack.pop_back();
+    if (b - a < 2)
+      continue;
+
+    int k = farthest(pts, first, n, a, b, &d2);
+    if (d2 <= tol2)
+      continue;
+
+    keep[k % n] = 1;
+    _stack.push_back(a);
+    _stack.push_back(k);
+    _stack.push_back(k);
+    _stack.push_back(b);
+  }
+
+  if (!closed)
+    return;
+
+  // Slivers thinner than the tolerance have nothing left to show
+  int kept = 0;
+  for (int p = 0; p < n; p++)
+    kept += keep[p];
+  if (kept < 3)
+    std::fill(keep, keep + n, 0);
+}
+
+void Simplifier::collectSpans(int nchains, const int len[], bool closed, const std::vector<char>& keep) {
+  _spans.clear();
+
+  for (int c = 0; c < nchains; c++) {
+    int first = _first[c];
+    int last = -1, head = -1;
+
+    for (int p = 0; p < len[c]; p++) {
+      if (!keep[first + p])
+        continue;
+
+      if (last >= 0) {
+        Span s = { last, p, c };
+        _spans.push_back(s);
+      } else {
+        head = p;
+      }
+      last = p;
+    }
+
+    // Closing span of a ring runs past its end
+    if (closed && head >= 0 && last != head) {
+      Span s = { last, head + len[c], c };
+      _spans.push_back(s);
+    }
+  }
+}
+
+// Grid cells a span passes through: column by column, the rows the span
+// covers within the column. Cells are hashed into _cell_mask + 1 buckets
+void Simplifier::spanCells(const double* a, const double* b, std::vector<int>& cells) const {
+  if (a[0] > b[0])
+    std::swap(a, b);
+
+  int x0 = static_cast<int>((a[0] - _grid_x) / _cell);
+  int x1 = static_cast<int>((b[0] - _grid_x) / _cell);
+
+  for (int x = x0; x <= x1; x++) {
+    double ya = a[1], yb = b[1];
+    if (x0 != x1) {
+      double slope = (b[1] - a[1]) / (b[0] - a[0]);
+      double xa = std::max(a[0], _grid_x + x * _cell);
+      double xb = std::min(b[0], _grid_x + (x + 1) * _cell);
+      ya = a[1] + (xa - a[0]) * slope;
+      yb = a[1] + (xb - a[0]) * slope;
+    }
+
+    // Rounding at the column edges must not lose a crossing there
+    double pad = 1e-6 * _cell;
+    int y0 = std::max(0, static_cast<int>((std::min(ya, yb) - pad - _grid_y) / _cell));
+    int y1 = static_cast<int>((std::max(ya, yb) + pad - _grid_y) / _cell);
+    for (int y = y0; y <= y1; y++)
+      cells.push_back((static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u) & _cell_mask);
+  }
+}
+
+int Simplifier::markCrossings(const double (*pts)[2]) {
+  int ns = _spans.size();
+  _crossing.assign(ns, 0);
+  if (ns < 2)
+    return 0;
+
+  const int* len = &_len[0];
+  double min_x = 1e300, min_y = 1e300, max_x = -1e300, max_y = -1e300;
+  for (int i = 0; i < ns; i++) {
+    const Span& s = _spans[i];
+    const double* a = pts[_first[s.chain] + s.a % len[s.chain]];
+    const double* b = pts[_first[s.chain] + s.b % len[s.chain]];
+    min_x = std::min(min_x, std::min(a[0], b[0]));
+    min_y = std::min(min_y, std::min(a[1], b[1]));
+    max_x = std::max(max_x, std::max(a[0], b[0]));
+    max_y = std::max(max_y, std::max(a[1], b[1]));
+  }
+
+  // Cells about as large as the spans, dense clusters of short spans do
+  // not pile up in a few cells
+  double span_sum = 0;
+  for (int i = 0; i < ns; i++) {
+    const Span& s = _spans[i];
+    const double* a = pts[_first[s.chain] + s.a % len[s.chain]];
+    const double* b = pts[_first[s.chain] + s.b % len[s.chain]];
+    span_sum += std::max(fabs(b[0] - a[0]), fabs(b[1] - a[1]));
+  }
+
+  double extent = std::max(max_x - min_x, max_y - min_y);
+  _grid_x = min_x;
+  _grid_y = min_y;
+  _cell = std::max(std::max(span_sum / ns, extent / SP_GRID_MAX), 1e-12);
+
+  _cell_mask = 1;
+  while (_cell_mask < static_cast<uint32_t>(2 * ns))
+    _cell_mask <<= 1;
+  _cell_mask--;
+
+  // Cells of every span, spans of every cell
+  _span_cells.clear();
+  _span_start.assign(1, 0);
+  for (int i = 0; i < ns; i++) {
+    const Span& s = _spans[i];
+    spanCells(pts[_first[s.chain] + s.a % len[s.chain]], pts[_first[s.chain] + s.b % len[s.chain]], _span_cells);
+    _span_start.push_back(_span_cells.size());
+  }
+
+  int cell_count = _cell_mask + 1;
+  _cell_start.assign(cell_count + 1, 0);
+  for (size_t k = 0; k < _span_cells.size(); k++)
+    _cell_start[_span_cells[k] + 1]++;
+  for (int c = 0; c < cell_count; c++)
+    _cell_start[c + 1] += _cell_start[c];
+
+  _cell_spans.resize(_cell_start[cell_count]);
+  std::vector<int> fill(_cell_start.begin(), _cell_start.end() - 1);
+  for (int i = 0; i < ns; i++)
+    for (int k = _span_start[i]; k < _span_start[i + 1]; k++)
+      _cell_spans[fill[_span_cells[k]]++] = i;
+
+  _stamp.assign(ns, -1);
+  int marked = 0;
+
+  for (int i = 0; i < ns; i++) {
+    const Span& si = _spans[i];
+    int ia = _first[si.chain] + si.a % len[si.chain];
+    int ib = _first[si.chain] + si.b % len[si.chain];
+
+    for (int c = _span_start[i]; c < _span_start[i + 1]; c++) {
+      int cell = _span_cells[c];
+      for (int k = _cell_start[cell]; k < _cell_start[cell + 1]; k++) {
+        int j = _cell_spans[k];
+        if (j <= i || _stamp[j] == i)
+          continue;
+        _stamp[j] = i;
+
+        const Span& sj = _spans[j];
+        int ja = _first[sj.chain] + sj.a % len[sj.chain];
+        int jb = _first[sj.chain] + sj.b % len[sj.chain];
+        if (ia == ja || ia == jb || ib == ja || ib == jb)
+          continue;
+
+        if (crosses(pts[ia], pts[ib], pts[ja], pts[jb])) {
+          marked += !_crossing[i] + !_crossing[j];
+          _crossing[i] = _crossing[j] = 1;
+        }
+      }
+    }
+  }
+
+  return marked;
+}
+
+int Simplifier::simplify(int nchains, const int len[], const double (*pts)[2], bool closed, double tol, std::vector<char>& keep) {
+  _first.resize(nchains);
+  _len.assign(len, len + nchains);
+
+  int total = 0;
+  for (int c = 0; c < nchains; c++) {
+    _first[c] = total;
+    total += len[c];
+  }
+
+  keep.assign(total, 0);
+  if (total == 0)
+    return 0;
+
+  for (int c = 0; c < nchains; c++)
+    douglasPeucker(pts, _first[c], len[c], closed, tol * tol, &keep[_first[c]]);
+
+  // A crossing span gets its farthest point back, after SP_MAX_PASSES all of
+  // its points. Done once every crossing is between spans of the input
+  for (int pass = 0; ; pass++) {
+    collectSpans(nchains, len, closed, keep);
+    if (markCrossings(pts) == 0)
+      break;
+
+    int refined = 0;
+    for (size_t i = 0; i < _spans.size(); i++) {
+      if (!_crossing[i])
+        continue;
+
+      const Span& s = _spans[i];
+      int first = _first[s.chain];
+      int n = len[s.chain];
+
+      if (pass >= SP_MAX_PASSES) {
+        for (int p = s.a + 1; p < s.b; p++) {
+          refined += !keep[first + p % n];
+          keep[first + p % n] = 1;
+        }
+      } else {
+        double d2;
+        int k = farthest(pts, first, n, s.a, s.b, &d2);
+        if (k >= 0 && !keep[first + k % n]) {
+          keep[first + k % n] = 1;
+          refined++;
+        }
+      }
+    }
+
+    if (refined == 0)
+      break;
+  }
+
+  int kept = 0;
+  for (int i = 0; i < total; i++)
+    kept += keep[i];
+  return kept;
+}
@@ -0,0 +1,62 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#define SP_MAX_PASSES   8      // Crossing repair passes before offending spans get all their points back
+#define SP_GRID_MAX     4096   // Crossing check grid cells along the larger side at most
+
+// Douglas-Peucker simplification of a group of rings or polylines that keeps
+// the group free of new crossings. Spans of the simplified chains are checked
+// against each other through a grid, a span crossing another gets back its
+// farthest point until no new crossing is left. Crossings already in the
+// input are kept as they are.
+//
+// Chains with all points within the tolerance of a line are dropped: rings
+// left with fewer than 3 points and polylines shorter than the tolerance.
+//
+// Scratch memory is kept between calls, one simplifier serves one thread at
+// a time.
+class Simplifier {
+public:
+  Simplifier();
+
+  // nchains chains of len[i] points stored one after another in pts, in a
+  // frame with equal units on both axes. Rings do not repeat their first
+  // point. keep gets a flag per point, returns the number of points kept
+  int simplify(int nchains, const int len[], const double (*pts)[2], bool closed, double tol, std::vector<char>& keep);
+
+private:
+  struct Span {
+    int a, b;        // Kept points, b is a when the span closes a ring
+    int chain;
+  };
+
+  void douglasPeucker(const double (*pts)[2], int first, int n, bool closed, double tol2, char* keep);
+  int  farthest(const double (*pts)[2], int first, int n, int a, int b, double* d2) const;
+
+  void collectSpans(int nchains, const int len[], bool closed, const std::vector<char>& keep);
+  int  markCrossings(const double (*pts)[2]);
+  void spanCells(const double* a, const double* b, std::vector<int>& cells) const;
+
+  std::vector<int>  _stack;
+  std::vector<Span> _spans;
+  std::vector<int>  _first;      // Of each chain
+  std::vector<int>  _len;
+  std::vector<char> _crossing;   // Per span
+
+  // Hashed grid over the spans: cells of span i in _span_cells from
+  // _span_start[i], spans of cell c in _cell_spans from _cell_start[c]
+  double   _grid_x, _grid_y;
+  double   _cell;
+  uint32_t _cell_mask;
+  std::vector<int>  _span_start;
+  std::vector<int>  _span_cells;
+  std::vector<int>  _cell_start;
+  std::vector<int>  _cell_spans;
+  std::vector<int>  _stamp;
+};
+
+#endif // SIMPLIFY_H
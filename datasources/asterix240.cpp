@@ -0,0 +1,308 @@
+#include "asterix240.h"
+
+#include <string.h>
+
+#define CAT240_SPEED_OF_LIGHT 299792458.0
+#define CAT240_METERS_PER_MILE 1852.0
+
+static inline void put16(uint8_t* p, uint32_t v) { p[0] = v >> 8; p[1] = v; }
+static inline void put24(uint8_t* p, uint32_t v) { p[0] = v >> 16; p[1] = v >> 8; p[2] = v; }
+static inline void put32(uint8_t* p, uint32_t v) { p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v; }
+
+static inline uint32_t get16(const uint8_t* p) { return (p[0] << 8) | p[1]; }
+static inline uint32_t get24(const uint8_t* p) { return (p[0] << 16) | (p[1] << 8) | p[2]; }
+static inline uint32_t get32(const uint8_t* p) { return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+
+static inline uint32_t quantise(float a) {
+  if (a <= 0.f)
+    return 0;
+  if (a >= 255.f)
+    return 255;
+  return (uint32_t)(a + 0.5f);
+}
+
+uint32_t cat240PackCells(const float* amps, uint32_t n, uint8_t res, uint8_t* out) {
+  if (res == CAT240_RES_8BIT) {
+    for (uint32_t i = 0; i < n; i++)
+      out[i] = quantise(amps[i]);
+    return n;
+  }
+
+  if (res == CAT240_RES_4BIT) {
+    uint32_t i = 0;
+    for (; i + 1 < n; i += 2)
+      out[i / 2] = (quantise(amps[i]) & 0xF0) | (quantise(amps[i + 1]) >> 4);
+    if (i < n)
+      out[i / 2] = quantise(amps[i]) & 0xF0;
+    return (n + 1) / 2;
+  }
+
+  if (res != CAT240_RES_1BIT && res != CAT240_RES_2BIT)
+    return 0;
+
+  const uint32_t nbits = 1 << (res - 1);
+  const uint32_t len   = (n * nbits + 7) / 8;
+  memset(out, 0, len);
+
+  for (uint32_t i = 0, bit = 0; i < n; i++, bit += nbits)
+    out[bit >> 3] |= (quantise(amps[i]) >> (8 - nbits)) << (8 - nbits - (bit & 7));
+
+  return len;
+}
+
+uint32_t cat240Compress(const uint8_t* in, uint32_t len, uint8_t* out) {
+  uint32_t i = 0, o = 0;
+
+  while (i < len) {
+    uint32_t run = 1;
+    while (i + run < len && run < 128 && in[i + run] == in[i])
+      run++;
+
+    if (run >= 2) {
+      out[o++] = (uint8_t)(257 - run);
+      out[o++] = in[i];
+      i += run;
+      continue;
+    }
+
+    // Literals up to the next run of three
+    uint32_t start = i, n = 0;
+    while (i < len && n < 128) {
+      if (i + 2 < len && in[i] == in[i + 1] && in[i] == in[i + 2])
+        break;
+      i++;
+      n++;
+    }
+
+    out[o++] = (uint8_t)(n - 1);
+    memcpy(&out[o], &in[start], n);
+    o += n;
+  }
+
+  return o;
+}
+
+int cat240Decompress(const uint8_t* in, uint32_t len, uint8_t* out, uint32_t max) {
+  uint32_t i = 0, o = 0;
+
+  while (i < len) {
+    int h = (int8_t) in[i++];
+
+    if (h >= 0) {
+      uint32_t n = h + 1;
+      if (i + n > len || o + n > max)
+        return -1;
+      memcpy(&out[o], &in[i], n);
+      i += n;
+      o += n;
+    } else if (h != -128) {
+      uint32_t n = 1 - h;
+      if (i >= len || o + n > max)
+        return -1;
+      memset(&out[o], in[i++], n);
+      o += n;
+    }
+  }
+
+  return o;
+}
+
+uint32_t cat240EncodeBlock(const Cat240Video& v, const uint8_t* data, uint32_t len, uint8_t* out, uint32_t size) {
+  // Smallest video block type that takes the octets with at most 255 blocks
+  uint32_t blk;
+  uint8_t  item;
+  if (len <= 255 * 4) {
+    blk = 4;   item = 0x40;   // I240/050
+  } else if (len <= 255 * 64) {
+    blk = 64;  item = 0x20;   // I240/051
+  } else if (len <= 255 * 256) {
+    blk = 256; item = 0x10;   // I240/052
+  } else {
+    return 0;
+  }
+
+  uint32_t rep   = (len + blk - 1) / blk;
+  uint32_t total = CAT240_HEADER_SIZE + rep * blk;
+  if (total > size || total > CAT240_MAX_BLOCK)
+    return 0;
+
+  uint8_t* p = out;
+  *p++ = CAT240_CATEGORY;
+  put16(p, total);                      p += 2;
+
+  *p++ = 0xE7;                          // 010, 000, 020, 041, 048, FX
+  *p++ = 0x80 | item | 0x08;            // 049, video block, 140
+
+  *p++ = v.sac;                         // I240/010
+  *p++ = v.sic;
+  *p++ = CAT240_MSG_VIDEO;              // I240/000
+  put32(p, v.msg_index);                p += 4;   // I240/020
+
+  put16(p, v.start_az);                 p += 2;   // I240/041
+  put16(p, v.end_az);                   p += 2;
+  put32(p, v.start_rg);                 p += 4;
+  put32(p, v.cell_dur);                 p += 4;
+
+  *p++ = v.compressed ? 0x80 : 0;       // I240/048
+  *p++ = v.res;
+
+  put16(p, len);                        p += 2;   // I240/049
+  put24(p, v.cells);                    p += 3;
+
+  *p++ = rep;                           // I240/050..052
+  memcpy(p, data, len);
+  memset(p + len, 0, rep * blk - len);
+  p += rep * blk;
+
+  put24(p, v.tod);                      p += 3;   // I240/140
+
+  return p - out;
+}
+
+uint32_t cat240DecodeBlock(const uint8_t* buf, uint32_t len, Cat240Video* v) {
+  if (len < 3 || buf[0] != CAT240_CATEGORY)
+    return 0;
+
+  uint32_t blen = get16(&buf[1]);
+  if (blen < 4 || blen > len)
+    return 0;
+
+  memset(v, 0, sizeof(*v));
+
+  const uint8_t* p   = buf + 3;
+  const uint8_t* end = buf + blen;
+
+  // FRN presence bits, 7 per FSPEC octet
+  uint32_t frns = 0, shift = 0;
+  do {
+    if (p >= end || shift > 7)
+      return 0;
+    frns |= (uint32_t)(*p >> 1) << shift;
+    shift += 7;
+  } while (*p++ & 1);
+
+  uint8_t  msg_type = 0;
+  uint32_t nb_vb    = 0;
+  bool     has_cnt  = false;
+
+  for (int frn = 1; frn <= 14; frn++) {
+    if (!((frns >> (7 * ((frn - 1) / 7))) & (0x40 >> ((frn - 1) % 7))))
+      continue;
+
+    uint32_t n;
+    switch (frn) {
+    case 1:  n = 2;  break;
+    case 2:  n = 1;  break;
+    case 3:  n = 4;  break;
+    case 4:  n = (p < end) ? 1 + p[0] : 1; break;
+    case 5:
+    case 6:  n = 12; break;
+    case 7:  n = 2;  break;
+    case 8:  n = 5;  break;
+    case 9:  n = (p < end) ? 1 + p[0] * 4 : 1;   break;
+    case 10: n = (p < end) ? 1 + p[0] * 64 : 1;  break;
+    case 11: n = (p < end) ? 1 + p[0] * 256 : 1; break;
+    case 12: n = 3;  break;
+    default: n = (p < end) ? p[0] : 1; break;  // RE and SP carry their length
+    }
+
+    if (n == 0 || p + n > end)
+      return 0;
+
+    switch (frn) {
+    case 1:
+      v->sac = p[0];
+      v->sic = p[1];
+      break;
+    case 2:
+      msg_type = p[0];
+      break;
+    case 3:
+      v->msg_index = get32(p);
+      break;
+    case 5:
+    case 6: {
+      v->start_az = get16(p);
+      v->end_az   = get16(p + 2);
+      v->start_rg = get32(p + 4);
+
+      uint64_t dur = get32(p + 8);
+      if (frn == 5)
+        dur *= 1000000;  // Nanoseconds
+      v->cell_dur = (dur > 0xFFFFFFFFull) ? 0xFFFFFFFFu : (uint32_t) dur;
+      break;
+    }
+    case 7:
+      v->compressed = (p[0] & 0x80) != 0;
+      v->res        = p[1];
+      break;
+    case 8:
+      nb_vb    = get16(p);
+      v->cells = get24(p + 2);
+      has_cnt  = true;
+      break;
+    case 9:
+    case 10:
+    case 11:
+      v->data     = p + 1;
+      v->data_len = n - 1;
+      break;
+    case 12:
+      v->tod = get24(p);
+      break;
+    }
+
+    p += n;
+  }
+
+  if (msg_type != CAT240_MSG_VIDEO || !has_cnt || v->data == NULL || nb_vb > v->data_len) {
+    v->cells    = 0;
+    v->data     = NULL;
+    v->data_len = 0;
+    return blen;
+  }
+
+  v->data_len = nb_vb;
+  return blen;
+}
+
+int cat240UnpackCells(const Cat240Video& v, float* amps, uint32_t max_cells, uint8_t* tmp, uint32_t tmp_size) {
+  if (v.res < CAT240_RES_1BIT || v.res > CAT240_RES_8BIT)
+    return -1;
+
+  const uint8_t* d = v.data;
+  uint32_t len = v.data_len;
+
+  if (v.compressed) {
+    int n = cat240Decompress(d, len, tmp, tmp_size);
+    if (n < 0)
+      return -1;
+    d   = tmp;
+    len = n;
+  }
+
+  const uint32_t nbits = 1 << (v.res - 1);
+  if (((uint64_t)v.cells * nbits + 7) / 8 > len)
+    return -1;
+
+  uint32_t cells = (v.cells < max_cells) ? v.cells : max_cells;
+
+  if (nbits == 8) {
+    for (uint32_t i = 0; i < cells; i++)
+      amps[i] = d[i];
+    return cells;
+  }
+
+  const uint32_t mask  = (1 << nbits) - 1;
+  const float    scale = 255.f / mask;
+  for (uint32_t i = 0, bit = 0; i < cells; i++, bit += nbits)
+    amps[i] = ((d[bit >> 3] >> (8 - nbits - (bit & 7))) & mask) * scale;
+
+  return cells;
+}
+
+uint32_t cat240CellDuration(float range, uint32_t brg_size) {
+  double cell = range * CAT240_METERS_PER_MILE / brg_size;
+  double fs   = 2.0 * cell / CAT240_SPEED_OF_LIGHT * 1e15;
+  return (fs >= 4294967295.0) ? 0xFFFFFFFFu : (uint32_t)(fs + 0.5);
+}
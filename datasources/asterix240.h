@@ -0,0 +1,67 @@
+#ifndef ASTERIX240_H
+#define ASTERIX240_H
+
+#include <stdint.h>
+
+// ASTERIX category 240 (radar video transmission) records.
+// One video message per data block: I240/010, I240/000, I240/020,
+// I240/041, I240/048, I240/049, one of I240/050..052 and I240/140.
+
+#define CAT240_CATEGORY     240
+
+#define CAT240_MSG_SUMMARY  1
+#define CAT240_MSG_VIDEO    2
+
+// I240/048 cell resolutions
+#define CAT240_RES_1BIT     1
+#define CAT240_RES_2BIT     2
+#define CAT240_RES_4BIT     3
+#define CAT240_RES_8BIT     4
+
+#define CAT240_HEADER_SIZE  35     // Data block and record bytes besides the video blocks
+#define CAT240_MAX_BLOCK    65535  // Largest data block
+
+// Fields of a video message
+struct Cat240Video {
+  uint8_t  sac;
+  uint8_t  sic;
+  uint32_t msg_index;   // Message counter, wraps at 2^32
+  uint16_t start_az;    // 360/65536 degree units
+  uint16_t end_az;
+  uint32_t start_rg;    // Index of the first cell
+  uint32_t cell_dur;    // Femtoseconds
+  uint8_t  res;
+  bool     compressed;  // Cells are PackBits coded
+  uint32_t cells;       // Number of cells in the message
+  uint32_t tod;         // Time of day, 1/128 s
+
+  const uint8_t* data;  // Video octets, set by cat240DecodeBlock
+  uint32_t       data_len;
+};
+
+// Quantises n amplitudes (0..255) to the resolution, first cell in the most
+// significant bits. Returns the number of octets written
+uint32_t cat240PackCells(const float* amps, uint32_t n, uint8_t res, uint8_t* out);
+
+// PackBits run-length coding. Out must hold len + (len + 127) / 128 octets
+uint32_t cat240Compress(const uint8_t* in, uint32_t len, uint8_t* out);
+
+// Decodes up to max octets, returns the number of octets or -1 on malformed input
+int cat240Decompress(const uint8_t* in, uint32_t len, uint8_t* out, uint32_t max);
+
+// Writes a data block with the message and video octets. Returns its
+// length or 0 if it does not fit into size octets
+uint32_t cat240EncodeBlock(const Cat240Video& v, const uint8_t* data, uint32_t len, uint8_t* out, uint32_t size);
+
+// Parses the data block at buf. Returns its length (also for messages
+// other than video, with v->cells set to 0) or 0 if it is malformed
+uint32_t cat240DecodeBlock(const uint8_t* buf, uint32_t len, Cat240Video* v);
+
+// Expands the cells of a decoded message to amplitudes 0..255. Tmp must
+// hold the uncompressed octets. Returns the number of cells or -1
+int cat240UnpackCells(const Cat240Video& v, float* amps, uint32_t max_cells, uint8_t* tmp, uint32_t tmp_size);
+
+// Cell duration for the range of brg_size cells in miles
+uint32_t cat240CellDuration(float range, uint32_t brg_size);
+
+#endif // ASTERIX240_H
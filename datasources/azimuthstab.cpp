@@ -0,0 +1,164 @@
+#include "azimuthstab.h"
+
+#include <math.h>
+#include <string.h>
+
+AzimuthStabiliser::AzimuthStabiliser(uint32_t brg_count, uint32_t brg_size) {
+  _brg_count = brg_count;
+  _brg_size  = brg_size;
+  _amps.assign((size_t)brg_count * brg_size, 0.f);
+
+  memset(_samples, 0, sizeof(_samples));
+  _written  = 0;
+  _last_raw = 0;
+  _enabled.store(false);
+
+  _win_count  = 0;
+  _win_pos    = 0;
+  _batch_t0   = 0;
+  _batch_step = 0;
+  _batch_idx  = 0;
+  _batch_n    = 0;
+  _last_batch = 0;
+  _prev_row   = -1;
+
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+AzimuthStabiliser::~AzimuthStabiliser() {
+}
+
+void AzimuthStabiliser::addHeading(uint64_t t_ns, float hdg) {
+  std::lock_guard<std::mutex> lock(_lock);
+
+  double h = hdg;
+  if (_written > 0) {
+    // Continue from the previous sample by the shortest turn
+    const HeadingSample& prev = _samples[(_written - 1) % AS_SAMPLES];
+    double d = hdg - _last_raw;
+    d -= 360.0 * floor((d + 180.0) / 360.0);
+    h = prev.hdg + d;
+
+    if (t_ns <= prev.t_ns)
+      t_ns = prev.t_ns + 1;
+  }
+
+  HeadingSample& s = _samples[_written % AS_SAMPLES];
+  s.t_ns = t_ns;
+  s.hdg  = h;
+
+  _last_raw = hdg;
+  _written++;
+}
+
+void AzimuthStabiliser::setEnabled(bool on) {
+  _enabled.store(on);
+}
+
+void AzimuthStabiliser::beginBatch(uint64_t t_ns, uint32_t n) {
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+
+    _win_count = (_written < AS_WINDOW) ? (uint32_t)_written : AS_WINDOW;
+    for (uint32_t i = 0; i < _win_count; i++)
+      _win[i] = _samples[(_written - _win_count + i) % AS_SAMPLES];
+    _stats.headings = _written;
+  }
+  _win_pos = 0;
+
+  // Bearings of the batch were acquired since the previous one
+  if (_last_batch == 0 || n == 0 || t_ns <= _last_batch || t_ns - _last_batch > AS_MAX_BATCH_MS * 1000000ull) {
+    _batch_t0   = t_ns;
+    _batch_step = 0;
+    _prev_row   = -1;
+  } else {
+    _batch_step = (t_ns - _last_batch) / n;
+    _batch_t0   = t_ns - _batch_step * (n - 1);
+  }
+
+  _batch_idx  = 0;
+  _batch_n    = n;
+  _last_batch = t_ns;
+  _stats.batches++;
+}
+
+float AzimuthStabiliser::headingAt(uint64_t t_ns) {
+  double h;
+
+  if (_win_count == 0) {
+    _stats.held++;
+    return 0.f;
+  }
+
+  const HeadingSample& last = _win[_win_count - 1];
+
+  if (t_ns <= _win[0].t_ns) {
+    h = _win[0].hdg;
+    _stats.held++;
+  } else if (t_ns >= last.t_ns) {
+    // Past the last sample the turn rate of the last segment goes on for a while
+    uint64_t dt = t_ns - last.t_ns;
+    if (dt > AS_EXTRAPOLATE_MS * 1000000ull) {
+      dt = AS_EXTRAPOLATE_MS * 1000000ull;
+      _stats.held++;
+    } else {
+      _stats.extrapolated++;
+    }
+
+    h = last.hdg;
+    if (_win_count > 1) {
+      const HeadingSample& prev = _win[_win_count - 2];
+      h += (last.hdg - prev.hdg) * (double)dt / (double)(last.t_ns - prev.t_ns);
+    }
+  } else {
+    // Bearing times grow within a batch, the segment search goes forward
+    if (t_ns < _win[_win_pos].t_ns)
+      _win_pos = 0;
+    while (_win[_win_pos + 1].t_ns <= t_ns)
+      _win_pos++;
+
+    const HeadingSample& a = _win[_win_pos];
+    const HeadingSample& b = _win[_win_pos + 1];
+    h = a.hdg + (b.hdg - a.hdg) * (double)(t_ns - a.t_ns) / (double)(b.t_ns - a.t_ns);
+  }
+
+  h -= 360.0 * floor(h / 360.0);
+  return (float)h;
+}
+
+uint32_t AzimuthStabiliser::place(uint32_t brg, const float* amps, bool fill, uint32_t* first) {
+  uint64_t t = _batch_t0 + _batch_step * _batch_idx;
+  if (_batch_idx + 1 < _batch_n)
+    _batch_idx++;
+
+  uint32_t shift = (uint32_t)lrintf(headingAt(t) * _brg_count / 360.f) % _brg_count;
+  uint32_t r     = (brg + shift) % _brg_count;
+
+  memcpy(row(r), amps, _brg_size * sizeof(float));
+  *first = r;
+  _stats.bearings++;
+
+  if (!fill)
+    return r;
+
+  // Rows the heading change stepped over would stay from the previous revolution
+  if (_prev_row >= 0) {
+    uint32_t d = (r + _brg_count - (uint32_t)_prev_row) % _brg_count;
+    if (d > 1 && d <= AS_MAX_FILL) {
+      for (uint32_t k = 1; k < d; k++)
+        memcpy(row(((uint32_t)_prev_row + k) % _brg_count), amps, _brg_size * sizeof(float));
+
+      *first = ((uint32_t)_prev_row + 1) % _brg_count;
+      _stats.filled += d - 1;
+    }
+  }
+
+  _prev_row = r;
+  return r;
+}
+
+void AzimuthStabiliser::printStats(FILE* f) const {
+  fprintf(f, "Azimuth stabilisation: %llu headings, %llu bearings in %llu batches, %llu rows filled, %llu extrapolated, %llu held\n"
+          , (unsigned long long)_stats.headings, (unsigned long long)_stats.bearings, (unsigned long long)_stats.batches
+          , (unsigned long long)_stats.filled, (unsigned long long)_stats.extrapolated, (unsigned long long)_stats.held);
+}
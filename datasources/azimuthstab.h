@@ -0,0 +1,88 @@
+#ifndef AZIMUTHSTAB_H
+#define AZIMUTHSTAB_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#define AS_SAMPLES        64    // Heading history kept
+#define AS_WINDOW         8     // Latest samples taken by a batch
+#define AS_EXTRAPOLATE_MS 500   // Heading is extrapolated this far past the last sample, then held
+#define AS_MAX_FILL       16    // Largest gap between north indexes filled with the same bearing
+#define AS_MAX_BATCH_MS   1000  // Longer pauses between batches do not spread timestamps
+
+// Heading sample, unwrapped so that interpolation never crosses 0/360
+struct HeadingSample {
+  uint64_t t_ns;   // CLOCK_MONOTONIC
+  double   hdg;    // Degrees, continuous
+};
+
+struct AzimuthStabStats {
+  uint64_t headings;
+  uint64_t batches;
+  uint64_t bearings;
+  uint64_t filled;        // North rows filled from a neighbouring bearing
+  uint64_t extrapolated;  // Bearings newer than the last heading sample
+  uint64_t held;          // Bearings outside the heading samples or without headings
+};
+
+// Per-bearing azimuth stabilisation. Heading samples come from the NMEA
+// side with their arrival time, bearings are stamped by the acquisition
+// thread and placed at north-referenced rows using the heading
+// interpolated for their own time. A batch takes a snapshot of the last
+// samples under the lock, the per-bearing lookup then walks it forward.
+class AzimuthStabiliser {
+public:
+  AzimuthStabiliser(uint32_t brg_count, uint32_t brg_size);
+  ~AzimuthStabiliser();
+
+  // Any thread
+  void addHeading(uint64_t t_ns, float hdg);
+  void setEnabled(bool on);
+  inline bool enabled() const { return _enabled.load(); }
+
+  // Processing thread. A batch of n bearings acquired since the previous
+  // batch up to t_ns, their timestamps are spread evenly over the interval
+  void beginBatch(uint64_t t_ns, uint32_t n);
+
+  // Places the next bearing of the batch (head-referenced brg) and returns
+  // its north-referenced row. With fill the rows skipped since the previous
+  // placed bearing get the same amplitudes, *first is the first row written
+  uint32_t place(uint32_t brg, const float* amps, bool fill, uint32_t* first);
+  inline float* row(uint32_t n) { return &_amps[(size_t)n * _brg_size]; }
+
+  // Heading at t_ns from the batch snapshot, degrees in [0, 360)
+  float headingAt(uint64_t t_ns);
+
+  inline const AzimuthStabStats& stats() const { return _stats; }
+  void printStats(FILE* f) const;
+
+private:
+  uint32_t _brg_count;
+  uint32_t _brg_size;
+  std::vector<float> _amps;   // North-referenced revolution
+
+  // Heading history, GUI thread writes
+  std::mutex    _lock;
+  HeadingSample _samples[AS_SAMPLES];
+  uint64_t      _written;
+  float         _last_raw;
+  std::atomic<bool> _enabled;
+
+  // Processing thread state
+  HeadingSample _win[AS_WINDOW];
+  uint32_t      _win_count;
+  uint32_t      _win_pos;     // Segment of the last lookup
+  uint64_t      _batch_t0;
+  uint64_t      _batch_step;  // Nanoseconds between bearings of the batch
+  uint32_t      _batch_idx;
+  uint32_t      _batch_n;
+  uint64_t      _last_batch;
+  int64_t       _prev_row;    // Last row placed, -1 after a pause
+
+  AzimuthStabStats _stats;
+};
+
+#endif // AZIMUTHSTAB_H
@@ -0,0 +1,100 @@
+#include "bearingrecorder.h"
+#include "radardatasource.h"
+
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#define BREC_BLOCK_BEARINGS 64  // Bearings written to disk at once
+#define BREC_IDLE_MS        5   // Sleep while the ring is empty
+
+void qSleep(int ms);
+
+BearingRecorder::BearingRecorder(BearingRing* ring) {
+  _ring        = ring;
+  _consumer    = -1;
+  _file        = NULL;
+  _finish_flag = true;
+  _buf         = new uint32_t[BREC_BLOCK_BEARINGS * BEARING_PACK_WORDS];
+  _buf_count   = 0;
+}
+
+BearingRecorder::~BearingRecorder() {
+  finish();
+  delete [] _buf;
+}
+
+bool BearingRecorder::start(const char* filename) {
+  if (_worker_thread.isRunning())
+    return false;
+
+  _file = fopen(filename, "wb");
+  if (_file == NULL) {
+    fprintf(stderr, "%s: failed to open %s: %s\n", __func__, filename, strerror(errno));
+    return false;
+  }
+
+  _consumer = _ring->addConsumer("recorder");
+  if (_consumer < 0) {
+    fprintf(stderr, "%s: no free bearing ring consumer\n", __func__);
+    fclose(_file);
+    _file = NULL;
+    return false;
+  }
+
+  _finish_flag   = false;
+  _worker_thread = QtConcurrent::run(this, &BearingRecorder::worker);
+  return true;
+}
+
+void BearingRecorder::finish() {
+  _finish_flag = true;
+  _worker_thread.waitForFinished();
+
+  if (_consumer >= 0) {
+    _ring->removeConsumer(_consumer);
+    _consumer = -1;
+  }
+
+  if (_file != NULL) {
+    fclose(_file);
+    _file = NULL;
+  }
+}
+
+void BearingRecorder::flush() {
+  if (_buf_count == 0)
+    return;
+
+  if (fwrite(_buf, BEARING_PACK_WORDS * sizeof(uint32_t), _buf_count, _file) != _buf_count)
+    fprintf(stderr, "%s: write failed: %s\n", __func__, strerror(errno));
+
+  _buf_count = 0;
+}
+
+void BearingRecorder::worker() {
+  static float amps[PELENG_SIZE];
+  uint32_t brg;
+
+  while (!_finish_flag) {
+    if (!_ring->read(_consumer, &brg, amps)) {
+      flush();
+      qSleep(BREC_IDLE_MS);
+      continue;
+    }
+
+    uint32_t* pack = &_buf[_buf_count * BEARING_PACK_WORDS];
+    memset(pack, 0, BEARING_PACK_WORDS * sizeof(uint32_t));
+
+    pack[0] = brg;
+    pack[1] = PELENG_SIZE;
+    pack[2] = 1;
+    for (int i = 0; i < PELENG_SIZE; i++)
+      pack[i + 3] = (uint32_t) lrintf(amps[i]);
+
+    if (++_buf_count == BREC_BLOCK_BEARINGS)
+      flush();
+  }
+
+  flush();
+}
@@ -0,0 +1,41 @@
+#ifndef BEARINGRECORDER_H
+#define BEARINGRECORDER_H
+
+#include "bearingring.h"
+
+#include <stdio.h>
+#include <QtGlobal>
+
+#if QT_VERSION >= 0x050000
+    #include <QtConcurrent/QtConcurrentRun>
+#else
+    #include <QtConcurrentRun>
+#endif
+
+// Disk recorder of processed bearings. Reads the bearing ring as an
+// independent consumer and writes packets in the dump file layout
+// (bearing, amps count, divisor, amps) of BEARING_PACK_WORDS words each
+class BearingRecorder {
+public:
+  explicit BearingRecorder(BearingRing* ring);
+  virtual ~BearingRecorder();
+
+  bool start(const char* filename);
+  void finish();
+
+private:
+  void worker();
+  void flush();
+
+  BearingRing* _ring;
+  int          _consumer;
+  FILE*        _file;
+  bool         _finish_flag;
+
+  uint32_t*    _buf;
+  uint32_t     _buf_count;
+
+  QFuture<void> _worker_thread;
+};
+
+#endif // BEARINGRECORDER_H
@@ -0,0 +1,183 @@
+#include "bearingring.h"
+
+#include <string.h>
+
+#define BRING_SLOT_BUSY UINT64_MAX
+
+BearingRing::BearingRing(uint32_t capacity, uint32_t brg_size) {
+  _capacity = 1;
+  while (_capacity < capacity)
+    _capacity <<= 1;
+
+  _mask     = _capacity - 1;
+  _brg_size = brg_size;
+
+  _slots = new Slot[_capacity];
+  for (uint32_t i = 0; i < _capacity; i++) {
+    _slots[i].seq.store(BRING_SLOT_BUSY);
+    _slots[i].brg.store(0);
+    _slots[i].t_ns.store(0);
+  }
+
+  _data.resize((size_t)_capacity * _brg_size);
+  _head.store(0);
+
+  for (int i = 0; i < BRING_MAX_CONSUMERS; i++) {
+    _consumers[i].active.store(false);
+    _consumers[i].name = "";
+  }
+}
+
+BearingRing::~BearingRing() {
+  delete [] _slots;
+}
+
+void BearingRing::publish(uint32_t brg, const float* amps, uint64_t t_ns) {
+  uint64_t seq  = _head.load(std::memory_order_relaxed);
+  Slot&    slot = _slots[seq & _mask];
+
+  // Readers check the slot sequence before and after copying
+  slot.seq.store(BRING_SLOT_BUSY, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.brg.store(brg, std::memory_order_relaxed);
+  slot.t_ns.store(t_ns, std::memory_order_relaxed);
+  memcpy(&_data[(seq & _mask) * _brg_size], amps, _brg_size * sizeof(float));
+
+  slot.seq.store(seq, std::memory_order_release);
+  _head.store(seq + 1, std::memory_order_release);
+}
+
+int BearingRing::addConsumer(const char* name) {
+  for (int i = 0; i < BRING_MAX_CONSUMERS; i++) {
+    Consumer& c = _consumers[i];
+    bool inactive = false;
+
+    if (!c.active.compare_exchange_strong(inactive, true))
+      continue;
+
+    c.cursor.store(_head.load(std::memory_order_acquire));
+    c.read.store(0);
+    c.overruns.store(0);
+    c.skipped.store(0);
+    c.max_lag.store(0);
+    c.name = name;
+    return i;
+  }
+
+  return -1;
+}
+
+void BearingRing::removeConsumer(int cons) {
+  if (cons >= 0 && cons < BRING_MAX_CONSUMERS)
+    _consumers[cons].active.store(false);
+}
+
+void BearingRing::overrun(Consumer& c, uint64_t head) {
+  // Resume half a ring behind the writer so the consumer is not lapped again at once
+  uint64_t cur = c.cursor.load(std::memory_order_relaxed);
+  uint64_t next = (head > _capacity / 2) ? head - _capacity / 2 : 0;
+
+  if (next < cur)
+    next = cur + 1;
+
+  c.overruns.fetch_add(1, std::memory_order_relaxed);
+  c.skipped.fetch_add(next - cur, std::memory_order_relaxed);
+  c.cursor.store(next, std::memory_order_release);
+}
+
+bool BearingRing::read(int cons, uint32_t* brg, float* amps, uint64_t* t_ns) {
+  return take(_consumers[cons], BRING_ANY_BRG, brg, amps, t_ns);
+}
+
+uint32_t BearingRing::readRun(int cons, uint32_t* first, float* amps, uint32_t max) {
+  Consumer& c = _consumers[cons];
+  uint32_t n = 0;
+  uint32_t brg;
+
+  while (n < max && take(c, n > 0 ? *first + n : BRING_ANY_BRG, &brg, amps + n * _brg_size, NULL)) {
+    if (n == 0)
+      *first = brg;
+    n++;
+  }
+
+  return n;
+}
+
+bool BearingRing::take(Consumer& c, uint32_t expect, uint32_t* brg, float* amps, uint64_t* t_ns) {
+  for (;;) {
+    uint64_t head = _head.load(std::memory_order_acquire);
+    uint64_t cur  = c.cursor.load(std::memory_order_relaxed);
+
+    if (cur >= head)
+      return false;
+
+    if (head - cur > _capacity) {
+      overrun(c, head);
+      continue;
+    }
+
+    if (head - cur > c.max_lag.load(std::memory_order_relaxed))
+      c.max_lag.store(head - cur, std::memory_order_relaxed);
+
+    Slot& slot = _slots[cur & _mask];
+    if (slot.seq.load(std::memory_order_acquire) != cur) {
+      overrun(c, _head.load(std::memory_order_acquire));
+      continue;
+    }
+
+    *brg = slot.brg.load(std::memory_order_relaxed);
+    if (expect != BRING_ANY_BRG && *brg != expect)
+      return false;
+
+    uint64_t t = slot.t_ns.load(std::memory_order_relaxed);
+    memcpy(amps, &_data[(cur & _mask) * _brg_size], _brg_size * sizeof(float));
+
+    // Slot has been rewritten while copying
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != cur) {
+      overrun(c, _head.load(std::memory_order_acquire));
+      continue;
+    }
+
+    if (t_ns)
+      *t_ns = t;
+
+    c.cursor.store(cur + 1, std::memory_order_release);
+    c.read.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+}
+
+BearingRingConsumerStats BearingRing::consumerStats(int cons) const {
+  BearingRingConsumerStats st;
+  memset(&st, 0, sizeof(st));
+
+  if (cons < 0 || cons >= BRING_MAX_CONSUMERS)
+    return st;
+
+  const Consumer& c = _consumers[cons];
+  uint64_t head = _head.load(std::memory_order_acquire);
+  uint64_t cur  = c.cursor.load(std::memory_order_acquire);
+
+  st.read     = c.read.load(std::memory_order_relaxed);
+  st.overruns = c.overruns.load(std::memory_order_relaxed);
+  st.skipped  = c.skipped.load(std::memory_order_relaxed);
+  st.lag      = (head > cur) ? head - cur : 0;
+  st.max_lag  = c.max_lag.load(std::memory_order_relaxed);
+  return st;
+}
+
+void BearingRing::printStats(FILE* f) const {
+  fprintf(f, "Bearing ring: %llu published, %u slots\n", (unsigned long long)published(), _capacity);
+
+  for (int i = 0; i < BRING_MAX_CONSUMERS; i++) {
+    if (!_consumers[i].active.load(std::memory_order_acquire))
+      continue;
+
+    BearingRingConsumerStats st = consumerStats(i);
+    fprintf(f, "  %s: lag %llu (max %llu), read %llu, overruns %llu (%llu bearings skipped)\n"
+            , _consumers[i].name, (unsigned long long)st.lag, (unsigned long long)st.max_lag
+            , (unsigned long long)st.read, (unsigned long long)st.overruns, (unsigned long long)st.skipped);
+  }
+}
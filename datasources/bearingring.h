@@ -0,0 +1,84 @@
+#ifndef BEARINGRING_H
+#define BEARINGRING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+
+#define BRING_MAX_CONSUMERS 8
+#define BRING_ANY_BRG       UINT32_MAX
+
+// Per-consumer ring statistics
+struct BearingRingConsumerStats {
+  uint64_t read;       // Bearings read by the consumer
+  uint64_t overruns;   // Number of times the writer has lapped the consumer
+  uint64_t skipped;    // Bearings lost because of overruns
+  uint64_t lag;        // Bearings published but not read yet
+  uint64_t max_lag;    // Largest lag seen by the consumer
+};
+
+// Broadcast ring of processed bearings with one writer and independent
+// consumer cursors. Writer never waits for consumers: a consumer which
+// falls more than a ring behind is moved forward and the loss is counted.
+class BearingRing {
+public:
+  BearingRing(uint32_t capacity, uint32_t brg_size);
+  ~BearingRing();
+
+  // Writer side (acquisition thread only). t_ns is the acquisition time
+  // of the bearing (CLOCK_MONOTONIC), 0 if unknown
+  void publish(uint32_t brg, const float* amps, uint64_t t_ns = 0);
+
+  inline uint64_t published() const { return _head.load(std::memory_order_acquire); }
+
+  // Consumer side. Each consumer id must be used from one thread only
+  int  addConsumer(const char* name);
+  void removeConsumer(int cons);
+
+  // Copies the next bearing into amps (brg_size values), false if there is nothing new
+  bool read(int cons, uint32_t* brg, float* amps, uint64_t* t_ns = NULL);
+  // Copies up to max bearings following one another (first, first + 1, ...)
+  // into amps and returns their number, 0 if there is nothing new. A bearing
+  // which does not follow is left for the next call
+  uint32_t readRun(int cons, uint32_t* first, float* amps, uint32_t max);
+
+  BearingRingConsumerStats consumerStats(int cons) const;
+  void printStats(FILE* f) const;
+
+  inline uint32_t capacity() const { return _capacity; }
+  inline uint32_t bearingSize() const { return _brg_size; }
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> seq;  // Sequence number of the bearing in the slot
+    std::atomic<uint32_t> brg;
+    std::atomic<uint64_t> t_ns;
+  };
+
+  struct Consumer {
+    std::atomic<bool>     active;
+    std::atomic<uint64_t> cursor;   // Next sequence number to read
+    std::atomic<uint64_t> read;
+    std::atomic<uint64_t> overruns;
+    std::atomic<uint64_t> skipped;
+    std::atomic<uint64_t> max_lag;
+    const char*           name;
+  };
+
+  void overrun(Consumer& c, uint64_t head);
+  bool take(Consumer& c, uint32_t expect, uint32_t* brg, float* amps, uint64_t* t_ns);
+
+  uint32_t _capacity;
+  uint32_t _mask;
+  uint32_t _brg_size;
+
+  Slot*              _slots;
+  std::vector<float> _data;
+
+  std::atomic<uint64_t> _head;     // Sequence number of the next bearing to publish
+
+  Consumer _consumers[BRING_MAX_CONSUMERS];
+};
+
+#endif // BEARINGRING_H
@@ -0,0 +1,145 @@
+#include "bearingsync.h"
+
+#include <string.h>
+
+BearingSync::BearingSync(uint32_t brg_count, uint32_t max_gap, uint32_t stab_len, uint32_t reorder_win)
+  : _missing(brg_count, false) {
+  _brg_count = brg_count;
+  _max_gap = max_gap;
+  _stab_len = stab_len > 0 ? stab_len : 1;
+  _reorder_win = reorder_win;
+
+  reset();
+  resetStats();
+}
+
+void BearingSync::reset() {
+  _state = BSS_NOTSYNC;
+  _head = 0;
+  _run_start = 0;
+  _run_len = 0;
+  _since_loss = 0;
+
+  _missing.assign(_brg_count, false);
+}
+
+void BearingSync::resetStats() {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+static int gapBin(uint32_t gap) {
+  int bin = 0;
+  while (gap > 1 && bin < BSYNC_GAP_BINS - 1) {
+    gap >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+void BearingSync::startRun(uint32_t brg) {
+  _head = brg;
+  _run_start = brg;
+  _run_len = 1;
+}
+
+void BearingSync::loseSync(uint32_t brg) {
+  _stats.resyncs++;
+  _state = BSS_WAIT4STAB;
+  _since_loss = 0;
+  startRun(brg);
+}
+
+BearingSync::result_t BearingSync::push(uint32_t brg) {
+  _stats.bearings++;
+
+  if (brg >= _brg_count)
+    return BSR_INVALID;
+
+  if (_state == BSS_SYNC) {
+    uint32_t d = distance(_head, brg);
+
+    if (d == 1) {
+      _head = brg;
+      _missing[brg] = false;
+      _stats.accepted++;
+      return BSR_ACCEPT;
+    }
+
+    if (d == 0) {
+      _stats.duplicates++;
+      return BSR_DROP;
+    }
+
+    // Forward jump within tolerance: mark the skipped bearings and go on
+    if (d <= _max_gap + 1) {
+      uint32_t gap = d - 1;
+      for (uint32_t i = 1; i <= gap; i++)
+        _missing[(_head + i) % _brg_count] = true;
+
+      _stats.missing += gap;
+      _stats.gap_hist[gapBin(gap)]++;
+
+      _head = brg;
+      _missing[brg] = false;
+      _stats.accepted++;
+      return BSR_ACCEPT;
+    }
+
+    // Bearing arrived shortly after its successors
+    if (_brg_count - d <= _reorder_win) {
+      if (_missing[brg]) {
+        _missing[brg] = false;
+        _stats.late++;
+        return BSR_LATE;
+      }
+
+      _stats.duplicates++;
+      return BSR_DROP;
+    }
+
+    if (d < _brg_count / 2)
+      _stats.gap_hist[BSYNC_GAP_BINS - 1]++;
+
+    loseSync(brg);
+  } else if (_state == BSS_NOTSYNC) {
+    _state = BSS_WAIT4STAB;
+    startRun(brg);
+  } else if (brg == (_head + 1) % _brg_count) {
+    _head = brg;
+    _run_len++;
+  } else {
+    startRun(brg);
+  }
+
+  _since_loss++;
+
+  if (_run_len >= _stab_len) {
+    _state = BSS_SYNC;
+
+    // Bearings of the stable run are valid, so forget the old gaps
+    _missing.assign(_brg_count, false);
+
+    _stats.last_recovery = _since_loss;
+    if (_since_loss > _stats.max_recovery)
+      _stats.max_recovery = _since_loss;
+
+    _stats.accepted++;
+    return BSR_ACCEPT;
+  }
+
+  _stats.unsynced++;
+  return BSR_HOLD;
+}
+
+void BearingSync::printStats(FILE* f) const {
+  fprintf(f, "Bearing sync: %llu brgs, %llu accepted, %llu late, %llu dup, %llu unsynced, %llu missing, %llu resyncs, recovery %u (max %u)\n"
+          , (unsigned long long)_stats.bearings, (unsigned long long)_stats.accepted
+          , (unsigned long long)_stats.late, (unsigned long long)_stats.duplicates
+          , (unsigned long long)_stats.unsynced, (unsigned long long)_stats.missing
+          , (unsigned long long)_stats.resyncs, _stats.last_recovery, _stats.max_recovery);
+
+  fprintf(f, "Bearing gaps:");
+  for (int i = 0; i < BSYNC_GAP_BINS; i++)
+    fprintf(f, " %s%u:%llu", (i == BSYNC_GAP_BINS - 1) ? ">=" : "", 1u << i, (unsigned long long)_stats.gap_hist[i]);
+  fprintf(f, "\n");
+}
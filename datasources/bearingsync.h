@@ -0,0 +1,83 @@
+#ifndef BEARINGSYNC_H
+#define BEARINGSYNC_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#define BSYNC_GAP_BINS 8 // Gap histogram bins: 1, 2-3, 4-7, ..., 64-127, >= 128 bearings
+
+// Bearing stream synchronization statistics
+struct BearingSyncStats {
+  uint64_t bearings;                  // Bearings pushed into the synchronizer
+  uint64_t accepted;                  // Bearings accepted in order
+  uint64_t late;                      // Bearings accepted out of order into a marked gap
+  uint64_t duplicates;                // Bearings dropped as repeated or too late
+  uint64_t unsynced;                  // Bearings dropped while not in sync
+  uint64_t missing;                   // Bearings marked missing inside tolerated gaps
+  uint64_t resyncs;                   // Number of times synchronization has been lost
+  uint32_t last_recovery;             // Bearings from the last sync loss (or start) to sync
+  uint32_t max_recovery;              // Worst recovery seen so far
+  uint64_t gap_hist[BSYNC_GAP_BINS];  // Histogram of gap lengths (in bearings)
+};
+
+// Bearing sync state machine. Tolerates gaps up to max_gap bearings and
+// reordering within reorder_win bearings without leaving the sync state.
+// Larger disturbances restart synchronization which completes after
+// stab_len sequential bearings rather than a whole clean revolution.
+class BearingSync {
+public:
+  enum state_t {
+    BSS_NOTSYNC   = 0, // No bearing has been seen yet
+    BSS_WAIT4STAB = 1, // Waiting for stab_len sequential bearings
+    BSS_SYNC      = 2  // Stream is synchronized
+  };
+
+  enum result_t {
+    BSR_ACCEPT    = 0, // Bearing is the new head of the stream
+    BSR_LATE      = 1, // Bearing filled a gap behind the head of the stream
+    BSR_HOLD      = 2, // Bearing belongs to a stable run which is not long enough yet
+    BSR_DROP      = 3, // Bearing must not be used (duplicate or too late)
+    BSR_INVALID   = 4  // Bearing number is out of range
+  };
+
+  BearingSync(uint32_t brg_count, uint32_t max_gap = 64, uint32_t stab_len = 16, uint32_t reorder_win = 8);
+
+  void reset();
+  void resetStats();
+
+  result_t push(uint32_t brg);
+
+  inline state_t  state() const               { return _state; }
+  inline bool     synced() const              { return _state == BSS_SYNC; }
+  inline uint32_t head() const                { return _head; }
+  inline uint32_t firstStable() const         { return _run_start; }
+  inline bool     isMissing(uint32_t brg) const { return brg < _brg_count && _missing[brg]; }
+  inline const BearingSyncStats& stats() const { return _stats; }
+
+  // Number of bearings between from (exclusive) and to (inclusive) along the scan direction
+  inline uint32_t distance(uint32_t from, uint32_t to) const { return (to + _brg_count - from) % _brg_count; }
+
+  void printStats(FILE* f) const;
+
+private:
+  void startRun(uint32_t brg);
+  void loseSync(uint32_t brg);
+
+  uint32_t _brg_count;
+  uint32_t _max_gap;
+  uint32_t _stab_len;
+  uint32_t _reorder_win;
+
+  state_t  _state;
+  uint32_t _head;             // Last in-order bearing
+  uint32_t _run_start;        // First bearing of the current stable run
+  uint32_t _run_len;          // Length of the current stable run
+  uint32_t _since_loss;       // Bearings pushed since the sync has been lost
+
+  std::vector<bool> _missing; // Bearings skipped by a tolerated gap
+
+  BearingSyncStats _stats;
+};
+
+#endif // BEARINGSYNC_H
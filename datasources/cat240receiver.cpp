@@ -0,0 +1,260 @@
+#include "cat240receiver.h"
+
+#include <string.h>
+#include <errno.h>
+#include <algorithm>
+
+#ifndef Q_OS_WIN
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif // !Q_OS_WIN
+
+Cat240Receiver::Cat240Receiver(uint32_t brg_count, uint32_t brg_size) {
+  _brg_count = brg_count;
+  _brg_size  = brg_size;
+  _socket    = -1;
+
+  _dgrams.resize(C240_RX_BATCH * C240_RX_DATAGRAM);
+  _tmp.resize(C240_RX_DATAGRAM * 2);
+  _cells.resize(brg_size);
+
+  _cur_brg   = -1;
+  _cur_cells = 0;
+  _cur.resize(brg_size + 3);
+
+  _packets.resize((size_t)C240_RX_BATCH * (brg_size + 3));
+  _ready = 0;
+
+  _has_index  = false;
+  _next_index = 0;
+
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+Cat240Receiver::~Cat240Receiver() {
+  close();
+}
+
+bool Cat240Receiver::open(const char* address) {
+#ifdef Q_OS_WIN
+  fprintf(stderr, "%s: not supported\n", __func__);
+  return false;
+#else
+  char host[256];
+  const char* colon = strrchr(address, ':');
+  if (colon == NULL || colon == address || (size_t)(colon - address) >= sizeof(host)) {
+    fprintf(stderr, "%s: %s is not host:port\n", __func__, address);
+    return false;
+  }
+
+  memcpy(host, address, colon - address);
+  host[colon - address] = '\0';
+
+  struct addrinfo hints, *ai = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family   = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  int res = getaddrinfo(host, colon + 1, &hints, &ai);
+  if (res != 0 || ai == NULL) {
+    fprintf(stderr, "%s: %s: %s\n", __func__, address, gai_strerror(res));
+    return false;
+  }
+
+  struct sockaddr_in sin;
+  memcpy(&sin, ai->ai_addr, sizeof(sin));
+  freeaddrinfo(ai);
+
+  try
+  {
+    _socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_socket < 0)
+      throw errno;
+
+    // A full revolution can arrive while the processing thread is busy
+    int rcvbuf = 8 << 20;
+    setsockopt(_socket, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    bool mcast = IN_MULTICAST(ntohl(sin.sin_addr.s_addr));
+    if (mcast) {
+      int reuse = 1;
+      setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+      struct ip_mreq mreq;
+      mreq.imr_multiaddr        = sin.sin_addr;
+      mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+      sin.sin_addr.s_addr       = htonl(INADDR_ANY);
+
+      if (bind(_socket, (struct sockaddr*)&sin, sizeof(sin)) < 0)
+        throw errno;
+      if (setsockopt(_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+        throw errno;
+    } else if (bind(_socket, (struct sockaddr*)&sin, sizeof(sin)) < 0) {
+      throw errno;
+    }
+  }
+  catch(int err)
+  {
+    fprintf(stderr, "%s: %s: %s\n", __func__, address, strerror(err));
+    close();
+    return false;
+  }
+
+  _cur_brg   = -1;
+  _has_index = false;
+  return true;
+#endif // Q_OS_WIN
+}
+
+void Cat240Receiver::close() {
+#ifndef Q_OS_WIN
+  if (_socket >= 0)
+    ::close(_socket);
+#endif // !Q_OS_WIN
+  _socket = -1;
+}
+
+void Cat240Receiver::complete() {
+  if (_cur_brg < 0)
+    return;
+
+  if ((size_t)(_ready + 1) * (_brg_size + 3) > _packets.size())
+    _packets.resize(_packets.size() * 2);
+
+  memcpy(&_packets[(size_t)_ready * (_brg_size + 3)], &_cur[0], (_brg_size + 3) * sizeof(uint32_t));
+  _ready++;
+
+  _stats.bearings++;
+  if (_cur_cells < _brg_size)
+    _stats.partial++;
+
+  _cur_brg = -1;
+}
+
+void Cat240Receiver::record(const Cat240Video& v) {
+  _stats.records++;
+
+  // Index sequence: gaps are messages lost on the way
+  if (_has_index && v.msg_index != _next_index) {
+    int32_t d = (int32_t)(v.msg_index - _next_index);
+    if (d > 0)
+      _stats.lost += d;
+    else
+      _stats.reordered++;
+  }
+  if (!_has_index || (int32_t)(v.msg_index - _next_index) >= 0)
+    _next_index = v.msg_index + 1;
+  _has_index = true;
+
+  int32_t brg = (int32_t)((((uint64_t)v.start_az * _brg_count) + 32768) >> 16) % _brg_count;
+  if (brg != _cur_brg) {
+    complete();
+
+    _cur_brg   = brg;
+    _cur_cells = 0;
+    _cur[0]    = brg;
+    _cur[1]    = _brg_size;
+    _cur[2]    = 1;
+    memset(&_cur[3], 0, _brg_size * sizeof(uint32_t));
+  }
+
+  if (v.start_rg >= _brg_size)
+    return;
+
+  int n = cat240UnpackCells(v, &_cells[0], _brg_size - v.start_rg, &_tmp[0], _tmp.size());
+  if (n < 0) {
+    _stats.malformed++;
+    return;
+  }
+
+  uint32_t* dst = &_cur[3 + v.start_rg];
+  for (int i = 0; i < n; i++)
+    dst[i] = (uint32_t)_cells[i];
+
+  _cur_cells += n;
+  if (_cur_cells >= _brg_size)
+    complete();
+}
+
+void Cat240Receiver::decode(const uint8_t* buf, uint32_t len) {
+  uint32_t off = 0;
+
+  while (off < len) {
+    Cat240Video v;
+    uint32_t blen = cat240DecodeBlock(&buf[off], len - off, &v);
+    if (blen == 0) {
+      _stats.malformed++;
+      return;
+    }
+
+    off += blen;
+    if (v.cells == 0)
+      _stats.other++;
+    else
+      record(v);
+  }
+}
+
+int Cat240Receiver::receive(int timeout_ms) {
+  _ready = 0;
+
+#ifdef Q_OS_WIN
+  Q_UNUSED(timeout_ms);
+  return -1;
+#else
+  if (_socket < 0)
+    return -1;
+
+  struct pollfd pfd;
+  pfd.fd     = _socket;
+  pfd.events = POLLIN;
+
+  int res = poll(&pfd, 1, timeout_ms);
+  if (res < 0)
+    return (errno == EINTR) ? 0 : -1;
+  if (res == 0)
+    return 0;
+
+  struct mmsghdr msgs[C240_RX_BATCH];
+  struct iovec   iovs[C240_RX_BATCH];
+
+  memset(msgs, 0, sizeof(msgs));
+  for (int i = 0; i < C240_RX_BATCH; i++) {
+    iovs[i].iov_base = &_dgrams[i * C240_RX_DATAGRAM];
+    iovs[i].iov_len  = C240_RX_DATAGRAM;
+    msgs[i].msg_hdr.msg_iov    = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  res = recvmmsg(_socket, msgs, C240_RX_BATCH, MSG_DONTWAIT, NULL);
+  if (res < 0)
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+
+  _stats.calls++;
+  for (int i = 0; i < res; i++) {
+    _stats.datagrams++;
+    _stats.octets += msgs[i].msg_len;
+
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      _stats.malformed++;
+      continue;
+    }
+
+    decode(&_dgrams[i * C240_RX_DATAGRAM], msgs[i].msg_len);
+  }
+
+  return _ready;
+#endif // Q_OS_WIN
+}
+
+void Cat240Receiver::printStats(FILE* f) const {
+  fprintf(f, "CAT-240 input: %llu datagrams in %llu recvmmsg calls, %llu records, %llu bearings (%llu partial), %llu lost, %llu reordered, %llu malformed, %llu other\n"
+          , (unsigned long long)_stats.datagrams, (unsigned long long)_stats.calls
+          , (unsigned long long)_stats.records, (unsigned long long)_stats.bearings, (unsigned long long)_stats.partial
+          , (unsigned long long)_stats.lost, (unsigned long long)_stats.reordered
+          , (unsigned long long)_stats.malformed, (unsigned long long)_stats.other);
+}
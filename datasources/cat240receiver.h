@@ -0,0 +1,79 @@
+#ifndef CAT240RECEIVER_H
+#define CAT240RECEIVER_H
+
+#include "asterix240.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#define C240_RX_BATCH    64    // Datagrams per recvmmsg call
+#define C240_RX_DATAGRAM 9000  // Largest datagram accepted, jumbo frames included
+
+struct Cat240ReceiverStats {
+  uint64_t calls;       // recvmmsg calls returning data
+  uint64_t datagrams;
+  uint64_t octets;
+  uint64_t records;     // Video messages
+  uint64_t other;       // Other messages, skipped
+  uint64_t malformed;   // Truncated datagrams and undecodable blocks
+  uint64_t bearings;    // Bearings handed out
+  uint64_t partial;     // Of them with missing range segments
+  uint64_t lost;        // Messages missing from the index sequence
+  uint64_t reordered;   // Messages with an index older than expected
+};
+
+// Receiver of ASTERIX CAT-240 radar video. Range segments of a bearing
+// are gathered into one packet in the acquisition layout (bearing, cells
+// count, divisor, amplitudes), a bearing is complete when all of its
+// cells have arrived or the next azimuth starts.
+class Cat240Receiver {
+public:
+  Cat240Receiver(uint32_t brg_count, uint32_t brg_size);
+  ~Cat240Receiver();
+
+  // Address is "host:port": a multicast group is joined, otherwise the
+  // socket is bound to it (0.0.0.0 for every interface)
+  bool open(const char* address);
+  void close();
+
+  // Waits up to timeout_ms and reads one batch of datagrams. Returns the
+  // number of completed bearings or -1 on socket error
+  int receive(int timeout_ms);
+
+  // Bearings completed by the last receive()
+  inline uint32_t count() const { return _ready; }
+  inline const uint32_t* packet(uint32_t i) const { return &_packets[(size_t)i * (_brg_size + 3)]; }
+
+  inline const Cat240ReceiverStats& stats() const { return _stats; }
+  void printStats(FILE* f) const;
+
+private:
+  void decode(const uint8_t* buf, uint32_t len);
+  void record(const Cat240Video& v);
+  void complete();
+
+  uint32_t _brg_count;
+  uint32_t _brg_size;
+  int      _socket;
+
+  std::vector<uint8_t>  _dgrams;
+  std::vector<uint8_t>  _tmp;
+  std::vector<float>    _cells;
+
+  // Bearing being gathered
+  int32_t  _cur_brg;
+  uint32_t _cur_cells;
+  std::vector<uint32_t> _cur;
+
+  // Completed bearings
+  std::vector<uint32_t> _packets;
+  uint32_t _ready;
+
+  bool     _has_index;
+  uint32_t _next_index;
+
+  Cat240ReceiverStats _stats;
+};
+
+#endif // CAT240RECEIVER_H
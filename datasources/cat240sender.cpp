@@ -0,0 +1,325 @@
+#include "cat240sender.h"
+#include "radardatasource.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <algorithm>
+
+#ifndef Q_OS_WIN
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif // !Q_OS_WIN
+
+#define C240_IDLE_MS 2   // Sleep while the ring is empty
+
+void qSleep(int ms);
+
+Cat240Sender::Cat240Sender(BearingRing* ring, uint32_t max_datagram) {
+  _ring         = ring;
+  _consumer     = -1;
+  _socket       = -1;
+  _finish_flag  = true;
+
+  _brg_count    = BEARINGS_PER_CYCLE;
+  _brg_size     = ring->bearingSize();
+  _max_datagram = max_datagram;
+
+  _res.store(CAT240_RES_8BIT);
+  _compress.store(false);
+  _range.store(1.f);
+  _source.store(0);
+  _msg_index = 0;
+
+  _amps.resize(_brg_size);
+  _packed.resize(_brg_size);
+  _rle.resize(_brg_size + (_brg_size + 127) / 128);
+
+  _dgrams.resize(C240_BATCH * _max_datagram);
+  memset(_dg_len, 0, sizeof(_dg_len));
+  _dg = 0;
+
+  _bearings.store(0);
+  _records.store(0);
+  _datagrams.store(0);
+  _octets.store(0);
+  _calls.store(0);
+  _errors.store(0);
+  _cpu_ns.store(0);
+}
+
+Cat240Sender::~Cat240Sender() {
+  finish();
+}
+
+void Cat240Sender::setResolution(uint8_t res) {
+  if (res == CAT240_RES_4BIT || res == CAT240_RES_8BIT)
+    _res.store(res);
+}
+
+void Cat240Sender::setCompression(bool on) {
+  _compress.store(on);
+}
+
+void Cat240Sender::setRange(float range) {
+  if (range > 0.f)
+    _range.store(range);
+}
+
+void Cat240Sender::setSource(uint8_t sac, uint8_t sic) {
+  _source.store((sac << 8) | sic);
+}
+
+bool Cat240Sender::start(const char* address) {
+  if (_worker_thread.isRunning())
+    return false;
+
+  if (!open(address))
+    return false;
+
+  _consumer = _ring->addConsumer("cat240");
+  if (_consumer < 0) {
+    fprintf(stderr, "%s: no free bearing ring consumer\n", __func__);
+    close();
+    return false;
+  }
+
+  _finish_flag   = false;
+  _worker_thread = QtConcurrent::run(this, &Cat240Sender::worker);
+  return true;
+}
+
+void Cat240Sender::finish() {
+  bool running = !_finish_flag;
+
+  _finish_flag = true;
+  _worker_thread.waitForFinished();
+
+  if (_consumer >= 0) {
+    _ring->removeConsumer(_consumer);
+    _consumer = -1;
+  }
+
+  if (running)
+    printStats(stdout);
+
+  close();
+}
+
+bool Cat240Sender::open(const char* address) {
+#ifdef Q_OS_WIN
+  fprintf(stderr, "%s: not supported\n", __func__);
+  return false;
+#else
+  char host[256];
+  const char* colon = strrchr(address, ':');
+  if (colon == NULL || colon == address || (size_t)(colon - address) >= sizeof(host)) {
+    fprintf(stderr, "%s: %s is not host:port\n", __func__, address);
+    return false;
+  }
+
+  memcpy(host, address, colon - address);
+  host[colon - address] = '\0';
+
+  struct addrinfo hints, *ai = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family   = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  int res = getaddrinfo(host, colon + 1, &hints, &ai);
+  if (res != 0 || ai == NULL) {
+    fprintf(stderr, "%s: %s: %s\n", __func__, address, gai_strerror(res));
+    return false;
+  }
+
+  try
+  {
+    _socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_socket < 0)
+      throw errno;
+
+    int sndbuf = 1 << 20;
+    setsockopt(_socket, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    const struct sockaddr_in* sin = (const struct sockaddr_in*) ai->ai_addr;
+    if (IN_MULTICAST(ntohl(sin->sin_addr.s_addr))) {
+      unsigned char ttl = C240_MCAST_TTL, loop = 1;
+      if (setsockopt(_socket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0
+       || setsockopt(_socket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0)
+        throw errno;
+    }
+
+    // Connected socket: sendmmsg needs no destination per message
+    if (::connect(_socket, ai->ai_addr, ai->ai_addrlen) < 0)
+      throw errno;
+  }
+  catch(int err)
+  {
+    fprintf(stderr, "%s: %s: %s\n", __func__, address, strerror(err));
+    freeaddrinfo(ai);
+    close();
+    return false;
+  }
+
+  freeaddrinfo(ai);
+
+  memset(_dg_len, 0, sizeof(_dg_len));
+  _dg = 0;
+  return true;
+#endif // Q_OS_WIN
+}
+
+void Cat240Sender::close() {
+#ifndef Q_OS_WIN
+  if (_socket >= 0)
+    ::close(_socket);
+#endif // !Q_OS_WIN
+  _socket = -1;
+}
+
+void Cat240Sender::flush() {
+  uint32_t count = _dg + (_dg_len[_dg] > 0 ? 1 : 0);
+  if (count == 0)
+    return;
+
+#ifndef Q_OS_WIN
+  struct mmsghdr msgs[C240_BATCH];
+  struct iovec   iovs[C240_BATCH];
+
+  memset(msgs, 0, sizeof(msgs));
+  for (uint32_t i = 0; i < count; i++) {
+    iovs[i].iov_base = &_dgrams[i * _max_datagram];
+    iovs[i].iov_len  = _dg_len[i];
+    msgs[i].msg_hdr.msg_iov    = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  // Never wait for the network, a full socket buffer drops the rest of the batch
+  uint32_t sent = 0;
+  while (sent < count && _socket >= 0) {
+    int res = sendmmsg(_socket, &msgs[sent], count - sent, MSG_DONTWAIT);
+    _calls++;
+
+    if (res < 0) {
+      if (errno == EINTR)
+        continue;
+      _errors += count - sent;
+      break;
+    }
+
+    for (int i = 0; i < res; i++)
+      _octets += _dg_len[sent + i];
+    _datagrams += res;
+    sent += res;
+  }
+#endif // !Q_OS_WIN
+
+  memset(_dg_len, 0, sizeof(_dg_len));
+  _dg = 0;
+}
+
+void Cat240Sender::addBlock(const Cat240Video& v, const uint8_t* data, uint32_t len) {
+  for (;;) {
+    uint32_t res = cat240EncodeBlock(v, data, len, &_dgrams[_dg * _max_datagram + _dg_len[_dg]], _max_datagram - _dg_len[_dg]);
+    if (res > 0) {
+      _dg_len[_dg] += res;
+      _records++;
+      return;
+    }
+
+    // Segments are sized to fit an empty datagram
+    if (_dg_len[_dg] == 0)
+      return;
+
+    if (_dg + 1 == C240_BATCH)
+      flush();
+    else
+      _dg++;
+  }
+}
+
+void Cat240Sender::send(uint32_t brg, const float* amps) {
+  const uint8_t  res      = _res.load(std::memory_order_relaxed);
+  const bool     compress = _compress.load(std::memory_order_relaxed);
+  const uint16_t source   = _source.load(std::memory_order_relaxed);
+
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+
+  Cat240Video v;
+  memset(&v, 0, sizeof(v));
+  v.sac        = source >> 8;
+  v.sic        = source & 0xFF;
+  v.start_az   = (uint16_t)(((uint64_t) brg << 16) / _brg_count);
+  v.end_az     = (uint16_t)(((uint64_t)(brg + 1) << 16) / _brg_count);
+  v.cell_dur   = cat240CellDuration(_range.load(std::memory_order_relaxed), _brg_size);
+  v.res        = res;
+  v.compressed = compress;
+  v.tod        = (uint32_t)((ts.tv_sec % 86400) * 128 + ts.tv_nsec / (1000000000 / 128));
+
+  const uint32_t nbits = 1 << (res - 1);
+  cat240PackCells(amps, _brg_size, res, &_packed[0]);
+
+  // Range segments small enough for a datagram even if coding does not pay
+  // off, with the padding of the video block type they need
+  uint32_t payload = _max_datagram - CAT240_HEADER_SIZE - 3;
+  if (payload > 255 * 4)
+    payload = std::max<uint32_t>(255 * 4, _max_datagram - CAT240_HEADER_SIZE - 63);
+  uint32_t cells = ((payload - 1) * 128 / 129 * 8 / nbits) & ~7u;
+  if (cells > _brg_size)
+    cells = _brg_size;
+
+  for (uint32_t start = 0; start < _brg_size; start += cells) {
+    uint32_t n = (_brg_size - start < cells) ? _brg_size - start : cells;
+    const uint8_t* data = &_packed[start * nbits / 8];
+    uint32_t len = (n * nbits + 7) / 8;
+
+    if (compress) {
+      len  = cat240Compress(data, len, &_rle[0]);
+      data = &_rle[0];
+    }
+
+    v.msg_index = _msg_index++;
+    v.start_rg  = start;
+    v.cells     = n;
+    addBlock(v, data, len);
+  }
+
+  _bearings++;
+}
+
+void Cat240Sender::worker() {
+  uint32_t brg;
+  struct timespec t1, t2;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+
+  while (!_finish_flag) {
+    if (!_ring->read(_consumer, &brg, &_amps[0])) {
+      flush();
+
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t2);
+      _cpu_ns.store((uint64_t)(t2.tv_sec - t1.tv_sec) * 1000000000ull + t2.tv_nsec - t1.tv_nsec);
+
+      qSleep(C240_IDLE_MS);
+      continue;
+    }
+
+    send(brg, &_amps[0]);
+  }
+
+  flush();
+}
+
+void Cat240Sender::printStats(FILE* f) const {
+  uint64_t brgs = _bearings.load();
+  fprintf(f, "CAT-240 output: %llu bearings, %llu records, %llu datagrams (%.1f octets per bearing), %llu sendmmsg calls, %llu datagrams dropped, %.2f us CPU per bearing\n"
+          , (unsigned long long)brgs, (unsigned long long)_records.load(), (unsigned long long)_datagrams.load()
+          , brgs ? (double)_octets.load() / brgs : 0.0, (unsigned long long)_calls.load(), (unsigned long long)_errors.load()
+          , brgs ? _cpu_ns.load() * 1e-3 / brgs : 0.0);
+}
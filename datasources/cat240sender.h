@@ -0,0 +1,91 @@
+#ifndef CAT240SENDER_H
+#define CAT240SENDER_H
+
+#include "bearingring.h"
+#include "asterix240.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+#include <QtGlobal>
+
+#if QT_VERSION >= 0x050000
+    #include <QtConcurrent/QtConcurrentRun>
+#else
+    #include <QtConcurrentRun>
+#endif
+
+#define C240_BATCH     32    // Datagrams per sendmmsg call
+#define C240_DATAGRAM  1472  // Datagram size fitting an Ethernet frame
+#define C240_MCAST_TTL 1     // Multicast stays on the ship network segment
+
+// Radar video streamer. Reads the bearing ring as an independent consumer
+// and sends every bearing as ASTERIX CAT-240 video messages over UDP.
+// Bearings longer than a datagram are split into range segments, short
+// ones share datagrams.
+class Cat240Sender {
+public:
+  explicit Cat240Sender(BearingRing* ring, uint32_t max_datagram = C240_DATAGRAM);
+  virtual ~Cat240Sender();
+
+  // Address is "host:port", unicast or multicast
+  bool start(const char* address);
+  void finish();
+
+  // Any thread
+  void setResolution(uint8_t res);  // CAT240_RES_4BIT or CAT240_RES_8BIT
+  void setCompression(bool on);
+  void setRange(float range);
+  void setSource(uint8_t sac, uint8_t sic);
+
+  // Sending thread
+  bool open(const char* address);
+  void close();
+  void send(uint32_t brg, const float* amps);
+  void flush();
+
+  // Any thread
+  inline uint64_t datagrams() const { return _datagrams.load(); }
+  inline uint64_t octets() const    { return _octets.load(); }
+  void printStats(FILE* f) const;
+
+private:
+  void worker();
+  void addBlock(const Cat240Video& v, const uint8_t* data, uint32_t len);
+
+  BearingRing* _ring;
+  int          _consumer;
+  int          _socket;
+  bool         _finish_flag;
+
+  uint32_t     _brg_count;
+  uint32_t     _brg_size;
+  uint32_t     _max_datagram;
+
+  std::atomic<uint8_t>  _res;
+  std::atomic<bool>     _compress;
+  std::atomic<float>    _range;
+  std::atomic<uint16_t> _source;   // SAC << 8 | SIC
+
+  uint32_t _msg_index;
+
+  std::vector<float>    _amps;
+  std::vector<uint8_t>  _packed;
+  std::vector<uint8_t>  _rle;
+
+  std::vector<uint8_t>  _dgrams;   // C240_BATCH datagrams of _max_datagram octets
+  uint32_t              _dg_len[C240_BATCH];
+  uint32_t              _dg;       // Datagram being filled
+
+  std::atomic<uint64_t> _bearings;
+  std::atomic<uint64_t> _records;
+  std::atomic<uint64_t> _datagrams;
+  std::atomic<uint64_t> _octets;
+  std::atomic<uint64_t> _calls;
+  std::atomic<uint64_t> _errors;
+  std::atomic<uint64_t> _cpu_ns;   // Worker thread CPU time
+
+  QFuture<void> _worker_thread;
+};
+
+#endif // CAT240SENDER_H
@@ -0,0 +1,139 @@
+#include "clutterfilter.h"
+
+#include <math.h>
+
+#ifdef __SSE2__
+  #include <emmintrin.h>
+#endif // __SSE2__
+
+ClutterFilter::ClutterFilter(uint32_t brg_size) {
+  _brg_size  = brg_size;
+
+  _wave.store(0);
+  _rain.store(0);
+
+  _stc_level = 0;
+  _ftc_level = 0;
+  _stc_len   = 0;
+  _ftc_k     = 0.f;
+
+  _stc_gain.assign(brg_size, 1.f);
+  _sum.assign(brg_size + 1, 0.f);
+}
+
+static int clampLevel(int level) {
+  if (level < 0)
+    return 0;
+  if (level > CLUTTER_MAX_LEVEL)
+    return CLUTTER_MAX_LEVEL;
+  return level;
+}
+
+void ClutterFilter::setWave(int level) {
+  _wave.store(clampLevel(level), std::memory_order_relaxed);
+}
+
+void ClutterFilter::setRain(int level) {
+  _rain.store(clampLevel(level), std::memory_order_relaxed);
+}
+
+void ClutterFilter::updateStc(int level) {
+  // Attenuation falls off quadratically from the maximum at zero range
+  // to nothing at the end of the STC zone
+  float depth = CLUTTER_STC_MAX_DB * level / CLUTTER_MAX_LEVEL;
+
+  _stc_len = (level > 0) ? (uint32_t)(_brg_size * CLUTTER_STC_RANGE) : 0;
+
+  for (uint32_t i = 0; i < _stc_len; i++) {
+    float x = 1.f - (float)i / _stc_len;
+    _stc_gain[i] = powf(10.f, -depth * x * x / 20.f);
+  }
+
+  _stc_level = level;
+}
+
+void ClutterFilter::updateFtc(int level) {
+  _ftc_k     = (float)level / CLUTTER_MAX_LEVEL;
+  _ftc_level = level;
+}
+
+// Gain curve multiplication
+static void stcKernel(float* __restrict__ a, const float* __restrict__ g, uint32_t n) {
+  uint32_t i = 0;
+#ifdef __SSE2__
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(a + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(g + i)));
+#endif // __SSE2__
+  for (; i < n; i++)
+    a[i] *= g[i];
+}
+
+// s[0] = 0, s[i + 1] = a[0] + ... + a[i]
+static void prefixSum(const float* __restrict__ a, float* __restrict__ s, uint32_t n) {
+  uint32_t i = 0;
+  s[0] = 0.f;
+#ifdef __SSE2__
+  // Scan inside the register, then add the running total of the previous quad
+  __m128 carry = _mm_setzero_ps();
+  for (; i + 4 <= n; i += 4) {
+    __m128 x = _mm_loadu_ps(a + i);
+    x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+    x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+    x = _mm_add_ps(x, carry);
+    _mm_storeu_ps(s + i + 1, x);
+    carry = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+#endif // __SSE2__
+  for (; i < n; i++)
+    s[i + 1] = s[i] + a[i];
+}
+
+// a[i] = max(a[i] - k * (s[i] - s[i - w]), 0) for i in [from, n)
+static void ftcKernel(float* __restrict__ a, const float* __restrict__ s, uint32_t from, uint32_t n, uint32_t w, float k) {
+  uint32_t i = from;
+#ifdef __SSE2__
+  const __m128 vk = _mm_set1_ps(k);
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + 4 <= n; i += 4) {
+    __m128 m = _mm_sub_ps(_mm_loadu_ps(s + i), _mm_loadu_ps(s + i - w));
+    __m128 v = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_mul_ps(vk, m));
+    _mm_storeu_ps(a + i, _mm_max_ps(v, zero));
+  }
+#endif // __SSE2__
+  for (; i < n; i++) {
+    float v = a[i] - k * (s[i] - s[i - w]);
+    a[i] = (v > 0.f) ? v : 0.f;
+  }
+}
+
+void ClutterFilter::apply(float* amps) {
+  int wave = _wave.load(std::memory_order_relaxed);
+  int rain = _rain.load(std::memory_order_relaxed);
+
+  if (wave != _stc_level)
+    updateStc(wave);
+  if (rain != _ftc_level)
+    updateFtc(rain);
+
+  if (_stc_len > 0)
+    stcKernel(amps, &_stc_gain[0], _stc_len);
+
+  if (_ftc_level == 0)
+    return;
+
+  // FTC: subtract the mean of the preceding window so that only the
+  // leading edges of extended echoes are left
+  float* s = &_sum[0];
+  prefixSum(amps, s, _brg_size);
+
+  const float k = _ftc_k / CLUTTER_FTC_WINDOW;
+  const uint32_t head = (_brg_size < CLUTTER_FTC_WINDOW) ? _brg_size : CLUTTER_FTC_WINDOW;
+
+  // Window is cut at zero range
+  for (uint32_t i = 0; i < head; i++) {
+    float v = amps[i] - k * s[i];
+    amps[i] = (v > 0.f) ? v : 0.f;
+  }
+
+  ftcKernel(amps, s, head, _brg_size, CLUTTER_FTC_WINDOW, k);
+}
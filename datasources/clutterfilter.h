@@ -0,0 +1,47 @@
+#ifndef CLUTTERFILTER_H
+#define CLUTTERFILTER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+
+#define CLUTTER_MAX_LEVEL    255   // Wave/rain control range is 0..255
+#define CLUTTER_STC_MAX_DB   40.f  // STC attenuation at zero range for the maximum level
+#define CLUTTER_STC_RANGE    0.4f  // Part of the sweep affected by STC
+#define CLUTTER_FTC_WINDOW   12    // FTC averaging window (samples)
+
+// Software sea (STC) and rain (FTC) clutter suppression applied to every
+// processed bearing. Levels may be changed from any thread at any moment,
+// the processing thread picks them up on the next bearing.
+class ClutterFilter {
+public:
+  explicit ClutterFilter(uint32_t brg_size);
+
+  void setWave(int level);
+  void setRain(int level);
+
+  // Processing thread only
+  void apply(float* amps);
+
+private:
+  void updateStc(int level);
+  void updateFtc(int level);
+
+  uint32_t _brg_size;
+
+  std::atomic<int> _wave;
+  std::atomic<int> _rain;
+
+  // Levels the tables below are built for
+  int _stc_level;
+  int _ftc_level;
+
+  std::vector<float> _stc_gain;  // Range dependent gain
+  uint32_t           _stc_len;   // Samples with gain below 1
+  float              _ftc_k;     // Part of the local mean to subtract
+
+  std::vector<float> _sum;       // Prefix sums of the bearing
+};
+
+#endif // CLUTTERFILTER_H
@@ -0,0 +1,148 @@
+#include "gainestimator.h"
+
+#include <string.h>
+#include <algorithm>
+
+#ifdef __SSE2__
+  #include <emmintrin.h>
+#endif // __SSE2__
+
+GainEstimator::GainEstimator(uint32_t brg_count, uint32_t max_gain) {
+  _brg_count = brg_count;
+  _max_gain  = max_gain;
+
+  _hist.resize(GEST_SECTORS * GEST_LANES * GEST_BINS);
+  reset();
+}
+
+void GainEstimator::reset() {
+  std::fill(_hist.begin(), _hist.end(), 0);
+
+  _last_brg = 0;
+  _bearings = 0;
+
+  memset(&_est, 0, sizeof(_est));
+  _est.gain = -1;
+}
+
+// Histogram bin of each amplitude: min(a, 255) / 4
+static void binIndices(const uint32_t* amps, uint8_t* bins, uint32_t count) {
+  uint32_t i = 0;
+#ifdef __SSE2__
+  // Raw amplitudes are non-negative ints, so signed saturation is safe
+  const __m128i mask = _mm_set1_epi8(GEST_BINS - 1);
+  for (; i + 16 <= count; i += 16) {
+    const __m128i* p = (const __m128i*) (amps + i);
+    __m128i w0 = _mm_packs_epi32(_mm_loadu_si128(p + 0), _mm_loadu_si128(p + 1));
+    __m128i w1 = _mm_packs_epi32(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3));
+    __m128i b  = _mm_packus_epi16(w0, w1);
+    b = _mm_and_si128(_mm_srli_epi16(b, 2), mask);
+    _mm_storeu_si128((__m128i*) (bins + i), b);
+  }
+#endif // __SSE2__
+  for (; i < count; i++)
+    bins[i] = std::min<uint32_t>(amps[i], 255) >> 2;
+}
+
+bool GainEstimator::addBearing(uint32_t brg, const uint32_t* amps, uint32_t count) {
+  bool ready = false;
+
+  if (brg >= _brg_count)
+    return false;
+
+  // Zero crossing closes the revolution if most of it has been seen. Late
+  // bearings step back a little, the crossing steps back over half a revolution
+  if (brg < _last_brg && _last_brg - brg > _brg_count / 2 && _bearings > _brg_count / 2) {
+    finishRevolution();
+    ready = true;
+  }
+  _last_brg = brg;
+  _bearings++;
+
+  if (_bins.size() < count)
+    _bins.resize(count);
+
+  binIndices(amps, &_bins[0], count);
+
+  // Consecutive samples go to different lanes to avoid store-to-load stalls
+  uint32_t* h = &_hist[(brg * GEST_SECTORS / _brg_count) * GEST_LANES * GEST_BINS];
+  const uint8_t* b = &_bins[0];
+  uint32_t i = 0;
+  for (; i + GEST_LANES <= count; i += GEST_LANES) {
+    h[0 * GEST_BINS + b[i + 0]]++;
+    h[1 * GEST_BINS + b[i + 1]]++;
+    h[2 * GEST_BINS + b[i + 2]]++;
+    h[3 * GEST_BINS + b[i + 3]]++;
+  }
+  for (; i < count; i++)
+    h[b[i]]++;
+
+  return ready;
+}
+
+int GainEstimator::percentile(const uint32_t* hist, uint64_t total, int pct) const {
+  uint64_t limit = total * pct / 100;
+  uint64_t sum = 0;
+
+  for (int i = 0; i < GEST_BINS; i++) {
+    sum += hist[i];
+    if (sum > limit)
+      return i * (256 / GEST_BINS) + (256 / GEST_BINS) / 2;
+  }
+
+  return 255;
+}
+
+void GainEstimator::finishRevolution() {
+  int noise[GEST_SECTORS];
+  int thresh[GEST_SECTORS];
+  int sectors = 0;
+
+  for (int s = 0; s < GEST_SECTORS; s++) {
+    uint32_t merged[GEST_BINS];
+    uint64_t total = 0;
+    uint32_t* h = &_hist[s * GEST_LANES * GEST_BINS];
+
+    for (int i = 0; i < GEST_BINS; i++) {
+      merged[i] = h[i] + h[GEST_BINS + i] + h[2 * GEST_BINS + i] + h[3 * GEST_BINS + i];
+      total += merged[i];
+    }
+
+    if (total == 0)
+      continue;
+
+    noise[sectors]  = percentile(merged, total, GEST_NOISE_PCT);
+    thresh[sectors] = percentile(merged, total, GEST_THRESH_PCT);
+    sectors++;
+  }
+
+  std::fill(_hist.begin(), _hist.end(), 0);
+  _bearings = 0;
+
+  if (sectors == 0)
+    return;
+
+  // Median over sectors so that land or heavy clutter in a few sectors doesn't matter
+  std::sort(noise, noise + sectors);
+  std::sort(thresh, thresh + sectors);
+
+  _est.revolution++;
+  _est.noise     = noise[sectors / 2];
+  _est.noise_min = noise[0];
+  _est.noise_max = noise[sectors - 1];
+  _est.threshold = thresh[sectors / 2];
+
+  // amplify() maps raw level (max_gain - gain) to the full scale
+  int gain = (int)_max_gain - _est.noise * (int)_max_gain / GEST_NOISE_TARGET;
+  gain = std::max(0, std::min(gain, (int)_max_gain - 1));
+
+  // Smooth proposals over revolutions
+  if (_est.gain >= 0)
+    gain = (3 * _est.gain + gain + 2) / 4;
+  _est.gain = gain;
+}
+
+void GainEstimator::printEstimate(FILE* f) const {
+  fprintf(f, "Gain estimate: revolution %u, noise %d (sectors %d..%d), threshold %d, gain %d\n"
+          , _est.revolution, _est.noise, _est.noise_min, _est.noise_max, _est.threshold, _est.gain);
+}
@@ -0,0 +1,55 @@
+#ifndef GAINESTIMATOR_H
+#define GAINESTIMATOR_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#define GEST_SECTORS      16    // Azimuth sectors with separate histograms
+#define GEST_BINS         64    // Histogram bins over 0..255 raw amplitudes
+#define GEST_LANES        4     // Interleaved copies of each histogram
+#define GEST_NOISE_PCT    50    // Percentile taken as the sector noise floor
+#define GEST_THRESH_PCT   95    // Percentile taken as the sector detection threshold
+#define GEST_NOISE_TARGET 32    // Display level the noise floor is amplified to
+
+// Noise floor, threshold and gain estimated over the last revolution
+struct GainEstimate {
+  uint32_t revolution;  // Number of completed revolutions
+  int      noise;       // Noise floor (raw amplitude, median over sectors)
+  int      noise_min;   // Quietest sector
+  int      noise_max;   // Noisiest sector
+  int      threshold;   // Detection threshold (raw amplitude)
+  int      gain;        // Proposed gain level
+};
+
+// Builds per-sector amplitude histograms of raw (not amplified) bearings
+// and once per revolution estimates the noise floor and the gain level
+// which brings it to GEST_NOISE_TARGET on the display
+class GainEstimator {
+public:
+  GainEstimator(uint32_t brg_count, uint32_t max_gain);
+
+  void reset();
+
+  // Returns true when the bearing completes a revolution and a new estimate is ready
+  bool addBearing(uint32_t brg, const uint32_t* amps, uint32_t count);
+
+  inline const GainEstimate& estimate() const { return _est; }
+  void printEstimate(FILE* f) const;
+
+private:
+  void finishRevolution();
+  int  percentile(const uint32_t* hist, uint64_t total, int pct) const;
+
+  uint32_t _brg_count;
+  uint32_t _max_gain;
+  uint32_t _last_brg;
+  uint32_t _bearings;      // Bearings in the current revolution
+
+  std::vector<uint32_t> _hist;   // [GEST_SECTORS][GEST_LANES][GEST_BINS]
+  std::vector<uint8_t>  _bins;   // Bin index of each amplitude of a bearing
+
+  GainEstimate _est;
+};
+
+#endif // GAINESTIMATOR_H
@@ -0,0 +1,274 @@
+#include "guardzone.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef __SSE2__
+  #include <emmintrin.h>
+#endif // __SSE2__
+
+GuardZones::GuardZones(uint32_t brg_count, uint32_t brg_size) {
+  _brg_count = brg_count;
+  _brg_size  = brg_size;
+  _range     = 0.f;
+
+  _pending.store(NULL);
+  _threshold.store(128.f);
+
+  _table     = NULL;
+  _last_brg  = 0;
+  _alarms    = 0;
+  _hit_zones = 0;
+  _raised    = 0;
+  memset(_hits, 0, sizeof(_hits));
+}
+
+GuardZones::~GuardZones() {
+  delete _pending.exchange(NULL);
+  delete _table;
+}
+
+void GuardZones::setZones(const std::vector<GuardZone>& zones) {
+  _zones = zones;
+
+  if (_zones.size() > GZ_MAX_ZONES) {
+    fprintf(stderr, "%s: only %d of %lu guard zones are used\n", __func__, GZ_MAX_ZONES, (unsigned long)_zones.size());
+    _zones.resize(GZ_MAX_ZONES);
+  }
+
+  rebuild();
+}
+
+void GuardZones::setScale(float range) {
+  if (range <= 0.f || range == _range)
+    return;
+
+  _range = range;
+  rebuild();
+}
+
+void GuardZones::setThreshold(float threshold) {
+  _threshold.store(threshold, std::memory_order_relaxed);
+}
+
+static bool insidePolygon(const std::vector<float>& poly, float x, float y) {
+  bool in = false;
+  size_t n = poly.size() / 2;
+
+  for (size_t i = 0, j = n - 1; i < n; j = i++) {
+    float xi = poly[2*i], yi = poly[2*i+1];
+    float xj = poly[2*j], yj = poly[2*j+1];
+
+    if (((yi > y) != (yj > y)) && (x < (xj - xi) * (y - yi) / (yj - yi) + xi))
+      in = !in;
+  }
+
+  return in;
+}
+
+void GuardZones::rasterise(const GuardZone& zone, int idx, std::vector< std::vector<GuardInterval> >& raw) const {
+  const float samples_per_mile = _brg_size / _range;
+  const uint64_t bit = 1ull << idx;
+
+  std::vector<float> cross;
+  bool origin_inside = false;
+
+  if (zone.type == GuardZone::GZ_POLYGON) {
+    if (zone.poly.size() < 6)
+      return;
+    origin_inside = insidePolygon(zone.poly, 0.f, 0.f);
+  }
+
+  for (uint32_t b = 0; b < _brg_count; b++) {
+    float a = (b + 0.5f) * 360.f / _brg_count;
+
+    if (zone.type == GuardZone::GZ_SECTOR) {
+      float span = fmodf(zone.brg_to - zone.brg_from + 720.f, 360.f);
+      if (span == 0.f)
+        span = 360.f;
+
+      if (fmodf(a - zone.brg_from + 720.f, 360.f) >= span)
+        continue;
+
+      float from = std::max(zone.rng_from * samples_per_mile, 0.f);
+      float to   = std::min(zone.rng_to * samples_per_mile, (float)_brg_size);
+      if (from < to) {
+        GuardInterval iv = { (uint16_t) from, (uint16_t) ceilf(to), bit };
+        raw[b].push_back(iv);
+      }
+      continue;
+    }
+
+    // Polygon: crossings of the bearing ray with the edges
+    float dx = sinf(a * (float)M_PI / 180.f);
+    float dy = cosf(a * (float)M_PI / 180.f);
+    size_t n = zone.poly.size() / 2;
+
+    cross.clear();
+    for (size_t i = 0; i < n; i++) {
+      float px = zone.poly[2*i], py = zone.poly[2*i+1];
+      float ex = zone.poly[2*((i+1)%n)] - px, ey = zone.poly[2*((i+1)%n)+1] - py;
+      float den = dx * ey - dy * ex;
+
+      if (fabsf(den) < 1e-12f)
+        continue;
+
+      float t = (px * ey - py * ex) / den;
+      float u = (px * dy - py * dx) / den;
+      if (t > 0.f && u >= 0.f && u < 1.f)
+        cross.push_back(t);
+    }
+
+    if (origin_inside)
+      cross.insert(cross.begin(), 0.f);
+    std::sort(cross.begin(), cross.end());
+
+    for (size_t i = 0; i + 1 < cross.size(); i += 2) {
+      float from = std::max(cross[i] * samples_per_mile, 0.f);
+      float to   = std::min(cross[i+1] * samples_per_mile, (float)_brg_size);
+      if (from < to) {
+        GuardInterval iv = { (uint16_t) from, (uint16_t) ceilf(to), bit };
+        raw[b].push_back(iv);
+      }
+    }
+  }
+}
+
+void GuardZones::rebuild() {
+  if (_range <= 0.f)
+    return;
+
+  std::vector< std::vector<GuardInterval> > raw(_brg_count);
+  for (size_t i = 0; i < _zones.size(); i++)
+    rasterise(_zones[i], i, raw);
+
+  GuardZoneTable* t = new GuardZoneTable();
+  t->first.resize(_brg_count + 1);
+
+  // Overlapping zones are split into disjoint intervals with the masks of
+  // all zones covering them, so each sample is tested once per bearing
+  std::vector<uint16_t> pts;
+  for (uint32_t b = 0; b < _brg_count; b++) {
+    t->first[b] = t->intervals.size();
+
+    const std::vector<GuardInterval>& r = raw[b];
+    if (r.empty())
+      continue;
+
+    pts.clear();
+    for (size_t i = 0; i < r.size(); i++) {
+      pts.push_back(r[i].from);
+      pts.push_back(r[i].to);
+    }
+    std::sort(pts.begin(), pts.end());
+    pts.erase(std::unique(pts.begin(), pts.end()), pts.end());
+
+    for (size_t k = 0; k + 1 < pts.size(); k++) {
+      uint64_t mask = 0;
+      for (size_t i = 0; i < r.size(); i++)
+        if (r[i].from <= pts[k] && pts[k + 1] <= r[i].to)
+          mask |= r[i].zones;
+
+      if (mask == 0)
+        continue;
+
+      if (t->intervals.size() > t->first[b] && t->intervals.back().to == pts[k] && t->intervals.back().zones == mask) {
+        t->intervals.back().to = pts[k + 1];
+      } else {
+        GuardInterval iv = { pts[k], pts[k + 1], mask };
+        t->intervals.push_back(iv);
+      }
+    }
+  }
+  t->first[_brg_count] = t->intervals.size();
+
+  delete _pending.exchange(t, std::memory_order_acq_rel);
+}
+
+// True if any of n amplitudes reaches the threshold
+static bool anyAbove(const float* a, uint32_t n, float thr) {
+  uint32_t i = 0;
+#ifdef __SSE2__
+  const __m128 t = _mm_set1_ps(thr);
+  for (; i + 16 <= n; i += 16) {
+    __m128 m = _mm_or_ps(_mm_or_ps(_mm_cmpge_ps(_mm_loadu_ps(a + i), t),
+                                   _mm_cmpge_ps(_mm_loadu_ps(a + i + 4), t)),
+                         _mm_or_ps(_mm_cmpge_ps(_mm_loadu_ps(a + i + 8), t),
+                                   _mm_cmpge_ps(_mm_loadu_ps(a + i + 12), t)));
+    if (_mm_movemask_ps(m))
+      return true;
+  }
+  for (; i + 4 <= n; i += 4)
+    if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(a + i), t)))
+      return true;
+#endif // __SSE2__
+  for (; i < n; i++)
+    if (a[i] >= thr)
+      return true;
+  return false;
+}
+
+uint64_t GuardZones::test(uint32_t brg, const float* amps) {
+  uint64_t changed = 0;
+
+  // New zones or scale: alarms start over
+  GuardZoneTable* t = _pending.exchange(NULL, std::memory_order_acq_rel);
+  if (t) {
+    delete _table;
+    _table = t;
+
+    changed   = _alarms;
+    _alarms   = 0;
+    _hit_zones = 0;
+    memset(_hits, 0, sizeof(_hits));
+  }
+
+  // Zone clear for a whole revolution ends its alarm. Late and re-placed
+  // bearings step back a little, only a step back over half a revolution
+  // is the wrap through zero
+  if (brg < _last_brg && _last_brg - brg > _brg_count / 2) {
+    uint64_t cleared = _alarms & ~_hit_zones;
+    _alarms  &= ~cleared;
+    changed  |= cleared;
+
+    _hit_zones = 0;
+    memset(_hits, 0, sizeof(_hits));
+  }
+  _last_brg = brg;
+
+  if (!_table || brg >= _brg_count)
+    return changed;
+
+  const float thr = _threshold.load(std::memory_order_relaxed);
+  uint64_t hit = 0;
+
+  for (uint32_t i = _table->first[brg]; i < _table->first[brg + 1]; i++) {
+    const GuardInterval& iv = _table->intervals[i];
+    if ((hit | iv.zones) != hit && anyAbove(amps + iv.from, iv.to - iv.from, thr))
+      hit |= iv.zones;
+  }
+
+  if (hit == 0)
+    return changed;
+
+  _hit_zones |= hit;
+
+  for (uint64_t m = hit & ~_alarms; m; m &= m - 1) {
+    int z = __builtin_ctzll(m);
+    if (++_hits[z] >= GZ_MIN_HITS) {
+      _alarms |= (1ull << z);
+      changed |= (1ull << z);
+      _raised++;
+    }
+  }
+
+  return changed;
+}
+
+void GuardZones::printStats(FILE* f) const {
+  const GuardZoneTable* t = _table;
+  fprintf(f, "Guard zones: %lu intervals, alarms 0x%llx, %llu raised\n"
+          , t ? (unsigned long)t->intervals.size() : 0ul
+          , (unsigned long long)_alarms, (unsigned long long)_raised);
+}
@@ -0,0 +1,91 @@
+#ifndef GUARDZONE_H
+#define GUARDZONE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+
+#define GZ_MAX_ZONES 64  // Zones are identified by bits of a 64-bit mask
+#define GZ_MIN_HITS  3   // Bearings with echo inside a zone needed to raise the alarm
+
+// Operator-defined guard zone. Bearings are in degrees clockwise in the
+// radar video frame, ranges and polygon vertices in miles from own ship
+// (x to the right, y up along zero bearing).
+struct GuardZone {
+  enum type_t {
+    GZ_SECTOR  = 0,
+    GZ_POLYGON = 1
+  };
+
+  type_t type;
+
+  float brg_from;
+  float brg_to;
+  float rng_from;
+  float rng_to;
+
+  std::vector<float> poly;  // x0, y0, x1, y1, ...
+};
+
+// Range interval [from, to) of one bearing covered by the zones in the mask
+struct GuardInterval {
+  uint16_t from;
+  uint16_t to;
+  uint64_t zones;
+};
+
+// Zones rasterised for a scale: intervals of bearing b are
+// intervals[first[b]] .. intervals[first[b + 1] - 1], disjoint and sorted
+struct GuardZoneTable {
+  std::vector<uint32_t>      first;
+  std::vector<GuardInterval> intervals;
+};
+
+// Guard zone alarm evaluated bearing by bearing. Zones and scale are set
+// from the GUI thread, the table is rebuilt there and handed over to the
+// processing thread without locking.
+class GuardZones {
+public:
+  GuardZones(uint32_t brg_count, uint32_t brg_size);
+  ~GuardZones();
+
+  // GUI thread
+  void setZones(const std::vector<GuardZone>& zones);
+  void setScale(float range);
+
+  // Any thread, auto gain sets it from the acquisition thread
+  void setThreshold(float threshold);
+
+  // Processing thread. Returns the mask of zones whose alarm state has changed
+  uint64_t test(uint32_t brg, const float* amps);
+
+  inline uint64_t alarms() const { return _alarms; }
+  // Zones rasterised for the current scale, NULL before the first test()
+  inline const GuardZoneTable* table() const { return _table; }
+  void printStats(FILE* f) const;
+
+private:
+  void rebuild();
+  void rasterise(const GuardZone& zone, int idx, std::vector< std::vector<GuardInterval> >& raw) const;
+
+  uint32_t _brg_count;
+  uint32_t _brg_size;
+
+  // GUI thread state
+  std::vector<GuardZone> _zones;
+  float                  _range;
+
+  std::atomic<GuardZoneTable*> _pending;
+  std::atomic<float>           _threshold;
+
+  // Processing thread state
+  GuardZoneTable* _table;
+  uint32_t        _last_brg;
+  uint64_t        _alarms;          // Zones in alarm
+  uint64_t        _hit_zones;       // Zones hit during the current revolution
+  uint8_t         _hits[GZ_MAX_ZONES];
+  uint64_t        _raised;          // Alarms raised since start
+};
+
+#endif // GUARDZONE_H
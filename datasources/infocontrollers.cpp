@@ -357,6 +357,29 @@ void BlankController::initBlock(const RLIPanelInfo& panelInfo) {
 //------------------------------------------------------------------------------
 
 DangerController::DangerController(QObject* parent) : InfoBlockController(parent) {
+  _text_id = -1;
+  _alarms = 0;
+}
+
+void DangerController::onGuardAlarm(int zone, bool on) {
+  if (zone < 0 || zone >= 64)
+    return;
+
+  if (on)
+    _alarms |= (Q_UINT64_C(1) << zone);
+  else
+    _alarms &= ~(Q_UINT64_C(1) << zone);
+
+  updateAlarm();
+}
+
+void DangerController::updateAlarm() {
+  if (_block == NULL || _text_id < 0)
+    return;
+
+  _block->setBackColor(_alarms ? INFO_TEXT_DYNAMIC_COLOR : INFO_BACKGRD_COLOR);
+  for (int i = 0; i < RLI_LANG_COUNT; i++)
+    _block->setText(_text_id, i, _alarms ? enc->fromUnicode(dec->toUnicode(RLIStrings::nDng[i])) : QByteArray());
 }
 
 void DangerController::initBlock(const RLIPanelInfo& panelInfo) {
@@ -367,7 +390,10 @@ void DangerController::initBlock(const RLIPanelInfo& panelInfo) {
   t.color = INFO_BACKGRD_COLOR;
   setInfoTextParams(t, panelInfo.texts["label"]);
   setInfoTextStr(t, RLIStrings::nDng);
-  //_block->addText(t);
+  _text_id = _block->addText(t);
+
+  // Label is shown only while a guard zone is in alarm
+  updateAlarm();
 }
 
 //------------------------------------------------------------------------------
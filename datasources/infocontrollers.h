@@ -184,6 +184,7 @@ public:
   explicit DangerController(QObject* parent = 0);
 
 public slots:
+  void onGuardAlarm(int zone, bool on);
 
 signals:
   void setRect(int rectId, const QRect& r);
@@ -191,6 +192,10 @@ signals:
 
 private:
   void initBlock(const RLIPanelInfo& panelInfo);
+  void updateAlarm();
+
+  int _text_id;
+  quint64 _alarms; // Guard zones in alarm
 };
 
 
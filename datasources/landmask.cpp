@@ -0,0 +1,335 @@
+#include "landmask.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+#ifdef __SSE2__
+  #include <emmintrin.h>
+#endif // __SSE2__
+
+LandMask::LandMask(uint32_t brg_count, uint32_t brg_size) {
+  _brg_count = brg_count;
+  _brg_size  = brg_size;
+
+  _dx.resize(brg_count);
+  _dy.resize(brg_count);
+  for (uint32_t b = 0; b < brg_count; b++) {
+    double a = (b + 0.5) * 2.0 * M_PI / brg_count;
+    _dx[b] = (float) sin(a);
+    _dy[b] = (float) cos(a);
+  }
+
+  _lat = _lon = _range = 0.f;
+  _mask_lat = _mask_lon = 0.f;
+  _has_pos  = false;
+  _dirty    = false;
+  _building = false;
+
+  _pending.store(NULL);
+  _shift.store(0);
+  _enabled.store(false);
+
+  _rebuilds.store(0);
+  _last_build_us.store(0);
+  _max_build_us.store(0);
+
+  _table  = NULL;
+  _masked = 0;
+}
+
+LandMask::~LandMask() {
+  delete _pending.exchange(NULL);
+  delete _table;
+}
+
+void LandMask::addAreas(const std::vector<float>& triangles) {
+  if (triangles.size() < 6)
+    return;
+
+  std::lock_guard<std::mutex> lock(_lock);
+
+  // Land already handed to a build stays untouched
+  std::vector<float>* land = _land ? new std::vector<float>(*_land) : new std::vector<float>();
+  land->insert(land->end(), triangles.begin(), triangles.end() - triangles.size() % 6);
+
+  _land.reset(land);
+  _dirty = true;
+}
+
+void LandMask::setPosition(float lat, float lon) {
+  std::lock_guard<std::mutex> lock(_lock);
+
+  _lat = lat;
+  _lon = lon;
+
+  if (!_has_pos) {
+    _has_pos = true;
+    _dirty   = true;
+    return;
+  }
+
+  if (_range <= 0.f)
+    return;
+
+  float dx = (lon - _mask_lon) * LM_MILES_PER_DEGREE * cosf(_mask_lat * (float)M_PI / 180.f);
+  float dy = (lat - _mask_lat) * LM_MILES_PER_DEGREE;
+  float thr = LM_MOVE_SAMPLES * _range / _brg_size;
+
+  if (dx * dx + dy * dy > thr * thr)
+    _dirty = true;
+}
+
+void LandMask::setScale(float range) {
+  std::lock_guard<std::mutex> lock(_lock);
+
+  if (range <= 0.f || range == _range)
+    return;
+
+  _range = range;
+  _dirty = true;
+}
+
+void LandMask::setHeading(float hdg) {
+  float h = fmodf(hdg, 360.f);
+  if (h < 0.f)
+    h += 360.f;
+
+  _shift.store((uint32_t)(h * _brg_count / 360.f + 0.5f) % _brg_count, std::memory_order_relaxed);
+}
+
+void LandMask::setEnabled(bool on) {
+  _enabled.store(on, std::memory_order_relaxed);
+}
+
+bool LandMask::startRebuild() {
+  std::lock_guard<std::mutex> lock(_lock);
+
+  if (!_dirty || _building || !_has_pos || _range <= 0.f || !_land)
+    return false;
+
+  _building = true;
+  return true;
+}
+
+static double elapsedNs(const struct timespec& t1, const struct timespec& t2) {
+  return (double)(t2.tv_sec - t1.tv_sec) * 1e9 + (double)(t2.tv_nsec - t1.tv_nsec);
+}
+
+void LandMask::rebuild() {
+  // Requests coming during a build are served by the next pass
+  for (;;) {
+    std::shared_ptr< const std::vector<float> > land;
+    float lat, lon, range;
+
+    {
+      std::lock_guard<std::mutex> lock(_lock);
+      if (!_dirty) {
+        _building = false;
+        return;
+      }
+
+      _dirty = false;
+      land  = _land;
+      lat   = _mask_lat = _lat;
+      lon   = _mask_lon = _lon;
+      range = _range;
+    }
+
+    struct timespec t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    LandMaskTable* t = build(*land, lat, lon, range);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    delete _pending.exchange(t, std::memory_order_acq_rel);
+
+    uint32_t us = (uint32_t)(elapsedNs(t1, t2) * 1e-3);
+    _last_build_us.store(us);
+    if (us > _max_build_us.load())
+      _max_build_us.store(us);
+    _rebuilds.fetch_add(1);
+  }
+}
+
+// Sets bits [from, to) of the row
+static void setBits(uint32_t* row, uint32_t from, uint32_t to) {
+  while (from < to) {
+    uint32_t b = from & 31;
+    uint32_t n = std::min(32 - b, to - from);
+
+    row[from >> 5] |= (n == 32) ? 0xFFFFFFFFu : ((1u << n) - 1) << b;
+    from += n;
+  }
+}
+
+void LandMask::rasterise(LandMaskTable* t, const float* x, const float* y) const {
+  // Counter-clockwise order, so the edge normals below point inside
+  float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  if (area == 0.f)
+    return;
+
+  int v[3] = { 0, 1, 2 };
+  if (area < 0.f)
+    std::swap(v[1], v[2]);
+
+  // Point p is inside when nx*px + ny*py >= c for all edges
+  float nx[3], ny[3], c[3];
+  bool origin_inside = true;
+  for (int i = 0; i < 3; i++) {
+    int a = v[i], b = v[(i + 1) % 3];
+    nx[i] = -(y[b] - y[a]);
+    ny[i] =   x[b] - x[a];
+    c[i]  = nx[i] * x[a] + ny[i] * y[a];
+    if (c[i] > 0.f)
+      origin_inside = false;
+  }
+
+  // Bearings crossing the triangle
+  int64_t b_from = 0, b_to = (int64_t)_brg_count - 1;
+  if (!origin_inside) {
+    double a0 = atan2(x[0], y[0]);
+    double lo = 0.0, hi = 0.0;
+    for (int i = 1; i < 3; i++) {
+      double d = atan2(x[i], y[i]) - a0;
+      if (d > M_PI)
+        d -= 2.0 * M_PI;
+      if (d < -M_PI)
+        d += 2.0 * M_PI;
+      lo = std::min(lo, d);
+      hi = std::max(hi, d);
+    }
+
+    b_from = (int64_t) floor((a0 + lo) * _brg_count / (2.0 * M_PI));
+    b_to   = (int64_t) floor((a0 + hi) * _brg_count / (2.0 * M_PI));
+    if (b_to - b_from >= (int64_t)_brg_count)
+      b_to = b_from + _brg_count - 1;
+  }
+
+  const float spm = _brg_size / t->range;
+
+  for (int64_t bb = b_from; bb <= b_to; bb++) {
+    uint32_t b = (uint32_t)(((bb % _brg_count) + _brg_count) % _brg_count);
+    float tmin = 0.f, tmax = t->range;
+
+    // Clip the bearing ray by the three edges
+    for (int i = 0; i < 3 && tmin < tmax; i++) {
+      float den = nx[i] * _dx[b] + ny[i] * _dy[b];
+
+      if (den > 0.f)
+        tmin = std::max(tmin, c[i] / den);
+      else if (den < 0.f)
+        tmax = std::min(tmax, c[i] / den);
+      else if (c[i] > 0.f)
+        tmax = tmin;
+    }
+
+    if (tmin >= tmax)
+      continue;
+
+    uint32_t from = (uint32_t)(tmin * spm + 0.5f);
+    uint32_t to   = std::min((uint32_t)(tmax * spm + 0.5f), _brg_size);
+    setBits(&t->bits[(size_t)b * t->words], from, to);
+  }
+}
+
+LandMaskTable* LandMask::build(const std::vector<float>& land, float lat, float lon, float range) const {
+  LandMaskTable* t = new LandMaskTable();
+  t->lat       = lat;
+  t->lon       = lon;
+  t->range     = range;
+  t->words     = (_brg_size + 31) / 32;
+  t->triangles = 0;
+  t->land      = 0;
+  t->bits.assign((size_t)_brg_count * t->words, 0);
+
+  const float ky = LM_MILES_PER_DEGREE;
+  const float kx = std::max(LM_MILES_PER_DEGREE * cosf(lat * (float)M_PI / 180.f), 1e-3f);
+  const float dlat = range / ky;
+  const float dlon = range / kx;
+
+  float x[3], y[3];
+  for (size_t i = 0; i + 6 <= land.size(); i += 6) {
+    const float* p = &land[i];
+
+    // Quick rejection by the bounding box in degrees
+    float lat_min = std::min(p[0], std::min(p[2], p[4]));
+    float lat_max = std::max(p[0], std::max(p[2], p[4]));
+    float lon_min = std::min(p[1], std::min(p[3], p[5]));
+    float lon_max = std::max(p[1], std::max(p[3], p[5]));
+
+    if (lat_max < lat - dlat || lat_min > lat + dlat || lon_max < lon - dlon || lon_min > lon + dlon)
+      continue;
+
+    for (int k = 0; k < 3; k++) {
+      x[k] = (p[2*k+1] - lon) * kx;
+      y[k] = (p[2*k]   - lat) * ky;
+    }
+
+    rasterise(t, x, y);
+    t->triangles++;
+  }
+
+  for (size_t i = 0; i < t->bits.size(); i++)
+    t->land += __builtin_popcount(t->bits[i]);
+
+  return t;
+}
+
+void LandMask::apply(uint32_t brg, float* amps) {
+  LandMaskTable* t = _pending.exchange(NULL, std::memory_order_acq_rel);
+  if (t) {
+    delete _table;
+    _table = t;
+  }
+
+  if (!_table || brg >= _brg_count || !_enabled.load(std::memory_order_relaxed))
+    return;
+
+  // Radar bearings are counted from the ship head, mask rows from north
+  uint32_t row_brg = (brg + _shift.load(std::memory_order_relaxed)) % _brg_count;
+  const uint32_t* row = &_table->bits[(size_t)row_brg * _table->words];
+  bool hit = false;
+
+  for (uint32_t w = 0; w < _table->words; w++) {
+    uint32_t bits = row[w];
+    if (bits == 0)
+      continue;
+
+    hit = true;
+    float* a = amps + w * 32;
+
+#ifdef __SSE2__
+    if (w * 32 + 32 <= _brg_size) {
+      for (int q = 0; q < 8; q++, bits >>= 4) {
+        uint32_t n = bits & 15;
+        if (n == 0)
+          continue;
+
+        __m128 m = _mm_castsi128_ps(_mm_set_epi32(-(int)((n >> 3) & 1), -(int)((n >> 2) & 1)
+                                                 , -(int)((n >> 1) & 1), -(int)(n & 1)));
+        _mm_storeu_ps(a + q * 4, _mm_andnot_ps(m, _mm_loadu_ps(a + q * 4)));
+      }
+      continue;
+    }
+#endif // __SSE2__
+
+    for (uint32_t i = 0; i < 32 && w * 32 + i < _brg_size; i++)
+      if ((bits >> i) & 1)
+        a[i] = 0.f;
+  }
+
+  if (hit)
+    _masked++;
+}
+
+void LandMask::printStats(FILE* f) const {
+  const LandMaskTable* t = _table;
+  fprintf(f, "Land mask: %s, %u rebuilds (last %.1f ms, max %.1f ms), %u triangles, %.1f%% land, %llu bearings masked\n"
+          , _enabled.load() ? "on" : "off", _rebuilds.load()
+          , _last_build_us.load() * 1e-3, _max_build_us.load() * 1e-3
+          , t ? t->triangles : 0
+          , t ? 100.0 * t->land / ((double)_brg_count * _brg_size) : 0.0
+          , (unsigned long long)_masked);
+}
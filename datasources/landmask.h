@@ -0,0 +1,84 @@
+#ifndef LANDMASK_H
+#define LANDMASK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define LM_MOVE_SAMPLES     4        // Own ship displacement in range samples which triggers a rebuild
+#define LM_MILES_PER_DEGREE 60.1077f // Miles in a degree of latitude, same earth radius as RLIMath
+
+// Land rasterised for one position and scale. Rows are north-referenced,
+// bit i of a row is set when range sample i of the bearing is over land
+struct LandMaskTable {
+  float    lat;
+  float    lon;
+  float    range;
+  uint32_t words;      // 32-bit words per bearing
+  uint32_t triangles;  // Triangles within range
+  uint64_t land;       // Samples over land
+  std::vector<uint32_t> bits;
+};
+
+// Chart land areas masked out of the radar video. Position, scale and
+// land are set from the GUI thread, the mask is built by rebuild() in a
+// worker and handed over to the processing thread without locking.
+class LandMask {
+public:
+  LandMask(uint32_t brg_count, uint32_t brg_size);
+  ~LandMask();
+
+  // GUI thread. Triangles are lat, lon pairs as in S52AreaLayer
+  void addAreas(const std::vector<float>& triangles);
+  void setPosition(float lat, float lon);
+  void setScale(float range);
+
+  // Any thread
+  void setHeading(float hdg);
+  void setEnabled(bool on);
+
+  // True if a rebuild is due and the caller has to run rebuild() in a worker
+  bool startRebuild();
+  void rebuild();
+
+  // Processing thread: zeroes the samples of the radar bearing over land
+  void apply(uint32_t brg, float* amps);
+
+  void printStats(FILE* f) const;
+
+  // Any thread: land rasterised for a position and scale, owned by the caller
+  LandMaskTable* build(const std::vector<float>& land, float lat, float lon, float range) const;
+
+private:
+  void rasterise(LandMaskTable* t, const float* x, const float* y) const;
+
+  uint32_t _brg_count;
+  uint32_t _brg_size;
+  std::vector<float> _dx, _dy;  // Bearing directions, x to the east and y to the north
+
+  // Build requests, GUI and worker threads
+  std::mutex _lock;
+  std::shared_ptr< const std::vector<float> > _land;
+  float _lat, _lon, _range;     // Requested
+  float _mask_lat, _mask_lon;   // Position of the last build started
+  bool  _has_pos;
+  bool  _dirty;
+  bool  _building;
+
+  std::atomic<LandMaskTable*> _pending;
+  std::atomic<uint32_t>       _shift;    // Heading in bearings
+  std::atomic<bool>           _enabled;
+
+  std::atomic<uint32_t> _rebuilds;
+  std::atomic<uint32_t> _last_build_us;
+  std::atomic<uint32_t> _max_build_us;
+
+  // Processing thread state
+  LandMaskTable* _table;
+  uint64_t       _masked;   // Bearings with land samples zeroed
+};
+
+#endif // LANDMASK_H
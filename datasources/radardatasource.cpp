@@ -17,7 +17,8 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <errno.h>
-#include <signal.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -58,8 +59,6 @@ uint32_t gmax = 0;
 #define APCTRL_CTRL_STATEN       0x0010
 #define APCTRL_CTRL_UARTEN       0x0020
 
-#define APCTRL_SPIWR_TIMEOUT     (unsigned long long)1000 * 1000000
-
 #define APCTRL_HIP_MASK          0x0003
 #define APCTRL_HIP_NONE          0
 #define APCTRL_HIP_WEAK          0x0002
@@ -67,7 +66,11 @@ uint32_t gmax = 0;
 #define APCTRL_HIP_SHIFT         0
 #define APCTRL_HIP_SARP_SHIFT    0
 
-static int spi_timeout = 0;
+#define RDS_POLL_MS              100   // Longest radar_worker sleep without events
+#define RDS_NOPOLL_MS            1     // Buffer check period when the driver cannot poll
+#define RDS_REGQ_POLL_MS         1     // radar_worker sleep while register commands wait on the SPI busy flag
+#define RDS_POLL_SPURIOUS        64    // Readiness reports without a new buffer before falling back
+#define RDS_FIRST_BEARING_MS     30000 // Warn when no bearing arrives within this time
 
 void qSleep(int ms) {
   if (ms <= 0) return;
@@ -79,21 +82,42 @@ void qSleep(int ms) {
 #endif
 }
 
-#ifndef Q_OS_WIN
-static void tmr_hndlr(int sig, siginfo_t * si, void * uc)
-{
-    Q_UNUSED(sig);
-    Q_UNUSED(si);
-    Q_UNUSED(uc);
-    spi_timeout = 1;
+static uint64_t nowNs() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec;
 }
-#endif
+
+#ifndef Q_OS_WIN
+// Register access of the queue goes through the driver ioctls
+class RadarDataSource::DeviceIo : public RegisterIo {
+public:
+  explicit DeviceIo(RadarDataSource* rds) : _rds(rds) {}
+
+  int regwr(uint32_t addr, uint32_t val) { return _rds->apctrl_regwr(addr, val); }
+  int regrd(uint32_t addr, uint32_t* val) { return _rds->apctrl_regrd(addr, val); }
+
+private:
+  RadarDataSource* _rds;
+};
+#endif // !Q_OS_WIN
 
 const u_int32_t RadarDataSource::max_gain_level = 255;
 
 RadarDataSource::RadarDataSource() {
   finish_flag = true;
   _radar_scale = new RadarScale();
+  _ring = new BearingRing(BEARINGS_PER_CYCLE / 2, PELENG_SIZE);
+  _clutter = new ClutterFilter(PELENG_SIZE);
+  _gain_est = new GainEstimator(BEARINGS_PER_CYCLE, max_gain_level);
+  _auto_gain = false;
+  _guard = new GuardZones(BEARINGS_PER_CYCLE, PELENG_SIZE);
+  _guard->setScale(_radar_scale->getCurScale()->len);
+  _land = new LandMask(BEARINGS_PER_CYCLE, PELENG_SIZE);
+  _land->setScale(_radar_scale->getCurScale()->len);
+  _stab = new AzimuthStabiliser(BEARINGS_PER_CYCLE, PELENG_SIZE);
+  _scene = NULL;
+  _rot = new RotationEstimator(BEARINGS_PER_CYCLE);
 
   loadData();
 
@@ -101,7 +125,7 @@ RadarDataSource::RadarDataSource() {
 // Disable radar device for win OS
 // ------------------------------------------------------
   file_curr         = 0;
-  syncstate         = RDSS_NOTSYNC;
+  bsync             = new BearingSync(BEARINGS_PER_CYCLE);
   bufpool           = NULL;
   bufpoolsize       = 0; //nextbuf(0)
   // rdpool = NULL;
@@ -110,12 +134,29 @@ RadarDataSource::RadarDataSource() {
   activescan        = 0;
   processed_bearing = 0;
   last_bearing      = 0;
+  acq_batch_ns      = 0;
+  brg_time.assign(BEARINGS_PER_CYCLE, 0);
+  row_time.assign(BEARINGS_PER_CYCLE, 0);
   fd                = -1;
+  net               = NULL;
+  net_input         = false;
+  regio             = new DeviceIo(this);
+  regq              = new RegisterQueue(regio);
+  evfd              = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  dev_pollable      = true;
+  dev_idle          = 0;
+  acq_first_ms      = -1;
+  acq_dev_wakeups   = 0;
+  acq_ctl_wakeups   = 0;
+  acq_timeouts      = 0;
+
+  if(evfd == -1)
+    fprintf(stderr, "%s: eventfd failed, control commands wait for device events: %s\n", __func__, strerror(errno));
+  else
+    regq->setNotify(&RadarDataSource::wakeWorker, this);
 
   for(int scanidx = 0; scanidx < RDS_MAX_SCANS; scanidx++)
     scans[scanidx] = NULL;
-
-  adcspi_tmid       = NULL;
 #endif //Q_OS_WIN
 // ------------------------------------------------------
   ampoffset         = 0;
@@ -134,8 +175,38 @@ RadarDataSource::RadarDataSource() {
 }
 
 RadarDataSource::~RadarDataSource() {
-  finish_flag = true;
-  while(workerThread.isRunning());
+#ifndef Q_OS_WIN
+  struct timespec t1, t2;
+  bool running = workerThread.isRunning();
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  finish();
+  workerThread.waitForFinished();
+  clock_gettime(CLOCK_MONOTONIC, &t2);
+
+  // Stages keep their stats while running, they are printed once here
+  if(running) {
+    printf("Acquisition stopped in %.2f ms\n", (t2.tv_sec - t1.tv_sec) * 1e3 + (t2.tv_nsec - t1.tv_nsec) * 1e-6);
+
+    if(net) {
+      net->printStats(stdout);
+    } else {
+      regq->printStats(stdout);
+      printAcqStats(stdout);
+    }
+
+    bsync->printStats(stdout);
+    _ring->printStats(stdout);
+    _gain_est->printEstimate(stdout);
+    _guard->printStats(stdout);
+    _land->printStats(stdout);
+    _stab->printStats(stdout);
+    _rot->printStats(stdout);
+  }
+#else
+  finish();
+  workerThread.waitForFinished();
+#endif // !Q_OS_WIN
 
 #ifndef Q_OS_WIN
 // Disable radar device for win OS
@@ -164,6 +235,14 @@ RadarDataSource::~RadarDataSource() {
     bufpoolsize = 0;
   }
 
+  delete bsync;
+  delete net;
+  delete regq;
+  delete regio;
+
+  if(evfd != -1)
+    ::close(evfd);
+
 #ifdef WRITE_WHENSYNC
   if(scanlog)
   {
@@ -176,9 +255,6 @@ RadarDataSource::~RadarDataSource() {
   fprintf(stderr, "gmax = %u\n", gmax);
 #endif // GET_MAX_AMPL
 
-  if(adcspi_tmid != NULL)
-      timer_delete(adcspi_tmid);
-
 #endif //Q_OS_WIN
 // ------------------------------------------------------
 
@@ -187,6 +263,17 @@ RadarDataSource::~RadarDataSource() {
       delete [] dump;
       dump = NULL;
   }
+
+  delete _ring;
+  delete _clutter;
+  delete _gain_est;
+  delete _guard;
+
+  _land_build.waitForFinished();
+  delete _land;
+  delete _stab;
+  delete _scene;
+  delete _rot;
 }
 
 void RadarDataSource::start() {
@@ -194,7 +281,23 @@ void RadarDataSource::start() {
     return;
 
   finish_flag = false;
-  workerThread = QtConcurrent::run(this, &RadarDataSource::worker);
+  if (_scene)
+    workerThread = QtConcurrent::run(this, &RadarDataSource::scene_worker);
+  else
+    workerThread = QtConcurrent::run(this, &RadarDataSource::worker);
+}
+
+bool RadarDataSource::setScene(const char * name, uint32_t seed) {
+  const RadarSceneConfig* cfg = findRadarScene(name);
+  if (cfg == NULL || workerThread.isRunning())
+    return false;
+
+  delete _scene;
+  _scene = new RadarScene(BEARINGS_PER_CYCLE, PELENG_SIZE, *cfg, seed);
+  _scene->setRange(_radar_scale->getCurScale()->len);
+
+  printf("Radar scene '%s', seed %u, %.0f rpm\n", cfg->name, seed, cfg->rpm);
+  return true;
 }
 
 
@@ -267,8 +370,6 @@ void RadarDataSource::start(const char * radarfn) {
 // Disable radar device for win OS
 // ------------------------------------------------------
     struct apctrl_caps caps;
-    struct sigaction   sa;
-    struct sigevent    tev;
     int ret;
 
     if(!radarfn)
@@ -276,6 +377,11 @@ void RadarDataSource::start(const char * radarfn) {
     if (workerThread.isRunning())
       return;
 
+    clock_gettime(CLOCK_MONOTONIC, &acq_t0);
+    acq_first_ms = -1;
+    dev_pollable = true;
+    dev_idle     = 0;
+
     rdpnext   = 0;
     rdpqueued = 0;
 
@@ -392,34 +498,8 @@ void RadarDataSource::start(const char * radarfn) {
     }
 #endif // WRITE_WHENSYNC
 
-    // Create a timer for ADC SPI timeout
-    sa.sa_flags     = SA_SIGINFO;
-    sa.sa_sigaction = tmr_hndlr;
-    sigemptyset(&sa.sa_mask);
-    if(sigaction(SIGRTMIN, &sa, NULL) != -1)
-    {
-        // Create timer
-        tev.sigev_notify = SIGEV_SIGNAL;
-        tev.sigev_signo  = SIGRTMIN;
-        tev.sigev_value.sival_ptr = &adcspi_tmid;
-        if(timer_create(CLOCK_REALTIME, &tev, &adcspi_tmid) == -1)
-        {
-            fprintf(stderr, "Failed to create timer for ADC SPI timeout handler: %s\n", strerror(errno));
-            fprintf(stderr, "WARNING: Creation of the timer for ADC SPI timeout failed and the operation my hang.\n");
-            fprintf(stderr, "\t Use Ctrl+C to terminate in such case.\n");
-
-            adcspi_tmid = NULL;
-        }
-    }
-    else
-    {
-        fprintf(stderr, "Failed to setup signal handler for ADC SPI timeout handler: %s\n", strerror(errno));
-        fprintf(stderr, "WARNING: since there's no timer for ADC SPI timeout the operation my hang.\n");
-        fprintf(stderr, "\t Use Ctrl+C to terminate in such case.\n");
-    }
-
     // Initialize AP generator
-    ret = initGen(true);
+    ret = initGen();
     if(ret != 0)
     {
         fprintf(stderr, "Failed to initialize AP generator (%d)\n", ret);
@@ -427,7 +507,7 @@ void RadarDataSource::start(const char * radarfn) {
     }
 
 	printf("Setting frequency.\n");
-    apctrl_adcspi_send(APCTRL_GEN_BASEADDR, 0x1f0024, 0x1f4007, true);
+    apctrl_adcspi_send(APCTRL_GEN_BASEADDR, 0x1f0024, 0x1f4007);
 	printf("Initializing ADC.\n");
     initADC();
 	printf("Initializing DAC.\n");
@@ -457,7 +537,12 @@ void RadarDataSource::start(const char * radarfn) {
     apctrl_regwr(APCTRL_GYROREG_BASEADDR, gyroReg);
 	printf("APCTRL_GYROREG_BASEADDR written with 0x%X\n", gyroReg);
 
-    syncstate    = RDSS_NOTSYNC;
+    bsync->reset();
+    bsync->resetStats();
+    late_bearings.clear();
+    processed_bearing = 0;
+    last_bearing      = 0;
+
     finish_flag  = false;
     workerThread = QtConcurrent::run(this, &RadarDataSource::radar_worker);
 
@@ -465,8 +550,74 @@ void RadarDataSource::start(const char * radarfn) {
 // ------------------------------------------------------
 }
 
+void RadarDataSource::start_cat240(const char * address) {
+  Q_UNUSED(address);
+#ifndef Q_OS_WIN
+  if (workerThread.isRunning() || fd != -1)
+    return;
+
+  if(!net)
+    net = new Cat240Receiver(BEARINGS_PER_CYCLE, PELENG_SIZE);
+
+  if(!net->open(address))
+    return;
+
+  for(int scanidx = 0; scanidx < RDS_MAX_SCANS; scanidx++) {
+    if(!scans[scanidx]) {
+      scans[scanidx] = new BearingBuffer * [BEARINGS_PER_CYCLE];
+      memset(scans[scanidx], 0, sizeof(BearingBuffer *) * BEARINGS_PER_CYCLE);
+    }
+  }
+
+  // Received bearings are copied into a pool in the acquisition layout,
+  // a revolution of buffers covers everything waiting for processing
+  if(!bufpool) {
+    bufpoolsize = BEARINGS_PER_CYCLE;
+    bufpool     = new BearingBuffer[bufpoolsize];
+    net_words.resize(bufpoolsize * BEARING_PACK_WORDS);
+
+    for(unsigned long i = 0; i < bufpoolsize; i++)
+      bufpool[i].bind(&net_words[i * BEARING_PACK_WORDS], i);
+  }
+
+  net_input  = true;
+  simulation = false;
+  activescan = 0;
+  rdpqueued  = 0;
+
+  bsync->reset();
+  bsync->resetStats();
+  late_bearings.clear();
+  processed_bearing = 0;
+  last_bearing      = 0;
+
+  finish_flag  = false;
+  workerThread = QtConcurrent::run(this, &RadarDataSource::net_worker);
+#endif // !Q_OS_WIN
+}
+
 void RadarDataSource::finish() {
   finish_flag = true;
+#ifndef Q_OS_WIN
+  wakeWorker(this);
+#endif // !Q_OS_WIN
+}
+
+void RadarDataSource::publishData(uint offset, uint count, GLfloat* amps, const uint64_t* times) {
+  // The display and the other consumers read the bearings from the ring
+  for(uint i = 0; i < count; i++) {
+    uint brg = (offset + i) % BEARINGS_PER_CYCLE;
+
+    _land->apply(brg, &amps[i * PELENG_SIZE]);
+    _clutter->apply(&amps[i * PELENG_SIZE]);
+    _ring->publish(brg, &amps[i * PELENG_SIZE], times ? times[brg] : 0);
+
+    uint64_t changed = _guard->test(brg, &amps[i * PELENG_SIZE]);
+    for(; changed; changed &= changed - 1) {
+      int zone = __builtin_ctzll(changed);
+      emit guardAlarm(zone, (_guard->alarms() >> zone) & 1);
+    }
+  }
 }
 
 #define BLOCK_TO_SEND 32
@@ -489,13 +640,14 @@ void RadarDataSource::worker() {
             iamps[2] = 1;
             for(int j = 3; j < PELENG_SIZE + 3; j++)
                 iamps[j] = file_amps[file][(offset + i) * PELENG_SIZE + j - 3];
+            estimateGain(iamps);
             amplify(iamps);
             for(int j = 3; j < PELENG_SIZE + 3; j++)
                 famps[(offset + i) * PELENG_SIZE + j - 3] = (float)iamps[j];
         }
 
         //emit updateData(offset, BLOCK_TO_SEND, /*&file_divs[file][offset], */&file_amps[file][offset*PELENG_SIZE]);
-        emit updateData(offset, BLOCK_TO_SEND, &famps[offset*PELENG_SIZE]);
+        publishData(offset, BLOCK_TO_SEND, &famps[offset*PELENG_SIZE]);
 
         offset = (offset + BLOCK_TO_SEND) % BEARINGS_PER_CYCLE;
         if (offset == 0) file = 1 - file;
@@ -503,6 +655,73 @@ void RadarDataSource::worker() {
   }
 }
 
+#define RDS_SCENE_SLEEP_MS 5 // Pause between scene blocks at a real antenna speed
+
+void RadarDataSource::scene_worker() {
+  static u_int32_t iamps[PELENG_SIZE + 3];
+  static float famps[BEARINGS_PER_CYCLE * PELENG_SIZE];
+  const RadarSceneConfig& cfg = _scene->config();
+  struct timespec t0, t;
+  uint64_t sent = 0;    // Bearings since start
+  uint64_t skipped = 0; // Bearings dropped when generation fell behind the antenna
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  while(!finish_flag) {
+    uint64_t due = sent + BLOCK_TO_SEND;
+
+    if(cfg.rpm > 0.f) {
+      clock_gettime(CLOCK_MONOTONIC, &t);
+      double s = (t.tv_sec - t0.tv_sec) + (t.tv_nsec - t0.tv_nsec) * 1e-9;
+      due = (uint64_t)(s * cfg.rpm / 60.0 * BEARINGS_PER_CYCLE);
+
+      if(due > sent + BEARINGS_PER_CYCLE) {
+        skipped += due - BEARINGS_PER_CYCLE - sent;
+        sent = due - BEARINGS_PER_CYCLE;
+      }
+    }
+
+    while(sent < due && !finish_flag) {
+      uint32_t rev    = sent / BEARINGS_PER_CYCLE;
+      uint32_t offset = sent % BEARINGS_PER_CYCLE;
+      uint32_t count  = BEARINGS_PER_CYCLE - offset;
+      if(count > BLOCK_TO_SEND)
+        count = BLOCK_TO_SEND;
+      if(count > due - sent)
+        count = due - sent;
+
+      for(uint32_t i = 0; i < count; i++) {
+        uint32_t brg = offset + i;
+
+        // Gain is estimated from raw video as with the device
+        const uint8_t* raw = _scene->raw(rev, brg);
+        iamps[0] = brg;
+        iamps[1] = PELENG_SIZE;
+        iamps[2] = 1;
+        for(int j = 0; j < PELENG_SIZE; j++)
+          iamps[j + 3] = raw[j];
+        estimateGain(iamps);
+
+        const uint8_t* amps = _scene->amplified(rev, brg, gain_level, max_gain_level);
+        for(int j = 0; j < PELENG_SIZE; j++)
+          famps[brg * PELENG_SIZE + j] = amps[j];
+      }
+
+      publishData(offset, count, &famps[offset * PELENG_SIZE]);
+      sent += count;
+    }
+
+    if(cfg.rpm > 0.f)
+      qSleep(RDS_SCENE_SLEEP_MS);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  double s = (t.tv_sec - t0.tv_sec) + (t.tv_nsec - t0.tv_nsec) * 1e-9;
+  printf("Radar scene: %llu bearings in %.1f s (%.0f per second), %llu skipped\n"
+         , (unsigned long long)sent, s, s > 0 ? sent / s : 0.0, (unsigned long long)skipped);
+  _scene->printStats(stdout);
+}
+
 void RadarDataSource::dump_worker() {
     u_int32_t good_start, good_end;
     u_int32_t tmp_start, tmp_end;
@@ -592,6 +811,7 @@ void RadarDataSource::dump_worker() {
 
             memcpy(&tmp_brg[i], &dump[curpos], BEARING_PACK_SIZE);
             preprocessBearing(&tmp_brg[i][0], true);
+            estimateGain(tmp_brg[i]);
             amplify(tmp_brg[i]);
 
             for(u_int32_t j = 0; j < amps; j++)
@@ -609,7 +829,7 @@ void RadarDataSource::dump_worker() {
         }
 
         if(!simulation)
-            emit updateData(offset, BLOCK_TO_SEND, /*&file_divs[0][offset], */&file_amps[0][offset*PELENG_SIZE]);
+            publishData(offset, BLOCK_TO_SEND, /*&file_divs[0][offset], */&file_amps[0][offset*PELENG_SIZE]);
     }
 }
 
@@ -621,6 +841,7 @@ uint32_t bearidx;
 
 void RadarDataSource::radar_worker() {
     int      res;
+    bool     regs_busy;
     uint32_t stepbear;
     uint32_t scanidx;
     //uint32_t bearidx;
@@ -647,12 +868,7 @@ void RadarDataSource::radar_worker() {
     try
     {
 
-#define SLEEPTIMESEC 30
-//#ifdef PRINTERRORS
-			printf("%s: Sleeping %d s while engine initializes.\n", __func__, SLEEPTIMESEC);
-//#endif // PRINTERRORS
-        sleep(SLEEPTIMESEC);
-        //res = ioctl(fd, APCTRL_IOCTL_START, 256);
+        // No start-up pause: bearings are taken as soon as DMA delivers them
         res = ioctl(fd, APCTRL_IOCTL_START, 2048);
         if (-1 == res) {
             fprintf(stderr, "Failed to start APCTRL: %s\n", strerror(errno));
@@ -668,22 +884,42 @@ void RadarDataSource::radar_worker() {
 		printf("%s: IOCTL_START succeeded.\n", __func__);
 //#endif // PRINTERRORS
 
+        regs_busy = false;
         while(!finish_flag)
         {
-            //clock_gettime(CLOCK_REALTIME, &t1);
-            //clock_gettime(CLOCK_REALTIME, &t2);
-            //double rdtime = (double)((long long)(t2.tv_sec - t1.tv_sec) * 1000000000 + (t2.tv_nsec - t1.tv_nsec) / 1000000);
-            //printf("%s: Read time %f ms (mean %f ms per bearing)\n", __func__, rdtime, rdtime / 256);
+            res = waitDevice(regs_busy);
+            if(res < 0)
+                throw -18;
 
-            res = ioctl(fd, APCTL_IOCTL_WAIT, &rdpnext);
+            regs_busy = serviceRegisters();
+            if(res == 0)
+                continue;
+
+            res = ioctl(fd, APCTL_IOCTL_GET_CUR, &rdpnext);
             if (-1 == res) {
                 fprintf(stderr, "%s: Failed to get current buffer: %s\n",
                         __func__, strerror(errno));
                 throw -18;
             }
 
+            // A driver without poll support is always ready, then buffers are checked periodically
+            if(rdpnext == rdpqueued)
+            {
+                if(dev_pollable && (++dev_idle >= RDS_POLL_SPURIOUS))
+                {
+                    fprintf(stderr, "%s: device does not signal DMA completion, checking every %d ms\n", __func__, RDS_NOPOLL_MS);
+                    dev_pollable = false;
+                }
+                continue;
+            }
+            dev_idle = 0;
+
+            // Buffers filled while simulating are dropped
             if(simulation)
+            {
+                rdpqueued = rdpnext;
                 continue;
+            }
 
 #ifdef PRINTERRORS
 			printf("%s: IOCTL_WAIT returned (%lu).\n", __func__, rdpnext);
@@ -695,11 +931,18 @@ void RadarDataSource::radar_worker() {
                 throw -19;
             }
 
+            // The driver does not timestamp DMA completion: the batch is stamped
+            // now and its earlier buffers one bearing step apart before that
+            acq_batch_ns = nowNs();
+            uint64_t step = _rot->bearingStep();
+            uint32_t left = (rdpnext + bufpoolsize - rdpqueued) % bufpoolsize;
+
             for(; rdpqueued != rdpnext; rdpqueued = (rdpqueued + 1) % bufpoolsize)
             {
                 BearingBuffer * bbuf = &bufpool[rdpqueued];
                 bool useData = true;
                 bbuf->used   = true;
+                bbuf->t_ns   = acq_batch_ns - (--left) * step;
 
 //				if(bearidx > 4095)
 				{
@@ -725,6 +968,13 @@ void RadarDataSource::radar_worker() {
                 if(useData)
                 {
                     stepbear = bbuf->ptr[0];
+                    if(acq_first_ms < 0)
+                    {
+                        struct timespec t;
+                        clock_gettime(CLOCK_MONOTONIC, &t);
+                        acq_first_ms = (t.tv_sec - acq_t0.tv_sec) * 1e3 + (t.tv_nsec - acq_t0.tv_nsec) * 1e-6;
+                        printf("%s: first bearing %.1f ms after start\n", __func__, acq_first_ms);
+                    }
 #ifdef WRITE_2SCANS
                     if((writestage == 0) && (stepbear == 0))
                         writestage = 1;
@@ -764,6 +1014,8 @@ void RadarDataSource::radar_worker() {
                     printf("Radar scan: %u (bearing %u)\n", ++scanidx, stepbear);
             }
 
+            finishBatch();
+
 #ifdef PRINTERRORS
 			printf("%s: calling preocessBearings.\n", __func__);
 #endif // PRINTERRORS
@@ -800,6 +1052,44 @@ void RadarDataSource::radar_worker() {
     }
     return;
 }
+
+void RadarDataSource::net_worker() {
+  uint32_t scanidx = 0;
+  uint32_t count   = 0;
+
+  while(!finish_flag) {
+    int res = net->receive(100);
+    if(res < 0) {
+      fprintf(stderr, "%s: receive failed: %s\n", __func__, strerror(errno));
+      break;
+    }
+
+    // Packets are stamped on reception, a datagram carries consecutive bearings
+    acq_batch_ns = nowNs();
+    uint64_t step = _rot->bearingStep();
+
+    for(int i = 0; i < res; i++) {
+      BearingBuffer * bbuf = &bufpool[rdpqueued];
+      rdpqueued = (rdpqueued + 1) % bufpoolsize;
+
+      memcpy(bbuf->ptr, net->packet(i), (PELENG_SIZE + 3) * sizeof(uint32_t));
+      bbuf->used = true;
+      bbuf->t_ns = acq_batch_ns - (res - 1 - i) * step;
+      setRawBearingData(bbuf);
+
+      if((++count % 4096) == 0)
+        printf("Radar scan: %u (bearing %u)\n", ++scanidx, bbuf->ptr[0]);
+    }
+
+    if(res > 0) {
+      finishBatch();
+      processBearings();
+    }
+  }
+
+  net->close();
+  finish_flag = true;
+}
 #endif //Q_OS_WIN
 // ------------------------------------------------------
 
@@ -934,7 +1224,7 @@ bool RadarDataSource::loadObserves1(char* filename, GLfloat* amps) {
 // ------------------------------------------------------
 int RadarDataSource::setRawBearingData(BearingBuffer * bearing) {
   uint32_t brg;
-  static uint32_t prev_bear = 0;
+  bool     was_synced;
 
 #ifdef PRINTERRORS
     printf("%s: Entered\n", __func__);
@@ -957,94 +1247,36 @@ int RadarDataSource::setRawBearingData(BearingBuffer * bearing) {
     printf("%s: Bearing: %u\n", __func__, brg);
 #endif // PRINTERRORS
 
-  // TODO: Delete after debugging (start)
-  if(((brg - prev_bear) != 1) && (brg != 0) && (prev_bear != 4095))
-  {
-      fprintf(stdout, "Non-sequential! cur %u, prev %u\n", brg, prev_bear);
-      //fprintf(stderr, "Non-sequential! cur %u, prev %u\n", brg, prev_bear);
-  }
-  prev_bear = brg;
-  // TODO: Delete after debugging (end)
-
+  was_synced = bsync->synced();
 
-  if (brg >= BEARINGS_PER_CYCLE) {
-    bearing->valid = false;
+  switch(bsync->push(brg)) {
+    case BearingSync::BSR_INVALID:
+      bearing->valid = false;
 #ifdef PRINTERRORS
-    fprintf(stdout, "%s: Invalid bearing (%u)\n", __func__, brg);
-    //fprintf(stderr, "%s: Invalid bearing (%u)\n", __func__, brg);
+      fprintf(stdout, "%s: Invalid bearing (%u)\n", __func__, brg);
 #endif // PRINTERRORS
-    return -3; // Invalid bearing
+      return -3; // Invalid bearing
+
+    case BearingSync::BSR_DROP:
+      bearing->valid = false;
+      return 0;
+
+    case BearingSync::BSR_LATE:
+      // The gap might have been published already, then the bearing is sent separately
+      if(bsync->distance(processed_bearing, brg) > bsync->distance(processed_bearing, last_bearing))
+        late_bearings.push_back(brg);
+      break;
+
+    default:
+      break;
   }
 
-  if(syncstate != RDSS_SYNC) {
-    switch(syncstate) {
-      case RDSS_NOTSYNC:
-        if (brg == 0)
-          syncstate = RDSS_WAIT4STAB;
-        break;
-      case RDSS_WAIT4STAB:
-        if(brg == 0) {
-          if(last_bearing == (BEARINGS_PER_CYCLE - 1)) {
-            // Full scan completed. Radar controller is synchronized
-            processed_bearing = BEARINGS_PER_CYCLE - 1;
+  if(was_synced && !bsync->synced()) {
+    // Synchronization lost: publish what has been received before the disturbance
 #ifdef PRINTERRORS
-            printf("In sync state (%u %u)!\n", brg, last_bearing);
+    fprintf(stdout, "%s: Restart synchronization: cur %u, prev %u\n", __func__, brg, last_bearing);
 #endif // PRINTERRORS
-            syncstate = RDSS_SYNC;
-            break;
-          }
-
-          syncstate = RDSS_NOTSYNC; // Gap in bearings. Restart synchronization process
-#ifdef PRINTERRORS
-          //fprintf(stderr, "%s: Restart synchronization: cur %u, prev %u\n", __func__, brg, last_bearing);
-          fprintf(stdout, "%s: Restart synchronization: cur %u, prev %u\n", __func__, brg, last_bearing);
-#ifdef WRITE_WHENSYNC
-          if(!brg && !last_bearing)
-          {
-              fprintf(scanlog, "BIDX: %u. %u, %u, %u", bearidx, bearing->ptr[0], bearing->ptr[1], bearing->ptr[2]);
-              for(int i = 3; i < 803; i++)
-              {
-                  if(((i - 3) % 8) == 0)
-                      fprintf(scanlog, "\n\t");
-                  fprintf(scanlog, "0x%08X ", bearing->ptr[i]);
-              }
-              fprintf(scanlog, "\n");
-          }
-#endif // WRITE_WHENSYNC
-#endif
-        } else {
-          if (brg != last_bearing + 1) {
-            syncstate = RDSS_NOTSYNC; // Gap in bearings. Restart synchronization process
-#ifdef PRINTERRORS
-            //fprintf(stderr, "%s: Restart synchronization: cur %u, prev %u\n", __func__, brg, last_bearing);
-            fprintf(stdout, "%s: Restart synchronization: cur %u, prev %u\n", __func__, brg, last_bearing);
-#ifdef WRITE_WHENSYNC
-            if(!brg && !last_bearing)
-            {
-                fprintf(scanlog, "%s: Restart synchronization: cur %u, prev %u\n", __func__, brg, last_bearing);
-                fprintf(scanlog, "BIDX: %u. %u, %u, %u", bearidx, bearing->ptr[0], bearing->ptr[1], bearing->ptr[2]);
-                for(int i = 3; i < 803; i++)
-                {
-                    if(((i - 3) % 8) == 0)
-                        fprintf(scanlog, "\n\t");
-                    fprintf(scanlog, "0x%08X ", bearing->ptr[i]);
-                }
-                fprintf(scanlog, "\n");
-            }
-#endif // WRITE_WHENSYNC
-#endif
-          }
-        }
-        break;
-      default:
-        break;
-      }
-
-    if(syncstate != RDSS_SYNC) {
-      last_bearing = brg;
-      bearing->valid = false;
-      return 0;
-    }
+    processBearings();
   }
 
 #ifdef WRITE_WHENSYNC
@@ -1058,6 +1290,7 @@ int RadarDataSource::setRawBearingData(BearingBuffer * bearing) {
   fprintf(scanlog, "\n");
 #endif // WRITE_WHENSYNC
 
+  // Bearings of a stable run are kept until the run is long enough
   bearing->valid = true;
   if(scans[activescan][brg] && (scans[activescan][brg]->used || scans[activescan][brg]->valid)) {
     // The bearing has not been processed yet but we have new data for this bearing
@@ -1065,30 +1298,25 @@ int RadarDataSource::setRawBearingData(BearingBuffer * bearing) {
     scans[activescan][brg]->used  = false;
     scans[activescan][brg]->valid = false;
 #ifdef PRINTERRORS
-    //fprintf(stderr, "%s: data at BRG %u has been overwritten\n", __func__, brg);
     fprintf(stdout, "%s: data at BRG %u has been overwritten (%c)\n", __func__, brg,
             (scans[activescan][brg]->used ? 'u' : 'v'));
 #endif // PRINTERRORS
   }
 
   scans[activescan][brg] = bearing;
+
+  if(!bsync->synced())
+    return 0;
+
+  if(!was_synced) {
+    // Whole stable run is published at once
+    processed_bearing = (bsync->firstStable() + BEARINGS_PER_CYCLE - 1) % BEARINGS_PER_CYCLE;
 #ifdef PRINTERRORS
-  if (brg == 0) {
-    if (last_bearing != (BEARINGS_PER_CYCLE - 1))
-    {
-        fprintf(stdout, "%s: Gap in bearings: cur %u, prev %u\n", __func__, brg, last_bearing);
-        //fprintf(stderr, "%s: Gap in bearings: cur %u, prev %u\n", __func__, brg, last_bearing);
-        syncstate = RDSS_NOTSYNC; // Gap in bearings. Restart synchronization process
-    }
-  } else if(brg != (last_bearing + 1))
-  {
-      fprintf(stdout, "%s: Gap in bearings: cur %u, prev %u\n", __func__, brg, last_bearing);
-      //fprintf(stderr, "%s: Gap in bearings: cur %u, prev %u\n", __func__, brg, last_bearing);
-      syncstate = RDSS_NOTSYNC; // Gap in bearings. Restart synchronization process
-  }
+    printf("In sync state (%u %u)!\n", bsync->firstStable(), brg);
 #endif // PRINTERRORS
+  }
 
-  last_bearing = brg;
+  last_bearing = bsync->head();
   return 0;
 }
 
@@ -1115,133 +1343,150 @@ BearingBuffer * RadarDataSource::getNextFreeBuffer(void) {
   return NULL;
 }
 
-int RadarDataSource::processBearings(void) {
-  uint32_t   div;
-  uint32_t   amps;
-  uint32_t * ptr;
-  uint32_t   firstbrg;
-  int         num;
-  int         res = 0;
+void RadarDataSource::processBearing(uint32_t brg) {
+  static uint32_t tmp_brgbuf[PELENG_SIZE + 3];
 
-  static uint32_t tmp_brgbuf[800 + 3];
-
-  if (syncstate != RDSS_SYNC)
-    return res;
+  BearingBuffer * bbuf = scans[activescan][brg];
+  GLfloat       * dst  = &file_amps[0][brg * PELENG_SIZE];
+  uint32_t        amps = 0;
 
-  //fprintf(stderr, "%s: Entered\n", __func__);
+  // Missing bearing is drawn blank instead of keeping the previous revolution
+  if(bbuf && bbuf->valid && !bsync->isMissing(brg)) {
+    amps = bbuf->ptr[1];
 
-  firstbrg = processed_bearing + 1;
-  if (firstbrg >= BEARINGS_PER_CYCLE)
-    firstbrg = 0;
+#ifdef GET_MAX_AMPL
+    uint32_t max = bbuf->ptr[3];
+    for(int i = 4; i < 803; i++)
+    {
+        if(bbuf->ptr[i] > max)
+            max = bbuf->ptr[i];
+    }
 
-  if (last_bearing < processed_bearing) {
-    num = BEARINGS_PER_CYCLE - processed_bearing - 1;
-    for(int i = 0; i < num; i++) {
-      processed_bearing++;
-      amps = scans[activescan][processed_bearing]->ptr[1];
-      div  = 1; //scans[activescan][processed_bearing]->ptr[2];
+    if(max > gmax)
+        gmax = max;
+#endif // GET_MAX_AMPL
 
-      if(amps > PELENG_SIZE)
-        amps = PELENG_SIZE;
+    if(amps > PELENG_SIZE)
+      amps = PELENG_SIZE;
 
-//	  fprintf(stderr, "%s: 1. Copy radar data to temporal buffer\n", __func__);
-	  for(uint32_t j = 0; j < amps + 3; j++)
-		  tmp_brgbuf[j] = scans[activescan][processed_bearing]->ptr[j];
-	  //fprintf(stderr, "%s: 1. Copy done.\n", __func__);
+    for(uint32_t j = 0; j < amps + 3; j++)
+      tmp_brgbuf[j] = bbuf->ptr[j];
+    if(!net_input)
       preprocessBearing(tmp_brgbuf, true);
-	  //fprintf(stderr, "%s: 1. Data preprocessed.\n", __func__);
-      amplify(tmp_brgbuf);
-
-	  if(div == 0)
-		  div = 1;
-      //file_divs[0][processed_bearing] = (div < 32) ? div : 1; // After debugging "div"
-      ptr = &(tmp_brgbuf[3]);
-      //ptr = &(scans[activescan][processed_bearing]->ptr[3]);
-
-      for(uint32_t j = 0; j < amps; j++)
-        file_amps[0][processed_bearing * PELENG_SIZE + j] = *ptr++;
+    estimateGain(tmp_brgbuf);
+    amplify(tmp_brgbuf);
 
-      scans[activescan][processed_bearing]->valid = false;
-    }
+    for(uint32_t j = 0; j < amps; j++)
+      dst[j] = tmp_brgbuf[j + 3];
 
-    if(num) {
-      emit updateData(firstbrg, num, /*&file_divs[0][firstbrg], */&file_amps[0][firstbrg * PELENG_SIZE]);
-    }
+    brg_time[brg] = bbuf->t_ns;
+    bbuf->valid = false;
+  } else {
+    brg_time[brg] = 0;
+  }
 
-    res      += num;
-    num       = last_bearing + 1;
-    firstbrg  = 0;
-  } else
-    num = last_bearing - processed_bearing;
+  for(uint32_t j = amps; j < PELENG_SIZE; j++)
+    dst[j] = 0;
+}
 
-  res      += num;
+int RadarDataSource::processBearings(void) {
+  uint32_t firstbrg;
+  uint32_t lastbrg;
+  int      res = 0;
+  bool     stab = _stab->enabled();
+
+  // Bearings of this batch are stamped between the previous batch and its acquisition
+  if(stab) {
+    uint32_t n = (last_bearing + BEARINGS_PER_CYCLE - processed_bearing) % BEARINGS_PER_CYCLE + late_bearings.size();
+    _stab->beginBatch(acq_batch_ns ? acq_batch_ns : nowNs(), n);
+  }
 
-  //fprintf(stderr, "%s: 2. About to precess bearings.\n", __func__);
+  while(processed_bearing != last_bearing) {
+    // Bearings are sent in contiguous chunks split at zero bearing
+    firstbrg = (processed_bearing + 1) % BEARINGS_PER_CYCLE;
+    lastbrg  = (firstbrg <= last_bearing) ? last_bearing : BEARINGS_PER_CYCLE - 1;
 
-  for(int i = 0; i < num; i++) {
-    if(++processed_bearing >= BEARINGS_PER_CYCLE)
-      processed_bearing = 0;
+    for(uint32_t brg = firstbrg; brg <= lastbrg; brg++)
+      processBearing(brg);
 
-	//fprintf(stderr, "%s: 2. Getting apms and div (BRG: %04u, scan: %d)\n", __func__, processed_bearing, activescan);
+    processed_bearing = lastbrg;
+    res += lastbrg - firstbrg + 1;
 
-    amps = scans[activescan][processed_bearing]->ptr[1];
-    div  = 1;// scans[activescan][processed_bearing]->ptr[2];
+    if(stab)
+      publishStabilised(firstbrg, lastbrg - firstbrg + 1, true);
+    else
+      publishData(firstbrg, lastbrg - firstbrg + 1, &file_amps[0][firstbrg * PELENG_SIZE], brg_time.data());
+  }
 
-	//fprintf(stderr, "%s: 2. apms %u. div %u\n", __func__,amps, div);
+  for(size_t i = 0; i < late_bearings.size(); i++) {
+    uint32_t brg = late_bearings[i];
 
+    processBearing(brg);
+    res++;
 
-#ifdef GET_MAX_AMPL
-    uint32_t max = scans[activescan][processed_bearing]->ptr[3];
-    for(int i = 4; i < 803; i++)
-    {
-        if(scans[activescan][processed_bearing]->ptr[i] > max)
-            max = scans[activescan][processed_bearing]->ptr[i];
-    }
-    if(max > 255)
-    {
-        div = max / 255 + 1;
-    }
+    if(stab)
+      publishStabilised(brg, 1, false);
+    else
+      publishData(brg, 1, &file_amps[0][brg * PELENG_SIZE], brg_time.data());
+  }
+  late_bearings.clear();
 
-    if(max > gmax)
-        gmax = max;
-#endif // GET_MAX_AMPL
-    //div = 4; // 10 bit data downgraded to 8 bit //1600 / 255 + 1;
+  return res;
+}
 
+void RadarDataSource::publishStabilised(uint32_t first, uint32_t count, bool fill) {
+  uint32_t run = 0;
+  uint32_t len = 0;
 
-    if (amps > PELENG_SIZE)
-      amps = PELENG_SIZE;
+  // Placed rows are published in contiguous runs of north-referenced bearings
+  for(uint32_t i = 0; i < count; i++) {
+    uint32_t brg = (first + i) % BEARINGS_PER_CYCLE;
+    uint32_t from;
+    uint32_t to  = _stab->place(brg, &file_amps[0][brg * PELENG_SIZE], fill, &from);
+    uint32_t n   = (to + BEARINGS_PER_CYCLE - from) % BEARINGS_PER_CYCLE + 1;
 
-	//fprintf(stderr, "%s: 2. Copy radar data to temporal buffer\n", __func__);
-    for(uint32_t j = 0; j < amps + 3; j++)
-		tmp_brgbuf[j] = scans[activescan][processed_bearing]->ptr[j];
-	//fprintf(stderr, "%s: 2. Copy done.\n", __func__);
-    preprocessBearing(tmp_brgbuf, true);
-	//fprintf(stderr, "%s: 2. Data preprocessed.\n", __func__);
-    amplify(tmp_brgbuf);
+    for(uint32_t j = 0; j < n; j++)
+      row_time[(from + j) % BEARINGS_PER_CYCLE] = brg_time[brg];
 
-	if(div == 0)
-		div = 1;
-    //file_divs[0][processed_bearing] = (div < 32) ? div : 1; // After debugging "div"
-    ptr = &(tmp_brgbuf[3]);
-    //ptr = &(scans[activescan][processed_bearing]->ptr[3]);
-	//fprintf(stderr, "%s: 2. Preparation for copying amplitudes is done.\n", __func__);
+    if(len > 0 && from == run + len && run + len + n <= (uint32_t)BEARINGS_PER_CYCLE) {
+      len += n;
+      continue;
+    }
 
-    for(uint32_t j = 0; j < amps; j++)
-      file_amps[0][processed_bearing * PELENG_SIZE + j] = *ptr++;
+    // Pending rows placed again now hold the new amplitudes and go out
+    // with the new run only, filtering and counting each row once
+    uint32_t start = run;
+    for(uint32_t j = run; j <= run + len; j++) {
+      if(j < run + len && (j + BEARINGS_PER_CYCLE - from) % BEARINGS_PER_CYCLE >= n)
+        continue;
+      if(j > start)
+        publishData(start, j - start, _stab->row(start), row_time.data());
+      start = j + 1;
+    }
 
-    scans[activescan][processed_bearing]->valid = false;
+    if(from + n > (uint32_t)BEARINGS_PER_CYCLE) {
+      publishData(from, BEARINGS_PER_CYCLE - from, _stab->row(from), row_time.data());
+      run = 0;
+      len = from + n - BEARINGS_PER_CYCLE;
+    } else {
+      run = from;
+      len = n;
+    }
   }
 
-  //fprintf(stderr, "%s: 2. Bearings done.\n", __func__);
+  if(len > 0)
+    publishData(run, len, _stab->row(run), row_time.data());
+}
 
-  if(num) {
-	//fprintf(stderr, "%s: emit updateData.\n", __func__);
-    emit updateData(firstbrg, num, /*&file_divs[0][firstbrg], */&file_amps[0][firstbrg * PELENG_SIZE]);
-	//fprintf(stderr, "%s: emit updateData done.\n", __func__);
-  }
+void RadarDataSource::finishBatch(void) {
+  // Rotation is measured on in-order bearings only
+  if(!bsync->synced())
+    return;
 
-  //fprintf(stderr, "%s: Leaving.\n", __func__);
-  return res;
+  if(_rot->addBatch(acq_batch_ns, last_bearing)) {
+    RotationRate r = _rot->rate();
+    emit rotationEstimated(r.rpm, r.jitter_us);
+  }
 }
 #endif // !Q_OS_WIN
 // ------------------------------------------------------
@@ -1338,7 +1583,7 @@ int RadarDataSource::preprocessBearing(u_int32_t * brgdata, bool inv)
 
 #ifndef Q_OS_WIN
 
-int RadarDataSource::initGen(bool usetimeout)
+int RadarDataSource::initGen(void)
 {
     unsigned int      i;
     int               res = 0;
@@ -1377,13 +1622,12 @@ int RadarDataSource::initGen(bool usetimeout)
     }
 
     printf("Initializing generator (Cmd reg: 0x%08X)...\n", APCTRL_GEN_BASEADDR);
-    usetimeout = true;
     for(i = 0; i < sizeof(gval) / sizeof(gval[0]); i++)
     {
 		res = apctrl_adcspi_send(
 				APCTRL_GEN_BASEADDR,
 				0x1f0000 + (gval[i].offset & 0x000000ff),
-				0x1f4000 + (gval[i].val & 0x000000ff), usetimeout);
+				0x1f4000 + (gval[i].val & 0x000000ff));
 		if(res != 0)
 		{
 			fprintf(stderr, "%s: apctrl_adcspi_send failed (%d)\n", __func__, res);
@@ -1410,7 +1654,7 @@ int RadarDataSource::initADC(void)
 
     for(unsigned int i = 0; i < sizeof(regv) / sizeof(regv[0]); i += 2)
     {
-        res = apctrl_adcspi_send(APCTRL_ADC_BASEADDR, regv[i], regv[i + 1], true);
+        res = apctrl_adcspi_send(APCTRL_ADC_BASEADDR, regv[i], regv[i + 1]);
         if(res != 0)
         {
             fprintf(stderr, "%s: apctrl_adcspi_send failed (%d)\n", __func__, res);
@@ -1434,7 +1678,7 @@ int RadarDataSource::initDAC(void)
 
     for(unsigned int i = 0; i < sizeof(regv) / sizeof(regv[0]); i += 2)
     {
-        res = apctrl_adcspi_send(APCTRL_ADC_BASEADDR, regv[i], regv[i + 1], true);
+        res = apctrl_adcspi_send(APCTRL_ADC_BASEADDR, regv[i], regv[i + 1]);
         if(res != 0)
         {
             fprintf(stderr, "%s: apctrl_adcspi_send failed (%d)\n", __func__, res);
@@ -1479,139 +1723,107 @@ int RadarDataSource::apctrl_regrd(u_int32_t regaddr, u_int32_t * regval)
     return res;
 }
 
-int RadarDataSource::apctrl_adcspi_send(u_int32_t baseaddr, u_int32_t addrv, u_int32_t datav, bool usetimeout)
+int RadarDataSource::apctrl_adcspi_send(u_int32_t baseaddr, u_int32_t addrv, u_int32_t datav)
 {
-    int               res;
-    u_int32_t         v;
-    struct itimerspec its;
-
     if(fd == -1)
        return 1;
 
-    if(adcspi_tmid == NULL)
-        usetimeout = false;
+    regq->spi(baseaddr, addrv, datav, "SPI transfer");
+    return regq->drain();
+}
+
+// Returns true while commands remain
+bool RadarDataSource::serviceRegisters(void)
+{
+    RegResult r;
+    bool      busy;
 
-	//printf("SPI: Address write\n");
-    // Write address to ADC SPI command register
-    if((res = apctrl_regwr(baseaddr, addrv)) != 0)
+    busy = regq->service();
+    while(regq->takeResult(&r))
     {
-        if(res > 0)
-            fprintf(stderr, "apctrl_regrd failed: %d\n", res);
-        else
-            fprintf(stderr, "apctrl_regrd failed: %s\n", strerror(errno));
-        fprintf(stderr, "\tADDR: 0x%08X, DATA: 0x%08X\n", baseaddr, addrv);
-        return res;
+        if(r.res != 0)
+            fprintf(stderr, "%s: %s failed (%d)\n", __func__, r.what, r.res);
+        emit deviceCommandDone(r.id, r.res);
     }
+    return busy;
+}
 
-    if(usetimeout)
+// Returns 1 when the device may have new buffers, 0 on control events and
+// timeouts, -1 on error. While register commands remain the wait is short
+// so that a pending SPI phase is polled again soon
+int RadarDataSource::waitDevice(bool regs_busy)
+{
+    struct pollfd pfd[2];
+    int           timeout = regs_busy ? RDS_REGQ_POLL_MS : (dev_pollable ? RDS_POLL_MS : RDS_NOPOLL_MS);
+    uint64_t      v;
+
+    pfd[0].fd      = evfd;
+    pfd[0].events  = POLLIN;
+    pfd[0].revents = 0;
+    pfd[1].fd      = fd;
+    pfd[1].events  = POLLIN;
+    pfd[1].revents = 0;
+
+    int res = poll(pfd, dev_pollable ? 2 : 1, timeout);
+    if(res < 0)
     {
-        // Start SPI timeout timer
-        its.it_value.tv_sec     = APCTRL_SPIWR_TIMEOUT / 1000000000;
-        its.it_value.tv_nsec    = APCTRL_SPIWR_TIMEOUT % 1000000000;
-        its.it_interval.tv_sec  = 0;
-        its.it_interval.tv_nsec = 0;
-
-        spi_timeout = 0;
-        if(timer_settime(adcspi_tmid, 0, &its, NULL) != -1)
-        {
-            v = 0;
-            do
-            {
-                if(spi_timeout)
-                {
-                    fprintf(stderr, "%s: SPI TIMOUT elapsed!\n", __func__);
-                    break;
-                }
-
-                res = apctrl_regrd(baseaddr, &v);
-                if(res != 0)
-                {
-                    if(res > 0)
-                        fprintf(stderr, "apctrl_regrd failed: %d\n", res);
-                    else
-                        fprintf(stderr, "apctrl_regrd failed: %s\n", strerror(errno));
-                    fprintf(stderr, "\tADDR: 0x%08X, DATA: 0x%08X\n", baseaddr, addrv);
-                    break;
-                }
-            }while(!(v & 0x80000000));
-
-            // Disarm timer
-            its.it_value.tv_sec     = 0;
-            its.it_value.tv_nsec    = 0;
-            its.it_interval.tv_sec  = 0;
-            its.it_interval.tv_nsec = 0;
-            if(timer_settime(adcspi_tmid, 0, &its, NULL) == -1)
-				fprintf(stderr, "Timer disarm failed: %s\n", strerror(errno));
-        }
-        else
-        {
-            fprintf(stderr, "Failed to start timer for SPI timeout handler: %s\n", strerror(errno));
-            fprintf(stderr, "WARNING: Start of the timer for SPI timeout failed and the operation my hang.\n");
-            fprintf(stderr, "\t Use Ctrl+C to terminate in such case.\n");
-        }
+        if(errno == EINTR)
+            return 0;
+        fprintf(stderr, "%s: poll failed: %s\n", __func__, strerror(errno));
+        return -1;
     }
 
-	//printf("SPI: Command write\n");
-    // Write address to ADC SPI command register
-    if((res = apctrl_regwr(baseaddr, datav)) != 0)
+    if(pfd[0].revents & POLLIN)
     {
-        if(res > 0)
-            fprintf(stderr, "apctrl_regrd (datav) failed: %d\n", res);
-        else
-            fprintf(stderr, "apctrl_regrd (datav) failed: %s\n", strerror(errno));
-        fprintf(stderr, "\tADDR: 0x%08X, DATA: 0x%08X\n", baseaddr, datav);
-        return res;
+        acq_ctl_wakeups++;
+        if(read(evfd, &v, sizeof(v)) < 0 && errno != EAGAIN)
+            fprintf(stderr, "%s: eventfd read failed: %s\n", __func__, strerror(errno));
     }
 
-    if(usetimeout)
+    if(pfd[1].revents & (POLLERR | POLLNVAL))
     {
-        // Start SPI timeout timer
-        its.it_value.tv_sec     = APCTRL_SPIWR_TIMEOUT / 1000000000;
-        its.it_value.tv_nsec    = APCTRL_SPIWR_TIMEOUT % 1000000000;
-        its.it_interval.tv_sec  = 0;
-        its.it_interval.tv_nsec = 0;
-
-        spi_timeout = 0;
-        if(timer_settime(adcspi_tmid, 0, &its, NULL) != -1)
-        {
-            v = 0;
-            do
-            {
-                if(spi_timeout)
-                {
-                    fprintf(stderr, "%s: SPI TIMOUT elapsed!\n", __func__);
-                    break;
-                }
+        fprintf(stderr, "%s: device error (0x%x)\n", __func__, pfd[1].revents);
+        return -1;
+    }
 
-                res = apctrl_regrd(baseaddr, &v);
-                if(res != 0)
-                {
-                    if(res > 0)
-                        fprintf(stderr, "apctrl_regrd (datav) failed: %d\n", res);
-                    else
-                        fprintf(stderr, "apctrl_regrd (datav) failed: %s\n", strerror(errno));
-                    fprintf(stderr, "\tADDR: 0x%08X, DATA: 0x%08X\n", baseaddr, datav);
-                    break;
-                }
-            }while(!(v & 0x80000000));
-
-            // Disarm timer
-            its.it_value.tv_sec     = 0;
-            its.it_value.tv_nsec    = 0;
-            its.it_interval.tv_sec  = 0;
-            its.it_interval.tv_nsec = 0;
-            if(timer_settime(adcspi_tmid, 0, &its, NULL) == -1)
-				fprintf(stderr, "Timer disarm failed: %s\n", strerror(errno));
-        }
-        else
+    if(res == 0 && !regs_busy)
+    {
+        acq_timeouts++;
+        if(acq_first_ms < 0)
         {
-            fprintf(stderr, "Failed to start timer for SPI timeout handler: %s\n", strerror(errno));
-            fprintf(stderr, "WARNING: Start of the timer for SPI timeout failed and the operation my hang.\n");
-            fprintf(stderr, "\t Use Ctrl+C to terminate in such case.\n");
+            struct timespec t;
+            clock_gettime(CLOCK_MONOTONIC, &t);
+            double ms = (t.tv_sec - acq_t0.tv_sec) * 1e3 + (t.tv_nsec - acq_t0.tv_nsec) * 1e-6;
+            if((ms >= RDS_FIRST_BEARING_MS) && (ms < RDS_FIRST_BEARING_MS + timeout))
+                fprintf(stderr, "%s: no bearings %d ms after start\n", __func__, RDS_FIRST_BEARING_MS);
         }
     }
 
-    return res;
+    if(!dev_pollable)
+        return (res == 0) ? 1 : 0;
+
+    if(pfd[1].revents & POLLIN)
+    {
+        acq_dev_wakeups++;
+        return 1;
+    }
+    return 0;
+}
+
+void RadarDataSource::wakeWorker(void * rds)
+{
+    RadarDataSource * self = static_cast<RadarDataSource *>(rds);
+    uint64_t          v    = 1;
+
+    if(self->evfd != -1 && write(self->evfd, &v, sizeof(v)) < 0 && errno != EAGAIN)
+        fprintf(stderr, "%s: eventfd write failed: %s\n", __func__, strerror(errno));
+}
+
+void RadarDataSource::printAcqStats(FILE * f)
+{
+    fprintf(f, "Acquisition: first bearing %.1f ms after start, %llu device and %llu control wakeups, %llu timeouts%s\n"
+            , acq_first_ms, (unsigned long long)acq_dev_wakeups, (unsigned long long)acq_ctl_wakeups
+            , (unsigned long long)acq_timeouts, dev_pollable ? "" : " (periodic buffer checks)");
 }
 #endif // !Q_OS_WIN
 
@@ -1637,18 +1849,22 @@ int RadarDataSource::setupScale(const rli_scale_t* pscale) {
   if(pscale == NULL)
     return res;
 
-  res = apctrl_regwr(APCTRL_PKIDPKOD_BASEADDR, pscale->pkidpkod);
-  if(res != 0) {
-    fprintf(stderr, "%s: PKID and PKOD setup failed (%d)\n", __func__, res);
-    return res;
+  // Executed by the acquisition thread, failures are reported from there.
+  // Without the device the scale still reaches the processing stages
+  if(fd != -1) {
+    regq->write(APCTRL_PKIDPKOD_BASEADDR, pscale->pkidpkod, "PKID and PKOD setup");
+    regq->spi(APCTRL_GEN_BASEADDR, pscale->gen_addr, pscale->gen_dat, "Frequency setup");
+    res = 0;
   }
+  #endif // !Q_OS_WIN
 
-  res = apctrl_adcspi_send(APCTRL_GEN_BASEADDR, pscale->gen_addr, pscale->gen_dat, true);
-  if(res != 0) {
-    fprintf(stderr, "%s: Frequency setup failed (%d)\n", __func__, res);
-    return res;
+  if(pscale != NULL) {
+    _guard->setScale(pscale->len);
+    _land->setScale(pscale->len);
+    if(_scene)
+      _scene->setRange(pscale->len);
+    rebuildLandMask();
   }
-  #endif // !Q_OS_WIN
 
   emit scaleChanged(*_radar_scale);
 
@@ -1662,6 +1878,87 @@ void RadarDataSource::setGain(int gain) {
     gain_level = gain;
 }
 
+void RadarDataSource::setWave(int level) {
+  _clutter->setWave(level);
+}
+
+void RadarDataSource::setRain(int level) {
+  _clutter->setRain(level);
+}
+
+void RadarDataSource::setGuardZones(const std::vector<GuardZone>& zones) {
+  _guard->setZones(zones);
+}
+
+void RadarDataSource::setAutoGain(bool on) {
+  _auto_gain = on;
+}
+
+void RadarDataSource::addLandAreas(const std::vector<float>& triangles) {
+  _land->addAreas(triangles);
+  rebuildLandMask();
+
+  if(_scene)
+    _scene->addLand(triangles);
+}
+
+void RadarDataSource::updateCoords(const QVector2D& coords) {
+  _land->setPosition(coords.x(), coords.y());
+  rebuildLandMask();
+
+  if(_scene)
+    _scene->setPosition(coords.x(), coords.y());
+}
+
+void RadarDataSource::setLandMask(bool on) {
+  _land->setEnabled(on);
+}
+
+void RadarDataSource::setStabilisation(bool on) {
+#ifndef Q_OS_WIN
+  // Only bearings from the device or the network go through processBearings
+  if(fd == -1 && !net_input)
+    on = false;
+#else
+  on = false;
+#endif // !Q_OS_WIN
+
+  _stab->setEnabled(on);
+  if(on)
+    _land->setHeading(0);
+
+  emit stabilisationChanged(on);
+}
+
+void RadarDataSource::rebuildLandMask() {
+  // Mask is built in a pool thread, the acquisition thread only picks it up
+  if (_land->startRebuild())
+    _land_build = QtConcurrent::run(_land, &LandMask::rebuild);
+}
+
+void RadarDataSource::estimateGain(u_int32_t* brg) {
+  uint32_t amps = brg[1];
+  if(amps > PELENG_SIZE)
+    amps = PELENG_SIZE;
+
+  if(!_gain_est->addBearing(brg[0], &brg[3], amps))
+    return;
+
+  const GainEstimate& est = _gain_est->estimate();
+  int gain = est.gain;
+  if(_auto_gain) {
+    setGain(gain);
+
+    // Guard zones test amplified bearings, the raw threshold goes through amplify() first
+    u_int32_t thr = est.threshold;
+    if(gain_level)
+      thr = std::min<u_int32_t>(thr * 255 / (max_gain_level - gain_level), 255);
+    _guard->setThreshold(thr);
+  }
+
+  emit gainEstimated(gain);
+}
+
 int RadarDataSource::amplify(u_int32_t* brg) {
     u_int32_t v;
     u_int32_t tr;
@@ -1737,10 +2034,10 @@ int RadarDataSource::setupHIP(hip_t hiptype, hip_channel_t hipch)
         //if(res != 0)
         //    throw res;
 		//
+        if(fd == -1)
+            throw 1;
         regv = (hipregv & (~mask)) | v | 0x2000;
-        res = apctrl_regwr(APCTRL_HIP_BASEADDR, regv);
-        if(res != 0)
-            throw res;
+        regq->write(APCTRL_HIP_BASEADDR, regv, "HIP setup");
 		fprintf(stderr, "HIP: %d, 0x%08X\n", hiptype, regv);
 		hipregv = regv;
         //res = ioctl(fd, APCTRL_IOCTL_START, 2048);
@@ -1808,62 +2105,21 @@ int RadarDataSource::simulate(bool sim)
         return 0;
     }
 
-    u_int32_t regv;
-
     if(simulation == sim)
         return 0; // Nothing to do
-    try
-    {
-        if(sim == true)
-        {
-            res = apctrl_regrd(APCTRL_CTRL_BASEADDR, &regv);
-            if(res < 0)
-                throw res;
-            regv &= ~0x0f;
-            regv |= APCTRL_CTRL_INTIZIEN | APCTRL_CTRL_MRPEN | APCTRL_CTRL_SIMULEN;
-            res = apctrl_regwr(APCTRL_CTRL_BASEADDR, regv);
-            if(res < 0)
-                throw res;
-            res = apctrl_regrd(APCTRL_CTRL_BASEADDR, &regv);
-            if(res < 0)
-                throw res;
 
-            res = apctrl_regrd(APCTRL_HIP_BASEADDR, &regv);
-            regv |= 1 << 13;
-            res = apctrl_regwr(APCTRL_HIP_BASEADDR, regv);
-            if(res < 0)
-                throw res;
-        }
-        else
-        {
-            res = apctrl_regrd(APCTRL_CTRL_BASEADDR, &regv);
-            if(res < 0)
-                throw res;
-            regv &= ~0x0f;
-            regv |= APCTRL_CTRL_MRPEN;
-            res = apctrl_regwr(APCTRL_CTRL_BASEADDR, regv);
-            if(res < 0)
-                throw res;
-            res = apctrl_regrd(APCTRL_CTRL_BASEADDR, &regv);
-            if(res < 0)
-                throw res;
-
-            res = apctrl_regrd(APCTRL_HIP_BASEADDR, &regv);
-            regv &= ~(1 << 13);
-            res = apctrl_regwr(APCTRL_HIP_BASEADDR, regv);
-            if(res < 0)
-                throw res;
-        }
-        simulation = sim;
+    // Read-modify-write of the control registers by the acquisition thread
+    if(sim == true)
+    {
+        regq->modify(APCTRL_CTRL_BASEADDR, 0x0f, APCTRL_CTRL_INTIZIEN | APCTRL_CTRL_MRPEN | APCTRL_CTRL_SIMULEN, "Simulation start");
+        regq->modify(APCTRL_HIP_BASEADDR, 0, 1 << 13, "Simulation start");
     }
-    catch(int e)
+    else
     {
-        if(e > 0)
-            fprintf(stderr, "Failed to %s simulation: %d\n", ((sim == true) ? "start" : "stop"), e);
-        else // if(e < 0)
-            fprintf(stderr, "Failed to %s simulation: %s\n", ((sim == true) ? "start" : "stop"), strerror(errno));
-        res = e;
+        regq->modify(APCTRL_CTRL_BASEADDR, 0x0f, APCTRL_CTRL_MRPEN, "Simulation stop");
+        regq->modify(APCTRL_HIP_BASEADDR, 1 << 13, 0, "Simulation stop");
     }
+    simulation = sim;
 
 #endif // !Q_OS_WIN
     return res;
@@ -1871,7 +2127,13 @@ int RadarDataSource::simulate(bool sim)
 
 void RadarDataSource::updateHeading(float hdg)
 {
-  int res;
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  _stab->addHeading((uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec, hdg);
+
+  // Stabilised bearings already are north-referenced
+  _land->setHeading(_stab->enabled() ? 0 : hdg);
+
   u_int32_t regv;
 
   regv = (u_int32_t)(hdg * 4096.0 / 360.0);
@@ -1880,16 +2142,9 @@ void RadarDataSource::updateHeading(float hdg)
 #ifndef Q_OS_WIN
   if(fd == -1)
     return;
-  res = apctrl_regwr(APCTRL_GYROREG_BASEADDR, regv);
-  if(res < 0)
-  {
-    fprintf(stderr, "%s: APCTRL_GYROREG_BASEADDR write with value 0x%X failed\n", __func__, regv);
-  }
-  else
-  {
-    gyroReg = regv;
-    fprintf(stderr, "%s: APCTRL_GYROREG_BASEADDR writen with 0x%X\n", __func__, regv);
-  }
-  // TODO: check return value of apctrl_regwr and signal error
+
+  // Headings arriving faster than the queue is serviced replace each other
+  regq->write(APCTRL_GYROREG_BASEADDR, regv, "Gyro heading", true);
+  gyroReg = regv;
 #endif // !Q_OS_WIN
 }
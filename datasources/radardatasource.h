@@ -2,9 +2,23 @@
 #define RADARDATASOURCE_H
 
 #include "radarscale.h"
+#include "bearingsync.h"
+#include "bearingring.h"
+#include "clutterfilter.h"
+#include "gainestimator.h"
+#include "guardzone.h"
+#include "landmask.h"
+#include "cat240receiver.h"
+#include "regqueue.h"
+#include "azimuthstab.h"
+#include "radarscene.h"
+#include "rotationrate.h"
 
 #include <stdint.h>
+#include <time.h>
+#include <vector>
 #include <QObject>
+#include <QVector2D>
 #include <QtOpenGL>
 
 #if QT_VERSION >= 0x050000
@@ -28,7 +42,7 @@ const int RDS_RDPOOL_SIZE     = 256;
 
 class BearingBuffer {
 public:
-    BearingBuffer(size_t datasize = BEARING_PACK_SIZE, size_t pagesize = 4096) : nr(0), ptr(NULL), used(false), valid(false), buf(NULL) {this->datasize = datasize; this->pagesize = pagesize;}
+    BearingBuffer(size_t datasize = BEARING_PACK_SIZE, size_t pagesize = 4096) : nr(0), ptr(NULL), used(false), valid(false), t_ns(0), buf(NULL) {this->datasize = datasize; this->pagesize = pagesize;}
     ~BearingBuffer(){/*if(buf) delete [] buf; */buf = ptr = NULL; used = false; valid = false;}
 
     bool create(void){buf = new uint32_t[pagesize * 2 / sizeof(uint32_t)]; ptr = buf; if(!buf) return false; else return true;}
@@ -40,6 +54,7 @@ public:
     uint32_t * ptr;
     bool       used;
     bool       valid;
+    uint64_t   t_ns;       // Acquisition time (CLOCK_MONOTONIC)
 
     size_t     datasize;
     size_t     pagesize;
@@ -60,6 +75,11 @@ public:
   void start();
   void start_dump();
   void start(const char * radarfn);
+  void start_cat240(const char * address); // CAT-240 video from the network, "host:port"
+
+  // Synthetic radar picture replacing the recorded one in start(), false
+  // for an unknown scenario name
+  bool setScene(const char * name, uint32_t seed);
 
   void finish();
 
@@ -71,15 +91,37 @@ public:
   void nextScale();
   void prevScale();
 
+  // Processed bearings for consumers other than the display
+  inline BearingRing* bearingRing() { return _ring; }
+
+  // Guard zones are rasterised for the current scale in the calling thread
+  void setGuardZones(const std::vector<GuardZone>& zones);
+
+  // Chart land areas (lat, lon triangles) for the land mask
+  void addLandAreas(const std::vector<float>& triangles);
+
+  // Antenna rotation measured from the bearing timestamps
+  inline RotationRate rotationRate() const { return _rot->rate(); }
+
 public slots:
   void updateHeading(float hdg);
   void setGain(int gain);
+  void setWave(int level);
+  void setRain(int level);
+  void setAutoGain(bool on);
+  void setLandMask(bool on);
+  void setStabilisation(bool on); // North-referenced bearings from interpolated heading
+  void updateCoords(const QVector2D& coords);
   void setAmpsOffset(int off);
   void onSimulationChanged(const QByteArray& str);
 
 signals:
-  void updateData(uint offset, uint count, GLfloat* amps);
   void scaleChanged(RadarScale scale);
+  void gainEstimated(int gain); // Once per revolution, applied when auto gain is on
+  void guardAlarm(int zone, bool on);
+  void stabilisationChanged(bool on); // Bearings are published north-referenced
+  void deviceCommandDone(uint id, int res); // Register command executed by the acquisition thread
+  void rotationEstimated(float rpm, float jitter_us); // Once per revolution of the antenna
 
 private:
   bool loadData();
@@ -92,10 +134,29 @@ private:
   uint  file_curr;
 
   RadarScale* _radar_scale;
+  BearingRing* _ring;
+  ClutterFilter* _clutter;
+  GainEstimator* _gain_est;
+  GuardZones* _guard;
+  LandMask* _land;
+  AzimuthStabiliser* _stab;
+  RadarScene* _scene;
+  RotationEstimator* _rot;
+  bool _auto_gain;
+
+  QFuture<void> _land_build;
+  void rebuildLandMask();
+
+  void estimateGain(u_int32_t* brg);
+
+  // times are the acquisition times indexed by bearing, NULL if unknown
+  void publishData(uint offset, uint count, GLfloat* amps, const uint64_t* times = NULL);
 
   void worker();
+  void scene_worker();
   void dump_worker();
   void radar_worker();
+  void net_worker();
 
   QFuture<void> workerThread;
 
@@ -107,16 +168,10 @@ private:
   BearingBuffer * getNextFreeBuffer(void);
   int processBearings(void);
 
-  enum radar_sync_stage
-  {
-      RDSS_FIRST     = 0,
-      RDSS_SYNC      = 0, // Radar controller is synchronized
-      RDSS_NOTSYNC   = 1, // No synchronization with radar controller
-      RDSS_WAIT4STAB = 2, // Zero bearing has been found; now check for stable bearing stream
-      RDSS_LAST      = 2
-  };
+  void processBearing(uint32_t brg);
+  void publishStabilised(uint32_t first, uint32_t count, bool fill);
 
-  enum radar_sync_stage syncstate;
+  BearingSync    * bsync;     // Bearing stream synchronization
 
   // Buffer pool
   BearingBuffer   * bufpool;
@@ -132,9 +187,43 @@ private:
   BearingBuffer ** scans[RDS_MAX_SCANS];
   int              activescan;
   uint32_t         processed_bearing;
-  uint32_t         last_bearing;
+  uint32_t         last_bearing;   // Last in-order bearing received in sync
+  std::vector<uint32_t> late_bearings; // Already published bearings filled later
+
+  // Acquisition times: buffers are stamped when the worker sees them
+  // completed, spread back over the batch by the measured bearing step
+  uint64_t         acq_batch_ns;   // Completion time of the latest batch
+  std::vector<uint64_t> brg_time;  // Head-referenced bearings
+  std::vector<uint64_t> row_time;  // North-referenced rows while stabilised
+  void finishBatch(void);
 
   int              fd;         // Radar device file descriptor
+
+  // Network video input
+  Cat240Receiver * net;
+  bool             net_input;  // Amplitudes come already scaled to 0..255
+  std::vector<uint32_t> net_words; // Storage of the buffer pool
+
+  // Register commands of the device, executed by radar_worker
+  class DeviceIo;
+  DeviceIo       * regio;
+  RegisterQueue  * regq;
+  bool serviceRegisters(void);
+
+  // Event-driven acquisition: radar_worker sleeps in poll() on the device
+  // and on an eventfd written for register commands and shutdown
+  int              evfd;
+  bool             dev_pollable;   // Driver reports DMA completion through poll()
+  uint32_t         dev_idle;       // Readiness reports in a row without a new buffer
+  struct timespec  acq_t0;         // start() call
+  double           acq_first_ms;   // Start to first bearing, negative until then
+  uint64_t         acq_dev_wakeups;
+  uint64_t         acq_ctl_wakeups;
+  uint64_t         acq_timeouts;
+
+  int  waitDevice(bool regs_busy);
+  static void wakeWorker(void * rds);
+  void printAcqStats(FILE * f);
 #endif // !Q_OS_WIN
 // ------------------------------------------------------
 
@@ -150,15 +239,15 @@ private:
   u_int32_t gain_level; // Amplification level 0..max_alevel
 
 #ifndef Q_OS_WIN
-  int initGen(bool usetimeout);
+  int initGen(void);
   int initADC(void);
   int initDAC(void);
   int apctrl_regwr(u_int32_t regaddr, u_int32_t regval);
   int apctrl_regrd(u_int32_t regaddr, u_int32_t * regval);
 
-  // ADC SPI manipulation data and routines
-  timer_t adcspi_tmid;
-  int apctrl_adcspi_send(u_int32_t baseaddr, u_int32_t addrv, u_int32_t datav, bool usetimeout);
+  // ADC SPI transfer run to completion in the calling thread, only while
+  // radar_worker is not servicing the register queue
+  int apctrl_adcspi_send(u_int32_t baseaddr, u_int32_t addrv, u_int32_t datav);
 #endif // !Q_OS_WIN
 
 public:
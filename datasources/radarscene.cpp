@@ -0,0 +1,365 @@
+#include "radarscene.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+const RadarSceneConfig radarScenes[] = {
+  // name       rpm   loop targets speed  noise  sea    rain        interference
+  { "calm",    24.f,  4,    8,     15.f,  8.f,   30.f,  0, 0.f,     0.f    },
+  { "coastal", 24.f,  4,   40,     25.f, 12.f,   90.f,  2, 90.f,    0.002f },
+  { "storm",   24.f,  4,  200,     30.f, 16.f,  180.f,  8, 140.f,   0.01f  },
+  { "flood",    0.f,  4,  200,     30.f, 16.f,  180.f,  8, 140.f,   0.01f  },
+  { NULL,       0.f,  0,    0,      0.f,  0.f,    0.f,  0, 0.f,     0.f    }
+};
+
+const RadarSceneConfig* findRadarScene(const char* name) {
+  for (const RadarSceneConfig* c = radarScenes; c->name != NULL; c++)
+    if (strcmp(c->name, name) == 0)
+      return c;
+  return NULL;
+}
+
+// Stateless hash, every random value of the scene is derived from it
+static inline uint32_t mix(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+static inline float unit(uint32_t h) {
+  return (mix(h) >> 8) * (1.f / 16777216.f);
+}
+
+RadarScene::RadarScene(uint32_t brg_count, uint32_t brg_size, const RadarSceneConfig& cfg, uint32_t seed)
+  : _raster(brg_count, brg_size) {
+  _brg_count = brg_count;
+  _brg_size  = brg_size;
+  _cfg       = cfg;
+  _seed      = seed;
+
+  if (_cfg.loop == 0)
+    _cfg.loop = 1;
+
+  _sin.resize(brg_count);
+  _cos.resize(brg_count);
+  for (uint32_t b = 0; b < brg_count; b++) {
+    _sin[b] = sinf(2.f * (float)M_PI * b / brg_count);
+    _cos[b] = cosf(2.f * (float)M_PI * b / brg_count);
+  }
+
+  // Objects of the scenario, placed in range fractions
+  uint32_t h = mix(seed ^ 0x5bd1e995u);
+  for (uint32_t i = 0; i < _cfg.targets; i++) {
+    Target t;
+    float r = 0.1f + 0.85f * unit(h++);
+    float a = 2.f * (float)M_PI * unit(h++);
+    float v = _cfg.max_speed * unit(h++);
+    float c = 2.f * (float)M_PI * unit(h++);
+    t.x  = r * sinf(a);
+    t.y  = r * cosf(a);
+    t.vx = v * sinf(c);
+    t.vy = v * cosf(c);
+    _targets.push_back(t);
+  }
+
+  float wind = 2.f * (float)M_PI * unit(h++);
+  for (uint32_t i = 0; i < _cfg.rain_cells; i++) {
+    RainCell c;
+    float r = 0.2f + 0.6f * unit(h++);
+    float a = 2.f * (float)M_PI * unit(h++);
+    float v = 10.f + 10.f * unit(h++);
+    c.x   = r * sinf(a);
+    c.y   = r * cosf(a);
+    c.r   = 0.05f + 0.1f * unit(h++);
+    c.vx  = v * sinf(wind);
+    c.vy  = v * cosf(wind);
+    c.amp = _cfg.rain * (0.6f + 0.4f * unit(h++));
+    _rain.push_back(c);
+  }
+
+  _lat     = 0;
+  _lon     = 0;
+  _range   = 4.f;
+  _has_pos = false;
+  _version.store(1);
+
+  _table_version = 0;
+  _cur_range     = _range;
+  _cur_rev       = ~0u;
+  _tgt_brg.resize(_targets.size());
+  _tgt_rng.resize(_targets.size());
+  _row.resize(brg_size);
+
+  for (int i = 0; i < RS_GAIN_SLOTS; i++) {
+    _slots[i].gain = ~0u;
+    _slots[i].used = 0;
+  }
+  _uses = 0;
+
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+RadarScene::~RadarScene() {
+}
+
+void RadarScene::addLand(const std::vector<float>& triangles) {
+  std::lock_guard<std::mutex> lock(_lock);
+
+  std::shared_ptr< std::vector<float> > land(new std::vector<float>());
+  if (_land)
+    *land = *_land;
+  land->insert(land->end(), triangles.begin(), triangles.end());
+  _land = land;
+  _version++;
+}
+
+void RadarScene::setPosition(float lat, float lon) {
+  std::lock_guard<std::mutex> lock(_lock);
+
+  // Land is rebuilt for a displacement of several range samples only
+  float cell = _range / _brg_size;
+  float dy = (lat - _lat) * LM_MILES_PER_DEGREE;
+  float dx = (lon - _lon) * LM_MILES_PER_DEGREE * cosf(lat * (float)M_PI / 180.f);
+  if (_has_pos && dx * dx + dy * dy < (LM_MOVE_SAMPLES * cell) * (LM_MOVE_SAMPLES * cell))
+    return;
+
+  _lat     = lat;
+  _lon     = lon;
+  _has_pos = true;
+  _version++;
+}
+
+void RadarScene::setRange(float range) {
+  std::lock_guard<std::mutex> lock(_lock);
+
+  if (range == _range)
+    return;
+
+  _range = range;
+  _version++;
+}
+
+void RadarScene::update(uint32_t rev) {
+  uint32_t ver = _version.load();
+
+  if (ver != _table_version) {
+    std::shared_ptr< const std::vector<float> > land;
+    float lat, lon;
+    bool  has_pos;
+    {
+      std::lock_guard<std::mutex> lock(_lock);
+      land       = _land;
+      lat        = _lat;
+      lon        = _lon;
+      has_pos    = _has_pos;
+      _cur_range = _range;
+      ver        = _version.load();
+    }
+
+    if (land && has_pos && !land->empty()) {
+      _table.reset(_raster.build(*land, lat, lon, _cur_range));
+      _stats.land_builds++;
+    } else {
+      _table.reset();
+    }
+
+    _table_version = ver;
+    _cur_rev       = ~0u;
+  }
+
+  if (rev == _cur_rev)
+    return;
+  _cur_rev = rev;
+
+  // Positions of the revolution within the scenario loop
+  float rev_s  = (_cfg.rpm > 0.f) ? 60.f / _cfg.rpm : 2.5f;
+  float hours  = (rev % _cfg.loop) * rev_s / 3600.f;
+  float k      = hours / _cur_range;
+
+  for (size_t i = 0; i < _targets.size(); i++) {
+    const Target& t = _targets[i];
+    float x = t.x + t.vx * k;
+    float y = t.y + t.vy * k;
+    float a = atan2f(x, y);
+    if (a < 0.f)
+      a += 2.f * (float)M_PI;
+
+    _tgt_brg[i] = a * _brg_count / (2.f * (float)M_PI);
+    _tgt_rng[i] = sqrtf(x * x + y * y) * _brg_size;
+  }
+}
+
+void RadarScene::placeRain(uint32_t brg, float* row) {
+  float rev_s = (_cfg.rpm > 0.f) ? 60.f / _cfg.rpm : 2.5f;
+  float k     = (_cur_rev % _cfg.loop) * rev_s / 3600.f / _cur_range;
+
+  for (size_t i = 0; i < _rain.size(); i++) {
+    const RainCell& c = _rain[i];
+    float cx = (c.x + c.vx * k) * _brg_size;
+    float cy = (c.y + c.vy * k) * _brg_size;
+    float r  = c.r * _brg_size;
+
+    // Chord of the cell along the bearing ray
+    float d  = cx * _sin[brg] + cy * _cos[brg];
+    float p2 = cx * cx + cy * cy - d * d;
+    if (d + r < 0.f || p2 >= r * r)
+      continue;
+
+    float half = sqrtf(r * r - p2);
+    int from = std::max(0, (int)(d - half));
+    int to   = std::min((int)_brg_size, (int)(d + half));
+
+    uint32_t h = mix(_seed ^ (uint32_t)i * 0x9e3779b9u ^ brg * 0x27d4eb2du ^ _cur_rev);
+    for (int j = from; j < to; j++) {
+      float edge = 1.f - fabsf(j - d) / half;
+      row[j] += c.amp * edge * (0.5f + 0.5f * unit(h + j));
+    }
+  }
+}
+
+void RadarScene::placeTargets(uint32_t brg, float* row) {
+  const float half = RS_BEAM_DEG / 360.f * _brg_count / 2.f;
+  const float n    = (float)_brg_count;
+
+  for (size_t i = 0; i < _targets.size(); i++) {
+    float db = brg - _tgt_brg[i];
+    if (db >= n / 2.f)
+      db -= n;
+    else if (db < -n / 2.f)
+      db += n;
+    if (fabsf(db) >= half)
+      continue;
+
+    // Two-way beam pattern across the beam width
+    float g   = cosf((float)M_PI / 2.f * db / half);
+    float amp = 230.f * g * g;
+
+    int from = (int)_tgt_rng[i];
+    int to   = std::min((int)_brg_size, from + RS_TARGET_CELLS);
+    for (int j = std::max(from, 0); j < to; j++)
+      row[j] = std::max(row[j], amp);
+  }
+}
+
+void RadarScene::generate(uint32_t rev, uint32_t brg, uint8_t* amps) {
+  update(rev);
+
+  float*   row = &_row[0];
+  uint32_t h0  = mix(_seed * 0x9e3779b9u ^ mix(rev * 0x85ebca6bu + brg));
+
+  // Receiver noise and sea clutter falling off with range, speckled
+  float c0  = std::max(1.f, 0.25f * _brg_size / _cur_range);
+  float sea = _cfg.sea * c0 * c0;
+  for (uint32_t j = 0; j < _brg_size; j++) {
+    float v = _cfg.noise * unit(h0 + j * 0x27d4eb2du);
+    float s = sea / ((j + c0) * (j + c0));
+    if (s > 0.5f) {
+      float u = unit(h0 ^ (j * 0x165667b1u));
+      v += s * 0.5f * u / (1.05f - u);
+    }
+    row[j] = v;
+  }
+
+  placeRain(brg, row);
+
+  // Land echoes, nothing but noise behind the first coast line
+  if (_table) {
+    const uint32_t* bits = &_table->bits[(size_t)brg * _table->words];
+    bool shadow = false;
+
+    for (uint32_t j = 0; j < _brg_size; j++) {
+      if (bits[j >> 5] & (1u << (j & 31))) {
+        row[j]  = RS_LAND_AMP * (0.75f + 0.25f * unit(h0 ^ (j * 0x2545f491u)));
+        shadow  = true;
+      } else if (shadow) {
+        row[j] = _cfg.noise * unit(h0 + j * 0x27d4eb2du);
+      }
+    }
+  }
+
+  placeTargets(brg, row);
+
+  // Another radar nearby: a spoke of its pulses
+  if (unit(h0 ^ 0x3c6ef372u) < _cfg.interference) {
+    uint32_t period = 3 + mix(h0) % 7;
+    for (uint32_t j = mix(h0 + 1) % period; j < _brg_size; j += period)
+      row[j] = std::max(row[j], 180.f);
+  }
+
+  for (uint32_t j = 0; j < _brg_size; j++)
+    amps[j] = (uint8_t)std::min(255.f, row[j]);
+
+  _stats.generated++;
+}
+
+const uint8_t* RadarScene::raw(uint32_t rev, uint32_t brg) {
+  if (_frames.empty()) {
+    _frames.resize((size_t)_cfg.loop * _brg_count * _brg_size);
+    _frame_stamp.assign((size_t)_cfg.loop * _brg_count, 0);
+  }
+
+  size_t   idx = (size_t)(rev % _cfg.loop) * _brg_count + brg;
+  uint8_t* dst = &_frames[idx * _brg_size];
+
+  if (_frame_stamp[idx] != _version.load()) {
+    generate(rev % _cfg.loop, brg, dst);
+    _frame_stamp[idx] = _table_version;
+  } else {
+    _stats.raw_hits++;
+  }
+
+  return dst;
+}
+
+const uint8_t* RadarScene::amplified(uint32_t rev, uint32_t brg, uint32_t gain, uint32_t max_gain) {
+  const uint8_t* src = raw(rev, brg);
+
+  if (gain == 0)
+    return src;
+
+  GainSlot* slot = &_slots[0];
+  for (int i = 0; i < RS_GAIN_SLOTS; i++) {
+    if (_slots[i].gain == gain) {
+      slot = &_slots[i];
+      break;
+    }
+    if (_slots[i].used < slot->used)
+      slot = &_slots[i];
+  }
+
+  if (slot->gain != gain) {
+    slot->gain = gain;
+    slot->amps.resize((size_t)_cfg.loop * _brg_count * _brg_size);
+    slot->stamp.assign((size_t)_cfg.loop * _brg_count, 0);
+  }
+  slot->used = ++_uses;
+
+  size_t   idx = (size_t)(rev % _cfg.loop) * _brg_count + brg;
+  uint8_t* dst = &slot->amps[idx * _brg_size];
+
+  if (slot->stamp[idx] == _frame_stamp[idx]) {
+    _stats.amp_hits++;
+    return dst;
+  }
+
+  // Same mapping as RadarDataSource::amplify
+  uint32_t tr    = (gain < max_gain) ? max_gain - gain : 1;
+  uint32_t ratio = (255 << 16) / tr;
+  for (uint32_t j = 0; j < _brg_size; j++)
+    dst[j] = (src[j] >= tr) ? 255 : (uint8_t)((src[j] * ratio) >> 16);
+
+  slot->stamp[idx] = _frame_stamp[idx];
+  _stats.amplified++;
+  return dst;
+}
+
+void RadarScene::printStats(FILE* f) const {
+  fprintf(f, "Radar scene '%s': %llu bearings generated, %llu raw and %llu amplified from cache, %llu amplified, %llu land builds\n"
+          , _cfg.name, (unsigned long long)_stats.generated, (unsigned long long)_stats.raw_hits
+          , (unsigned long long)_stats.amp_hits, (unsigned long long)_stats.amplified
+          , (unsigned long long)_stats.land_builds);
+}
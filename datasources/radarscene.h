@@ -0,0 +1,129 @@
+#ifndef RADARSCENE_H
+#define RADARSCENE_H
+
+#include "landmask.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define RS_GAIN_SLOTS   2      // Gain levels with amplified frames kept
+#define RS_BEAM_DEG     1.2f   // Horizontal beam width
+#define RS_TARGET_CELLS 3      // Range extent of a point target echo
+#define RS_LAND_AMP     200.f  // Land echo amplitude
+
+// Scenario of the synthetic radar picture. Targets and rain cells are
+// placed from the seed within the current range
+struct RadarSceneConfig {
+  const char* name;
+  float    rpm;           // Antenna speed, 0 generates as fast as bearings are taken
+  uint32_t loop;          // Revolutions before the scenario repeats
+  uint32_t targets;
+  float    max_speed;     // Knots
+  float    noise;         // Receiver noise amplitude
+  float    sea;           // Sea clutter amplitude at the shortest range
+  uint32_t rain_cells;
+  float    rain;          // Rain amplitude
+  float    interference;  // Probability of an interference spoke per bearing
+};
+
+// Built-in scenarios, NULL name terminated
+extern const RadarSceneConfig radarScenes[];
+const RadarSceneConfig* findRadarScene(const char* name);
+
+struct RadarSceneStats {
+  uint64_t generated;   // Bearings synthesised
+  uint64_t raw_hits;    // Raw bearings taken from the frame cache
+  uint64_t amplified;   // Bearings amplified into a gain slot
+  uint64_t amp_hits;    // Amplified bearings taken from a gain slot
+  uint64_t land_builds;
+};
+
+// Deterministic synthetic radar video. A bearing of a revolution depends
+// only on the seed, the scenario and the land, so any bearing rate and
+// any consumer order give the same picture. Raw frames of the scenario
+// loop and their amplified copies per gain level are generated on first
+// use and served from memory afterwards.
+class RadarScene {
+public:
+  RadarScene(uint32_t brg_count, uint32_t brg_size, const RadarSceneConfig& cfg, uint32_t seed);
+  ~RadarScene();
+
+  inline const RadarSceneConfig& config() const { return _cfg; }
+
+  // Any thread. Land triangles are lat, lon pairs as in S52AreaLayer
+  void addLand(const std::vector<float>& triangles);
+  void setPosition(float lat, float lon);
+  void setRange(float range);
+
+  // Generating thread. Amplitudes 0..255 of bearing brg of revolution rev
+  void generate(uint32_t rev, uint32_t brg, uint8_t* amps);
+
+  // Generating thread. Cached bearing of the scenario loop, raw and amplified
+  // the same way as RadarDataSource::amplify for gain of max_gain
+  const uint8_t* raw(uint32_t rev, uint32_t brg);
+  const uint8_t* amplified(uint32_t rev, uint32_t brg, uint32_t gain, uint32_t max_gain);
+
+  inline const RadarSceneStats& stats() const { return _stats; }
+  void printStats(FILE* f) const;
+
+private:
+  struct Target {
+    float x, y;     // Range fractions, x to the east and y to the north
+    float vx, vy;   // Knots
+  };
+
+  struct RainCell {
+    float x, y, r;  // Range fractions
+    float vx, vy;   // Knots
+    float amp;
+  };
+
+  struct GainSlot {
+    uint32_t gain;
+    uint32_t used;                // Last use, for replacement
+    std::vector<uint8_t>  amps;   // [loop][brg_count][brg_size]
+    std::vector<uint32_t> stamp;  // Scene version a bearing was amplified for
+  };
+
+  void update(uint32_t rev);
+  void placeTargets(uint32_t brg, float* row);
+  void placeRain(uint32_t brg, float* row);
+
+  uint32_t _brg_count;
+  uint32_t _brg_size;
+  RadarSceneConfig _cfg;
+  uint32_t _seed;
+
+  std::vector<Target>   _targets;
+  std::vector<RainCell> _rain;
+  std::vector<float>    _sin, _cos;     // Bearing directions
+
+  // Inputs, any thread
+  std::mutex _lock;
+  std::shared_ptr< const std::vector<float> > _land;
+  float _lat, _lon, _range;
+  bool  _has_pos;
+  std::atomic<uint32_t> _version;       // Bumped on every input change
+
+  // Generating thread state
+  LandMask       _raster;
+  std::unique_ptr<LandMaskTable> _table;
+  uint32_t       _table_version;
+  float          _cur_range;
+  uint32_t       _cur_rev;              // Revolution the positions below are for
+  std::vector<float>    _tgt_brg, _tgt_rng;   // Bearing (bearings) and range (cells) per target
+  std::vector<float>    _row;
+
+  std::vector<uint8_t>  _frames;        // [loop][brg_count][brg_size]
+  std::vector<uint32_t> _frame_stamp;
+  GainSlot              _slots[RS_GAIN_SLOTS];
+  uint32_t              _uses;
+
+  RadarSceneStats _stats;
+};
+
+#endif // RADARSCENE_H
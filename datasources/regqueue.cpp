@@ -0,0 +1,253 @@
+#include "regqueue.h"
+
+#include <string.h>
+#include <time.h>
+
+#define RQ_MAX_RESULTS 1024  // Results nobody takes are dropped beyond this
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+RegisterQueue::RegisterQueue(RegisterIo* io) {
+  _io         = io;
+  _notify     = NULL;
+  _notify_arg = NULL;
+  _next_id    = 1;
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+RegisterQueue::~RegisterQueue() {
+}
+
+void RegisterQueue::setNotify(void (*fn)(void*), void* arg) {
+  _notify     = fn;
+  _notify_arg = arg;
+}
+
+uint32_t RegisterQueue::submit(const RegCommand& cmd) {
+  uint32_t id;
+
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+
+    _pending.push_back(cmd);
+
+    RegCommand& c = _pending.back();
+    c.id       = _next_id++;
+    c.t_submit = nowNs();
+    c.t_start  = 0;
+    c.deadline = 0;
+    c.phase    = 0;
+    c.res      = 0;
+
+    _stats.submitted++;
+    id = c.id;
+  }
+
+  if (_notify)
+    _notify(_notify_arg);
+  return id;
+}
+
+uint32_t RegisterQueue::write(uint32_t addr, uint32_t val, const char* what, bool coalesce) {
+  if (coalesce) {
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // Only the latest queued command on the register may take the new value,
+    // the servicing thread has been woken up for it already
+    for (std::deque<RegCommand>::reverse_iterator it = _pending.rbegin(); it != _pending.rend(); ++it) {
+      if (it->addr != addr)
+        continue;
+
+      if (it->op != RegCommand::RC_WRITE)
+        break;
+
+      it->val = val;
+      _stats.coalesced++;
+      return it->id;
+    }
+  }
+
+  RegCommand cmd;
+  cmd.op   = RegCommand::RC_WRITE;
+  cmd.addr = addr;
+  cmd.val  = val;
+  cmd.aux  = 0;
+  cmd.what = what;
+  return submit(cmd);
+}
+
+uint32_t RegisterQueue::modify(uint32_t addr, uint32_t clear, uint32_t set, const char* what) {
+  RegCommand cmd;
+  cmd.op   = RegCommand::RC_MODIFY;
+  cmd.addr = addr;
+  cmd.val  = set;
+  cmd.aux  = clear;
+  cmd.what = what;
+  return submit(cmd);
+}
+
+uint32_t RegisterQueue::spi(uint32_t cmdreg, uint32_t addrv, uint32_t datav, const char* what) {
+  RegCommand cmd;
+  cmd.op   = RegCommand::RC_SPI;
+  cmd.addr = cmdreg;
+  cmd.val  = addrv;
+  cmd.aux  = datav;
+  cmd.what = what;
+  return submit(cmd);
+}
+
+bool RegisterQueue::step(RegCommand& cmd, uint32_t* polls) {
+  uint32_t v = 0;
+
+  if (cmd.phase == 0)
+    cmd.t_start = nowNs();
+
+  switch (cmd.op) {
+  case RegCommand::RC_WRITE:
+    cmd.res = _io->regwr(cmd.addr, cmd.val);
+    return true;
+
+  case RegCommand::RC_MODIFY:
+    cmd.res = _io->regrd(cmd.addr, &v);
+    if (cmd.res == 0)
+      cmd.res = _io->regwr(cmd.addr, (v & ~cmd.aux) | cmd.val);
+    return true;
+
+  case RegCommand::RC_SPI:
+    break;
+  }
+
+  // SPI: address word, wait for busy flag, data word, wait for busy flag
+  for (;;) {
+    switch (cmd.phase) {
+    case 0:
+    case 2:
+      cmd.res = _io->regwr(cmd.addr, (cmd.phase == 0) ? cmd.val : cmd.aux);
+      if (cmd.res != 0)
+        return true;
+
+      cmd.deadline = nowNs() + RQ_SPI_TIMEOUT_MS * 1000000ull;
+      cmd.phase++;
+      break;
+
+    case 1:
+    case 3:
+      if (*polls >= RQ_POLLS_PER_PASS)
+        return false;
+      (*polls)++;
+
+      cmd.res = _io->regrd(cmd.addr, &v);
+      if (cmd.res != 0)
+        return true;
+
+      if (!(v & RQ_SPI_BUSY)) {
+        if (nowNs() < cmd.deadline)
+          break;
+
+        // As before, the transfer goes on after a timeout
+        fprintf(stderr, "%s: SPI timeout elapsed (%s, 0x%08X)\n", __func__, cmd.what, (cmd.phase == 1) ? cmd.val : cmd.aux);
+        std::lock_guard<std::mutex> lock(_lock);
+        _stats.timeouts++;
+      }
+
+      cmd.phase++;
+      break;
+
+    default:
+      return true;
+    }
+  }
+}
+
+void RegisterQueue::finish(RegCommand& cmd) {
+  uint64_t t = nowNs();
+  std::lock_guard<std::mutex> lock(_lock);
+
+  double wait = (cmd.t_start - cmd.t_submit) * 1e-3;
+  double exec = (t - cmd.t_start) * 1e-3;
+
+  _stats.completed++;
+  if (cmd.res != 0)
+    _stats.failed++;
+  _stats.queue_us += wait;
+  _stats.exec_us  += exec;
+  if (wait + exec > _stats.max_us)
+    _stats.max_us = wait + exec;
+
+  RegResult r = { cmd.id, cmd.res, cmd.what, wait + exec };
+  _results.push_back(r);
+  if (_results.size() > RQ_MAX_RESULTS)
+    _results.pop_front();
+}
+
+bool RegisterQueue::service() {
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // Everything submitted so far is executed as one batch
+    while (!_pending.empty()) {
+      _active.push_back(_pending.front());
+      _pending.pop_front();
+    }
+
+    if (_active.empty())
+      return false;
+    _stats.passes++;
+  }
+
+  uint32_t polls = 0;
+  while (!_active.empty()) {
+    if (!step(_active.front(), &polls))
+      break;
+
+    finish(_active.front());
+    _active.pop_front();
+  }
+
+  std::lock_guard<std::mutex> lock(_lock);
+  _stats.polls += polls;
+  return !_active.empty() || !_pending.empty();
+}
+
+bool RegisterQueue::takeResult(RegResult* r) {
+  std::lock_guard<std::mutex> lock(_lock);
+
+  if (_results.empty())
+    return false;
+
+  *r = _results.front();
+  _results.pop_front();
+  return true;
+}
+
+int RegisterQueue::drain() {
+  int res = 0;
+  RegResult r;
+
+  while (service())
+    ;
+
+  while (takeResult(&r))
+    if (res == 0)
+      res = r.res;
+
+  return res;
+}
+
+RegQueueStats RegisterQueue::stats() {
+  std::lock_guard<std::mutex> lock(_lock);
+  return _stats;
+}
+
+void RegisterQueue::printStats(FILE* f) {
+  RegQueueStats st = stats();
+  fprintf(f, "Register queue: %llu commands (%llu coalesced), %llu failed, %llu SPI timeouts, wait %.1f us, execution %.1f us, max %.1f us, %llu polls in %llu passes\n"
+          , (unsigned long long)st.submitted, (unsigned long long)st.coalesced
+          , (unsigned long long)st.failed, (unsigned long long)st.timeouts
+          , st.completed ? st.queue_us / st.completed : 0.0, st.completed ? st.exec_us / st.completed : 0.0
+          , st.max_us, (unsigned long long)st.polls, (unsigned long long)st.passes);
+}
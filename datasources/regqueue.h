@@ -0,0 +1,113 @@
+#ifndef REGQUEUE_H
+#define REGQUEUE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#define RQ_SPI_TIMEOUT_MS   1000       // SPI busy flag wait, per phase
+#define RQ_SPI_BUSY         0x80000000 // SPI command register: transfer accepted
+#define RQ_POLLS_PER_PASS   16         // Register reads one service pass may spend on polling
+
+// Register access of the acquisition card
+class RegisterIo {
+public:
+  virtual ~RegisterIo() {}
+
+  virtual int regwr(uint32_t addr, uint32_t val) = 0;
+  virtual int regrd(uint32_t addr, uint32_t* val) = 0;
+};
+
+struct RegCommand {
+  enum op_t {
+    RC_WRITE  = 0,   // addr = val
+    RC_MODIFY = 1,   // addr = (addr & ~aux) | val
+    RC_SPI    = 2    // SPI transfer through command register addr: address word val, data word aux
+  };
+
+  op_t        op;
+  uint32_t    addr;
+  uint32_t    val;
+  uint32_t    aux;
+  const char* what;   // Shown in error messages
+
+  uint32_t    id;
+  uint64_t    t_submit;
+  uint64_t    t_start;
+  uint64_t    deadline;
+  int         phase;
+  int         res;
+};
+
+// Finished command as reported to the submitter
+struct RegResult {
+  uint32_t    id;
+  int         res;
+  const char* what;
+  double      latency_us;   // From submission to completion
+};
+
+struct RegQueueStats {
+  uint64_t submitted;
+  uint64_t coalesced;     // Writes replaced by a later write to the same register
+  uint64_t completed;
+  uint64_t failed;
+  uint64_t timeouts;      // SPI phases without the busy flag in time
+  uint64_t polls;
+  uint64_t passes;
+  double   queue_us;      // Sum of waits before execution
+  double   exec_us;       // Sum of execution times
+  double   max_us;        // Largest submission to completion time
+};
+
+// Command queue of the acquisition card registers. Any thread submits,
+// the acquisition thread executes in service() passes that never wait
+// for the SPI busy flag: a command still waiting resumes in the next
+// pass, timeouts are checked against the monotonic clock.
+class RegisterQueue {
+public:
+  explicit RegisterQueue(RegisterIo* io);
+  ~RegisterQueue();
+
+  // Called after every submission, wakes the thread servicing the queue
+  void setNotify(void (*fn)(void*), void* arg);
+
+  // Any thread, returns the command id. A coalescing write replaces the
+  // value of a queued write to the same register instead of adding one
+  uint32_t write(uint32_t addr, uint32_t val, const char* what, bool coalesce = false);
+  uint32_t modify(uint32_t addr, uint32_t clear, uint32_t set, const char* what);
+  uint32_t spi(uint32_t cmdreg, uint32_t addrv, uint32_t datav, const char* what);
+
+  // Acquisition thread. Returns true while commands remain
+  bool service();
+  bool takeResult(RegResult* r);
+
+  // Runs everything queued to completion in the calling thread while the
+  // acquisition thread is not servicing the queue. Returns 0 or the first error
+  int drain();
+
+  RegQueueStats stats();
+  void printStats(FILE* f);
+
+private:
+  uint32_t submit(const RegCommand& cmd);
+  bool step(RegCommand& cmd, uint32_t* polls);
+  void finish(RegCommand& cmd);
+
+  RegisterIo* _io;
+  void      (*_notify)(void*);
+  void*       _notify_arg;
+
+  std::mutex              _lock;
+  std::deque<RegCommand>  _pending;
+  std::deque<RegResult>   _results;
+  uint32_t                _next_id;
+  RegQueueStats           _stats;
+
+  // Acquisition thread
+  std::deque<RegCommand>  _active;
+};
+
+#endif // REGQUEUE_H
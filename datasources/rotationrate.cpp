@@ -0,0 +1,130 @@
+#include "rotationrate.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+RotationEstimator::RotationEstimator(uint32_t brg_count) {
+  _brg_count  = brg_count;
+  _started    = false;
+  _last_brg   = 0;
+  _last_t     = 0;
+  _rev_t0     = 0;
+  _advance    = 0;
+  _sx = _sy = _sxx = _sxy = _syy = 0;
+  _points     = 0;
+  _step_ns    = 0;
+  _hist_count = 0;
+
+  memset(_history, 0, sizeof(_history));
+  memset(&_rate, 0, sizeof(_rate));
+}
+
+RotationEstimator::~RotationEstimator() {
+}
+
+void RotationEstimator::restart(uint64_t t_ns, uint32_t brg) {
+  _started  = true;
+  _last_brg = brg;
+  _last_t   = t_ns;
+  _rev_t0   = t_ns;
+  _advance  = 0;
+
+  // The first point of a revolution is its origin
+  _sx = _sy = _sxx = _sxy = _syy = 0;
+  _points = 1;
+}
+
+bool RotationEstimator::addBatch(uint64_t t_ns, uint32_t brg) {
+  if (!_started) {
+    restart(t_ns, brg);
+    return false;
+  }
+
+  uint32_t d = (brg + _brg_count - _last_brg) % _brg_count;
+  if (d == 0)
+    return false;
+
+  // Backward jumps and pauses do not belong to a steady rotation
+  if (d > _brg_count / 2 || t_ns <= _last_t || t_ns - _last_t > RR_MAX_GAP_MS * 1000000ull) {
+    restart(t_ns, brg);
+
+    std::lock_guard<std::mutex> lock(_lock);
+    _rate.restarts++;
+    return false;
+  }
+
+  _advance += d;
+  _last_brg = brg;
+  _last_t   = t_ns;
+
+  // Time in microseconds against bearings advanced
+  double x = (double)_advance;
+  double y = (t_ns - _rev_t0) * 1e-3;
+  _sx  += x;
+  _sy  += y;
+  _sxx += x * x;
+  _sxy += x * y;
+  _syy += y * y;
+  _points++;
+
+  if (_advance < _brg_count)
+    return false;
+
+  finishRevolution();
+
+  // The next revolution starts from this batch
+  restart(t_ns, brg);
+  return true;
+}
+
+void RotationEstimator::finishRevolution() {
+  double n   = _points;
+  double den = n * _sxx - _sx * _sx;
+  if (_points < 3 || den <= 0)
+    return;
+
+  double b   = (n * _sxy - _sx * _sy) / den;   // Microseconds per bearing
+  double a   = (_sy - b * _sx) / n;
+  double sse = _syy - a * _sy - b * _sxy;
+  if (sse < 0)
+    sse = 0;
+  if (b <= 0)
+    return;
+
+  double period_us = b * _brg_count;
+  double rpm = 60e6 / period_us;
+  _step_ns = (uint64_t)(b * 1e3);
+
+  _history[_hist_count % RR_HISTORY] = rpm;
+  _hist_count++;
+
+  uint32_t k = (_hist_count < RR_HISTORY) ? _hist_count : RR_HISTORY;
+  double mean = 0, var = 0;
+  for (uint32_t i = 0; i < k; i++)
+    mean += _history[i];
+  mean /= k;
+  for (uint32_t i = 0; i < k; i++)
+    var += (_history[i] - mean) * (_history[i] - mean);
+
+  std::lock_guard<std::mutex> lock(_lock);
+  _rate.rpm       = rpm;
+  _rate.rpm_dev   = (k > 1) ? sqrt(var / (k - 1)) : 0;
+  _rate.period_ms = period_us * 1e-3;
+  _rate.jitter_us = sqrt(sse / n);
+  _rate.brg_ns    = b * 1e3;
+  _rate.revolutions++;
+  _rate.batches  += _points - 1;
+}
+
+RotationRate RotationEstimator::rate() const {
+  std::lock_guard<std::mutex> lock(_lock);
+  return _rate;
+}
+
+void RotationEstimator::printStats(FILE* f) const {
+  RotationRate r = rate();
+  fprintf(f, "Antenna: %.2f rpm (dev %.3f), period %.1f ms, jitter %.1f us, %.0f ns per bearing, %llu revolutions, %llu batches, %llu restarts\n"
+          , r.rpm, r.rpm_dev, r.period_ms, r.jitter_us, r.brg_ns, (unsigned long long)r.revolutions
+          , (unsigned long long)r.batches, (unsigned long long)r.restarts);
+}
@@ -0,0 +1,65 @@
+#ifndef ROTATIONRATE_H
+#define ROTATIONRATE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <mutex>
+
+#define RR_HISTORY     16     // Revolutions kept for the RPM spread
+#define RR_MAX_GAP_MS  5000   // Longer pauses between batches restart the revolution
+
+// Antenna rotation measured over the last complete revolution
+struct RotationRate {
+  double   rpm;          // 0 until a revolution has been seen
+  double   rpm_dev;      // Standard deviation of rpm over the last RR_HISTORY revolutions
+  double   period_ms;
+  double   jitter_us;    // RMS deviation of batch times from uniform rotation
+  double   brg_ns;       // Time between bearings
+  uint64_t revolutions;
+  uint64_t batches;
+  uint64_t restarts;     // Revolutions abandoned on a bearing jump or a pause
+};
+
+// Rotation rate and acquisition jitter from timestamped bearing batches.
+// A revolution is fitted with a straight line of time against bearings
+// advanced, accumulated batch by batch: the slope gives the rate, the
+// residuals the jitter of the batch times.
+class RotationEstimator {
+public:
+  explicit RotationEstimator(uint32_t brg_count);
+  ~RotationEstimator();
+
+  // Acquisition thread: batch completed at t_ns (CLOCK_MONOTONIC), brg is
+  // its last bearing. Returns true when a revolution has been completed
+  bool addBatch(uint64_t t_ns, uint32_t brg);
+
+  // Acquisition thread: time between bearings for stamping a batch, 0 until known
+  inline uint64_t bearingStep() const { return _step_ns; }
+
+  // Any thread
+  RotationRate rate() const;
+  void printStats(FILE* f) const;
+
+private:
+  void restart(uint64_t t_ns, uint32_t brg);
+  void finishRevolution();
+
+  uint32_t _brg_count;
+
+  // Acquisition thread state
+  bool     _started;
+  uint32_t _last_brg;
+  uint64_t _last_t;
+  uint64_t _rev_t0;
+  uint64_t _advance;     // Bearings since the revolution start
+  double   _sx, _sy, _sxx, _sxy, _syy;
+  uint32_t _points;
+  uint64_t _step_ns;
+  double   _history[RR_HISTORY];
+  uint32_t _hist_count;
+
+  mutable std::mutex _lock;
+  RotationRate _rate;
+};
+
+#endif // ROTATIONRATE_H
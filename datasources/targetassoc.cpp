@@ -0,0 +1,262 @@
+#include "targetassoc.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static float courseDiff(float a, float b) {
+  float d = fmodf(fabsf(a - b), 360.f);
+  return (d > 180.f) ? 360.f - d : d;
+}
+
+TargetAssociator::TargetAssociator() {
+  _mask = 0;
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+TargetAssociator::~TargetAssociator() {
+}
+
+uint32_t TargetAssociator::update(kind_t kind, const std::string& tag, const TrackReport& r) {
+  std::unordered_map<std::string, uint32_t>::iterator it = _index[kind].find(tag);
+  if (it != _index[kind].end()) {
+    _tracks[kind][it->second].r = r;
+    return it->second;
+  }
+
+  uint32_t idx;
+  if (!_free[kind].empty()) {
+    idx = _free[kind].back();
+    _free[kind].pop_back();
+  } else {
+    idx = _tracks[kind].size();
+    _tracks[kind].push_back(Track());
+  }
+
+  Track& tr  = _tracks[kind][idx];
+  tr.tag     = tag;
+  tr.r       = r;
+  tr.used    = true;
+  tr.partner = -1;
+  tr.valid   = false;
+
+  _index[kind][tag] = idx;
+  return idx;
+}
+
+void TargetAssociator::remove(kind_t kind, const std::string& tag) {
+  std::unordered_map<std::string, uint32_t>::iterator it = _index[kind].find(tag);
+  if (it == _index[kind].end())
+    return;
+
+  uint32_t idx = it->second;
+  Track&   tr  = _tracks[kind][idx];
+
+  // The partner is released at once, the next pass may pair it again
+  if (tr.partner >= 0) {
+    _tracks[1 - kind][tr.partner].partner = -1;
+    _stats.pairs--;
+  }
+
+  tr.used    = false;
+  tr.partner = -1;
+  tr.tag.clear();
+  _free[kind].push_back(idx);
+  _index[kind].erase(it);
+}
+
+int TargetAssociator::find(kind_t kind, const std::string& tag) const {
+  std::unordered_map<std::string, uint32_t>::const_iterator it = _index[kind].find(tag);
+  return (it == _index[kind].end()) ? -1 : (int)it->second;
+}
+
+void TargetAssociator::predict(Track& tr, double t, double lat0, double lon0, double kx) {
+  double dt = t - tr.r.t;
+
+  tr.valid = tr.used && dt < TA_MAX_AGE_S;
+  if (!tr.valid)
+    return;
+  if (dt < 0)
+    dt = 0;
+
+  double dlon = tr.r.lon - lon0;
+  dlon -= 360.0 * floor((dlon + 180.0) / 360.0);
+
+  double run = tr.r.sog * dt / 3600.0;
+  double c   = tr.r.cog * M_PI / 180.0;
+  tr.x = (float)(dlon * kx + run * sin(c));
+  tr.y = (float)((tr.r.lat - lat0) * TA_MILES_PER_DEGREE + run * cos(c));
+}
+
+uint32_t TargetAssociator::cellHash(int ix, int iy) const {
+  return ((uint32_t)ix * 73856093u ^ (uint32_t)iy * 19349663u) & _mask;
+}
+
+float TargetAssociator::cost(const Track& radar, const Track& ais) const {
+  float dx = radar.x - ais.x;
+  float dy = radar.y - ais.y;
+  float d2 = (dx * dx + dy * dy) / (TA_GATE_MILES * TA_GATE_MILES);
+  if (d2 >= 1.f)
+    return -1.f;
+
+  float dv = (radar.r.sog - ais.r.sog) / TA_GATE_KNOTS;
+  if (dv * dv >= 1.f)
+    return -1.f;
+
+  float c = d2 + dv * dv;
+  if (radar.r.sog >= TA_COG_MIN_KNOTS && ais.r.sog >= TA_COG_MIN_KNOTS) {
+    float dc = courseDiff(radar.r.cog, ais.r.cog) / TA_GATE_DEG;
+    if (dc >= 1.f)
+      return -1.f;
+    c += dc * dc;
+  }
+
+  return c;
+}
+
+void TargetAssociator::associate(double t) {
+  uint64_t t1 = nowNs();
+  std::vector<Track>& radar = _tracks[TA_RADAR];
+  std::vector<Track>& ais   = _tracks[TA_AIS];
+
+  // Flat coordinates around the first radar track, good within radar range
+  double lat0 = 0, lon0 = 0;
+  for (size_t i = 0; i < radar.size(); i++)
+    if (radar[i].used) {
+      lat0 = radar[i].r.lat;
+      lon0 = radar[i].r.lon;
+      break;
+    }
+  double kx = TA_MILES_PER_DEGREE * cos(lat0 * M_PI / 180.0);
+
+  for (size_t i = 0; i < radar.size(); i++)
+    predict(radar[i], t, lat0, lon0, kx);
+  for (size_t i = 0; i < ais.size(); i++)
+    predict(ais[i], t, lat0, lon0, kx);
+
+  // AIS targets sorted into hash buckets of gate-sized cells
+  uint32_t buckets = 64;
+  while (buckets < 2 * ais.size())
+    buckets <<= 1;
+  _mask = buckets - 1;
+
+  _bucket.assign(buckets + 1, 0);
+  _item_bucket.resize(ais.size());
+  for (size_t i = 0; i < ais.size(); i++) {
+    if (!ais[i].valid)
+      continue;
+    uint32_t h = cellHash((int)floorf(ais[i].x / TA_GATE_MILES), (int)floorf(ais[i].y / TA_GATE_MILES));
+    _item_bucket[i] = h;
+    _bucket[h + 1]++;
+  }
+  for (uint32_t b = 0; b < buckets; b++)
+    _bucket[b + 1] += _bucket[b];
+
+  _items.resize(_bucket[buckets]);
+  std::vector<uint32_t> fill(_bucket.begin(), _bucket.end() - 1);
+  for (size_t i = 0; i < ais.size(); i++)
+    if (ais[i].valid)
+      _items[fill[_item_bucket[i]]++] = i;
+
+  // Gated pairs, each radar track against the 3 x 3 cells around it
+  _cand.clear();
+  for (size_t r = 0; r < radar.size(); r++) {
+    if (!radar[r].valid)
+      continue;
+
+    int ix = (int)floorf(radar[r].x / TA_GATE_MILES);
+    int iy = (int)floorf(radar[r].y / TA_GATE_MILES);
+    uint32_t seen[9];
+    int nseen = 0;
+
+    for (int dy = -1; dy <= 1; dy++)
+      for (int dx = -1; dx <= 1; dx++) {
+        uint32_t h = cellHash(ix + dx, iy + dy);
+
+        // Neighbouring cells may share a bucket
+        bool dup = false;
+        for (int k = 0; k < nseen; k++)
+          dup |= (seen[k] == h);
+        if (dup)
+          continue;
+        seen[nseen++] = h;
+
+        for (uint32_t k = _bucket[h]; k < _bucket[h + 1]; k++) {
+          uint32_t a = _items[k];
+          float c = cost(radar[r], ais[a]);
+          if (c < 0.f)
+            continue;
+          if (radar[r].partner == (int)a)
+            c *= TA_KEEP;
+
+          Candidate cand = { c, (uint32_t)r, a };
+          _cand.push_back(cand);
+        }
+      }
+  }
+
+  std::sort(_cand.begin(), _cand.end());
+
+  // Cheapest pairs first
+  for (int k = 0; k < 2; k++) {
+    _prev[k].resize(_tracks[k].size());
+    for (size_t i = 0; i < _tracks[k].size(); i++) {
+      _prev[k][i] = _tracks[k][i].partner;
+      _tracks[k][i].partner = -1;
+    }
+  }
+
+  uint64_t pairs = 0;
+  for (size_t k = 0; k < _cand.size(); k++) {
+    const Candidate& c = _cand[k];
+    if (radar[c.radar].partner >= 0 || ais[c.ais].partner >= 0)
+      continue;
+
+    radar[c.radar].partner = c.ais;
+    ais[c.ais].partner     = c.radar;
+    pairs++;
+  }
+
+  for (int k = 0; k < 2; k++) {
+    _changed[k].clear();
+    for (size_t i = 0; i < _tracks[k].size(); i++)
+      if (_tracks[k][i].used && _tracks[k][i].partner != _prev[k][i])
+        _changed[k].push_back(i);
+    _stats.changes += _changed[k].size();
+  }
+
+  double us = (nowNs() - t1) / 1e3;
+  _stats.passes++;
+  _stats.candidates += _cand.size();
+  _stats.pairs   = pairs;
+  _stats.last_us = us;
+  if (us > _stats.max_us)
+    _stats.max_us = us;
+}
+
+uint64_t TargetAssociator::gatedPairs() const {
+  const std::vector<Track>& radar = _tracks[TA_RADAR];
+  const std::vector<Track>& ais   = _tracks[TA_AIS];
+
+  uint64_t gated = 0;
+  for (size_t r = 0; r < radar.size(); r++)
+    for (size_t a = 0; a < ais.size(); a++)
+      gated += (radar[r].valid && ais[a].valid && cost(radar[r], ais[a]) >= 0.f);
+
+  return gated;
+}
+
+void TargetAssociator::printStats(FILE* f) const {
+  fprintf(f, "Target association: %lu radar, %lu AIS, %llu pairs, %llu passes (last %.1f us, max %.1f us), %llu candidates, %llu changes\n"
+          , (unsigned long)_index[TA_RADAR].size(), (unsigned long)_index[TA_AIS].size()
+          , (unsigned long long)_stats.pairs, (unsigned long long)_stats.passes, _stats.last_us, _stats.max_us
+          , (unsigned long long)_stats.candidates, (unsigned long long)_stats.changes);
+}
@@ -0,0 +1,112 @@
+#ifndef TARGETASSOC_H
+#define TARGETASSOC_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define TA_GATE_MILES     0.5f   // Largest distance between predicted AIS and radar positions
+#define TA_GATE_KNOTS     8.f    // Largest speed difference
+#define TA_GATE_DEG       45.f   // Largest course difference of targets under way
+#define TA_COG_MIN_KNOTS  2.f    // Courses of slower targets are not compared
+#define TA_KEEP           0.5f   // Cost factor of pairs associated by the previous pass
+#define TA_MAX_AGE_S      360.0  // Older reports are not predicted and not associated
+#define TA_MILES_PER_DEGREE 60.1077  // Same earth radius as RLIMath
+
+// Position report of a track, either source
+struct TrackReport {
+  double t;          // Seconds, same clock as associate()
+  float  lat, lon;   // Degrees
+  float  cog, sog;   // Degrees, knots
+};
+
+struct TargetAssocStats {
+  uint64_t passes;
+  uint64_t candidates;  // Pairs within the gates
+  uint64_t pairs;       // Associated pairs after the last pass
+  uint64_t changes;     // Tracks which got or lost a partner
+  double   last_us;
+  double   max_us;
+};
+
+// Association of AIS targets with radar tracks. Both sources report in
+// any order, a pass predicts every track to a common time, hashes the AIS
+// positions into a grid of gate-sized cells and compares each radar
+// track with the AIS targets of the neighbouring cells only. Gated pairs
+// are assigned cheapest first, a pair kept from the previous pass costs
+// less so that associations do not flicker between close targets.
+class TargetAssociator {
+public:
+  enum kind_t {
+    TA_RADAR = 0,
+    TA_AIS   = 1
+  };
+
+  TargetAssociator();
+  ~TargetAssociator();
+
+  // Returns the index of the track, kept until remove()
+  uint32_t update(kind_t kind, const std::string& tag, const TrackReport& r);
+  void remove(kind_t kind, const std::string& tag);
+
+  // Associates the tracks predicted to t. Tracks whose partner has
+  // changed are listed by changed() until the next pass
+  void associate(double t);
+
+  // Partner index of the other kind, -1 if none
+  inline int partner(kind_t kind, uint32_t idx) const { return _tracks[kind][idx].partner; }
+  inline const std::string& tag(kind_t kind, uint32_t idx) const { return _tracks[kind][idx].tag; }
+  inline const TrackReport& report(kind_t kind, uint32_t idx) const { return _tracks[kind][idx].r; }
+  int find(kind_t kind, const std::string& tag) const;
+
+  inline const std::vector<uint32_t>& changed(kind_t kind) const { return _changed[kind]; }
+
+  // Pairs of the last pass within the gates, every radar track compared
+  // with every AIS target: the reference for the pairs the grid lookup
+  // adds to stats().candidates
+  uint64_t gatedPairs() const;
+
+  inline const TargetAssocStats& stats() const { return _stats; }
+  void printStats(FILE* f) const;
+
+private:
+  struct Track {
+    std::string tag;
+    TrackReport r;
+    bool  used;
+    int   partner;
+    float x, y;      // Predicted position of the pass, miles from the reference
+    bool  valid;     // Predicted by the pass
+  };
+
+  struct Candidate {
+    float    cost;
+    uint32_t radar;
+    uint32_t ais;
+
+    bool operator<(const Candidate& o) const { return cost < o.cost; }
+  };
+
+  void predict(Track& tr, double t, double lat0, double lon0, double kx);
+  uint32_t cellHash(int ix, int iy) const;
+  float cost(const Track& radar, const Track& ais) const;
+
+  std::vector<Track>    _tracks[2];
+  std::vector<uint32_t> _free[2];
+  std::unordered_map<std::string, uint32_t> _index[2];
+
+  // Pass scratch, reused
+  uint32_t               _mask;
+  std::vector<uint32_t>  _bucket;    // First item of a hash bucket, _mask + 2 entries
+  std::vector<uint32_t>  _items;     // AIS indexes sorted by bucket
+  std::vector<uint32_t>  _item_bucket;
+  std::vector<Candidate> _cand;
+  std::vector<int>       _prev[2];
+  std::vector<uint32_t>  _changed[2];
+
+  TargetAssocStats _stats;
+};
+
+#endif // TARGETASSOC_H
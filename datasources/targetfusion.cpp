@@ -0,0 +1,102 @@
+#include "targetfusion.h"
+
+
+TargetFusion::TargetFusion(QObject *parent) : QObject(parent) {
+  _timerId = -1;
+  _clock.start();
+}
+
+TargetFusion::~TargetFusion() {
+  finish();
+
+  if (_assoc.stats().passes > 0)
+    _assoc.printStats(stdout);
+}
+
+void TargetFusion::start() {
+  if (_timerId != -1)
+    return;
+
+  _timerId = startTimer(TF_PASS_MS);
+}
+
+void TargetFusion::finish() {
+  if (_timerId == -1)
+    return;
+
+  killTimer(_timerId);
+  _timerId = -1;
+}
+
+void TargetFusion::updateRadar(QString tag, RadarTarget target) {
+  report(TargetAssociator::TA_RADAR, tag, target);
+}
+
+void TargetFusion::updateAis(QString tag, RadarTarget target) {
+  report(TargetAssociator::TA_AIS, tag, target);
+}
+
+void TargetFusion::report(TargetAssociator::kind_t kind, const QString& tag, const RadarTarget& target) {
+  TrackReport r;
+  r.t   = _clock.elapsed() / 1000.0;
+  r.lat = target.Latitude;
+  r.lon = target.Longtitude;
+  r.cog = target.CourseOverGround;
+  r.sog = target.SpeedOverGround;
+
+  _last[kind][tag] = target;
+  publish(kind, _assoc.update(kind, tag.toStdString(), r));
+}
+
+void TargetFusion::publish(TargetAssociator::kind_t kind, uint32_t idx) {
+  int other = _assoc.partner(kind, idx);
+
+  if (other < 0) {
+    QString tag = QString::fromStdString(_assoc.tag(kind, idx));
+    RadarTarget target = _last[kind].value(tag);
+    target.Sources = (kind == TargetAssociator::TA_RADAR) ? TARGET_SRC_RADAR : TARGET_SRC_AIS;
+    emit updateTarget(tag, target);
+    return;
+  }
+
+  uint32_t radar = (kind == TargetAssociator::TA_RADAR) ? idx : other;
+  uint32_t ais   = (kind == TargetAssociator::TA_AIS) ? idx : other;
+  emit updateTarget(QString::fromStdString(_assoc.tag(TargetAssociator::TA_AIS, ais)), merged(radar, ais));
+}
+
+RadarTarget TargetFusion::merged(uint32_t radar, uint32_t ais) const {
+  const TrackReport& rr = _assoc.report(TargetAssociator::TA_RADAR, radar);
+  const TrackReport& ra = _assoc.report(TargetAssociator::TA_AIS, ais);
+  const RadarTarget  rt = _last[TargetAssociator::TA_RADAR].value(QString::fromStdString(_assoc.tag(TargetAssociator::TA_RADAR, radar)));
+
+  // Identity, heading and turn rate are only known from AIS, the position
+  // is taken from the latest report of either source
+  RadarTarget target = _last[TargetAssociator::TA_AIS].value(QString::fromStdString(_assoc.tag(TargetAssociator::TA_AIS, ais)));
+  if (rr.t > ra.t) {
+    target.Latitude   = rt.Latitude;
+    target.Longtitude = rt.Longtitude;
+  }
+
+  target.Lost    = target.Lost && rt.Lost;
+  target.Sources = TARGET_SRC_RADAR | TARGET_SRC_AIS;
+  return target;
+}
+
+void TargetFusion::timerEvent(QTimerEvent* e) {
+  Q_UNUSED(e);
+
+  _assoc.associate(_clock.elapsed() / 1000.0);
+
+  // A radar track paired with an AIS target is shown under the AIS tag only
+  const std::vector<uint32_t>& radar = _assoc.changed(TargetAssociator::TA_RADAR);
+  for (size_t i = 0; i < radar.size(); i++) {
+    if (_assoc.partner(TargetAssociator::TA_RADAR, radar[i]) >= 0)
+      emit deleteTarget(QString::fromStdString(_assoc.tag(TargetAssociator::TA_RADAR, radar[i])));
+    else
+      publish(TargetAssociator::TA_RADAR, radar[i]);
+  }
+
+  const std::vector<uint32_t>& ais = _assoc.changed(TargetAssociator::TA_AIS);
+  for (size_t i = 0; i < ais.size(); i++)
+    publish(TargetAssociator::TA_AIS, ais[i]);
+}
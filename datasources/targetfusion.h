@@ -0,0 +1,50 @@
+#ifndef TARGETFUSION_H
+#define TARGETFUSION_H
+
+#include "targetassoc.h"
+#include "../layers/targetengine.h"
+
+#include <QMap>
+#include <QElapsedTimer>
+#include <QTimerEvent>
+
+#define TF_PASS_MS  1000  // Association pass period
+
+// Merges AIS targets and radar tracks into one target stream. A radar
+// track associated with an AIS target is published under the AIS tag with
+// both sources set and its own tag deleted, unassociated targets pass
+// through under their own tags.
+class TargetFusion : public QObject
+{
+  Q_OBJECT
+public:
+  explicit TargetFusion(QObject *parent = 0);
+  virtual ~TargetFusion();
+
+signals:
+  void updateTarget(QString tag, RadarTarget target);
+  void deleteTarget(QString tag);
+
+protected slots:
+  void timerEvent(QTimerEvent* e);
+
+public slots:
+  void start();
+  void finish();
+
+  void updateRadar(QString tag, RadarTarget target);
+  void updateAis(QString tag, RadarTarget target);
+
+private:
+  void report(TargetAssociator::kind_t kind, const QString& tag, const RadarTarget& target);
+  void publish(TargetAssociator::kind_t kind, uint32_t idx);
+  RadarTarget merged(uint32_t radar, uint32_t ais) const;
+
+  int _timerId;
+  QElapsedTimer _clock;
+
+  TargetAssociator _assoc;
+  QMap<QString, RadarTarget> _last[2];  // Last report per tag and source
+};
+
+#endif // TARGETFUSION_H
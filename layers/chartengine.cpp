@@ -1,8 +1,13 @@
 #include "chartengine.h"
 
+#include <QDebug>
 #include <QDateTime>
 #include <QXmlStreamReader>
 
+#include <math.h>
+
+#include "../common/rlimath.h"
+
 ChartSettingsModel::ChartSettingsModel(const QString& file_path, QObject *parent) : QAbstractTableModel(parent), file(file_path) {
   load();
 }
@@ -289,6 +294,10 @@ QVariant ChartSettingsModel::headerData(int section, Qt::Orientation orientation
 
 
 ChartEngine::ChartEngine() {
+  area_engine = NULL;
+  line_engine = NULL;
+  mark_engine = NULL;
+  text_engine = NULL;
   sndg_engine = NULL;
   setting_up = false;
 
@@ -297,6 +306,10 @@ ChartEngine::ChartEngine() {
   _center = QVector2D(0, 0);
   _scale = 10;
   _angle = 0;
+  _stats.clear();
+  _stats_scale = 0;
+  _renders = 0;
+  _renders_cpu_ns = 0;
   back_color = QColor(0, 0, 0);
 
   //_fbo_format.setAttachment(QGLFramebufferObject::NoAttachment);
@@ -308,18 +321,11 @@ ChartEngine::ChartEngine() {
 }
 
 ChartEngine::~ChartEngine() {
-  if (sndg_engine != NULL)
-    delete sndg_engine;
-
-  QList<QString> layer_names;
-  for (int i = 0; i < (layer_names = area_engines.keys()).size(); i++)
-    delete area_engines[layer_names[i]];
-  for (int i = 0; i < (layer_names = line_engines.keys()).size(); i++)
-    delete line_engines[layer_names[i]];
-  for (int i = 0; i < (layer_names = mark_engines.keys()).size(); i++)
-    delete mark_engines[layer_names[i]];
-  for (int i = 0; i < (layer_names = text_engines.keys()).size(); i++)
-    delete text_engines[layer_names[i]];
+  delete area_engine;
+  delete line_engine;
+  delete mark_engine;
+  delete text_engine;
+  delete sndg_engine;
 
   if (initialized)
     delete _fbo;
@@ -340,10 +346,24 @@ bool ChartEngine::init(S52References* ref, const QGLContext* context) {
 
   shaders = new ChartShaders();
   shaders->init(context);
+  initPrograms();
+
+  area_engine = new ChartAreaEngine();
+  area_engine->init(context);
+  line_engine = new ChartLineEngine();
+  line_engine->init(context);
+  mark_engine = new ChartMarkEngine();
+  mark_engine->init(context);
+  text_engine = new ChartTextEngine();
+  text_engine->init(context);
+  sndg_engine = new ChartSndgEngine();
+  sndg_engine->init(context);
 
   canvas = QSize(255, 255);
-  _fbo = new QGLFramebufferObject(canvas, _fbo_format);
+  _fbo_size = canvas + QSize(2*CE_OVERSCAN_PX, 2*CE_OVERSCAN_PX);
+  _fbo = new QGLFramebufferObject(_fbo_size, _fbo_format);
 
+  _renders_clock.start();
   initialized = true;
 
   draw();
@@ -353,12 +373,13 @@ bool ChartEngine::init(S52References* ref, const QGLContext* context) {
 
 void ChartEngine::resize(uint radius) {
   canvas = QSize(2*radius+1, 2*radius+1);
+  _fbo_size = canvas + QSize(2*CE_OVERSCAN_PX, 2*CE_OVERSCAN_PX);
 
   if (!initialized)
       return;
 
   delete _fbo;
-  _fbo = new QGLFramebufferObject(canvas, _fbo_format);
+  _fbo = new QGLFramebufferObject(_fbo_size, _fbo_format);
 
   draw();
 }
@@ -371,11 +392,16 @@ void ChartEngine::setChart(S52Chart* chrt, S52References* ref) {
   clear();
 
   back_color = ref->getColor("NODTA");
+  setColorTables(ref);
+
+  // Layers go into the buffers in display order, so neighbours drawn one
+  // after another join into one range
+  QStringList order = settings->getLayersDisplayOrder();
 
-  setAreaLayers(chrt, ref);
-  setLineLayers(chrt, ref);
-  setMarkLayers(chrt, ref);
-  setTextLayers(chrt, ref);
+  setAreaLayers(chrt, ref, order);
+  setLineLayers(chrt, ref, order);
+  setMarkLayers(chrt, ref, order);
+  setTextLayers(chrt, ref, order);
 
   setSndgLayer(chrt, ref);
   setting_up = false;
@@ -383,20 +409,53 @@ void ChartEngine::setChart(S52Chart* chrt, S52References* ref) {
   draw();
 }
 
+QPoint chartViewOffset(const QVector2D& fbo_center, const QPoint& fbo_shift
+                     , const QVector2D& center, const QPoint& center_shift, float scale) {
+  // As the chart shaders project, the new center in pixels off the old one
+  double x_m = RLIMath::EARTH_RADIUS * cos(RLIMath::radians(fbo_center.x())) * RLIMath::radians(center.y() - fbo_center.y());
+  double y_m = -RLIMath::EARTH_RADIUS * RLIMath::radians(center.x() - fbo_center.x());
+
+  return QPoint(qRound(x_m / scale), qRound(y_m / scale)) + fbo_shift - center_shift;
+}
+
+QRectF ChartEngine::getTextureRect() const {
+  float w = _fbo_size.width();
+  float h = _fbo_size.height();
+
+  // FBO rows run bottom up
+  float left = CE_OVERSCAN_PX + _offset.x();
+  float top = CE_OVERSCAN_PX + _offset.y();
+  return QRectF(left / w, 1.f - (top + canvas.height()) / h, canvas.width() / w, canvas.height() / h);
+}
+
 void ChartEngine::update(QVector2D center, float scale, float angle, QPoint center_shift) {
-  bool need_update = (abs(_center.x() - center.x()) > 0.0005
-                    || abs(_center.y() - center.y()) > 0.0005
-                    || abs(_scale - scale) > 0.005
-                    || abs(_angle - angle) > 0.005
-                    || abs(_center_shift.x() - center_shift.x()) > 0.005
-                    || abs(_center_shift.y() - center_shift.y()) > 0.005);
-
-  if (initialized && !setting_up && need_update) {
+  if (!initialized || setting_up)
+    return;
+
+  // Whole pixels keep the composite a pixel-exact copy of the FBO
+  QPoint offset = chartViewOffset(_center, _center_shift, center, center_shift, scale);
+
+  bool need_update = (fabs(_scale - scale) > 0.005
+                    || fabs(_angle - angle) > 0.005
+                    || qAbs(offset.x()) > CE_OVERSCAN_PX
+                    || qAbs(offset.y()) > CE_OVERSCAN_PX);
+
+  if (need_update) {
     _center = center;
     _scale = scale;
     _angle = angle;
     _center_shift = center_shift;
     draw();
+  } else {
+    _offset = offset;
+  }
+
+  if (_renders_clock.elapsed() >= CE_STATS_PERIOD) {
+    qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Chart renders per minute:"
+             << _renders * 60000.0 / _renders_clock.restart()
+             << ", CPU per render:" << (_renders > 0 ? _renders_cpu_ns * 1e-6 / _renders : 0) << "ms";
+    _renders = 0;
+    _renders_cpu_ns = 0;
   }
 }
 
@@ -406,9 +465,12 @@ void ChartEngine::draw() {
 
   //qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Update chart";
 
+  _offset = QPoint(0, 0);
+  _renders++;
+
   _fbo->bind();
 
-  glViewport(0, 0, canvas.width(), canvas.height());
+  glViewport(0, 0, _fbo_size.width(), _fbo_size.height());
 
   glClearColor(back_color.redF(), back_color.greenF(), back_color.blueF(), 1.f);
   glClear(GL_COLOR_BUFFER_BIT);
@@ -417,12 +479,12 @@ void ChartEngine::draw() {
   glMatrixMode( GL_PROJECTION );
   glPushMatrix();
   glLoadIdentity();
-  glOrtho(0, canvas.width(), canvas.height(), 0, -1, 1 );
+  glOrtho(0, _fbo_size.width(), _fbo_size.height(), 0, -1, 1 );
 
   glMatrixMode( GL_MODELVIEW );
   glPushMatrix();
   glLoadIdentity();
-  glTranslatef(_center_shift.x() + canvas.width()/2.f, _center_shift.y() + canvas.height()/2.f, 0);
+  glTranslatef(_center_shift.x() + _fbo_size.width()/2.f, _center_shift.y() + _fbo_size.height()/2.f, 0);
 
   drawLayers();
 
@@ -442,140 +504,214 @@ void ChartEngine::clear() {
   if (!initialized)
       return;
 
-  if (sndg_engine != NULL) {
-    sndg_engine->clearData();
-  }
+  _layer_slots.clear();
 
-  QList<QString> layer_names;
+  area_engine->clearData();
+  line_engine->clearData();
+  mark_engine->clearData();
+  text_engine->clearData();
+  sndg_engine->clearData();
+}
 
-  for (int i = 0; i < (layer_names = area_engines.keys()).size(); i++)
-    area_engines[layer_names[i]]->clearData();
-  for (int i = 0; i < (layer_names = line_engines.keys()).size(); i++)
-    line_engines[layer_names[i]]->clearData();
-  for (int i = 0; i < (layer_names = mark_engines.keys()).size(); i++)
-    mark_engines[layer_names[i]]->clearData();
-  for (int i = 0; i < (layer_names = text_engines.keys()).size(); i++)
-    text_engines[layer_names[i]]->clearData();
+// Uniforms that stay the same for every draw: all the attributes are per
+// vertex and every program samples texture unit 0
+void ChartEngine::initPrograms() {
+  QGLShaderProgram* prog = shaders->getChartAreaProgram();
+  if (prog == NULL)
+    return;
+
+  prog->bind();
+  glUniform1i(shaders->getAreaUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
+  glUniform1f(shaders->getAreaUniformLoc(AREA_UNIFORMS_COLOR_INDEX), -1);
+  glUniform2f(shaders->getAreaUniformLoc(AREA_UNIFORMS_PATTERN_INDEX), -1, -1);
+  glUniform2f(shaders->getAreaUniformLoc(AREA_UNIFORMS_PATTERN_DIM), -1, -1);
+  prog->release();
+
+  prog = shaders->getChartLineProgram();
+  prog->bind();
+  glUniform1i(shaders->getLineUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
+  glUniform1f(shaders->getLineUniformLoc(LINE_UNIFORMS_COLOR_INDEX), -1);
+  glUniform2f(shaders->getLineUniformLoc(LINE_UNIFORMS_PATTERN_INDEX), -1, -1);
+  glUniform2f(shaders->getLineUniformLoc(LINE_UNIFORMS_PATTERN_DIM), -1, -1);
+  prog->release();
+
+  prog = shaders->getChartMarkProgram();
+  prog->bind();
+  glUniform1i(shaders->getMarkUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
+  glUniform2f(shaders->getMarkUniformLoc(MARK_UNIFORMS_SYMBOL_ORIGIN), -1, -1);
+  glUniform2f(shaders->getMarkUniformLoc(MARK_UNIFORMS_SYMBOL_SIZE), -1, -1);
+  glUniform2f(shaders->getMarkUniformLoc(MARK_UNIFORMS_SYMBOL_PIVOT), -1, -1);
+  prog->release();
+
+  prog = shaders->getChartTextProgram();
+  prog->bind();
+  glUniform1i(shaders->getTextUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
+  glUniform2f(shaders->getTextUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_DIM), 32*16, 32*16);
+  prog->release();
+
+  prog = shaders->getChartSndgProgram();
+  prog->bind();
+  glUniform1i(shaders->getSndgUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
+  prog->release();
+}
+
+// Uniforms keep their values in the program, the tables go up once per scheme
+void ChartEngine::setColorTables(S52References* ref) {
+  QString scheme = ref->getColorScheme();
+  if (scheme == _color_scheme || shaders->getChartAreaProgram() == NULL)
+    return;
+
+  std::vector<float> color_table = ref->getColorTable();
+  if (color_table.empty())
+    return;
+
+  shaders->getChartAreaProgram()->bind();
+  glUniform1fv(shaders->getAreaUniformLoc(AREA_UNIFORMS_COLOR_TABLE), color_table.size(), &color_table[0]);
+  shaders->getChartAreaProgram()->release();
+
+  shaders->getChartLineProgram()->bind();
+  glUniform1fv(shaders->getLineUniformLoc(LINE_UNIFORMS_COLOR_TABLE), color_table.size(), &color_table[0]);
+  shaders->getChartLineProgram()->release();
+
+  _color_scheme = scheme;
 }
 
 void ChartEngine::drawLayers() {
-  QStringList displayOrder = settings->getLayersDisplayOrder();
-  for (int i = displayOrder.size() - 1; i >= 0; i--)
-    if (!settings->isLayerVisible(displayOrder[i]))
-      displayOrder.removeAt(i);
+  QElapsedTimer clock;
+  clock.start();
 
+  // One pass over the settings, a lookup per visible layer
+  QStringList displayOrder = settings->getLayersDisplayOrder();
+  _area_slots.clear();
+  _line_slots.clear();
+  _mark_slots.clear();
+  _text_slots.clear();
 
-  shaders->getChartAreaProgram()->bind();
   for (int i = 0; i < displayOrder.size(); i++) {
-    QString s = displayOrder[i];
-    if (area_engines.contains(s) && area_engines[s] != NULL)
-      area_engines[s]->draw(shaders, _center, _scale, _angle);
+    QHash<QString, LayerSlots>::const_iterator it = _layer_slots.constFind(displayOrder[i]);
+    if (it == _layer_slots.constEnd() || !settings->isLayerVisible(displayOrder[i]))
+      continue;
+
+    if (it->area >= 0) _area_slots.push_back(it->area);
+    if (it->line >= 0) _line_slots.push_back(it->line);
+    if (it->mark >= 0) _mark_slots.push_back(it->mark);
+    if (it->text >= 0) _text_slots.push_back(it->text);
   }
-  shaders->getChartAreaProgram()->release();
 
 
+  // Farthest pixel of the FBO from the chart center
+  float half_w = _fbo_size.width() / 2.f + qAbs(_center_shift.x());
+  float half_h = _fbo_size.height() / 2.f + qAbs(_center_shift.y());
+
+  ChartView view;
+  view.lat = _center.x();
+  view.lon = _center.y();
+  view.scale = _scale;
+  view.angle = _angle;
+  view.radius_px = sqrt(half_w * half_w + half_h * half_h);
+
+  _stats.clear();
+
+  shaders->getChartAreaProgram()->bind();
+  area_engine->draw(shaders, view, _area_slots, &_stats);
+  shaders->getChartAreaProgram()->release();
+
   shaders->getChartLineProgram()->bind();
-  for (int i = 0; i < displayOrder.size(); i++) {
-    QString s = displayOrder[i];
-    if (line_engines.contains(s) && line_engines[s] != NULL)
-      line_engines[s]->draw(shaders, _center, _scale, _angle);
-  }
+  line_engine->draw(shaders, view, _line_slots, &_stats);
   shaders->getChartLineProgram()->release();
 
-
   shaders->getChartMarkProgram()->bind();
-  for (int i = 0; i < displayOrder.size(); i++) {
-    QString s = displayOrder[i];
-    if (mark_engines.contains(s) && mark_engines[s] != NULL)
-      mark_engines[s]->draw(shaders, _center, _scale, _angle);
-  }
+  mark_engine->draw(shaders, view, _mark_slots, &_stats);
   shaders->getChartMarkProgram()->release();
 
   shaders->getChartTextProgram()->bind();
-  for (int i = 0; i < displayOrder.size(); i++) {
-    QString s = displayOrder[i];
-    if (text_engines.contains(s) && text_engines[s] != NULL)
-      text_engines[s]->draw(shaders, _center, _scale, _angle);
-  }
+  text_engine->draw(shaders, view, _text_slots, &_stats);
   shaders->getChartTextProgram()->release();
 
-
-  if (sndg_engine != NULL && settings->areSoundingsVisible()) {
+  if (settings->areSoundingsVisible()) {
     shaders->getChartSndgProgram()->bind();
-    sndg_engine->draw(shaders, _center, _scale, _angle);
+    sndg_engine->draw(shaders, view, &_stats);
     shaders->getChartSndgProgram()->release();
   }
+
+  // Commands issued, the GPU may still be at them
+  _stats.cpu_ns = clock.nsecsElapsed();
+  _renders_cpu_ns += _stats.cpu_ns;
+
+  if (_stats_scale != _scale && _stats.total > 0) {
+    _stats_scale = _scale;
+    qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Chart at" << _scale << "m/px:"
+             << _stats.draw_calls << "draw calls of" << _stats.ranges << "ranges,"
+             << _stats.vertices << "of" << _stats.total << "vertices," << _stats.cpu_ns * 1e-6 << "ms CPU";
+  }
 }
 
-void ChartEngine::setAreaLayers(S52Chart* chrt, S52References* ref) {
+void ChartEngine::setAreaLayers(S52Chart* chrt, S52References* ref, const QStringList& order) {
   QList<QString> layer_names = chrt->getAreaLayerNames();
+  QList<S52AreaLayer*> layers;
 
-  for (int i = 0; i < layer_names.size(); i++) {
-    QString layer_name = layer_names[i];
-    S52AreaLayer* layer = chrt->getAreaLayer(layer_name);
-
-    if (!area_engines.contains(layer_name)) {
-      area_engines[layer_name] = new ChartAreaEngine();
-      area_engines[layer_name]->init(ctxt);
-    }
+  // Layers the settings do not list are never drawn
+  for (int i = 0; i < order.size(); i++) {
+    if (!layer_names.contains(order[i]))
+      continue;
 
-    area_engines[layer_name]->setPatternTexture(assets->getPatternTextureId(ref->getColorScheme())
-                                              , assets->getPatternTextureDim(ref->getColorScheme()));
-    area_engines[layer_name]->setData(layer, assets, ref);
+    _layer_slots[order[i]].area = layers.size();
+    layers.push_back(chrt->getAreaLayer(order[i]));
   }
+
+  area_engine->setPatternTexture(assets->getPatternTextureId(ref->getColorScheme())
+                               , assets->getPatternTextureDim(ref->getColorScheme()));
+  area_engine->setData(layers, assets, ref);
 }
 
-void ChartEngine::setLineLayers(S52Chart* chrt, S52References* ref) {
+void ChartEngine::setLineLayers(S52Chart* chrt, S52References* ref, const QStringList& order) {
   QList<QString> layer_names = chrt->getLineLayerNames();
+  QList<S52LineLayer*> layers;
 
-  for (int i = 0; i < layer_names.size(); i++) {
-    QString layer_name = layer_names[i];
-    S52LineLayer* layer = chrt->getLineLayer(layer_name);
+  for (int i = 0; i < order.size(); i++) {
+    if (!layer_names.contains(order[i]))
+      continue;
 
-    if (!line_engines.contains(layer_name)) {
-      line_engines[layer_name] = new ChartLineEngine();
-      line_engines[layer_name]->init(ctxt);
-    }
-
-    line_engines[layer_name]->setPatternTexture(assets->getLineTextureId(ref->getColorScheme())
-                                              , assets->getLineTextureDim(ref->getColorScheme()));
-    line_engines[layer_name]->setData(layer, assets, ref);
+    _layer_slots[order[i]].line = layers.size();
+    layers.push_back(chrt->getLineLayer(order[i]));
   }
+
+  line_engine->setPatternTexture(assets->getLineTextureId(ref->getColorScheme())
+                               , assets->getLineTextureDim(ref->getColorScheme()));
+  line_engine->setData(layers, assets, ref);
 }
 
-void ChartEngine::setMarkLayers(S52Chart* chrt, S52References* ref) {
+void ChartEngine::setMarkLayers(S52Chart* chrt, S52References* ref, const QStringList& order) {
   QList<QString> layer_names = chrt->getMarkLayerNames();
+  QList<S52MarkLayer*> layers;
 
-  for (int i = 0; i < layer_names.size(); i++) {
-    QString layer_name = layer_names[i];
-    S52MarkLayer* layer = chrt->getMarkLayer(layer_name);
-
-    if (!mark_engines.contains(layer_name)) {
-      mark_engines[layer_name] = new ChartMarkEngine();
-      mark_engines[layer_name]->init(ctxt);
-    }
+  for (int i = 0; i < order.size(); i++) {
+    if (!layer_names.contains(order[i]))
+      continue;
 
-    mark_engines[layer_name]->setPatternTexture(assets->getSymbolTextureId(ref->getColorScheme())
-                                              , assets->getSymbolTextureDim(ref->getColorScheme()));
-    mark_engines[layer_name]->setData(layer, assets, ref);
+    _layer_slots[order[i]].mark = layers.size();
+    layers.push_back(chrt->getMarkLayer(order[i]));
   }
+
+  mark_engine->setPatternTexture(assets->getSymbolTextureId(ref->getColorScheme())
+                               , assets->getSymbolTextureDim(ref->getColorScheme()));
+  mark_engine->setData(layers, assets, ref);
 }
 
-void ChartEngine::setTextLayers(S52Chart* chrt, S52References* /*ref*/) {
+void ChartEngine::setTextLayers(S52Chart* chrt, S52References* /*ref*/, const QStringList& order) {
   QList<QString> layer_names = chrt->getTextLayerNames();
+  QList<S52TextLayer*> layers;
 
-  for (int i = 0; i < layer_names.size(); i++) {
-    QString layer_name = layer_names[i];
-    S52TextLayer* layer = chrt->getTextLayer(layer_name);
-
-    if (!text_engines.contains(layer_name)) {
-      text_engines[layer_name] = new ChartTextEngine();
-      text_engines[layer_name]->init(ctxt);
-    }
+  for (int i = 0; i < order.size(); i++) {
+    if (!layer_names.contains(order[i]))
+      continue;
 
-    text_engines[layer_name]->setGlyphTexture(assets->getGlyphTextureId());
-    text_engines[layer_name]->setData(layer);
+    _layer_slots[order[i]].text = layers.size();
+    layers.push_back(chrt->getTextLayer(order[i]));
   }
+
+  text_engine->setGlyphTexture(assets->getGlyphTextureId());
+  text_engine->setData(layers);
 }
 
 void ChartEngine::setSndgLayer(S52Chart* chrt, S52References* ref) {
@@ -583,11 +719,6 @@ void ChartEngine::setSndgLayer(S52Chart* chrt, S52References* ref) {
   if (layer == NULL)
     return;
 
-  if (sndg_engine == NULL) {
-    sndg_engine = new ChartSndgEngine();
-    sndg_engine->init(ctxt);
-  }
-
   sndg_engine->setPatternTexture(assets->getSymbolTextureId(ref->getColorScheme())
                                , assets->getSymbolTextureDim(ref->getColorScheme()));
   sndg_engine->setData(layer, assets, ref);
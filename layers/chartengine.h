@@ -4,7 +4,9 @@
 #include <QVector2D>
 
 #include <QFile>
+#include <QHash>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QAbstractTableModel>
 
 #include <QtOpenGL/QGLFramebufferObject>
@@ -18,6 +20,9 @@
 #include "chartlayers.h"
 #include "chartshaders.h"
 
+#define CE_OVERSCAN_PX    256      // Chart FBO reaches this far past every side of the viewport
+#define CE_STATS_PERIOD   60000    // ms between the reports of chart renders
+
 
 class ChartSettingsModel : public QAbstractTableModel {
     Q_OBJECT
@@ -96,6 +101,9 @@ public:
   void update(QVector2D center, float scale, float angle, QPoint center_shift);
 
   inline GLuint getTextureId() { return _fbo->texture(); }
+  // Part of the texture the viewport shows, in texture coordinates
+  QRectF getTextureRect() const;
+  inline const ChartDrawStats& drawStats() { return _stats; }
 
 private:
   bool initialized;
@@ -112,6 +120,20 @@ private:
   float _scale;
   float _angle;
 
+  // The FBO is canvas with CE_OVERSCAN_PX on every side, rendered at _center.
+  // Moving the view within the margin only shifts the part shown by _offset
+  QSize _fbo_size;
+  QPoint _offset;
+
+  // Of the last render, reported whenever the scale changes
+  ChartDrawStats _stats;
+  float _stats_scale;
+
+  // Renders since the last report, every CE_STATS_PERIOD
+  uint32_t _renders;
+  uint64_t _renders_cpu_ns;
+  QElapsedTimer _renders_clock;
+
   QGLFramebufferObjectFormat _fbo_format;
   QGLFramebufferObject* _fbo;
 
@@ -123,17 +145,42 @@ private:
   void draw();
   void drawLayers();
 
-  void setAreaLayers(S52Chart* chrt, S52References* ref);
-  void setLineLayers(S52Chart* chrt, S52References* ref);
-  void setMarkLayers(S52Chart* chrt, S52References* ref);
-  void setTextLayers(S52Chart* chrt, S52References* ref);
+  void initPrograms();
+  void setColorTables(S52References* ref);
+
+  void setAreaLayers(S52Chart* chrt, S52References* ref, const QStringList& order);
+  void setLineLayers(S52Chart* chrt, S52References* ref, const QStringList& order);
+  void setMarkLayers(S52Chart* chrt, S52References* ref, const QStringList& order);
+  void setTextLayers(S52Chart* chrt, S52References* ref, const QStringList& order);
   void setSndgLayer(S52Chart* chrt, S52References* ref);
 
-  QMap<QString, ChartAreaEngine*>  area_engines;
-  QMap<QString, ChartLineEngine*>  line_engines;
-  QMap<QString, ChartMarkEngine*>  mark_engines;
-  QMap<QString, ChartTextEngine*>  text_engines;
+  // An engine per primitive type holds all the layers of the chart
+  ChartAreaEngine* area_engine;
+  ChartLineEngine* line_engine;
+  ChartMarkEngine* mark_engine;
+  ChartTextEngine* text_engine;
   ChartSndgEngine* sndg_engine;
+
+  // Slots of a layer in the engines, -1 where the chart has no such layer
+  struct LayerSlots {
+    int area, line, mark, text;
+    LayerSlots() { area = line = mark = text = -1; }
+  };
+  QHash<QString, LayerSlots> _layer_slots;
+
+  // Visible slots in drawing order, gathered in one pass over the settings
+  std::vector<int> _area_slots;
+  std::vector<int> _line_slots;
+  std::vector<int> _mark_slots;
+  std::vector<int> _text_slots;
+
+  // Scheme of the colour tables set in the area and line programs
+  QString _color_scheme;
 };
 
+// Where a view lies in an FBO rendered around fbo_center with fbo_shift:
+// pixels from the margin of the FBO to the margin of the view
+QPoint chartViewOffset(const QVector2D& fbo_center, const QPoint& fbo_shift
+                     , const QVector2D& center, const QPoint& center_shift, float scale);
+
 #endif // CHARTENGINE_H
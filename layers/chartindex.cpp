@@ -0,0 +1,512 @@
+#include "chartindex.h"
+
+#include <algorithm>
+#include <math.h>
+
+#include "../common/rlimath.h"
+
+using namespace RLIMath;
+
+
+ChartIndex::ChartIndex() {
+  _margin_px = 0;
+  _verts = 0;
+  _buckets = 0;
+}
+
+void ChartIndex::clear() {
+  _items.clear();
+  _order.clear();
+  _vert_first.clear();
+  _nodes.clear();
+  _margin_px = 0;
+  _verts = 0;
+  _buckets = 0;
+}
+
+void ChartIndex::build() {
+  _nodes.clear();
+  _order.resize(_items.size());
+  for (size_t i = 0; i < _items.size(); i++)
+    _order[i] = i;
+  _buckets = 0;
+
+  if (!_items.empty())
+    buildNode(0, _items.size(), 0);
+
+  _vert_first.resize(_order.size() + 1);
+  _vert_first[0] = 0;
+  for (size_t i = 0; i < _order.size(); i++)
+    _vert_first[i+1] = _vert_first[i] + _items[_order[i]].verts;
+  _verts = _vert_first.back();
+
+  // Nodes were built over item ranges, the layout of order() makes them vertex ranges
+  for (size_t i = 0; i < _nodes.size(); i++) {
+    int a = _nodes[i].first;
+    int b = a + _nodes[i].count;
+    _nodes[i].first = _vert_first[a];
+    _nodes[i].count = _vert_first[b] - _vert_first[a];
+  }
+}
+
+int ChartIndex::buildNode(int a, int b, int depth) {
+  Node n;
+  n.min_lat = n.min_lon =  1e9f;
+  n.max_lat = n.max_lon = -1e9f;
+  n.first = a;
+  n.count = b - a;
+  for (int k = 0; k < 4; k++)
+    n.child[k] = -1;
+
+  // Children are split at the middle of the item centers
+  float c_min_lat = 1e9f, c_max_lat = -1e9f;
+  float c_min_lon = 1e9f, c_max_lon = -1e9f;
+  uint64_t verts = 0;
+
+  for (int i = a; i < b; i++) {
+    const ChartIndexItem& it = _items[_order[i]];
+    n.min_lat = std::min(n.min_lat, it.min_lat);
+    n.min_lon = std::min(n.min_lon, it.min_lon);
+    n.max_lat = std::max(n.max_lat, it.max_lat);
+    n.max_lon = std::max(n.max_lon, it.max_lon);
+
+    float c_lat = 0.5f * (it.min_lat + it.max_lat);
+    float c_lon = 0.5f * (it.min_lon + it.max_lon);
+    c_min_lat = std::min(c_min_lat, c_lat);
+    c_max_lat = std::max(c_max_lat, c_lat);
+    c_min_lon = std::min(c_min_lon, c_lon);
+    c_max_lon = std::max(c_max_lon, c_lon);
+
+    verts += it.verts;
+  }
+
+  int idx = _nodes.size();
+  _nodes.push_back(n);
+
+  if (verts <= CI_BUCKET_VERTS || b - a <= 1 || depth >= CI_MAX_DEPTH) {
+    _buckets++;
+    return idx;
+  }
+
+  float mid_lat = 0.5f * (c_min_lat + c_max_lat);
+  float mid_lon = 0.5f * (c_min_lon + c_max_lon);
+  const std::vector<ChartIndexItem>& items = _items;
+
+  int* o = &_order[0];
+  int* m  = std::stable_partition(o + a, o + b, [&](int i) { return items[i].min_lat + items[i].max_lat < 2 * mid_lat; });
+  int* m1 = std::stable_partition(o + a, m,     [&](int i) { return items[i].min_lon + items[i].max_lon < 2 * mid_lon; });
+  int* m2 = std::stable_partition(m,     o + b, [&](int i) { return items[i].min_lon + items[i].max_lon < 2 * mid_lon; });
+
+  int bounds[5] = { a, static_cast<int>(m1 - o), static_cast<int>(m - o), static_cast<int>(m2 - o), b };
+
+  // Items all at one center cannot be split further
+  for (int k = 0; k < 4; k++) {
+    if (bounds[k] == a && bounds[k+1] == b) {
+      _buckets++;
+      return idx;
+    }
+  }
+
+  for (int k = 0; k < 4; k++) {
+    if (bounds[k+1] > bounds[k]) {
+      int child = buildNode(bounds[k], bounds[k+1], depth + 1);
+      _nodes[idx].child[k] = child;
+    }
+  }
+
+  return idx;
+}
+
+void ChartIndex::appendNode(const Node& n, std::vector<int>& firsts, std::vector<int>& counts) const {
+  if (n.count == 0)
+    return;
+
+  // Nodes come in layout order, a range right after the last one extends it
+  if (!firsts.empty() && firsts.back() + counts.back() == n.first) {
+    counts.back() += n.count;
+    return;
+  }
+
+  firsts.push_back(n.first);
+  counts.push_back(n.count);
+}
+
+uint64_t ChartIndex::query(const ChartView& view, std::vector<int>& firsts, std::vector<int>& counts) const {
+  firsts.clear();
+  counts.clear();
+
+  if (_nodes.empty())
+    return 0;
+
+  double r_m   = (view.radius_px + _margin_px) * view.scale;
+  double d_lat = degrees(r_m / EARTH_RADIUS);
+  double cos_lat = cos(radians(view.lat));
+  double d_lon = (cos_lat > 1e-6) ? d_lat / cos_lat : 360;
+
+  float min_lat = view.lat - d_lat, max_lat = view.lat + d_lat;
+  float min_lon = view.lon - d_lon, max_lon = view.lon + d_lon;
+
+  int stack[4 * (CI_MAX_DEPTH + 1)];
+  int top = 0;
+  stack[top++] = 0;
+
+  uint64_t verts = 0;
+  while (top > 0) {
+    const Node& n = _nodes[stack[--top]];
+
+    if (n.max_lat < min_lat || n.min_lat > max_lat || n.max_lon < min_lon || n.min_lon > max_lon)
+      continue;
+
+    bool inside = (n.min_lat >= min_lat && n.max_lat <= max_lat && n.min_lon >= min_lon && n.max_lon <= max_lon);
+    bool leaf = (n.child[0] < 0 && n.child[1] < 0 && n.child[2] < 0 && n.child[3] < 0);
+
+    if (inside || leaf) {
+      appendNode(n, firsts, counts);
+      verts += n.count;
+      continue;
+    }
+
+    // Reversed so the children come off the stack in layout order
+    for (int k = 3; k >= 0; k--)
+      if (n.child[k] >= 0)
+        stack[top++] = n.child[k];
+  }
+
+  return verts;
+}
+
+
+void ChartBatch::append(int first, int count) {
+  if (count <= 0)
+    return;
+
+  if (!_firsts.empty() && _firsts.back() + _counts.back() == first) {
+    _counts.back() += count;
+    return;
+  }
+
+  _firsts.push_back(first);
+  _counts.push_back(count);
+}
+
+uint64_t ChartBatch::add(const ChartIndex& index, int first, int count, const ChartView& view) {
+  if (index.empty()) {
+    append(first, count);
+    return std::max(count, 0);
+  }
+
+  uint64_t verts = index.query(view, _query_firsts, _query_counts);
+  for (size_t i = 0; i < _query_firsts.size(); i++)
+    append(first + _query_firsts[i], _query_counts[i]);
+  return verts;
+}
+
+ChartTiles::ChartTiles() {
+  _vertex_count = 0;
+  _part_count = 0;
+}
+
+void ChartTiles::clear() {
+  _tiles.clear();
+  _vertex_count = 0;
+  _part_count = 0;
+}
+
+double ChartTiles::side(float min_scale) {
+  return CI_TILE_DEG * std::max(1.0, min_scale / CI_TILE_SCALE);
+}
+
+void ChartTiles::add(int first, const ChartIndexItem& item, double side) {
+  if (!_tiles.empty()) {
+    Tile& t = _tiles.back();
+    double min_lat = std::min<double>(t.min_lat, item.min_lat);
+    double min_lon = std::min<double>(t.min_lon, item.min_lon);
+    double max_lat = std::max<double>(t.max_lat, item.max_lat);
+    double max_lon = std::max<double>(t.max_lon, item.max_lon);
+
+    if ((max_lat - min_lat <= side && max_lon - min_lon <= side) || t.first == first) {
+      t.min_lat = min_lat; t.min_lon = min_lon;
+      t.max_lat = max_lat; t.max_lon = max_lon;
+      return;
+    }
+  }
+
+  Tile t = { first, item.min_lat, item.min_lon, item.max_lat, item.max_lon, 0, 0 };
+  _tiles.push_back(t);
+}
+
+void ChartTiles::build(int vertex_count) {
+  _vertex_count = vertex_count;
+
+  // Points of a single location still get a step
+  for (size_t i = 0; i < _tiles.size(); i++) {
+    Tile& t = _tiles[i];
+    t.step_lat = std::max(t.max_lat - t.min_lat, 1e-9) / CI_TILE_STEPS;
+    t.step_lon = std::max(t.max_lon - t.min_lon, 1e-9) / CI_TILE_STEPS;
+  }
+}
+
+static uint16_t quantizeStep(double v, double origin, double step) {
+  double q = floor((v - origin) / step + 0.5);
+  return static_cast<uint16_t>(std::max(0.0, std::min<double>(CI_TILE_STEPS, q)));
+}
+
+void ChartTiles::quantize(const float* points, int count, int stride, uint16_t* offsets) const {
+  if (_tiles.empty()) {
+    std::fill(offsets, offsets + 2 * count, 0);
+    return;
+  }
+
+  size_t t = 0;
+  for (int p = 0; p < count; p++) {
+    while (t + 1 < _tiles.size() && _tiles[t+1].first <= p * stride)
+      t++;
+
+    const Tile& tile = _tiles[t];
+    offsets[2*p+0] = quantizeStep(points[2*p+0], tile.min_lat, tile.step_lat);
+    offsets[2*p+1] = quantizeStep(points[2*p+1], tile.min_lon, tile.step_lon);
+  }
+}
+
+int ChartTiles::tileAt(int vertex) const {
+  int t = 0, n = _tiles.size();
+  while (n > 0) {
+    int half = n / 2;
+    if (_tiles[t + half].first <= vertex) {
+      t += half + 1;
+      n -= half + 1;
+    } else {
+      n = half;
+    }
+  }
+  return std::max(t - 1, 0);
+}
+
+void ChartTiles::decode(int tile, const uint16_t* offset, double* lat, double* lon) const {
+  const Tile& t = _tiles[tile];
+  *lat = t.min_lat + offset[0] * t.step_lat;
+  *lon = t.min_lon + offset[1] * t.step_lon;
+}
+
+void ChartTiles::frame(int tile, const ChartView& view, float origin_m[2], float step_m[2]) const {
+  const Tile& t = _tiles[tile];
+  double lon_m = EARTH_RADIUS * cos(radians(view.lat));
+
+  origin_m[0] = lon_m * radians(t.min_lon - view.lon);
+  origin_m[1] = -EARTH_RADIUS * radians(t.min_lat - view.lat);
+  step_m[0] = lon_m * radians(t.step_lon);
+  step_m[1] = -EARTH_RADIUS * radians(t.step_lat);
+}
+
+void ChartTiles::split(const ChartBatch& batch) {
+  _part_count = 0;
+  if (_tiles.empty())
+    return;
+
+  int last = -1;
+  for (int i = 0; i < batch.size(); i++) {
+    int first = batch.firsts()[i];
+    int count = batch.counts()[i];
+
+    for (int t = tileAt(first); count > 0; t++) {
+      int end = (t + 1 < static_cast<int>(_tiles.size())) ? _tiles[t+1].first : first + count;
+      int n = std::min(count, end - first);
+      if (n <= 0)
+        continue;
+
+      if (t != last) {
+        if (_part_count == static_cast<int>(_parts.size())) {
+          _parts.push_back(ChartBatch());
+          _part_tiles.push_back(0);
+        }
+        _parts[_part_count].clear();
+        _part_tiles[_part_count] = t;
+        _part_count++;
+        last = t;
+      }
+
+      _parts[_part_count - 1].append(first, n);
+      first += n;
+      count -= n;
+    }
+  }
+}
+
+
+static void pointBounds(ChartIndexItem* it, const float* p, int points) {
+  it->min_lat = it->max_lat = p[0];
+  it->min_lon = it->max_lon = p[1];
+  for (int i = 1; i < points; i++) {
+    it->min_lat = std::min(it->min_lat, p[2*i+0]);
+    it->max_lat = std::max(it->max_lat, p[2*i+0]);
+    it->min_lon = std::min(it->min_lon, p[2*i+1]);
+    it->max_lon = std::max(it->max_lon, p[2*i+1]);
+  }
+}
+
+// Float range of the i-th feature of a layer, as the engines walk it
+static int featureEnd(const std::vector<int>& start_inds, size_t size, size_t i) {
+  if (i < start_inds.size() - 1)
+    return start_inds[i+1] - 1;
+  return size - 1;
+}
+
+void indexAreaLayer(S52AreaLayer* layer, int level, ChartIndex* index) {
+  index->clear();
+
+  const std::vector<int>& start_inds = (level == 0) ? layer->start_inds : layer->lods[level-1].start_inds;
+  const std::vector<float>& triangles = (level == 0) ? layer->triangles : layer->lods[level-1].triangles;
+
+  for (size_t i = 0; i < start_inds.size(); i++) {
+    int fst_idx = start_inds[i];
+    int lst_idx = featureEnd(start_inds, triangles.size(), i);
+    if (lst_idx <= fst_idx)
+      continue;
+
+    // Runs of whole triangles, neighbours in the triangulation are mostly close
+    int first = fst_idx / 2;
+    int end = (lst_idx + 1) / 2;
+    for (int v = first; v < end; v += 3 * CI_AREA_CHUNK) {
+      ChartIndexItem it;
+      it.feature = i;
+      it.first = v;
+      it.count = std::min(3 * CI_AREA_CHUNK, end - v);
+      it.verts = it.count;
+      pointBounds(&it, &triangles[2*v], it.count);
+      index->add(it);
+    }
+  }
+
+  index->setMargin(1);
+  index->build();
+}
+
+void indexLineLayer(S52LineLayer* layer, int level, ChartIndex* index) {
+  index->clear();
+
+  const std::vector<int>& start_inds = (level == 0) ? layer->start_inds : layer->lods[level-1].start_inds;
+  const std::vector<float>& points = (level == 0) ? layer->points : layer->lods[level-1].points;
+
+  for (size_t i = 0; i < start_inds.size(); i++) {
+    int fst_idx = start_inds[i];
+    int lst_idx = featureEnd(start_inds, points.size(), i);
+    if (lst_idx <= fst_idx)
+      continue;
+
+    // Every segment is a quad of its own, a line splits anywhere
+    int first = fst_idx / 2;
+    int segments = (lst_idx - fst_idx + 1) / 2 - 1;
+    for (int s = 0; s < segments; s += CI_LINE_CHUNK) {
+      ChartIndexItem it;
+      it.feature = i;
+      it.first = first + s;
+      it.count = std::min(CI_LINE_CHUNK, segments - s);
+      it.verts = 4 * it.count;
+      pointBounds(&it, &points[2*it.first], it.count + 1);
+      index->add(it);
+    }
+  }
+
+  index->setMargin(CI_LINE_MARGIN_PX);
+  index->build();
+}
+
+static float symbolReach(S52References* ref, const QString& symbol_ref) {
+  QVector2D dim = ref->getSymbolDim(symbol_ref);
+  return std::max(dim.x(), dim.y());
+}
+
+void indexMarkLayer(S52MarkLayer* layer, S52References* ref, ChartIndex* index) {
+  index->clear();
+
+  float margin = 0;
+  if (layer->is_symbol_uniform)
+    margin = symbolReach(ref, layer->symbol_ref);
+
+  for (size_t i = 0; i < layer->points.size() / 2; i++) {
+    ChartIndexItem it;
+    it.feature = i;
+    it.first = i;
+    it.count = 1;
+    it.verts = 4;
+    pointBounds(&it, &layer->points[2*i], 1);
+    index->add(it);
+
+    if (!layer->is_symbol_uniform)
+      margin = std::max(margin, symbolReach(ref, layer->symbol_refs[i]));
+  }
+
+  index->setMargin(margin);
+  index->build();
+}
+
+void indexTextLayer(S52TextLayer* layer, ChartIndex* index) {
+  index->clear();
+
+  int max_len = 0;
+  for (size_t i = 0; i < layer->points.size() / 2; i++) {
+    int len = layer->texts[i].size();
+    if (len == 0)
+      continue;
+
+    ChartIndexItem it;
+    it.feature = i;
+    it.first = i;
+    it.count = 1;
+    it.verts = len;
+    pointBounds(&it, &layer->points[2*i], 1);
+    index->add(it);
+
+    max_len = std::max(max_len, len);
+  }
+
+  index->setMargin(CI_GLYPH_PX * (max_len + 1));
+  index->build();
+}
+
+int soundingSymbols(double depth) {
+  QString s = QString::number(depth, 'f', 1);
+
+  int count = 0;
+  bool frac = false;
+  for (int j = 0; j < s.length(); j++) {
+    if (s[j] == '.') {
+      frac = true;
+      continue;
+    }
+
+    if (frac && s[j] == '0')
+      continue;
+
+    count++;
+  }
+  return count;
+}
+
+void indexSndgLayer(S52SndgLayer* layer, S52References* ref, ChartIndex* index) {
+  index->clear();
+
+  int max_symbols = 0;
+  for (size_t i = 0; i < layer->points.size() / 2; i++) {
+    int symbols = soundingSymbols(layer->depths[i]);
+    if (symbols == 0)
+      continue;
+
+    ChartIndexItem it;
+    it.feature = i;
+    it.first = i;
+    it.count = 1;
+    it.verts = 4 * symbols;
+    pointBounds(&it, &layer->points[2*i], 1);
+    index->add(it);
+
+    max_symbols = std::max(max_symbols, symbols);
+  }
+
+  float digit = 0;
+  for (int d = 0; d < 10; d++)
+    digit = std::max(digit, symbolReach(ref, QString("SOUNDS0%1").arg(d)));
+
+  index->setMargin(digit * (max_symbols + 1));
+  index->build();
+}
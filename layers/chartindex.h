@@ -0,0 +1,189 @@
+#ifndef CHARTINDEX_H
+#define CHARTINDEX_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "../s52/s52chart.h"
+#include "../s52/s52references.h"
+
+#define CI_BUCKET_VERTS     4096   // Buckets are split down to this many vertices
+#define CI_MAX_DEPTH        12     // Quadtree depth limit
+#define CI_AREA_CHUNK       64     // Triangles of an area indexed together
+#define CI_LINE_CHUNK       32     // Segments of a line indexed together
+#define CI_LINE_MARGIN_PX   16     // Line patterns reach this far off the line
+#define CI_GLYPH_PX         32     // Text glyph size as drawn by ChartTextEngine
+#define CI_TILE_STEPS       65535  // Vertex offsets within a tile are 16-bit
+#define CI_TILE_DEG         0.0625 // Tile side of full detail geometry, steps of about 10 cm
+#define CI_TILE_SCALE       2.0    // m/px past which tiles of coarser levels grow with the scale
+
+// What the chart FBO shows: the center in degrees, meters per pixel and the
+// distance from the center to the farthest drawn pixel. The visible area is
+// a circle, so the view does not depend on the rotation
+struct ChartView {
+  float lat, lon;
+  float scale;
+  float angle;
+  float radius_px;
+};
+
+// Draw calls, vertex ranges and vertices of one chart render against all
+// vertices loaded, and the CPU time the render took
+struct ChartDrawStats {
+  uint32_t draw_calls;
+  uint32_t ranges;
+  uint64_t vertices;
+  uint64_t total;
+  uint64_t cpu_ns;
+
+  void clear() { draw_calls = 0; ranges = 0; vertices = 0; total = 0; cpu_ns = 0; }
+};
+
+// Indexed piece of a layer: a feature or a run of its triangles or segments.
+// first and count are in units of the layer (vertices of the triangles, points
+// of the line, points of a mark layer), verts is what the engine draws for it
+struct ChartIndexItem {
+  float min_lat, min_lon;
+  float max_lat, max_lon;
+  int feature;
+  int first;
+  int count;
+  int verts;
+};
+
+// Quadtree over the items of a layer. The engine lays out its buffers in
+// order(), every node then covers one contiguous vertex range and a view
+// is drawn with the ranges of the nodes it touches, adjacent ones merged
+class ChartIndex {
+public:
+  ChartIndex();
+
+  void clear();
+
+  void add(const ChartIndexItem& item) { _items.push_back(item); }
+  // Pixels drawn around the item bounds: symbols, text, line patterns
+  void setMargin(float px) { _margin_px = px; }
+
+  void build();
+
+  inline bool empty() const { return _nodes.empty(); }
+  inline const std::vector<ChartIndexItem>& items() const { return _items; }
+  inline const std::vector<int>& order() const { return _order; }
+  inline uint64_t vertexCount() const { return _verts; }
+  inline int bucketCount() const { return _buckets; }
+
+  // Vertex ranges to draw for the view, returns the vertices in them
+  uint64_t query(const ChartView& view, std::vector<int>& firsts, std::vector<int>& counts) const;
+
+private:
+  struct Node {
+    float min_lat, min_lon;
+    float max_lat, max_lon;
+    int first, count;       // Vertex range
+    int child[4];           // Quadrants, -1 where empty and everywhere for a bucket
+  };
+
+  int  buildNode(int a, int b, int depth);
+  void appendNode(const Node& n, std::vector<int>& firsts, std::vector<int>& counts) const;
+
+  std::vector<ChartIndexItem> _items;
+  std::vector<int>  _order;
+  std::vector<int>  _vert_first;   // Of each position in _order, one extra at the end
+  std::vector<Node> _nodes;
+  float    _margin_px;
+  uint64_t _verts;
+  int      _buckets;
+};
+
+// Vertex ranges of all the layers an engine draws, in the order they are
+// added. Layers share the buffers of the engine, so a layer added with the
+// first vertex it starts at joins its ranges to the ones before whenever
+// they touch. The whole batch goes out in one multi-draw call
+class ChartBatch {
+public:
+  inline void clear() { _firsts.clear(); _counts.clear(); }
+
+  // Buckets of index in the view, all of count vertices without an index.
+  // Returns the vertices added
+  uint64_t add(const ChartIndex& index, int first, int count, const ChartView& view);
+
+  inline bool empty() const { return _firsts.empty(); }
+  inline int size() const { return _firsts.size(); }
+  inline const int* firsts() const { return &_firsts[0]; }
+  inline const int* counts() const { return &_counts[0]; }
+
+  // Vertex range, joined to the last one when they touch
+  void append(int first, int count);
+
+private:
+  std::vector<int> _firsts;
+  std::vector<int> _counts;
+  std::vector<int> _query_firsts;
+  std::vector<int> _query_counts;
+};
+
+// Vertex positions of an engine as 16-bit offsets within tiles. A tile is
+// a run of the layout: items are added in layout order and join the tile
+// of the items before while its frame stays within the side given for
+// them, so tiles are spatially compact as the layout follows the index.
+// The shaders get the tile origin from the view center in meters, found
+// in double, and the meters of a step; the precision no longer depends on
+// how far the chart lies from lat/lon 0. A batch is drawn in parts, one
+// per run of its ranges within a tile, in the order of the batch
+class ChartTiles {
+public:
+  ChartTiles();
+
+  void clear();
+
+  // Items from vertex first on
+  void add(int first, const ChartIndexItem& item, double side);
+  void build(int vertex_count);
+
+  // Tile side for a level drawn from min_scale m/px on
+  static double side(float min_scale);
+
+  // Lat/lon pairs of count points, point p at vertex p * stride
+  void quantize(const float* points, int count, int stride, uint16_t* offsets) const;
+
+  inline int tileCount() const { return _tiles.size(); }
+  int tileAt(int vertex) const;
+  void decode(int tile, const uint16_t* offset, double* lat, double* lon) const;
+
+  // Origin of the tile in meters east and south of the view center and
+  // meters of a step along lon and lat, as the shaders take them
+  void frame(int tile, const ChartView& view, float origin_m[2], float step_m[2]) const;
+
+  void split(const ChartBatch& batch);
+  inline int partCount() const { return _part_count; }
+  inline int partTile(int p) const { return _part_tiles[p]; }
+  inline const ChartBatch& part(int p) const { return _parts[p]; }
+
+private:
+  struct Tile {
+    int first;
+    double min_lat, min_lon;
+    double max_lat, max_lon;
+    double step_lat, step_lon;
+  };
+
+  std::vector<Tile> _tiles;
+  int _vertex_count;
+
+  std::vector<ChartBatch> _parts;
+  std::vector<int> _part_tiles;
+  int _part_count;
+};
+
+// Items of a layer in the vertex counts of its engine. Areas and lines are
+// indexed per level of detail: 0 is the full geometry, k is lods[k-1]
+void indexAreaLayer(S52AreaLayer* layer, int level, ChartIndex* index);
+void indexLineLayer(S52LineLayer* layer, int level, ChartIndex* index);
+void indexMarkLayer(S52MarkLayer* layer, S52References* ref, ChartIndex* index);
+void indexTextLayer(S52TextLayer* layer, ChartIndex* index);
+void indexSndgLayer(S52SndgLayer* layer, S52References* ref, ChartIndex* index);
+
+// Digit symbols ChartSndgEngine draws for a depth
+int soundingSymbols(double depth);
+
+#endif // CHARTINDEX_H
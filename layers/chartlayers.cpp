@@ -1,12 +1,156 @@
 #include "chartlayers.h"
 
+static ChartMultiDrawArrays resolveMultiDraw(const QGLContext* context) {
+  return reinterpret_cast<ChartMultiDrawArrays>(context->getProcAddress("glMultiDrawArrays"));
+}
+
+// Coarsest level meant for the scale, level 0 is drawn at any scale
+static int levelFor(const std::vector<float>& level_scales, float scale) {
+  int l = 0;
+  while (l + 1 < static_cast<int>(level_scales.size()) && level_scales[l+1] <= scale)
+    l++;
+  return l;
+}
+
+// Visible buckets of the level of a layer for the scale, the layer counts
+// against the vertices loaded with its full detail
+static void addLayer(ChartBatch& batch, const ChartLayerSlot& layer, const ChartView& view, ChartDrawStats* stats) {
+  if (layer.levels.empty())
+    return;
+
+  int l = levelFor(layer.level_scales, view.scale);
+  stats->total += layer.level_counts[0];
+  stats->vertices += batch.add(layer.levels[l], layer.level_firsts[l], layer.level_counts[l], view);
+}
+
+static void drawBatch(GLenum mode, const ChartBatch& batch, ChartMultiDrawArrays multi_draw, ChartDrawStats* stats) {
+  if (batch.empty())
+    return;
+
+  stats->ranges += batch.size();
+
+  if (multi_draw != NULL) {
+    multi_draw(mode, batch.firsts(), batch.counts(), batch.size());
+    stats->draw_calls++;
+    return;
+  }
+
+  for (int i = 0; i < batch.size(); i++)
+    glDrawArrays(mode, batch.firsts()[i], batch.counts()[i]);
+  stats->draw_calls += batch.size();
+}
+
+
+ChartQuads::ChartQuads() {
+  multi_draw = NULL;
+  divisor = NULL;
+  draw_instanced = NULL;
+}
+
+void ChartQuads::init(const QGLContext* context) {
+  initializeGLFunctions(context);
+  multi_draw = resolveMultiDraw(context);
+
+  // Some platforms hand out entry points the driver does not back
+  QByteArray ext(reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS)));
+  bool core = (QGLFormat::openGLVersionFlags() & QGLFormat::OpenGL_Version_3_3) != 0;
+  if (core) {
+    divisor = reinterpret_cast<ChartVertexAttribDivisor>(context->getProcAddress("glVertexAttribDivisor"));
+    draw_instanced = reinterpret_cast<ChartDrawArraysInstanced>(context->getProcAddress("glDrawArraysInstanced"));
+  } else if (ext.contains("GL_ARB_instanced_arrays")) {
+    divisor = reinterpret_cast<ChartVertexAttribDivisor>(context->getProcAddress("glVertexAttribDivisorARB"));
+    draw_instanced = reinterpret_cast<ChartDrawArraysInstanced>(context->getProcAddress("glDrawArraysInstancedARB"));
+  }
+}
+
+template <typename T>
+static void repeatRecords(std::vector<T>& records, int size) {
+  std::vector<T> verts;
+  verts.reserve(4 * records.size());
+  for (size_t r = 0; r < records.size(); r += size)
+    for (int k = 0; k < 4; k++)
+      verts.insert(verts.end(), records.begin() + r, records.begin() + r + size);
+  records.swap(verts);
+}
+
+void ChartQuads::upload(GLuint vbo, std::vector<GLfloat>& records, int size) {
+  if (!instanced())
+    repeatRecords(records, size);
+
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, records.size() * sizeof(GLfloat), &records[0], GL_STATIC_DRAW);
+}
+
+void ChartQuads::upload(GLuint vbo, std::vector<GLushort>& records, int size) {
+  if (!instanced())
+    repeatRecords(records, size);
+
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, records.size() * sizeof(GLushort), &records[0], GL_STATIC_DRAW);
+}
+
+void ChartQuads::uploadCorners(GLuint vbo, int quads) {
+  std::vector<GLfloat> orders;
+  for (int q = 0; q < (instanced() ? 1 : quads); q++)
+    for (int k = 0; k < 4; k++)
+      orders.push_back(k);
+
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, orders.size() * sizeof(GLfloat), &orders[0], GL_STATIC_DRAW);
+}
+
+void ChartQuads::draw(const ChartBatch& batch, GLuint corner_loc, GLuint corner_vbo
+                    , const ChartQuadAttribute* attrs, int attr_count, ChartDrawStats* stats) {
+  if (batch.empty())
+    return;
+
+  glBindBuffer(GL_ARRAY_BUFFER, corner_vbo);
+  glVertexAttribPointer(corner_loc, 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
+  glEnableVertexAttribArray(corner_loc);
+
+  for (int a = 0; a < attr_count; a++)
+    glEnableVertexAttribArray(attrs[a].loc);
+
+  if (!instanced()) {
+    for (int a = 0; a < attr_count; a++) {
+      glBindBuffer(GL_ARRAY_BUFFER, attrs[a].vbo);
+      glVertexAttribPointer(attrs[a].loc, attrs[a].size, attrs[a].type, GL_FALSE, 0, (void *) 0);
+    }
+
+    drawBatch(GL_QUADS, batch, multi_draw, stats);
+    return;
+  }
+
+  // Instances have no first one to start from before GL 4.2, the records
+  // are pointed at the first quad of every range instead
+  for (int a = 0; a < attr_count; a++)
+    divisor(attrs[a].loc, 1);
+
+  for (int i = 0; i < batch.size(); i++) {
+    int first = batch.firsts()[i] / 4;
+    for (int a = 0; a < attr_count; a++) {
+      size_t bytes = (attrs[a].type == GL_FLOAT) ? sizeof(GLfloat) : sizeof(GLushort);
+      glBindBuffer(GL_ARRAY_BUFFER, attrs[a].vbo);
+      glVertexAttribPointer(attrs[a].loc, attrs[a].size, attrs[a].type, GL_FALSE, 0
+                          , reinterpret_cast<void*>(first * attrs[a].size * bytes));
+    }
+    draw_instanced(GL_QUADS, 0, 4, batch.counts()[i] / 4);
+  }
+
+  stats->ranges += batch.size();
+  stats->draw_calls += batch.size();
+
+  // Divisors are not part of the program, the next one reads per vertex
+  for (int a = 0; a < attr_count; a++)
+    divisor(attrs[a].loc, 0);
+}
+
 ChartAreaEngine::ChartAreaEngine() {
   initialized = false;
   pattern_tex_id = -1;
   point_count = 0;
+  multi_draw = NULL;
 
-  is_color_uniform = false;
-  is_pattern_uniform = false;
   vbo_ids = new GLuint[AREA_ATTRIBUTES_COUNT];
 }
 
@@ -22,28 +166,21 @@ void ChartAreaEngine::init(const QGLContext* context) {
 
   initializeGLFunctions(context);
   glGenBuffers(AREA_ATTRIBUTES_COUNT, vbo_ids);
+  multi_draw = resolveMultiDraw(context);
   initialized = true;
 }
 
 void ChartAreaEngine::clearData() {
+  layers.clear();
+  tiles.clear();
+
   if (point_count == 0)
     return;
 
   point_count = 0;
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_COORDS]);
-  glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-  if (!is_color_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_COLOR_INDEX]);
-    glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-  }
-
-  if (!is_pattern_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_PATTERN_INDEX]);
-    glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_PATTERN_DIM]);
+  for (int i = 0; i < AREA_ATTRIBUTES_COUNT; i++) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[i]);
     glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
   }
 }
@@ -53,134 +190,142 @@ void ChartAreaEngine::setPatternTexture(GLuint tex_id, QVector2D dim) {
   pattern_tex_dim = dim;
 }
 
-void ChartAreaEngine::setData(S52AreaLayer* layer, S52Assets* assets, S52References* ref) {
+void ChartAreaEngine::setData(const QList<S52AreaLayer*>& layer_list, S52Assets* assets, S52References* ref) {
+  std::vector<GLfloat> coords;
   std::vector<GLfloat> color_inds;
   std::vector<GLfloat> tex_inds;
   std::vector<GLfloat> tex_dims;
 
-  if (layer->is_pattern_uniform) {
-    is_pattern_uniform = true;
-    patternIdx = assets->getPatternIndex(ref->getColorScheme(), layer->pattern_ref);
-    patternDim = assets->getPatternDim(ref->getColorScheme(), layer->pattern_ref);
-  }
+  QString scheme = ref->getColorScheme();
+  layers.resize(layer_list.size());
+  tiles.clear();
 
-  if (layer->is_color_uniform) {
-    is_color_uniform = true;
-    color_ind = layer->color_ind;
-  }
+  for (int s = 0; s < layer_list.size(); s++) {
+    S52AreaLayer* layer = layer_list[s];
+    ChartLayerSlot& slot = layers[s];
 
-  if ((!is_color_uniform) || (!is_pattern_uniform)) {
-    for (unsigned int i = 0; i < layer->start_inds.size(); i++) {
-      int fst_idx = layer->start_inds[i];
-      int lst_idx = 0;
+    QVector2D tex_ind, tex_dim;
+    if (layer->is_pattern_uniform) {
+      tex_ind = assets->getPatternIndex(scheme, layer->pattern_ref);
+      tex_dim = assets->getPatternDim(scheme, layer->pattern_ref);
+    }
 
-      if (i < layer->start_inds.size() - 1)
-        lst_idx = layer->start_inds[i+1] - 1;
-      else
-        lst_idx = layer->triangles.size() - 1;
+    slot.levels.resize(layer->lods.size() + 1);
+    slot.level_scales.assign(1, 0.f);
+    slot.level_firsts.clear();
+    slot.level_counts.clear();
 
-      if (lst_idx <= fst_idx)
-        continue;
+    for (size_t l = 0; l < slot.levels.size(); l++) {
+      const std::vector<float>& triangles = (l == 0) ? layer->triangles : layer->lods[l-1].triangles;
+      if (l > 0)
+        slot.level_scales.push_back(layer->lods[l-1].min_scale);
 
-      QVector2D tex_ind;
-      QVector2D tex_dim;
+      ChartIndex& index = slot.levels[l];
+      indexAreaLayer(layer, l, &index);
+      slot.level_firsts.push_back(coords.size() / 2);
 
-      if (!is_pattern_uniform) {
-        tex_ind = assets->getPatternIndex(ref->getColorScheme(), layer->pattern_refs[i]);
-        tex_dim = assets->getPatternDim(ref->getColorScheme(), layer->pattern_refs[i]);
-      }
+      const std::vector<ChartIndexItem>& items = index.items();
+      const std::vector<int>& order = index.order();
 
-      for (int j = fst_idx; j < lst_idx; j += 2) {
-        if (!is_color_uniform) {
-          color_inds.push_back(layer->color_inds[i]);
+      for (unsigned int o = 0; o < order.size(); o++) {
+        const ChartIndexItem& it = items[order[o]];
+        int i = it.feature;
+
+        tiles.add(coords.size() / 2, it, ChartTiles::side(slot.level_scales[l]));
+        coords.insert(coords.end(), triangles.begin() + 2*it.first
+                                  , triangles.begin() + 2*(it.first + it.count));
+
+        if (!layer->is_pattern_uniform) {
+          tex_ind = assets->getPatternIndex(scheme, layer->pattern_refs[i]);
+          tex_dim = assets->getPatternDim(scheme, layer->pattern_refs[i]);
         }
 
-        if (!is_pattern_uniform) {
+        float color_ind = layer->is_color_uniform ? layer->color_ind : layer->color_inds[i];
+        color_inds.insert(color_inds.end(), it.count, color_ind);
+
+        for (int j = 0; j < it.count; j++) {
           tex_inds.push_back(tex_ind.x());
           tex_inds.push_back(tex_ind.y());
           tex_dims.push_back(tex_dim.x());
           tex_dims.push_back(tex_dim.y());
         }
       }
+
+      slot.level_counts.push_back(coords.size() / 2 - slot.level_firsts[l]);
+
+      // Drawn whole if the layout does not match the index
+      if (slot.level_counts[l] != static_cast<int>(index.vertexCount()))
+        index.clear();
     }
   }
 
-  point_count = layer->triangles.size() / 2;
-  color_table = ref->getColorTable();
+  point_count = coords.size() / 2;
+  tiles.build(point_count);
+  if (point_count == 0)
+    return;
+
+  std::vector<GLushort> offsets(coords.size());
+  tiles.quantize(&coords[0], point_count, 1, &offsets[0]);
 
   glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_COORDS]);
-  glBufferData(GL_ARRAY_BUFFER, layer->triangles.size() * sizeof(GLfloat), &(layer->triangles[0]), GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, offsets.size() * sizeof(GLushort), &offsets[0], GL_STATIC_DRAW);
 
-  if (!is_color_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_COLOR_INDEX]);
-    glBufferData(GL_ARRAY_BUFFER, color_inds.size() * sizeof(GLfloat), &color_inds[0], GL_STATIC_DRAW);
-  }
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_COLOR_INDEX]);
+  glBufferData(GL_ARRAY_BUFFER, color_inds.size() * sizeof(GLfloat), &color_inds[0], GL_STATIC_DRAW);
 
-  if (!is_pattern_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_PATTERN_INDEX]);
-    glBufferData(GL_ARRAY_BUFFER, tex_inds.size() * sizeof(GLfloat), &tex_inds[0], GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_PATTERN_INDEX]);
+  glBufferData(GL_ARRAY_BUFFER, tex_inds.size() * sizeof(GLfloat), &tex_inds[0], GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_PATTERN_DIM]);
-    glBufferData(GL_ARRAY_BUFFER, tex_dims.size() * sizeof(GLfloat), &tex_dims[0], GL_STATIC_DRAW);
-  }
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_PATTERN_DIM]);
+  glBufferData(GL_ARRAY_BUFFER, tex_dims.size() * sizeof(GLfloat), &tex_dims[0], GL_STATIC_DRAW);
 }
 
-void ChartAreaEngine::draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle) {
+void ChartAreaEngine::draw(ChartShaders* shaders, const ChartView& view, const std::vector<int>& visible, ChartDrawStats* stats) {
   if (!initialized
    || pattern_tex_id == -1
    || point_count <= 0)
     return;
 
-  glUniform2f(shaders->getAreaUniformLoc(COMMON_UNIFORMS_CENTER), cur_coords.x(), cur_coords.y());
-  glUniform1f(shaders->getAreaUniformLoc(COMMON_UNIFORMS_SCALE), scale);
-  glUniform1f(shaders->getAreaUniformLoc(COMMON_UNIFORMS_NORTH), angle);
+  batch.clear();
+  for (size_t i = 0; i < visible.size(); i++)
+    addLayer(batch, layers[visible[i]], view, stats);
+
+  if (batch.empty())
+    return;
+
+  glUniform1f(shaders->getAreaUniformLoc(COMMON_UNIFORMS_SCALE), view.scale);
+  glUniform1f(shaders->getAreaUniformLoc(COMMON_UNIFORMS_NORTH), view.angle);
   glUniform2f(shaders->getAreaUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_DIM), pattern_tex_dim.x(), pattern_tex_dim.y());
 
   glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_COORDS]);
-  glVertexAttribPointer(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_COORDS), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
+  glVertexAttribPointer(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_COORDS), 2, GL_UNSIGNED_SHORT, GL_FALSE, 0, (void *) 0);
   glEnableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_COORDS));
 
-  if (!is_color_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_COLOR_INDEX]);
-    glVertexAttribPointer(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_COLOR_INDEX), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glEnableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_COLOR_INDEX));
-
-    glUniform1f(shaders->getAreaUniformLoc(AREA_UNIFORMS_COLOR_INDEX), -1);
-  } else {
-    glDisableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_COLOR_INDEX));
-
-    glUniform1f(shaders->getAreaUniformLoc(AREA_UNIFORMS_COLOR_INDEX), color_ind);
-  }
-
-  if (!is_pattern_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_PATTERN_INDEX]);
-    glVertexAttribPointer(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_INDEX), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glEnableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_INDEX));
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_COLOR_INDEX]);
+  glVertexAttribPointer(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_COLOR_INDEX), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
+  glEnableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_COLOR_INDEX));
 
-    glBindBuffer(GL_ARRAY_BUFFER, AREA_ATTRIBUTES_PATTERN_DIM);
-    glVertexAttribPointer(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_DIM), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glEnableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_DIM));
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_PATTERN_INDEX]);
+  glVertexAttribPointer(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_INDEX), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
+  glEnableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_INDEX));
 
-    glUniform2f(shaders->getAreaUniformLoc(AREA_UNIFORMS_PATTERN_INDEX), -1, -1);
-    glUniform2f(shaders->getAreaUniformLoc(AREA_UNIFORMS_PATTERN_DIM), -1, -1);
-  } else {
-    glDisableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_INDEX));
-    glDisableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_DIM));
-
-    glUniform2f(shaders->getAreaUniformLoc(AREA_UNIFORMS_PATTERN_INDEX), patternIdx.x(), patternIdx.y());
-    glUniform2f(shaders->getAreaUniformLoc(AREA_UNIFORMS_PATTERN_DIM), patternDim.x(), patternDim.y());
-  }
-
-  glUniform1f(shaders->getAreaUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
-  glUniform1fv(shaders->getAreaUniformLoc(AREA_UNIFORMS_COLOR_TABLE), color_table.size(), &color_table[0]);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[AREA_ATTRIBUTES_PATTERN_DIM]);
+  glVertexAttribPointer(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_DIM), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
+  glEnableVertexAttribArray(shaders->getAreaAttributeLoc(AREA_ATTRIBUTES_PATTERN_DIM));
 
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, pattern_tex_id);
 
-  glDrawArrays(GL_TRIANGLES, 0, point_count);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  tiles.split(batch);
+  for (int p = 0; p < tiles.partCount(); p++) {
+    GLfloat origin[2], step[2];
+    tiles.frame(tiles.partTile(p), view, origin, step);
+    glUniform2f(shaders->getAreaUniformLoc(COMMON_UNIFORMS_TILE_ORIGIN), origin[0], origin[1]);
+    glUniform2f(shaders->getAreaUniformLoc(COMMON_UNIFORMS_TILE_STEP), step[0], step[1]);
 
-  glFlush();
+    drawBatch(GL_TRIANGLES, tiles.part(p), multi_draw, stats);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 
@@ -190,8 +335,6 @@ ChartLineEngine::ChartLineEngine() {
   initialized = false;
   point_count = 0;
   pattern_tex_id = -1;
-  is_pattern_uniform = false;
-  is_color_uniform = false;
   vbo_ids = new GLuint[LINE_ATTRIBUTES_COUNT];
 }
 
@@ -202,33 +345,16 @@ ChartLineEngine::~ChartLineEngine() {
 }
 
 void ChartLineEngine::clearData() {
+  layers.clear();
+  tiles.clear();
+
   if (point_count == 0)
     return;
 
   point_count = 0;
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_COORDS1]);
-  glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_COORDS2]);
-  glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_DISTANCE]);
-  glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_ORDER]);
-  glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-  if (!is_pattern_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_PATTERN_INDEX]);
-    glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_PATTERN_DIM]);
-    glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-  }
-
-  if (!is_color_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_COLOR_INDEX]);
+  for (int i = 0; i < LINE_ATTRIBUTES_COUNT; i++) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[i]);
     glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
   }
 }
@@ -239,6 +365,7 @@ void ChartLineEngine::init(const QGLContext* context) {
 
   initializeGLFunctions(context);
   glGenBuffers(LINE_ATTRIBUTES_COUNT, vbo_ids);
+  quads.init(context);
   initialized = true;
 }
 
@@ -247,167 +374,146 @@ void ChartLineEngine::setPatternTexture(GLuint tex_id, QVector2D dim) {
   pattern_tex_dim = dim;
 }
 
-void ChartLineEngine::setData(S52LineLayer* layer, S52Assets* assets, S52References* ref) {
+void ChartLineEngine::setData(const QList<S52LineLayer*>& layer_list, S52Assets* assets, S52References* ref) {
   if (!initialized)
     return;
 
+  // A record per segment
   std::vector<GLfloat> coords1;
   std::vector<GLfloat> coords2;
-  std::vector<GLfloat> point_ords;
   std::vector<GLfloat> distances;
   std::vector<GLfloat> color_inds;
   std::vector<GLfloat> tex_inds;
   std::vector<GLfloat> tex_dims;
 
-  if (layer->is_pattern_uniform) {
-    is_pattern_uniform = true;
-    patternIdx = assets->getLineIndex(ref->getColorScheme(), layer->pattern_ref);
-    patternDim = assets->getLineDim(ref->getColorScheme(), layer->pattern_ref);
-  }
+  QString scheme = ref->getColorScheme();
+  layers.resize(layer_list.size());
+  tiles.clear();
 
-  if (layer->is_color_uniform) {
-    is_color_uniform = true;
-    color_ind = layer->color_ind;
-  }
+  for (int s = 0; s < layer_list.size(); s++) {
+    S52LineLayer* layer = layer_list[s];
+    ChartLayerSlot& slot = layers[s];
 
-  for (unsigned int i = 0; i < layer->start_inds.size(); i++) {
-    int fst_idx = layer->start_inds[i];
-    int lst_idx = 0;
+    QVector2D tex_ind, tex_dim;
+    if (layer->is_pattern_uniform) {
+      tex_ind = assets->getLineIndex(scheme, layer->pattern_ref);
+      tex_dim = assets->getLineDim(scheme, layer->pattern_ref);
+    }
 
-    if (i < layer->start_inds.size() - 1)
-      lst_idx = layer->start_inds[i+1] - 1;
-    else
-      lst_idx = layer->points.size() - 1;
+    slot.levels.resize(layer->lods.size() + 1);
+    slot.level_scales.assign(1, 0.f);
+    slot.level_firsts.clear();
+    slot.level_counts.clear();
 
-    if (lst_idx <= fst_idx)
-      continue;
+    for (size_t l = 0; l < slot.levels.size(); l++) {
+      const std::vector<float>& points = (l == 0) ? layer->points : layer->lods[l-1].points;
+      const std::vector<float>& dists = (l == 0) ? layer->distances : layer->lods[l-1].distances;
+      if (l > 0)
+        slot.level_scales.push_back(layer->lods[l-1].min_scale);
 
-    QVector2D tex_ind, tex_dim;
-    if (!is_pattern_uniform) {
-      tex_ind = assets->getLineIndex(ref->getColorScheme(), layer->pattern_refs[i]);
-      tex_dim = assets->getLineDim(ref->getColorScheme(), layer->pattern_refs[i]);
-    }
+      ChartIndex& index = slot.levels[l];
+      indexLineLayer(layer, l, &index);
+      slot.level_firsts.push_back(4 * distances.size());
+
+      const std::vector<ChartIndexItem>& items = index.items();
+      const std::vector<int>& order = index.order();
+
+      for (unsigned int o = 0; o < order.size(); o++) {
+        const ChartIndexItem& it = items[order[o]];
+        int i = it.feature;
 
-    for (int j = fst_idx; j < lst_idx - 2; j += 2) {
-      for (int k = 0; k < 4; k++) {
-        coords1.push_back(layer->points[j+0]);
-        coords1.push_back(layer->points[j+1]);
-        coords2.push_back(layer->points[j+2]);
-        coords2.push_back(layer->points[j+3]);
-        point_ords.push_back(k);
-        distances.push_back(layer->distances[j/2]);
-
-        if (!is_color_uniform) {
-          color_inds.push_back(layer->color_inds[i]);
+        if (!layer->is_pattern_uniform) {
+          tex_ind = assets->getLineIndex(scheme, layer->pattern_refs[i]);
+          tex_dim = assets->getLineDim(scheme, layer->pattern_refs[i]);
         }
 
-        if (!is_pattern_uniform) {
+        float color_ind = layer->is_color_uniform ? layer->color_ind : layer->color_inds[i];
+        tiles.add(4 * distances.size(), it, ChartTiles::side(slot.level_scales[l]));
+
+        for (int j = 2*it.first; j < 2*(it.first + it.count); j += 2) {
+          coords1.push_back(points[j+0]);
+          coords1.push_back(points[j+1]);
+          coords2.push_back(points[j+2]);
+          coords2.push_back(points[j+3]);
+          distances.push_back(dists[j/2]);
+          color_inds.push_back(color_ind);
+
           tex_inds.push_back(tex_ind.x());
           tex_inds.push_back(tex_ind.y());
           tex_dims.push_back(tex_dim.x());
           tex_dims.push_back(tex_dim.y());
         }
       }
-    }
-  }
-
-  point_count = point_ords.size();
-  color_table = ref->getColorTable();
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_COORDS1]);
-  glBufferData(GL_ARRAY_BUFFER, coords1.size() * sizeof(GLfloat), &coords1[0], GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_COORDS2]);
-  glBufferData(GL_ARRAY_BUFFER, coords2.size() * sizeof(GLfloat), &coords2[0], GL_STATIC_DRAW);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_DISTANCE]);
-  glBufferData(GL_ARRAY_BUFFER, distances.size() * sizeof(GLfloat), &distances[0], GL_STATIC_DRAW);
+      slot.level_counts.push_back(4 * distances.size() - slot.level_firsts[l]);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_ORDER]);
-  glBufferData(GL_ARRAY_BUFFER, point_ords.size() * sizeof(GLfloat), &point_ords[0], GL_STATIC_DRAW);
-
-  if (!is_pattern_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_PATTERN_INDEX]);
-    glBufferData(GL_ARRAY_BUFFER, tex_inds.size() * sizeof(GLfloat), &tex_inds[0], GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_PATTERN_DIM]);
-    glBufferData(GL_ARRAY_BUFFER, tex_dims.size() * sizeof(GLfloat), &tex_dims[0], GL_STATIC_DRAW);
+      // Drawn whole if the layout does not match the index
+      if (slot.level_counts[l] != static_cast<int>(index.vertexCount()))
+        index.clear();
+    }
   }
 
-  if (!is_color_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_COLOR_INDEX]);
-    glBufferData(GL_ARRAY_BUFFER, color_inds.size() * sizeof(GLfloat), &color_inds[0], GL_STATIC_DRAW);
-  }
+  int quad_count = distances.size();
+  point_count = 4 * quad_count;
+  tiles.build(point_count);
+  if (quad_count == 0)
+    return;
+
+  // Both ends in the tile of the segment
+  std::vector<GLushort> offsets1(coords1.size());
+  std::vector<GLushort> offsets2(coords2.size());
+  tiles.quantize(&coords1[0], quad_count, 4, &offsets1[0]);
+  tiles.quantize(&coords2[0], quad_count, 4, &offsets2[0]);
+
+  quads.upload(vbo_ids[LINE_ATTRIBUTES_COORDS1], offsets1, 2);
+  quads.upload(vbo_ids[LINE_ATTRIBUTES_COORDS2], offsets2, 2);
+  quads.upload(vbo_ids[LINE_ATTRIBUTES_DISTANCE], distances, 1);
+  quads.upload(vbo_ids[LINE_ATTRIBUTES_PATTERN_INDEX], tex_inds, 2);
+  quads.upload(vbo_ids[LINE_ATTRIBUTES_PATTERN_DIM], tex_dims, 2);
+  quads.upload(vbo_ids[LINE_ATTRIBUTES_COLOR_INDEX], color_inds, 1);
+  quads.uploadCorners(vbo_ids[LINE_ATTRIBUTES_ORDER], quad_count);
 }
 
-void ChartLineEngine::draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle) {
+void ChartLineEngine::draw(ChartShaders* shaders, const ChartView& view, const std::vector<int>& visible, ChartDrawStats* stats) {
   if (!initialized
    || pattern_tex_id == -1
    || point_count <= 0)
     return;
 
-  glUniform2f(shaders->getLineUniformLoc(COMMON_UNIFORMS_CENTER), cur_coords.x(), cur_coords.y());
-  glUniform1f(shaders->getLineUniformLoc(COMMON_UNIFORMS_SCALE), scale);
-  glUniform1f(shaders->getLineUniformLoc(COMMON_UNIFORMS_NORTH), angle);
-  glUniform2f(shaders->getLineUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_DIM), pattern_tex_dim.x(), pattern_tex_dim.y());
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_COORDS1]);
-  glVertexAttribPointer(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COORDS1), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COORDS1));
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_COORDS2]);
-  glVertexAttribPointer(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COORDS2), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COORDS2));
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_DISTANCE]);
-  glVertexAttribPointer(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_DISTANCE), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_DISTANCE));
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_ORDER]);
-  glVertexAttribPointer(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_ORDER), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_ORDER));
+  batch.clear();
+  for (size_t i = 0; i < visible.size(); i++)
+    addLayer(batch, layers[visible[i]], view, stats);
 
-  if (!is_pattern_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_PATTERN_INDEX]);
-    glVertexAttribPointer(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_PATTERN_INDEX), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glEnableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_PATTERN_INDEX));
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_PATTERN_DIM]);
-    glVertexAttribPointer(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_PATTERN_DIM), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glEnableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_PATTERN_DIM));
-
-    glUniform2f(shaders->getLineUniformLoc(LINE_UNIFORMS_PATTERN_INDEX), -1, -1);
-    glUniform2f(shaders->getLineUniformLoc(LINE_UNIFORMS_PATTERN_DIM), -1, -1);
-  } else {
-    glDisableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_PATTERN_INDEX));
-    glDisableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_PATTERN_DIM));
-
-    glUniform2f(shaders->getLineUniformLoc(LINE_UNIFORMS_PATTERN_INDEX), patternIdx.x(), patternIdx.y());
-    glUniform2f(shaders->getLineUniformLoc(LINE_UNIFORMS_PATTERN_DIM), patternDim.x(), patternDim.y());
-  }
-
-  if (!is_color_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[LINE_ATTRIBUTES_COLOR_INDEX]);
-    glVertexAttribPointer(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COLOR_INDEX), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glEnableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COLOR_INDEX));
-
-    glUniform1f(shaders->getLineUniformLoc(LINE_UNIFORMS_COLOR_INDEX), -1);
-  } else {
-    glDisableVertexAttribArray(shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COLOR_INDEX));
+  if (batch.empty())
+    return;
 
-    glUniform1f(shaders->getLineUniformLoc(LINE_UNIFORMS_COLOR_INDEX), color_ind);
-  }
+  glUniform1f(shaders->getLineUniformLoc(COMMON_UNIFORMS_SCALE), view.scale);
+  glUniform1f(shaders->getLineUniformLoc(COMMON_UNIFORMS_NORTH), view.angle);
+  glUniform2f(shaders->getLineUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_DIM), pattern_tex_dim.x(), pattern_tex_dim.y());
 
-  glUniform1f(shaders->getLineUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
-  glUniform1fv(shaders->getLineUniformLoc(LINE_UNIFORMS_COLOR_TABLE), color_table.size(), &color_table[0]);
+  const ChartQuadAttribute attrs[] = {
+    { shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COORDS1), vbo_ids[LINE_ATTRIBUTES_COORDS1], 2, GL_UNSIGNED_SHORT }
+  , { shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COORDS2), vbo_ids[LINE_ATTRIBUTES_COORDS2], 2, GL_UNSIGNED_SHORT }
+  , { shaders->getLineAttributeLoc(LINE_ATTRIBUTES_DISTANCE), vbo_ids[LINE_ATTRIBUTES_DISTANCE], 1, GL_FLOAT }
+  , { shaders->getLineAttributeLoc(LINE_ATTRIBUTES_PATTERN_INDEX), vbo_ids[LINE_ATTRIBUTES_PATTERN_INDEX], 2, GL_FLOAT }
+  , { shaders->getLineAttributeLoc(LINE_ATTRIBUTES_PATTERN_DIM), vbo_ids[LINE_ATTRIBUTES_PATTERN_DIM], 2, GL_FLOAT }
+  , { shaders->getLineAttributeLoc(LINE_ATTRIBUTES_COLOR_INDEX), vbo_ids[LINE_ATTRIBUTES_COLOR_INDEX], 1, GL_FLOAT }
+  };
 
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, pattern_tex_id);
 
-  glDrawArrays(GL_QUADS, 0, point_count);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  tiles.split(batch);
+  for (int p = 0; p < tiles.partCount(); p++) {
+    GLfloat origin[2], step[2];
+    tiles.frame(tiles.partTile(p), view, origin, step);
+    glUniform2f(shaders->getLineUniformLoc(COMMON_UNIFORMS_TILE_ORIGIN), origin[0], origin[1]);
+    glUniform2f(shaders->getLineUniformLoc(COMMON_UNIFORMS_TILE_STEP), step[0], step[1]);
 
-  glFlush();
+    quads.draw(tiles.part(p), shaders->getLineAttributeLoc(LINE_ATTRIBUTES_ORDER), vbo_ids[LINE_ATTRIBUTES_ORDER]
+             , attrs, sizeof(attrs) / sizeof(attrs[0]), stats);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 
@@ -419,6 +525,7 @@ ChartTextEngine::ChartTextEngine() {
   initialized = false;
   glyph_tex_id = -1;
   point_count = 0;
+  multi_draw = NULL;
   vbo_ids = new GLuint[TEXT_ATTRIBUTES_COUNT];
 }
 
@@ -434,10 +541,14 @@ void ChartTextEngine::init(const QGLContext* context) {
 
   initializeGLFunctions(context);
   glGenBuffers(TEXT_ATTRIBUTES_COUNT, vbo_ids);
+  multi_draw = resolveMultiDraw(context);
   initialized = true;
 }
 
 void ChartTextEngine::clearData() {
+  layers.clear();
+  tiles.clear();
+
   if (point_count == 0)
     return;
 
@@ -457,27 +568,60 @@ void ChartTextEngine::setGlyphTexture(GLuint tex_id) {
   glyph_tex_id = tex_id;
 }
 
-void ChartTextEngine::setData(S52TextLayer* layer) {
+void ChartTextEngine::setData(const QList<S52TextLayer*>& layer_list) {
   std::vector<GLfloat> world_coords;
   std::vector<GLfloat> char_orders;
   std::vector<GLfloat> char_values;
 
-  for (unsigned int i = 0; i < (layer->points.size() / 2); i ++) {
-    QString txt = layer->texts[i];
+  layers.resize(layer_list.size());
+  tiles.clear();
 
-    for (int j = 0; j < txt.size(); j++) {
-      world_coords.push_back(layer->points[2*i+0]);
-      world_coords.push_back(layer->points[2*i+1]);
+  for (int s = 0; s < layer_list.size(); s++) {
+    S52TextLayer* layer = layer_list[s];
+    ChartLayerSlot& slot = layers[s];
+
+    slot.levels.resize(1);
+    slot.level_scales.assign(1, 0.f);
+    slot.level_firsts.assign(1, char_orders.size());
+
+    ChartIndex& index = slot.levels[0];
+    indexTextLayer(layer, &index);
+
+    const std::vector<ChartIndexItem>& items = index.items();
+    const std::vector<int>& order = index.order();
+
+    for (unsigned int o = 0; o < order.size(); o++) {
+      const ChartIndexItem& it = items[order[o]];
+      int i = it.first;
+      QString txt = layer->texts[i];
+      tiles.add(char_orders.size(), it, ChartTiles::side(0));
+
+      for (int j = 0; j < txt.size(); j++) {
+        world_coords.push_back(layer->points[2*i+0]);
+        world_coords.push_back(layer->points[2*i+1]);
 
-      char_orders.push_back(j);
-      char_values.push_back(static_cast<int>(txt.at(j).toLatin1()));
+        char_orders.push_back(j);
+        char_values.push_back(static_cast<int>(txt.at(j).toLatin1()));
+      }
     }
+
+    slot.level_counts.assign(1, char_orders.size() - slot.level_firsts[0]);
+
+    // Drawn whole if the layout does not match the index
+    if (slot.level_counts[0] != static_cast<int>(index.vertexCount()))
+      index.clear();
   }
 
   point_count = char_orders.size();
+  tiles.build(point_count);
+  if (point_count == 0)
+    return;
+
+  std::vector<GLushort> offsets(world_coords.size());
+  tiles.quantize(&world_coords[0], point_count, 1, &offsets[0]);
 
   glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[TEXT_ATTRIBUTES_COORDS]);
-  glBufferData(GL_ARRAY_BUFFER, world_coords.size() * sizeof(GLfloat), &world_coords[0], GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, offsets.size() * sizeof(GLushort), &offsets[0], GL_STATIC_DRAW);
 
   glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[TEXT_ATTRIBUTES_CHAR_ORDER]);
   glBufferData(GL_ARRAY_BUFFER, char_orders.size() * sizeof(GLfloat), &char_orders[0], GL_STATIC_DRAW);
@@ -486,19 +630,24 @@ void ChartTextEngine::setData(S52TextLayer* layer) {
   glBufferData(GL_ARRAY_BUFFER, char_values.size() * sizeof(GLfloat), &char_values[0], GL_STATIC_DRAW);
 }
 
-void ChartTextEngine::draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle) {
+void ChartTextEngine::draw(ChartShaders* shaders, const ChartView& view, const std::vector<int>& visible, ChartDrawStats* stats) {
   if (!initialized
    || glyph_tex_id == -1
    || point_count <= 0)
     return;
 
-  glUniform2f(shaders->getTextUniformLoc(COMMON_UNIFORMS_CENTER), cur_coords.x(), cur_coords.y());
-  glUniform1f(shaders->getTextUniformLoc(COMMON_UNIFORMS_SCALE), scale);
-  glUniform1f(shaders->getTextUniformLoc(COMMON_UNIFORMS_NORTH),  angle);
-  glUniform2f(shaders->getTextUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_DIM), 32*16, 32*16);
+  batch.clear();
+  for (size_t i = 0; i < visible.size(); i++)
+    addLayer(batch, layers[visible[i]], view, stats);
+
+  if (batch.empty())
+    return;
+
+  glUniform1f(shaders->getTextUniformLoc(COMMON_UNIFORMS_SCALE), view.scale);
+  glUniform1f(shaders->getTextUniformLoc(COMMON_UNIFORMS_NORTH),  view.angle);
 
   glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[TEXT_ATTRIBUTES_COORDS]);
-  glVertexAttribPointer(shaders->getTextAttributeLoc(TEXT_ATTRIBUTES_COORDS), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
+  glVertexAttribPointer(shaders->getTextAttributeLoc(TEXT_ATTRIBUTES_COORDS), 2, GL_UNSIGNED_SHORT, GL_FALSE, 0, (void *) 0);
   glEnableVertexAttribArray(shaders->getTextAttributeLoc(TEXT_ATTRIBUTES_COORDS));
 
   glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[TEXT_ATTRIBUTES_CHAR_ORDER]);
@@ -509,17 +658,21 @@ void ChartTextEngine::draw(ChartShaders* shaders, QVector2D cur_coords, float sc
   glVertexAttribPointer(shaders->getTextAttributeLoc(TEXT_ATTRIBUTES_CHAR_VALUE), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
   glEnableVertexAttribArray(shaders->getTextAttributeLoc(TEXT_ATTRIBUTES_CHAR_VALUE));
 
-  glUniform1f(shaders->getLineUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
-
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, glyph_tex_id);
 
   glPointSize(32);
 
-  glDrawArrays(GL_POINTS, 0, point_count);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  tiles.split(batch);
+  for (int p = 0; p < tiles.partCount(); p++) {
+    GLfloat origin[2], step[2];
+    tiles.frame(tiles.partTile(p), view, origin, step);
+    glUniform2f(shaders->getTextUniformLoc(COMMON_UNIFORMS_TILE_ORIGIN), origin[0], origin[1]);
+    glUniform2f(shaders->getTextUniformLoc(COMMON_UNIFORMS_TILE_STEP), step[0], step[1]);
 
-  glFlush();
+    drawBatch(GL_POINTS, tiles.part(p), multi_draw, stats);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 
@@ -529,7 +682,6 @@ void ChartTextEngine::draw(ChartShaders* shaders, QVector2D cur_coords, float sc
 ChartMarkEngine::ChartMarkEngine() {
   initialized = false;
   point_count = 0;
-  is_pattern_uniform = false;
   pattern_tex_id = -1;
   vbo_ids = new GLuint[MARK_ATTRIBUTES_COUNT];
 }
@@ -546,29 +698,21 @@ void ChartMarkEngine::init(const QGLContext* context) {
 
   initializeGLFunctions(context);
   glGenBuffers(MARK_ATTRIBUTES_COUNT, vbo_ids);
+  quads.init(context);
   initialized = true;
 }
 
 void ChartMarkEngine::clearData() {
+  layers.clear();
+  tiles.clear();
+
   if (point_count == 0)
     return;
 
   point_count = 0;
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_WORLD_COORDS]);
-  glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_VERTEX_ORDER]);
-  glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-  if (!is_pattern_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_SYMBOL_ORIGIN]);
-    glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_SYMBOL_SIZE]);
-    glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_SYMBOL_PIVOT]);
+  for (int i = 0; i < MARK_ATTRIBUTES_COUNT; i++) {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[i]);
     glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
   }
 }
@@ -578,119 +722,120 @@ void ChartMarkEngine::setPatternTexture(GLuint tex_id, QVector2D size) {
   pattern_tex_size = size;
 }
 
-void ChartMarkEngine::setData(S52MarkLayer* layer, S52Assets* /*assets*/, S52References* ref) {
+void ChartMarkEngine::setData(const QList<S52MarkLayer*>& layer_list, S52Assets* /*assets*/, S52References* ref) {
+  // A record per mark
   std::vector<GLfloat> world_coords;
-  std::vector<GLfloat> vertex_orders;
   std::vector<GLfloat> symbol_origins;
   std::vector<GLfloat> symbol_sizes;
   std::vector<GLfloat> symbol_pivots;
 
-  if (layer->is_symbol_uniform) {
-    is_pattern_uniform = true;
-    patternOrigin = ref->getSymbolIndex(layer->symbol_ref);
-    patternSize = ref->getSymbolDim(layer->symbol_ref);
-    patternPivot = ref->getSymbolPivot(layer->symbol_ref);
-  }
+  layers.resize(layer_list.size());
+  tiles.clear();
+
+  for (int s = 0; s < layer_list.size(); s++) {
+    S52MarkLayer* layer = layer_list[s];
+    ChartLayerSlot& slot = layers[s];
 
-  for (unsigned int i = 0; i < (layer->points.size() / 2); i ++) {
     QVector2D tex_orig, tex_size, tex_pivt;
-    if (!is_pattern_uniform) {
-      tex_orig = ref->getSymbolIndex(layer->symbol_refs[i]);
-      tex_size = ref->getSymbolDim(layer->symbol_refs[i]);
-      tex_pivt = ref->getSymbolPivot(layer->symbol_refs[i]);
+    if (layer->is_symbol_uniform) {
+      tex_orig = ref->getSymbolIndex(layer->symbol_ref);
+      tex_size = ref->getSymbolDim(layer->symbol_ref);
+      tex_pivt = ref->getSymbolPivot(layer->symbol_ref);
     }
 
-    for (int k = 0; k < 4; k++) {
-      world_coords.push_back(layer->points[2*i+0]);
-      world_coords.push_back(layer->points[2*i+1]);
+    slot.levels.resize(1);
+    slot.level_scales.assign(1, 0.f);
+    slot.level_firsts.assign(1, 2 * world_coords.size());
 
-      vertex_orders.push_back(k);
+    ChartIndex& index = slot.levels[0];
+    indexMarkLayer(layer, ref, &index);
 
-      if (!is_pattern_uniform) {
-        symbol_origins.push_back(tex_orig.x());
-        symbol_origins.push_back(tex_orig.y());
-        symbol_sizes.push_back(tex_size.x());
-        symbol_sizes.push_back(tex_size.y());
-        symbol_pivots.push_back(tex_pivt.x());
-        symbol_pivots.push_back(tex_pivt.y());
-      }
-    }
-  }
+    const std::vector<ChartIndexItem>& items = index.items();
+    const std::vector<int>& order = index.order();
 
-  point_count = vertex_orders.size();
+    for (unsigned int o = 0; o < order.size(); o++) {
+      const ChartIndexItem& it = items[order[o]];
+      int i = it.first;
+      tiles.add(2 * world_coords.size(), it, ChartTiles::side(0));
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_WORLD_COORDS]);
-  glBufferData(GL_ARRAY_BUFFER, world_coords.size() * sizeof(GLfloat), &world_coords[0], GL_STATIC_DRAW);
+      if (!layer->is_symbol_uniform) {
+        tex_orig = ref->getSymbolIndex(layer->symbol_refs[i]);
+        tex_size = ref->getSymbolDim(layer->symbol_refs[i]);
+        tex_pivt = ref->getSymbolPivot(layer->symbol_refs[i]);
+      }
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_VERTEX_ORDER]);
-  glBufferData(GL_ARRAY_BUFFER, vertex_orders.size() * sizeof(GLfloat), &vertex_orders[0], GL_STATIC_DRAW);
+      world_coords.push_back(layer->points[2*i+0]);
+      world_coords.push_back(layer->points[2*i+1]);
 
-  if (!is_pattern_uniform) {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_SYMBOL_ORIGIN]);
-    glBufferData(GL_ARRAY_BUFFER, symbol_origins.size() * sizeof(GLfloat), &symbol_origins[0], GL_STATIC_DRAW);
+      symbol_origins.push_back(tex_orig.x());
+      symbol_origins.push_back(tex_orig.y());
+      symbol_sizes.push_back(tex_size.x());
+      symbol_sizes.push_back(tex_size.y());
+      symbol_pivots.push_back(tex_pivt.x());
+      symbol_pivots.push_back(tex_pivt.y());
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_SYMBOL_SIZE]);
-    glBufferData(GL_ARRAY_BUFFER, symbol_sizes.size() * sizeof(GLfloat), &symbol_sizes[0], GL_STATIC_DRAW);
+    slot.level_counts.assign(1, 2 * world_coords.size() - slot.level_firsts[0]);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_SYMBOL_PIVOT]);
-    glBufferData(GL_ARRAY_BUFFER, symbol_pivots.size() * sizeof(GLfloat), &symbol_pivots[0], GL_STATIC_DRAW);
+    // Drawn whole if the layout does not match the index
+    if (slot.level_counts[0] != static_cast<int>(index.vertexCount()))
+      index.clear();
   }
+
+  int quad_count = world_coords.size() / 2;
+  point_count = 4 * quad_count;
+  tiles.build(point_count);
+  if (quad_count == 0)
+    return;
+
+  std::vector<GLushort> offsets(world_coords.size());
+  tiles.quantize(&world_coords[0], quad_count, 4, &offsets[0]);
+
+  quads.upload(vbo_ids[MARK_ATTRIBUTES_WORLD_COORDS], offsets, 2);
+  quads.upload(vbo_ids[MARK_ATTRIBUTES_SYMBOL_ORIGIN], symbol_origins, 2);
+  quads.upload(vbo_ids[MARK_ATTRIBUTES_SYMBOL_SIZE], symbol_sizes, 2);
+  quads.upload(vbo_ids[MARK_ATTRIBUTES_SYMBOL_PIVOT], symbol_pivots, 2);
+  quads.uploadCorners(vbo_ids[MARK_ATTRIBUTES_VERTEX_ORDER], quad_count);
 }
 
-void ChartMarkEngine::draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle) {
+void ChartMarkEngine::draw(ChartShaders* shaders, const ChartView& view, const std::vector<int>& visible, ChartDrawStats* stats) {
   if (!initialized
    || pattern_tex_id == -1
    || point_count <= 0)
     return;
 
-  glUniform2f(shaders->getMarkUniformLoc(COMMON_UNIFORMS_CENTER), cur_coords.x(), cur_coords.y());
-  glUniform1f(shaders->getMarkUniformLoc(COMMON_UNIFORMS_SCALE), scale);
-  glUniform1f(shaders->getMarkUniformLoc(COMMON_UNIFORMS_NORTH),  angle);
-  glUniform2f(shaders->getMarkUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_DIM), pattern_tex_size.x(), pattern_tex_size.y());
+  batch.clear();
+  for (size_t i = 0; i < visible.size(); i++)
+    addLayer(batch, layers[visible[i]], view, stats);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_WORLD_COORDS]);
-  glVertexAttribPointer(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_WORLD_COORDS), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_WORLD_COORDS));
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_VERTEX_ORDER]);
-  glVertexAttribPointer(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_VERTEX_ORDER), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_VERTEX_ORDER));
-
-  if (!is_pattern_uniform) {
-    glUniform2f(shaders->getMarkUniformLoc(MARK_UNIFORMS_SYMBOL_ORIGIN), -1, -1);
-    glUniform2f(shaders->getMarkUniformLoc(MARK_UNIFORMS_SYMBOL_SIZE), -1, -1);
-    glUniform2f(shaders->getMarkUniformLoc(MARK_UNIFORMS_SYMBOL_PIVOT), -1, -1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_SYMBOL_ORIGIN]);
-    glVertexAttribPointer(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_ORIGIN), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glEnableVertexAttribArray(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_ORIGIN));
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_SYMBOL_SIZE]);
-    glVertexAttribPointer(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_SIZE), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glEnableVertexAttribArray(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_SIZE));
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MARK_ATTRIBUTES_SYMBOL_PIVOT]);
-    glVertexAttribPointer(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_PIVOT), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glEnableVertexAttribArray(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_PIVOT));
-  } else {
-    glUniform2f(shaders->getMarkUniformLoc(MARK_UNIFORMS_SYMBOL_ORIGIN), patternOrigin.x(), patternOrigin.y());
-    glUniform2f(shaders->getMarkUniformLoc(MARK_UNIFORMS_SYMBOL_SIZE), patternSize.x(), patternSize.y());
-    glUniform2f(shaders->getMarkUniformLoc(MARK_UNIFORMS_SYMBOL_PIVOT), patternPivot.x(), patternPivot.y());
-
-    glDisableVertexAttribArray(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_ORIGIN));
-    glDisableVertexAttribArray(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_SIZE));
-    glDisableVertexAttribArray(shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_PIVOT));
-  }
+  if (batch.empty())
+    return;
 
-  glUniform1f(shaders->getLineUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
+  glUniform1f(shaders->getMarkUniformLoc(COMMON_UNIFORMS_SCALE), view.scale);
+  glUniform1f(shaders->getMarkUniformLoc(COMMON_UNIFORMS_NORTH),  view.angle);
+  glUniform2f(shaders->getMarkUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_DIM), pattern_tex_size.x(), pattern_tex_size.y());
+
+  const ChartQuadAttribute attrs[] = {
+    { shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_WORLD_COORDS), vbo_ids[MARK_ATTRIBUTES_WORLD_COORDS], 2, GL_UNSIGNED_SHORT }
+  , { shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_ORIGIN), vbo_ids[MARK_ATTRIBUTES_SYMBOL_ORIGIN], 2, GL_FLOAT }
+  , { shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_SIZE), vbo_ids[MARK_ATTRIBUTES_SYMBOL_SIZE], 2, GL_FLOAT }
+  , { shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_SYMBOL_PIVOT), vbo_ids[MARK_ATTRIBUTES_SYMBOL_PIVOT], 2, GL_FLOAT }
+  };
 
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, pattern_tex_id);
 
-  glDrawArrays(GL_QUADS, 0, point_count);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  tiles.split(batch);
+  for (int p = 0; p < tiles.partCount(); p++) {
+    GLfloat origin[2], step[2];
+    tiles.frame(tiles.partTile(p), view, origin, step);
+    glUniform2f(shaders->getMarkUniformLoc(COMMON_UNIFORMS_TILE_ORIGIN), origin[0], origin[1]);
+    glUniform2f(shaders->getMarkUniformLoc(COMMON_UNIFORMS_TILE_STEP), step[0], step[1]);
 
-  glFlush();
+    quads.draw(tiles.part(p), shaders->getMarkAttributeLoc(MARK_ATTRIBUTES_VERTEX_ORDER), vbo_ids[MARK_ATTRIBUTES_VERTEX_ORDER]
+             , attrs, sizeof(attrs) / sizeof(attrs[0]), stats);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 
@@ -716,6 +861,7 @@ void ChartSndgEngine::init(const QGLContext* context) {
 
   initializeGLFunctions(context);
   glGenBuffers(SNDG_ATTRIBUTES_COUNT, vbo_ids);
+  quads.init(context);
   initialized = true;
 }
 
@@ -724,6 +870,8 @@ void ChartSndgEngine::clearData() {
     return;
 
   point_count = 0;
+  index.clear();
+  tiles.clear();
 
   /*glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_WORLD_COORDS]);
   glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
@@ -749,8 +897,8 @@ void ChartSndgEngine::setPatternTexture(GLuint tex_id, QVector2D size) {
 }
 
 void ChartSndgEngine::setData(S52SndgLayer* layer, S52Assets* /*assets*/, S52References* ref) {
+  // A record per digit
   std::vector<GLfloat> world_coords;
-  std::vector<GLfloat> vertex_orders;
   std::vector<GLfloat> symbol_orders;
   std::vector<GLfloat> symbol_fracs;
   std::vector<GLfloat> symbol_counts;
@@ -758,7 +906,17 @@ void ChartSndgEngine::setData(S52SndgLayer* layer, S52Assets* /*assets*/, S52Ref
   std::vector<GLfloat> symbol_sizes;
   std::vector<GLfloat> symbol_pivots;
 
-  for (unsigned int i = 0; i < (layer->points.size() / 2); i++) {
+  indexSndgLayer(layer, ref, &index);
+  tiles.clear();
+
+  const std::vector<ChartIndexItem>& items = index.items();
+  const std::vector<int>& order = index.order();
+
+  for (unsigned int o = 0; o < order.size(); o++) {
+    const ChartIndexItem& it = items[order[o]];
+    int i = it.first;
+    tiles.add(4 * symbol_orders.size(), it, ChartTiles::side(0));
+
     QVector2D tex_orig, tex_size, tex_pivt;
     QString depth = QString::number(layer->depths[i], 'f', 1);
 
@@ -777,109 +935,91 @@ void ChartSndgEngine::setData(S52SndgLayer* layer, S52Assets* /*assets*/, S52Ref
       tex_size = ref->getSymbolDim(symbol_ref);
       tex_pivt = ref->getSymbolPivot(symbol_ref);
 
-      for (int k = 0; k < 4; k++) {
-        world_coords.push_back(layer->points[2*i+0]);
-        world_coords.push_back(layer->points[2*i+1]);
-
-        vertex_orders.push_back(k);
+      world_coords.push_back(layer->points[2*i+0]);
+      world_coords.push_back(layer->points[2*i+1]);
 
-        if (!frac) {
-          symbol_orders.push_back(j);
-          symbol_fracs.push_back(0);
-        } else {
-          symbol_orders.push_back(j-1);
-          symbol_fracs.push_back(1);
-        }
+      if (!frac) {
+        symbol_orders.push_back(j);
+        symbol_fracs.push_back(0);
+      } else {
+        symbol_orders.push_back(j-1);
+        symbol_fracs.push_back(1);
+      }
 
-        symbol_counts.push_back(depth.length() - 2);
+      symbol_counts.push_back(depth.length() - 2);
 
-        symbol_origins.push_back(tex_orig.x());
-        symbol_origins.push_back(tex_orig.y());
+      symbol_origins.push_back(tex_orig.x());
+      symbol_origins.push_back(tex_orig.y());
 
-        symbol_sizes.push_back(tex_size.x());
-        symbol_sizes.push_back(tex_size.y());
+      symbol_sizes.push_back(tex_size.x());
+      symbol_sizes.push_back(tex_size.y());
 
-        symbol_pivots.push_back(tex_pivt.x());
-        symbol_pivots.push_back(tex_pivt.y());
-      }
+      symbol_pivots.push_back(tex_pivt.x());
+      symbol_pivots.push_back(tex_pivt.y());
     }
   }
 
-  point_count = vertex_orders.size();
+  int quad_count = symbol_orders.size();
+  point_count = 4 * quad_count;
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_WORLD_COORDS]);
-  glBufferData(GL_ARRAY_BUFFER, world_coords.size() * sizeof(GLfloat), &world_coords[0], GL_STATIC_DRAW);
+  // Drawn whole if the layout does not match the index
+  if (point_count != static_cast<int>(index.vertexCount()))
+    index.clear();
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_VERTEX_ORDER]);
-  glBufferData(GL_ARRAY_BUFFER, vertex_orders.size() * sizeof(GLfloat), &vertex_orders[0], GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_ORDER]);
-  glBufferData(GL_ARRAY_BUFFER, symbol_orders.size() * sizeof(GLfloat), &symbol_orders[0], GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_FRAC]);
-  glBufferData(GL_ARRAY_BUFFER, symbol_fracs.size() * sizeof(GLfloat), &symbol_fracs[0], GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_COUNT]);
-  glBufferData(GL_ARRAY_BUFFER, symbol_counts.size() * sizeof(GLfloat), &symbol_counts[0], GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_ORIGIN]);
-  glBufferData(GL_ARRAY_BUFFER, symbol_origins.size() * sizeof(GLfloat), &symbol_origins[0], GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_SIZE]);
-  glBufferData(GL_ARRAY_BUFFER, symbol_sizes.size() * sizeof(GLfloat), &symbol_sizes[0], GL_STATIC_DRAW);
+  tiles.build(point_count);
+  if (quad_count == 0)
+    return;
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_PIVOT]);
-  glBufferData(GL_ARRAY_BUFFER, symbol_pivots.size() * sizeof(GLfloat), &symbol_pivots[0], GL_STATIC_DRAW);
+  std::vector<GLushort> offsets(world_coords.size());
+  tiles.quantize(&world_coords[0], quad_count, 4, &offsets[0]);
+
+  quads.upload(vbo_ids[SNDG_ATTRIBUTES_WORLD_COORDS], offsets, 2);
+  quads.upload(vbo_ids[SNDG_ATTRIBUTES_SYMBOL_ORDER], symbol_orders, 1);
+  quads.upload(vbo_ids[SNDG_ATTRIBUTES_SYMBOL_FRAC], symbol_fracs, 1);
+  quads.upload(vbo_ids[SNDG_ATTRIBUTES_SYMBOL_COUNT], symbol_counts, 1);
+  quads.upload(vbo_ids[SNDG_ATTRIBUTES_SYMBOL_ORIGIN], symbol_origins, 2);
+  quads.upload(vbo_ids[SNDG_ATTRIBUTES_SYMBOL_SIZE], symbol_sizes, 2);
+  quads.upload(vbo_ids[SNDG_ATTRIBUTES_SYMBOL_PIVOT], symbol_pivots, 2);
+  quads.uploadCorners(vbo_ids[SNDG_ATTRIBUTES_VERTEX_ORDER], quad_count);
 }
 
-void ChartSndgEngine::draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle) {
+void ChartSndgEngine::draw(ChartShaders* shaders, const ChartView& view, ChartDrawStats* stats) {
   if (!initialized || pattern_tex_id == -1 || point_count <= 0)
     return;
 
-  glUniform2f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_CENTER), cur_coords.x(), cur_coords.y());
-  glUniform1f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_SCALE), scale);
-  glUniform1f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_NORTH),  angle);
-  glUniform2f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_DIM), pattern_tex_size.x(), pattern_tex_size.y());
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_WORLD_COORDS]);
-  glVertexAttribPointer(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_WORLD_COORDS), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_WORLD_COORDS));
+  batch.clear();
+  stats->total += point_count;
+  stats->vertices += batch.add(index, 0, point_count, view);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_VERTEX_ORDER]);
-  glVertexAttribPointer(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_VERTEX_ORDER), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_VERTEX_ORDER));
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_ORDER]);
-  glVertexAttribPointer(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_ORDER), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_ORDER));
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_FRAC]);
-  glVertexAttribPointer(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_FRAC), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_FRAC));
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_COUNT]);
-  glVertexAttribPointer(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_COUNT), 1, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_COUNT));
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_ORIGIN]);
-  glVertexAttribPointer(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_ORIGIN), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_ORIGIN));
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_SIZE]);
-  glVertexAttribPointer(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_SIZE), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_SIZE));
+  if (batch.empty())
+    return;
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[SNDG_ATTRIBUTES_SYMBOL_PIVOT]);
-  glVertexAttribPointer(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_PIVOT), 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-  glEnableVertexAttribArray(shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_PIVOT));
+  glUniform1f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_SCALE), view.scale);
+  glUniform1f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_NORTH),  view.angle);
+  glUniform2f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_DIM), pattern_tex_size.x(), pattern_tex_size.y());
 
-  glUniform1f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_PATTERN_TEX_ID), 0);
+  const ChartQuadAttribute attrs[] = {
+    { shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_WORLD_COORDS), vbo_ids[SNDG_ATTRIBUTES_WORLD_COORDS], 2, GL_UNSIGNED_SHORT }
+  , { shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_ORDER), vbo_ids[SNDG_ATTRIBUTES_SYMBOL_ORDER], 1, GL_FLOAT }
+  , { shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_FRAC), vbo_ids[SNDG_ATTRIBUTES_SYMBOL_FRAC], 1, GL_FLOAT }
+  , { shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_COUNT), vbo_ids[SNDG_ATTRIBUTES_SYMBOL_COUNT], 1, GL_FLOAT }
+  , { shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_ORIGIN), vbo_ids[SNDG_ATTRIBUTES_SYMBOL_ORIGIN], 2, GL_FLOAT }
+  , { shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_SIZE), vbo_ids[SNDG_ATTRIBUTES_SYMBOL_SIZE], 2, GL_FLOAT }
+  , { shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_SYMBOL_PIVOT), vbo_ids[SNDG_ATTRIBUTES_SYMBOL_PIVOT], 2, GL_FLOAT }
+  };
 
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, pattern_tex_id);
 
-  glDrawArrays(GL_QUADS, 0, point_count);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  tiles.split(batch);
+  for (int p = 0; p < tiles.partCount(); p++) {
+    GLfloat origin[2], step[2];
+    tiles.frame(tiles.partTile(p), view, origin, step);
+    glUniform2f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_TILE_ORIGIN), origin[0], origin[1]);
+    glUniform2f(shaders->getSndgUniformLoc(COMMON_UNIFORMS_TILE_STEP), step[0], step[1]);
 
-  glFlush();
+    quads.draw(tiles.part(p), shaders->getSndgAttributeLoc(SNDG_ATTRIBUTES_VERTEX_ORDER), vbo_ids[SNDG_ATTRIBUTES_VERTEX_ORDER]
+             , attrs, sizeof(attrs) / sizeof(attrs[0]), stats);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
 }
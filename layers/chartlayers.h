@@ -4,12 +4,86 @@
 #include <QColor>
 #include <QVector2D>
 
+#include "chartindex.h"
 #include "chartshaders.h"
 
 #include "../s52/s52chart.h"
 #include "../s52/s52assets.h"
 #include "../s52/s52references.h"
 
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// Floats of a vertex or of a quad record in the engine buffers, the 16-bit
+// offsets of a position taking one
+#define AREA_VERTEX_FLOATS  6    // Position, colour, pattern origin and size
+#define LINE_QUAD_FLOATS    8    // Both ends, distance, colour, pattern origin and size
+#define MARK_QUAD_FLOATS    7    // Position, symbol origin, size and pivot
+#define TEXT_VERTEX_FLOATS  3    // Position, char order and value
+#define SNDG_QUAD_FLOATS    10   // Position, digit order, fraction and count, symbol origin, size and pivot
+
+// glMultiDrawArrays is GL 1.4, QGLFunctions leaves it out. The engines
+// resolve it on init and fall back to a glDrawArrays per range without it
+typedef void (APIENTRY *ChartMultiDrawArrays)(GLenum mode, const GLint* firsts, const GLsizei* counts, GLsizei primcount);
+
+// Instancing, GL 3.3 or ARB_instanced_arrays
+typedef void (APIENTRY *ChartVertexAttribDivisor)(GLuint index, GLuint divisor);
+typedef void (APIENTRY *ChartDrawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei primcount);
+
+// Per-quad attribute of a ChartQuads draw, GL_FLOAT or GL_UNSIGNED_SHORT
+struct ChartQuadAttribute {
+  GLuint loc;
+  GLuint vbo;
+  int size;
+  GLenum type;
+};
+
+// Line segments, marks and sounding digits are quads the vertex shaders
+// span from one record: a quad is an instance of the four corners of the
+// corner buffer, its record advancing once per instance. Layouts and
+// batches stay in vertices, four per quad, so the index and the stats do
+// not tell the two apart. Without instancing every record is repeated for
+// the four corners on upload and the batch drawn as plain quads
+class ChartQuads : protected QGLFunctions {
+public:
+  explicit ChartQuads();
+
+  void init(const QGLContext* context);
+  inline bool instanced() const { return divisor != NULL && draw_instanced != NULL; }
+
+  // Records of size values each, one per quad
+  void upload(GLuint vbo, std::vector<GLfloat>& records, int size);
+  void upload(GLuint vbo, std::vector<GLushort>& records, int size);
+  // Vertex orders 0 to 3 of the corners
+  void uploadCorners(GLuint vbo, int quads);
+
+  void draw(const ChartBatch& batch, GLuint corner_loc, GLuint corner_vbo
+          , const ChartQuadAttribute* attrs, int attr_count, ChartDrawStats* stats);
+
+private:
+  ChartMultiDrawArrays     multi_draw;
+  ChartVertexAttribDivisor divisor;
+  ChartDrawArraysInstanced draw_instanced;
+};
+
+// A layer in the buffers shared by all the layers of an engine: its levels
+// of detail one after another, each laid out bucket by bucket. Marks and
+// texts have level 0 only
+struct ChartLayerSlot {
+  std::vector<ChartIndex> levels;
+  std::vector<float> level_scales;
+  std::vector<int> level_firsts;
+  std::vector<int> level_counts;
+};
+
+// Every engine draws all the layers of its primitive type: the layers are
+// set together, slot i holding the i-th one, and a draw takes the slots to
+// show in drawing order. The visible buckets of them all go out in one
+// multi-draw call with the program state set once, lines, marks and
+// soundings go out as ChartQuads. Positions are 16-bit offsets within
+// ChartTiles, the batch is drawn in parts with the frame of their tile.
+// The constant uniforms of the programs are ChartEngine's
 class ChartAreaEngine : protected QGLFunctions
 {
 public:
@@ -21,9 +95,9 @@ public:
   void clearData();
 
   void setPatternTexture(GLuint tex_id, QVector2D dim);
-  void setData(S52AreaLayer* layer, S52Assets* assets, S52References* ref);
+  void setData(const QList<S52AreaLayer*>& layers, S52Assets* assets, S52References* ref);
 
-  void draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle);
+  void draw(ChartShaders* shaders, const ChartView& view, const std::vector<int>& visible, ChartDrawStats* stats);
 
 private:
   GLuint*   vbo_ids;
@@ -31,14 +105,10 @@ private:
   bool initialized;
   int point_count;
 
-  bool is_pattern_uniform;
-  QVector2D patternIdx;
-  QVector2D patternDim;
-
-  bool is_color_uniform;
-  int color_ind;
-
-  std::vector<float> color_table;
+  std::vector<ChartLayerSlot> layers;
+  ChartBatch batch;
+  ChartTiles tiles;
+  ChartMultiDrawArrays multi_draw;
 
   GLint  pattern_tex_id;
   QVector2D pattern_tex_dim;
@@ -55,25 +125,21 @@ public:
   void clearData();
 
   void setPatternTexture(GLuint tex_id, QVector2D dim);
-  void setData(S52LineLayer* layer, S52Assets* assets, S52References* ref);
+  void setData(const QList<S52LineLayer*>& layers, S52Assets* assets, S52References* ref);
 
-  void draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle);
+  void draw(ChartShaders* shaders, const ChartView& view, const std::vector<int>& visible, ChartDrawStats* stats);
 
 private:
   bool initialized;
   int point_count;
 
-  bool is_pattern_uniform;
-  QVector2D patternIdx;
-  QVector2D patternDim;
-
-  bool is_color_uniform;
-  int color_ind;
+  std::vector<ChartLayerSlot> layers;
+  ChartBatch batch;
+  ChartTiles tiles;
+  ChartQuads quads;
 
   GLuint*  vbo_ids;
 
-  std::vector<float> color_table;
-
   GLint    pattern_tex_id;
   QVector2D pattern_tex_dim;
 };
@@ -89,18 +155,19 @@ public:
   void clearData();
 
   void setPatternTexture(GLuint tex_id, QVector2D size);
-  void setData(S52MarkLayer* layer, S52Assets* assets, S52References* ref);
+  void setData(const QList<S52MarkLayer*>& layers, S52Assets* assets, S52References* ref);
 
-  void draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle);
+  void draw(ChartShaders* shaders, const ChartView& view, const std::vector<int>& visible, ChartDrawStats* stats);
 
 private:
   bool      initialized;
   int       point_count;
 
-  bool      is_pattern_uniform;
-  QVector2D patternOrigin;
-  QVector2D patternSize;
-  QVector2D patternPivot;
+  std::vector<ChartLayerSlot> layers;
+  ChartBatch batch;
+  ChartTiles tiles;
+  ChartQuads quads;
+
   GLuint*   vbo_ids;
 
   GLint     pattern_tex_id;
@@ -120,12 +187,18 @@ public:
   void setPatternTexture(GLuint tex_id, QVector2D size);
   void setData(S52SndgLayer* layer, S52Assets* assets, S52References* ref);
 
-  void draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle);
+  void draw(ChartShaders* shaders, const ChartView& view, ChartDrawStats* stats);
 
 private:
   bool      initialized;
   int       point_count;
 
+  // Buffers are laid out bucket by bucket, a draw covers the visible ones
+  ChartIndex index;
+  ChartBatch batch;
+  ChartTiles tiles;
+  ChartQuads quads;
+
   GLuint*   vbo_ids;
 
   GLint     pattern_tex_id;
@@ -143,17 +216,21 @@ public:
   void clearData();
 
   void setGlyphTexture(GLuint tex_id);
-  void setData(S52TextLayer* layer);
+  void setData(const QList<S52TextLayer*>& layers);
 
-  void draw(ChartShaders* shaders, QVector2D cur_coords, float scale, float angle);
+  void draw(ChartShaders* shaders, const ChartView& view, const std::vector<int>& visible, ChartDrawStats* stats);
 
 private:
   bool initialized;
   int point_count;
 
+  std::vector<ChartLayerSlot> layers;
+  ChartBatch batch;
+  ChartTiles tiles;
+  ChartMultiDrawArrays multi_draw;
+
   GLuint* vbo_ids;
   GLint   glyph_tex_id;
 };
 
-
 #endif // CHARTLAYERENGINES_H
@@ -169,6 +169,8 @@ bool ChartShaders::initChartAreaProgram() {
   area_uniform_locs[COMMON_UNIFORMS_SCALE]            = chart_area_program->uniformLocation("scale");
   area_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_ID]   = chart_area_program->uniformLocation("pattern_tex");
   area_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_DIM]  = chart_area_program->uniformLocation("assetdim");
+  area_uniform_locs[COMMON_UNIFORMS_TILE_ORIGIN]      = chart_area_program->uniformLocation("tile_origin");
+  area_uniform_locs[COMMON_UNIFORMS_TILE_STEP]        = chart_area_program->uniformLocation("tile_step");
 
   area_uniform_locs[AREA_UNIFORMS_COLOR_INDEX]        = chart_area_program->uniformLocation("u_color_index");
   area_uniform_locs[AREA_UNIFORMS_PATTERN_INDEX]      = chart_area_program->uniformLocation("u_tex_origin");
@@ -206,6 +208,8 @@ bool ChartShaders::initChartLineProgram() {
   line_uniform_locs[COMMON_UNIFORMS_SCALE]            = chart_line_program->uniformLocation("scale");
   line_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_ID]   = chart_line_program->uniformLocation("pattern_tex");
   line_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_DIM]  = chart_line_program->uniformLocation("assetdim");
+  line_uniform_locs[COMMON_UNIFORMS_TILE_ORIGIN]      = chart_line_program->uniformLocation("tile_origin");
+  line_uniform_locs[COMMON_UNIFORMS_TILE_STEP]        = chart_line_program->uniformLocation("tile_step");
 
   line_uniform_locs[LINE_UNIFORMS_COLOR_INDEX]        = chart_line_program->uniformLocation("u_color_index");
   line_uniform_locs[LINE_UNIFORMS_PATTERN_INDEX]      = chart_line_program->uniformLocation("u_tex_origin");
@@ -246,6 +250,8 @@ bool ChartShaders::initChartTextProgram() {
   text_uniform_locs[COMMON_UNIFORMS_SCALE]            = chart_text_program->uniformLocation("scale");
   text_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_ID]   = chart_text_program->uniformLocation("glyph_tex");
   text_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_DIM]  = chart_text_program->uniformLocation("pattern_tex_size");
+  text_uniform_locs[COMMON_UNIFORMS_TILE_ORIGIN]      = chart_text_program->uniformLocation("tile_origin");
+  text_uniform_locs[COMMON_UNIFORMS_TILE_STEP]        = chart_text_program->uniformLocation("tile_step");
 
   text_uniform_locs[TEXT_UNIFORMS_COLOR]              = chart_text_program->uniformLocation("color");
 
@@ -279,6 +285,8 @@ bool ChartShaders::initChartMarkProgram() {
   mark_uniform_locs[COMMON_UNIFORMS_SCALE]            = chart_mark_program->uniformLocation("scale");
   mark_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_ID]   = chart_mark_program->uniformLocation("pattern_tex_id");
   mark_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_DIM]  = chart_mark_program->uniformLocation("pattern_tex_size");
+  mark_uniform_locs[COMMON_UNIFORMS_TILE_ORIGIN]      = chart_mark_program->uniformLocation("tile_origin");
+  mark_uniform_locs[COMMON_UNIFORMS_TILE_STEP]        = chart_mark_program->uniformLocation("tile_step");
 
   mark_uniform_locs[MARK_UNIFORMS_SYMBOL_ORIGIN]      = chart_mark_program->uniformLocation("u_symbol_origin");
   mark_uniform_locs[MARK_UNIFORMS_SYMBOL_SIZE]        = chart_mark_program->uniformLocation("u_symbol_size");
@@ -316,6 +324,8 @@ bool ChartShaders::initChartSndgProgram() {
   sndg_uniform_locs[COMMON_UNIFORMS_SCALE]            = chart_sndg_program->uniformLocation("scale");
   sndg_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_ID]   = chart_sndg_program->uniformLocation("pattern_tex_id");
   sndg_uniform_locs[COMMON_UNIFORMS_PATTERN_TEX_DIM]  = chart_sndg_program->uniformLocation("pattern_tex_size");
+  sndg_uniform_locs[COMMON_UNIFORMS_TILE_ORIGIN]      = chart_sndg_program->uniformLocation("tile_origin");
+  sndg_uniform_locs[COMMON_UNIFORMS_TILE_STEP]        = chart_sndg_program->uniformLocation("tile_step");
 
   sndg_attribute_locs[SNDG_ATTRIBUTES_WORLD_COORDS]   = chart_sndg_program->attributeLocation("world_coords");
   sndg_attribute_locs[SNDG_ATTRIBUTES_VERTEX_ORDER]   = chart_sndg_program->attributeLocation("vertex_order");
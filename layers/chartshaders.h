@@ -10,7 +10,9 @@ typedef enum CHART_SHADER_COMMON_UNIFORMS
 , COMMON_UNIFORMS_SCALE           = 2
 , COMMON_UNIFORMS_PATTERN_TEX_ID  = 3
 , COMMON_UNIFORMS_PATTERN_TEX_DIM = 4
-, COMMON_UNIFORMS_COUNT           = 5
+, COMMON_UNIFORMS_TILE_ORIGIN     = 5
+, COMMON_UNIFORMS_TILE_STEP       = 6
+, COMMON_UNIFORMS_COUNT           = 7
 } CHART_SHADER_COMMON_UNIFORMS;
 
 
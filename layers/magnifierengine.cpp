@@ -1,13 +1,40 @@
 #include "magnifierengine.h"
+#include "../datasources/bearingring.h"
+
+#include <math.h>
+#include <string.h>
+
+static double const PI = acos(-1);
+
 
 MagnifierEngine::MagnifierEngine(const QSize& screen_size, const QMap<QString, QString>& params, QObject* parent) : QObject(parent), QGLFunctions() {
   _initialized = false;
+  _peleng_count = 0;
+  _peleng_len = 0;
+  _north = 0;
+  _has_data = false;
+  _tex_id = 0;
+
+  _ring = NULL;
+  _ring_cons = -1;
+
+  _prog = new QGLShaderProgram();
+  _pal = new RadarPalette();
+
   resize(screen_size, params);
 }
 
 MagnifierEngine::~MagnifierEngine() {
-  if (_initialized)
+  if (_initialized) {
     delete _fbo;
+    glDeleteTextures(1, &_tex_id);
+  }
+
+  if (_ring != NULL)
+    _ring->removeConsumer(_ring_cons);
+
+  delete _prog;
+  delete _pal;
 }
 
 void MagnifierEngine::resize(const QSize& screen_size, const QMap<QString, QString>& params) {
@@ -23,6 +50,32 @@ void MagnifierEngine::resize(const QSize& screen_size, const QMap<QString, QStri
   }
 }
 
+void MagnifierEngine::resizeData(uint pel_count, uint pel_len) {
+  _peleng_count = pel_count;
+  _peleng_len = pel_len;
+  _amps.assign(pel_count * pel_len, 0);
+  _has_data = false;
+
+  if (_initialized) {
+    glBindTexture(GL_TEXTURE_2D, _tex_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE8, _peleng_len, _peleng_count, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+}
+
+void MagnifierEngine::shiftNorth(uint north) {
+  _north = north;
+}
+
+void MagnifierEngine::setCursor(const QPointF& cursor, float radius) {
+  if (radius > 0)
+    _cursor = cursor * (_peleng_len / radius);
+}
+
+void MagnifierEngine::onBrightnessChanged(int br) {
+  _pal->setBrightness(br);
+}
+
 bool MagnifierEngine::init(const QGLContext* context) {
   if (_initialized)
     return false;
@@ -31,10 +84,130 @@ bool MagnifierEngine::init(const QGLContext* context) {
 
   _fbo = new QGLFramebufferObject(_size);
 
+  // Nearest samples, every magnified pixel shows one bearing and range cell
+  glGenTextures(1, &_tex_id);
+  glBindTexture(GL_TEXTURE_2D, _tex_id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE8, _peleng_len, _peleng_count, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, NULL);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  initShader();
+
   _initialized = true;
   return _initialized;
 }
 
+void MagnifierEngine::initShader() {
+  setlocale(LC_NUMERIC, "C");
+  _prog->addShaderFromSourceFile(QGLShader::Vertex, ":/res/shaders/magnifier.vert.glsl");
+  _prog->addShaderFromSourceFile(QGLShader::Fragment, ":/res/shaders/magnifier.frag.glsl");
+  setlocale(LC_ALL, "");
+
+  _prog->link();
+  _prog->bind();
+
+  _unif_locs[UNIF_CENTER]    = _prog->uniformLocation("center");
+  _unif_locs[UNIF_CELL_PX]   = _prog->uniformLocation("cell_pixels");
+  _unif_locs[UNIF_PEL_CNT]   = _prog->uniformLocation("pel_count");
+  _unif_locs[UNIF_BRG_FIRST] = _prog->uniformLocation("brg_first");
+  _unif_locs[UNIF_RNG_FIRST] = _prog->uniformLocation("rng_first");
+  _unif_locs[UNIF_FOOT]      = _prog->uniformLocation("foot_size");
+  _unif_locs[UNIF_TEX_SIZE]  = _prog->uniformLocation("tex_size");
+  _unif_locs[UNIF_PAL]       = _prog->uniformLocation("palette");
+  _unif_locs[UNIF_THR]       = _prog->uniformLocation("threshold");
+  _unif_locs[UNIF_POLAR]     = _prog->uniformLocation("polar");
+
+  _prog->release();
+}
+
+MagnifierFootprint MagnifierEngine::footprint(float x, float y, float w, float h, uint pel_count, uint pel_len) {
+  MagnifierFootprint fp = { 0, 0, 0, 0 };
+
+  float x0 = x - w / 2, x1 = x + w / 2;
+  float y0 = y - h / 2, y1 = y + h / 2;
+
+  // Nearest and farthest points of the window from the radar origin
+  float nx = qBound(x0, 0.f, x1);
+  float ny = qBound(y0, 0.f, y1);
+  float fx = qMax(fabsf(x0), fabsf(x1));
+  float fy = qMax(fabsf(y0), fabsf(y1));
+  float rmin = sqrtf(nx*nx + ny*ny);
+  float rmax = sqrtf(fx*fx + fy*fy);
+
+  // Pixels take the nearest range cell
+  if (rmin >= pel_len - 0.5f || pel_count == 0)
+    return fp;
+
+  fp.rng_first = static_cast<uint>(floorf(rmin));
+  fp.rng_count = qMin(pel_len - 1, static_cast<uint>(ceilf(rmax))) - fp.rng_first + 1;
+
+  if (x0 <= 0 && x1 >= 0 && y0 <= 0 && y1 >= 0) {
+    fp.brg_first = 0;
+    fp.brg_count = pel_count;
+    return fp;
+  }
+
+  // Seen from outside, the angular extremes of the window are at its corners
+  float center = atan2f(x, -y);
+  float dmin = 0, dmax = 0;
+  for (int i = 0; i < 4; i++) {
+    float cx = (i & 1) ? x1 : x0;
+    float cy = (i & 2) ? y1 : y0;
+    float d = atan2f(cx, -cy) - center;
+    d -= 2 * PI * floorf((d + PI) / (2 * PI));
+    dmin = qMin(dmin, d);
+    dmax = qMax(dmax, d);
+  }
+
+  float k = pel_count / (2 * PI);
+  int first = static_cast<int>(floorf((center + dmin) * k + 0.5f)) - 1;
+  int last  = static_cast<int>(floorf((center + dmax) * k + 0.5f)) + 1;
+
+  fp.brg_count = qMin(pel_count, static_cast<uint>(last - first + 1));
+  fp.brg_first = ((first % static_cast<int>(pel_count)) + pel_count) % pel_count;
+  return fp;
+}
+
+void MagnifierEngine::setRing(BearingRing* ring) {
+  if (_ring != NULL)
+    _ring->removeConsumer(_ring_cons);
+
+  _ring = ring;
+  _ring_cons = (ring != NULL) ? ring->addConsumer("magnifier") : -1;
+
+  if (_ring_cons < 0)
+    _ring = NULL;
+}
+
+void MagnifierEngine::readRing() {
+  if (_ring == NULL || _ring->bearingSize() != _peleng_len)
+    return;
+
+  _ring_amps.resize(RE_RING_BATCH * _peleng_len);
+
+  uint32_t first, n;
+  while ((n = _ring->readRun(_ring_cons, &first, &_ring_amps[0], RE_RING_BATCH)) > 0)
+    updateData(first, n, &_ring_amps[0]);
+}
+
+void MagnifierEngine::updateData(uint offset, uint count, GLfloat* amps) {
+  if (_amps.empty())
+    return;
+
+  for (uint i = 0; i < count; i++) {
+    GLubyte* dst = &_amps[((offset + i) % _peleng_count) * _peleng_len];
+    const GLfloat* src = &amps[i * _peleng_len];
+
+    for (uint j = 0; j < _peleng_len; j++)
+      dst[j] = static_cast<GLubyte>(qBound(0.f, src[j], 255.f));
+  }
+
+  _has_data = true;
+}
+
 void MagnifierEngine::update() {
   if (!_initialized)
     return;
@@ -53,6 +226,65 @@ void MagnifierEngine::update() {
   glLoadIdentity();
   glOrtho(0, _size.width(), _size.height(), 0, -1, 1 );
 
+  if (_has_data)
+    drawPolar();
+
+  drawBorder();
+
+  glMatrixMode( GL_PROJECTION );
+  glPopMatrix();
+
+  _fbo->release();
+}
+
+void MagnifierEngine::drawPolar() {
+  float w = _size.width();
+  float h = _size.height();
+
+  MagnifierFootprint fp = footprint(_cursor.x(), _cursor.y(), w / MAG_CELL_PIXELS, h / MAG_CELL_PIXELS, _peleng_count, _peleng_len);
+  if (fp.rng_count == 0)
+    return;
+
+  // Only the bearings and range cells under the window go to the texture
+  _upload.resize(fp.brg_count * fp.rng_count);
+  for (uint i = 0; i < fp.brg_count; i++) {
+    uint brg = (fp.brg_first + i + _peleng_count - _north) % _peleng_count;
+    memcpy(&_upload[i * fp.rng_count], &_amps[brg * _peleng_len + fp.rng_first], fp.rng_count);
+  }
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, _tex_id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fp.rng_count, fp.brg_count, GL_LUMINANCE, GL_UNSIGNED_BYTE, _upload.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  _prog->bind();
+
+  glUniform2f(_unif_locs[UNIF_CENTER], _cursor.x(), _cursor.y());
+  glUniform1f(_unif_locs[UNIF_CELL_PX], MAG_CELL_PIXELS);
+  glUniform1f(_unif_locs[UNIF_PEL_CNT], _peleng_count);
+  glUniform1f(_unif_locs[UNIF_BRG_FIRST], fp.brg_first);
+  glUniform1f(_unif_locs[UNIF_RNG_FIRST], fp.rng_first);
+  glUniform2f(_unif_locs[UNIF_FOOT], fp.rng_count, fp.brg_count);
+  glUniform2f(_unif_locs[UNIF_TEX_SIZE], _peleng_len, _peleng_count);
+  glUniform3fv(_unif_locs[UNIF_PAL], 16*3, _pal->getPalette());
+  glUniform1f(_unif_locs[UNIF_THR], 4);
+  glUniform1i(_unif_locs[UNIF_POLAR], 0);
+
+  // Every pixel of the window looks its bearing and range cell up in the footprint
+  glBegin(GL_QUADS);
+    glTexCoord2f(-w/2, -h/2); glVertex2f(0.f, 0.f);
+    glTexCoord2f( w/2, -h/2); glVertex2f(w, 0.f);
+    glTexCoord2f( w/2,  h/2); glVertex2f(w, h);
+    glTexCoord2f(-w/2,  h/2); glVertex2f(0.f, h);
+  glEnd();
+
+  _prog->release();
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void MagnifierEngine::drawBorder() {
   glShadeModel( GL_FLAT );
 
   glLineWidth(1.f);
@@ -78,9 +310,4 @@ void MagnifierEngine::update() {
     glVertex2f(0.f, _size.height()/2.0f);
     glVertex2f(_size.width(), _size.height()/2.0f);
   glEnd();
-
-  glMatrixMode( GL_PROJECTION );
-  glPopMatrix();
-
-  _fbo->release();
 }
@@ -1,10 +1,24 @@
 #ifndef MAGNIFIERENGINE_H
 #define MAGNIFIERENGINE_H
 
+#include <vector>
+
 #include <QtOpenGL/QGLFunctions>
 #include <QtOpenGL/QGLFramebufferObject>
 #include <QtOpenGL/QGLShaderProgram>
 
+#include "radarengine.h"
+
+#define MAG_CELL_PIXELS 2  // Magnifier pixels per radar range cell
+
+// Polar region of the radar data covered by the magnifier window
+struct MagnifierFootprint {
+  uint brg_first;   // Display bearing, counted clockwise from up
+  uint brg_count;
+  uint rng_first;   // Range cell
+  uint rng_count;
+};
+
 class MagnifierEngine : public QObject, protected QGLFunctions {
   Q_OBJECT
 public:
@@ -18,16 +32,60 @@ public:
   bool init     (const QGLContext* context);
   void resize   (const QSize& screen_size, const QMap<QString, QString>& params);
 
+  void resizeData (uint pel_count, uint pel_len);
+  void shiftNorth (uint north);
+
+  // Cursor relative to the radar origin in display pixels, radius is the
+  // display size of the full range
+  void setCursor  (const QPointF& cursor, float radius);
+
+  // Bearings come from a cursor of the ring, readRing() takes the ones
+  // published since the last call and runs every frame even when hidden
+  void setRing    (BearingRing* ring);
+  void readRing   ();
+
+  // Bearings and range cells under a window of w x h pixels centred at
+  // (x, y) range cells from the radar origin, y down
+  static MagnifierFootprint footprint(float x, float y, float w, float h, uint pel_count, uint pel_len);
+
 public slots:
   void update();
+  void onBrightnessChanged(int br);
 
 private:
+  void updateData(uint offset, uint count, GLfloat* amps);
+
+  void initShader();
+  void drawPolar();
+  void drawBorder();
+
   bool _initialized;
 
   QSize _size;
   QPointF _position;
 
   QGLFramebufferObject* _fbo;
+
+  // Radar data at native resolution, one byte per range cell
+  uint _peleng_count, _peleng_len;
+  uint _north;
+  bool _has_data;
+  std::vector<GLubyte> _amps;
+  std::vector<GLubyte> _upload;   // Footprint packed for the texture
+
+  BearingRing*         _ring;
+  int                  _ring_cons;
+  std::vector<GLfloat> _ring_amps;
+
+  QPointF _cursor;                // Range cells from the radar origin
+
+  GLuint _tex_id;                 // pel_len x pel_count, only the footprint is uploaded
+  QGLShaderProgram* _prog;
+  RadarPalette* _pal;
+
+  enum { UNIF_CENTER = 0, UNIF_CELL_PX = 1, UNIF_PEL_CNT = 2, UNIF_BRG_FIRST = 3, UNIF_RNG_FIRST = 4
+       , UNIF_FOOT = 5, UNIF_TEX_SIZE = 6, UNIF_PAL = 7, UNIF_THR = 8, UNIF_POLAR = 9, UNIF_CNT = 10 } ;
+  GLuint _unif_locs[UNIF_CNT];
 };
 
 #endif // MAGNIFIERENGINE_H
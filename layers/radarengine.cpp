@@ -1,4 +1,5 @@
 #include "radarengine.h"
+#include "../datasources/bearingring.h"
 
 #include <algorithm>
 #include <math.h>
@@ -100,6 +101,9 @@ RadarEngine::RadarEngine(uint pel_count, uint pel_len) {
   _initialized = false;
   _has_data = false;
 
+  _ring = NULL;
+  _ring_cons = -1;
+
   resizeTexture(256);
   resizeData(pel_count, pel_len);
 
@@ -122,10 +126,48 @@ RadarEngine::~RadarEngine() {
     delete _fbo;
   }
 
+  if (_ring != NULL)
+    _ring->removeConsumer(_ring_cons);
+
   delete _prog;
 }
 
 
+void RadarEngine::setRing(BearingRing* ring) {
+  if (_ring != NULL)
+    _ring->removeConsumer(_ring_cons);
+
+  _ring = ring;
+  _ring_cons = (ring != NULL) ? ring->addConsumer("display") : -1;
+
+  if (_ring_cons < 0)
+    _ring = NULL;
+}
+
+
+void RadarEngine::readRing() {
+  if (_ring == NULL || _ring->bearingSize() != _peleng_len)
+    return;
+
+  _ring_amps.resize(RE_RING_BATCH * _peleng_len);
+
+  uint32_t first, n;
+  uint total = 0;
+  while ((n = _ring->readRun(_ring_cons, &first, &_ring_amps[0], RE_RING_BATCH)) > 0) {
+    if (first >= _peleng_count)
+      continue;
+
+    n = qMin(n, _peleng_count - first);
+    updateData(first, n, &_ring_amps[0]);
+    total += n;
+  }
+
+  // A whole revolution came in since the last frame
+  if (_has_data && total >= _peleng_count)
+    _draw_circle = true;
+}
+
+
 void RadarEngine::onBrightnessChanged(int br) {
   _pal->setBrightness(br);
 }
@@ -346,6 +388,8 @@ void RadarEngine::updateTexture() {
   if (!_initialized)
     return;
 
+  readRing();
+
   if (!_has_data) {
     clearTexture();
     return;
@@ -9,6 +9,10 @@
 #include <QtOpenGL/QGLFramebufferObject>
 #include <QtOpenGL/QGLShaderProgram>
 
+class BearingRing;
+
+#define RE_RING_BATCH 256   // Bearings copied from the ring per buffer update
+
 // Класс для расчета радарной палитры
 class RadarPalette {
 public:
@@ -64,6 +68,9 @@ public:
 
   inline uint  pelengCount() const      { return _peleng_count; }
 
+  // Bearings are read from a cursor of the ring on every updateTexture()
+  void setRing(BearingRing* ring);
+
 public slots:
   void clearTexture();
   void clearData();
@@ -71,9 +78,11 @@ public slots:
   void onBrightnessChanged(int br);
 
   void updateTexture();
-  void updateData(uint offset, uint count, GLfloat* amps);
 
 private:
+  void readRing();
+  void updateData(uint offset, uint count, GLfloat* amps);
+
   void initShader();
   void drawPelengs(uint first, uint last);
 
@@ -82,6 +91,10 @@ private:
   bool _initialized;
   bool _has_data;
 
+  BearingRing*         _ring;
+  int                  _ring_cons;
+  std::vector<GLfloat> _ring_amps;
+
   // Radar parameters
   QPoint  _center;
   uint    _north;
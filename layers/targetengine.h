@@ -10,9 +10,14 @@
 #include <QGLFunctions>
 
 
+// Sources a published target was seen by
+#define TARGET_SRC_RADAR  1
+#define TARGET_SRC_AIS    2
+
 struct RadarTarget {
 public:
   RadarTarget() {
+    Sources = 0;
     Lost = false;
     Latitude = 0;
     Longtitude = 0;
@@ -23,6 +28,7 @@ public:
   }
 
   RadarTarget(const RadarTarget& o) {
+    Sources = o.Sources;
     Lost = o.Lost;
     Latitude = o.Latitude;
     Longtitude = o.Longtitude;
@@ -34,6 +40,7 @@ public:
 
   ~RadarTarget() { }
 
+  int Sources; // TARGET_SRC_* bits, 0 if not known
   bool Lost;
   float Latitude, Longtitude;
   float Heading, Rotation;
@@ -63,6 +63,7 @@ MainWindow::MainWindow(QWidget *parent) : QWidget(parent) {
 
   _pult_driver = new BoardPultController(this);
   _target_ds = new TargetDataSource();
+  _target_fusion = new TargetFusion();
   _radar_ds = new RadarDataSource();
   _ship_ds = new ShipDataSource();
   _chart_mngr = new ChartManager();
@@ -84,17 +85,84 @@ MainWindow::MainWindow(QWidget *parent) : QWidget(parent) {
   rx.setPattern("--radar-device");
   argpos = args.indexOf(rx);
 
-  if ((argpos >= 0) && (argpos < args.count() - 1))
+  // Slave display: radar video from another console, --cat240-in <host:port>
+  int netpos = args.indexOf(QRegExp("--cat240-in"));
+
+  if ((netpos >= 0) && (netpos < args.count() - 1))
+    _radar_ds->start_cat240(args.at(netpos + 1).toStdString().c_str());
+  else if ((argpos >= 0) && (argpos < args.count() - 1))
     _radar_ds->start(args.at(argpos + 1).toStdString().c_str());
   else {
     rx.setPattern("--use-dump");
     argpos = args.indexOf(rx);
     if(argpos >= 0)
       _radar_ds->start_dump();
-    else
+    else {
+      // Synthetic radar picture for load testing: --scene <name>[:seed]
+      int scenepos = args.indexOf(QRegExp("--scene"));
+      if ((scenepos >= 0) && (scenepos < args.count() - 1)) {
+        QStringList vals = args.at(scenepos + 1).split(':');
+        uint seed = (vals.count() > 1) ? vals.at(1).toUInt() : 1;
+        if (!_radar_ds->setScene(vals.at(0).toStdString().c_str(), seed))
+          qDebug() << "Unknown radar scene" << vals.at(0);
+      }
       _radar_ds->start();
+    }
   }
 
+  rx.setPattern("--auto-gain");
+  bool autoGain = (args.indexOf(rx) >= 0);
+  _radar_ds->setAutoGain(autoGain);
+
+  rx.setPattern("--land-mask");
+  _radar_ds->setLandMask(args.indexOf(rx) >= 0);
+
+  // Guard zones: --guard-sector <brg1,brg2,rng1,rng2> (degrees, miles)
+  //              --guard-polygon <x1,y1,x2,y2,...> (miles from own ship)
+  std::vector<GuardZone> zones;
+  for (int i = 0; i < args.count() - 1; i++) {
+    QStringList vals = args.at(i + 1).split(',');
+    GuardZone zone;
+
+    if (args.at(i) == "--guard-sector" && vals.count() == 4) {
+      zone.type     = GuardZone::GZ_SECTOR;
+      zone.brg_from = vals[0].toFloat();
+      zone.brg_to   = vals[1].toFloat();
+      zone.rng_from = vals[2].toFloat();
+      zone.rng_to   = vals[3].toFloat();
+      zones.push_back(zone);
+    } else if (args.at(i) == "--guard-polygon" && vals.count() >= 6 && vals.count() % 2 == 0) {
+      zone.type = GuardZone::GZ_POLYGON;
+      for (int j = 0; j < vals.count(); j++)
+        zone.poly.push_back(vals[j].toFloat());
+      zones.push_back(zone);
+    }
+  }
+
+  if (!zones.empty())
+    _radar_ds->setGuardZones(zones);
+
+  _radar_rec = new BearingRecorder(_radar_ds->bearingRing());
+
+  rx.setPattern("--record-bearings");
+  argpos = args.indexOf(rx);
+  if ((argpos >= 0) && (argpos < args.count() - 1))
+    _radar_rec->start(args.at(argpos + 1).toStdString().c_str());
+
+  // Radar video to the ship network: --cat240-out <host:port> [--cat240-4bit] [--cat240-packbits]
+  _cat240_out = new Cat240Sender(_radar_ds->bearingRing());
+  _cat240_out->setRange(_radar_ds->getCurrentScale().getCurScale()->len);
+  connect(_radar_ds, SIGNAL(scaleChanged(RadarScale)), this, SLOT(onRadarScaleChanged(RadarScale)));
+
+  if (args.contains("--cat240-4bit"))
+    _cat240_out->setResolution(CAT240_RES_4BIT);
+  _cat240_out->setCompression(args.contains("--cat240-packbits"));
+
+  rx.setPattern("--cat240-out");
+  argpos = args.indexOf(rx);
+  if ((argpos >= 0) && (argpos < args.count() - 1))
+    _cat240_out->start(args.at(argpos + 1).toStdString().c_str());
+
   qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "RadarDS init finish";
 
   rx.setPattern("--nmea-port");
@@ -154,11 +222,19 @@ MainWindow::MainWindow(QWidget *parent) : QWidget(parent) {
   _vd_ctrl = new VdController(this);
 
   connect(_pult_driver, SIGNAL(gain_changed(int)), _gain_ctrl, SLOT(onValueChanged(int)));
+  if (autoGain)
+    connect(_radar_ds, SIGNAL(gainEstimated(int)), _gain_ctrl, SLOT(onValueChanged(int)));
   connect(_pult_driver, SIGNAL(wave_changed(int)), _water_ctrl, SLOT(onValueChanged(int)));
   connect(_pult_driver, SIGNAL(rain_changed(int)), _rain_ctrl, SLOT(onValueChanged(int)));
 
   // gain_slot used only for simulated Control Panel Unit. Must be removed at finish build
   connect(wgtButtonPanel, SIGNAL(gainChanged(int)), _radar_ds, SLOT(setGain(int)));
+  connect(wgtButtonPanel, SIGNAL(waterChanged(int)), _radar_ds, SLOT(setWave(int)));
+  connect(wgtButtonPanel, SIGNAL(rainChanged(int)), _radar_ds, SLOT(setRain(int)));
+
+  // Sea and rain clutter suppression is done in software
+  connect(_pult_driver, SIGNAL(wave_changed(int)), _radar_ds, SLOT(setWave(int)));
+  connect(_pult_driver, SIGNAL(rain_changed(int)), _radar_ds, SLOT(setRain(int)));
 
   connect(wgtRLI, SIGNAL(initialized()), this, SLOT(onRLIWidgetInitialized()));
   startTimer(33);
@@ -171,6 +247,12 @@ MainWindow::~MainWindow() {
   delete _pult_driver;
 
   delete _target_ds;
+  delete _target_fusion;
+  delete _radar_rec;
+  delete _cat240_out;
+  // The engines hold cursors of the ring
+  wgtRLI->radarEngine()->setRing(NULL);
+  wgtRLI->magnifierEngine()->setRing(NULL);
   delete _radar_ds;
   delete _chart_mngr;
 
@@ -233,15 +315,35 @@ void MainWindow::handleSigInt() {
 #endif // !Q_OS_WIN
 
 
+void MainWindow::onNewChart(const QString& name) {
+  S52Chart* chart = _chart_mngr->getChart(name);
+  if (chart == NULL)
+    return;
+
+  S52AreaLayer* land = chart->getAreaLayer("LNDARE");
+  if (land != NULL)
+    _radar_ds->addLandAreas(land->triangles);
+}
+
+void MainWindow::onRadarScaleChanged(RadarScale scale) {
+  _cat240_out->setRange(scale.getCurScale()->len);
+}
+
 void MainWindow::onRLIWidgetInitialized() {
   setCursor(QCursor(QPixmap("://res/cursors/cross_72dpi_12px_r0_g128_b255.png")));
 
   qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Connect radar to datasource";
-  connect(_radar_ds, SIGNAL(updateData(uint, uint, GLfloat*)), wgtRLI->radarEngine(), SLOT(updateData(uint, uint, GLfloat*)));
+  wgtRLI->radarEngine()->setRing(_radar_ds->bearingRing());
+  wgtRLI->magnifierEngine()->setRing(_radar_ds->bearingRing());
   connect(_radar_ds, SIGNAL(scaleChanged(RadarScale)), _scle_ctrl, SLOT(onScaleChanged(RadarScale)));
+  connect(_radar_ds, SIGNAL(guardAlarm(int, bool)), _dngr_ctrl, SLOT(onGuardAlarm(int, bool)));
   connect(_radar_ds, SIGNAL(scaleChanged(RadarScale)), wgtRLI, SLOT(onScaleChanged(RadarScale)));
   wgtRLI->onScaleChanged(_radar_ds->getCurrentScale());
 
+  // Per-bearing azimuth stabilisation instead of turning the whole picture: --azimuth-stab
+  connect(_radar_ds, SIGNAL(stabilisationChanged(bool)), wgtRLI, SLOT(onRadarStabilised(bool)));
+  _radar_ds->setStabilisation(qApp->arguments().contains("--azimuth-stab"));
+
   connect(wgtRLI, SIGNAL(displayVNDistance(float, const char *)), _vd_ctrl, SLOT(display_distance(float, const char *)));
   connect(wgtRLI, SIGNAL(displaydBRG(float, float)), _vn_ctrl, SLOT(display_brg(float, float)));
 
@@ -288,15 +390,23 @@ void MainWindow::onRLIWidgetInitialized() {
   connect( wgtRLI->targetEngine(), SIGNAL(selectedTargetUpdated(QString, RadarTarget))
          , _trgs_ctrl, SLOT(updateTarget(QString, RadarTarget)));
 
+  // Radar tracks and AIS targets reach the display through the fusion
   connect(_target_ds, SIGNAL(updateTarget(QString, RadarTarget))
+         , _target_fusion, SLOT(updateRadar(QString, RadarTarget)));
+  connect(_target_fusion, SIGNAL(updateTarget(QString, RadarTarget))
          , wgtRLI->targetEngine(), SLOT(updateTarget(QString, RadarTarget)));
+  connect(_target_fusion, SIGNAL(deleteTarget(QString))
+         , wgtRLI->targetEngine(), SLOT(deleteTarget(QString)));
 
 
+  _target_fusion->start();
   _target_ds->start();
 
 
   connect(_ship_ds, SIGNAL(coordsUpdated(QVector2D))
          , wgtRLI, SLOT(onCoordsChanged(QVector2D)));
+  connect(_ship_ds, SIGNAL(coordsUpdated(QVector2D))
+         , _radar_ds, SLOT(updateCoords(QVector2D)));
 
   _ship_ds->start();
 
@@ -305,6 +415,7 @@ void MainWindow::onRLIWidgetInitialized() {
 
 
   connect(_chart_mngr, SIGNAL(new_chart_available(QString)), wgtRLI, SLOT(new_chart(QString)));
+  connect(_chart_mngr, SIGNAL(new_chart_available(QString)), this, SLOT(onNewChart(QString)));
   _chart_mngr->loadCharts();
 
   qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Setup menu signals";
@@ -312,6 +423,7 @@ void MainWindow::onRLIWidgetInitialized() {
   connect( wgtRLI->menuEngine(), SIGNAL(languageChanged(QByteArray)), wgtRLI->infoEngine(), SLOT(onLanguageChanged(QByteArray)) );
   connect( wgtRLI->menuEngine(), SIGNAL(languageChanged(QByteArray)), wgtRLI->menuEngine(), SLOT(onLanguageChanged(QByteArray)) );
   connect( wgtRLI->menuEngine(), SIGNAL(radarBrightnessChanged(int)), wgtRLI->radarEngine(), SLOT(onBrightnessChanged(int)) );
+  connect( wgtRLI->menuEngine(), SIGNAL(radarBrightnessChanged(int)), wgtRLI->magnifierEngine(), SLOT(onBrightnessChanged(int)) );
 
 
   connect( wgtRLI->menuEngine(), SIGNAL(startRouteEdit()), wgtRLI, SLOT(onStartRouteEdit()) );
@@ -346,7 +458,7 @@ void MainWindow::onRLIWidgetInitialized() {
 
 
   // Start NMEA processor
-  connect(_nmeaprc, SIGNAL(updateTarget(QString, RadarTarget)), wgtRLI->targetEngine(), SLOT(updateTarget(QString, RadarTarget)));
+  connect(_nmeaprc, SIGNAL(updateTarget(QString, RadarTarget)), _target_fusion, SLOT(updateAis(QString, RadarTarget)));
   connect(_nmeaprc, SIGNAL(updateHdgGyro(float)), _crse_ctrl, SLOT(course_changed(float)));
   connect(_nmeaprc, SIGNAL(updateHdgGyro(float)), _radar_ds, SLOT(updateHeading(float)));
   connect(_nmeaprc, SIGNAL(updateHdgGyro(float)), wgtRLI, SLOT(onHeadingChanged(float)));
@@ -14,7 +14,10 @@
 #include "s52/chartmanager.h"
 #include "datasources/boardpultcontroller.h"
 #include "datasources/targetdatasource.h"
+#include "datasources/targetfusion.h"
 #include "datasources/radardatasource.h"
+#include "datasources/bearingrecorder.h"
+#include "datasources/cat240sender.h"
 #include "datasources/shipdatasource.h"
 #include "datasources/infocontrollers.h"
 #include "datasources//radarscale.h"
@@ -48,6 +51,8 @@ private slots:
 
   void onClose();
   void onRLIWidgetInitialized();
+  void onNewChart(const QString& name);
+  void onRadarScaleChanged(RadarScale scale);
 
 private:
   void setupInfoBlock(InfoBlockController* ctrl, const RLIPanelInfo& panelInfo);
@@ -92,7 +97,10 @@ private:
   // Источники данных
   ChartManager* _chart_mngr;
   TargetDataSource* _target_ds;
+  TargetFusion* _target_fusion;
   RadarDataSource* _radar_ds;
+  BearingRecorder* _radar_rec;
+  Cat240Sender* _cat240_out;
   ShipDataSource* _ship_ds;
 
   QSet<int> pressedKeys;
@@ -1,12 +1,15 @@
 #version 120
 
+// Position in 16-bit lat/lon steps from the tile origin
 attribute vec2	coords;
 attribute float color_index;
 attribute vec2	tex_origin;
 attribute vec2	tex_dim;
 
 uniform float	north;
-uniform vec2	center;
+// Tile origin in meters east and south of the center, meters of a lon and a lat step
+uniform vec2	tile_origin;
+uniform vec2	tile_step;
 uniform float	scale;
 uniform vec2  assetdim;
 
@@ -22,13 +25,10 @@ varying vec2	v_inner_texcoords;
 varying float v_use_tex_color;
 
 void main() {
-  float lat_rads = radians(center.x);
-
-  float y_m = -6378137*radians(coords.x - center.x);
-  float x_m = 6378137*cos(lat_rads)*radians(coords.y - center.y);
+  vec2 pos_m = tile_origin + tile_step * coords.yx;
 
   // screen position
-  vec2 pix_pos = vec2(x_m, y_m) / scale;
+  vec2 pix_pos = pos_m / scale;
   gl_Position = gl_ProjectionMatrix * gl_ModelViewMatrix  * vec4(pix_pos, 0, 1);
 
   if (u_tex_dim.r == -1) {
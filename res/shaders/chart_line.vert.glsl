@@ -1,5 +1,6 @@
 #version 120
 
+// Segment ends in 16-bit lat/lon steps from the tile origin
 attribute vec2	coords1;
 attribute vec2	coords2;
 attribute float dist;
@@ -9,7 +10,9 @@ attribute vec2	tex_dim;
 attribute float color_index;
 
 uniform float	north;
-uniform vec2	center;
+// Tile origin in meters east and south of the center, meters of a lon and a lat step
+uniform vec2	tile_origin;
+uniform vec2	tile_step;
 uniform float	scale;
 uniform vec2  assetdim;
 
@@ -27,18 +30,13 @@ varying vec2	v_inner_texcoords;
 varying float v_use_tex_color;
 
 void main() {
-  float lat_rads = radians(center.x);
-
-  float y1_m = -6378137*radians(coords1.x - center.x);
-  float y2_m = -6378137*radians(coords2.x - center.x);
-
-  float x1_m = 6378137*cos(lat_rads)*radians(coords1.y - center.y);
-  float x2_m = 6378137*cos(lat_rads)*radians(coords2.y - center.y);
+  vec2 pos1_m = tile_origin + tile_step * coords1.yx;
+  vec2 pos2_m = tile_origin + tile_step * coords2.yx;
 
   // screen position
   float pix_per_meter = 1 / scale;
-  vec2 pos1_pix = vec2(x1_m, y1_m) / scale;
-  vec2 pos2_pix = vec2(x2_m, y2_m) / scale;
+  vec2 pos1_pix = pos1_m / scale;
+  vec2 pos2_pix = pos2_m / scale;
 
 
   vec2 tan_pix = pos2_pix - pos1_pix;
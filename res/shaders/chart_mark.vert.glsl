@@ -1,6 +1,6 @@
 #version 120
 
-// World position lat/lon in degrees
+// World position in 16-bit lat/lon steps from the tile origin
 attribute vec2	world_coords;
 // Quad vertex order (1 - bottom left, 2 - boottom right, 3 - top right, 4 - top left)
 attribute float vertex_order;
@@ -13,8 +13,9 @@ attribute vec2	symbol_pivot;
 
 // Angle to north
 uniform float   north;
-// Chart center position lat/lon in degrees
-uniform vec2    center;
+// Tile origin in meters east and south of the center, meters of a lon and a lat step
+uniform vec2    tile_origin;
+uniform vec2    tile_step;
 // meters/pixel
 uniform float   scale;
 
@@ -31,13 +32,10 @@ varying vec2	v_texcoords;
 varying vec4	v_color;
 
 void main() {
-  float lat_rads = radians(center.x);
-
-  float y_m = -6378137*radians(world_coords.x - center.x);
-  float x_m = 6378137*cos(lat_rads)*radians(world_coords.y - center.y);
+  vec2 pos_m = tile_origin + tile_step * world_coords.yx;
 
   // screen position
-  vec2 pos_pix = vec2(x_m, y_m) / scale;
+  vec2 pos_pix = pos_m / scale;
 
   // Variables to store symbol parameters
   vec2 origin, size, pivot;
@@ -1,6 +1,6 @@
 #version 120
 
-// World position lat/lon in degrees
+// World position in 16-bit lat/lon steps from the tile origin
 attribute vec2	world_coords;
 // Quad vertex order (1 - bottom left, 2 - boottom right, 3 - top right, 4 - top left)
 attribute float vertex_order;
@@ -16,8 +16,9 @@ attribute vec2	symbol_pivot;
 
 // Angle to north
 uniform float   north;
-// Chart center position lat/lon in degrees
-uniform vec2    center;
+// Tile origin in meters east and south of the center, meters of a lon and a lat step
+uniform vec2    tile_origin;
+uniform vec2    tile_step;
 // meters / pixel
 uniform float   scale;
 
@@ -27,13 +28,10 @@ uniform vec2  pattern_tex_size;
 varying vec2	v_texcoords;
 
 void main() {
-  float lat_rads = radians(center.x);
-
-  float y_m = -6378137*radians(world_coords.x - center.x);
-  float x_m = 6378137*cos(lat_rads)*radians(world_coords.y - center.y);
+  vec2 pos_m = tile_origin + tile_step * world_coords.yx;
 
   // screen position
-  vec2 pos_pix = vec2(x_m, y_m) / scale;
+  vec2 pos_pix = pos_m / scale;
   pos_pix = pos_pix + vec2(symbol_order * 8 - symbol_count * 4, symbol_frac * -4);
 
   // Variables to store symbol parameters
@@ -1,6 +1,6 @@
 #version 120
 
-// World position lat/lon in degrees
+// World position in 16-bit lat/lon steps from the tile origin
 attribute vec2	world_coords;
 // Character int value and order in text line
 attribute float	char_order;
@@ -8,8 +8,9 @@ attribute float	char_val;
 
 // Angle to north
 uniform float   north;
-// Chart center position lat/lon in degrees
-uniform vec2    center;
+// Tile origin in meters east and south of the center, meters of a lon and a lat step
+uniform vec2    tile_origin;
+uniform vec2    tile_step;
 // meters / pixel
 uniform float   scale;
 
@@ -22,13 +23,10 @@ varying float  v_char_val;
 
 
 void main() {
-  float lat_rads = radians(center.x);
-
-  float y_m = -6378137*radians(world_coords.x - center.x);
-  float x_m = 6378137*cos(lat_rads)*radians(world_coords.y - center.y);
+  vec2 pos_m = tile_origin + tile_step * world_coords.yx;
 
   // screen position
-  vec2 pos_pix = vec2(x_m, y_m) / scale;
+  vec2 pos_pix = pos_m / scale;
 
 
   gl_Position = gl_ProjectionMatrix * gl_ModelViewMatrix  * vec4(pos_pix.x + char_order * 12.0, pos_pix.y, 0, 1);
@@ -0,0 +1,35 @@
+#version 120
+
+varying vec2 win_pos;
+
+uniform sampler2D polar;      // Footprint: range cells along x, bearings along y
+uniform vec2  center;         // Window centre in range cells from the radar origin, y down
+uniform float cell_pixels;
+uniform float pel_count;
+uniform float brg_first;
+uniform float rng_first;
+uniform vec2  foot_size;      // Range cells and bearings of the footprint
+uniform vec2  tex_size;
+
+uniform vec3 palette[16];
+uniform float threshold;
+
+void main() {
+  vec2 p = center + win_pos / cell_pixels;
+
+  // Nearest bearing and range cell as in the radar coordinate table
+  float brg = floor(atan(p.x, -p.y) * pel_count / 6.28318530718 + 0.5);
+  float row = mod(brg - brg_first, pel_count);
+  float col = floor(length(p) + 0.5) - rng_first;
+
+  float norm_amp = 0.0;
+  if (col >= 0.0 && col < foot_size.x && row < foot_size.y) {
+    float amp = texture2D(polar, vec2((col + 0.5) / tex_size.x, (row + 0.5) / tex_size.y)).r * 255.0;
+    norm_amp = floor(amp / 16.0);
+  }
+
+  if (norm_amp < threshold)
+    norm_amp = 0.0;
+
+  gl_FragColor = vec4(palette[int(norm_amp)] / 255.0, 1.0);
+}
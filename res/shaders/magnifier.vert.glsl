@@ -0,0 +1,9 @@
+#version 120
+
+varying vec2 win_pos;
+
+void main() {
+  // Pixels from the window centre, y down
+  win_pos = gl_MultiTexCoord0.xy;
+  gl_Position = gl_ProjectionMatrix * gl_ModelViewMatrix * gl_Vertex;
+}
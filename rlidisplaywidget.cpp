@@ -23,6 +23,7 @@ RLIDisplayWidget::RLIDisplayWidget(QWidget *parent) : QGLWidget(parent) {
 
   _menuEngine = new MenuEngine(screen_size, layout->menu, this);
   _magnifierEngine = new MagnifierEngine(screen_size, layout->magnifier, this);
+  _magnifierEngine->resizeData(8192, 800);
 
   _targetEngine = new TargetEngine();
   _routeEngine = new RouteEngine();
@@ -36,6 +37,7 @@ RLIDisplayWidget::RLIDisplayWidget(QWidget *parent) : QGLWidget(parent) {
   _initialized = false;
   _route_edition = false;
   _is_magnifier_visible = false;
+  _radar_stabilised = false;
 }
 
 RLIDisplayWidget::~RLIDisplayWidget() {
@@ -87,8 +89,17 @@ void RLIDisplayWidget::onHeadingChanged(float hdg) {
   _controlsEngine->setVnP(hdg);
   _maskEngine->setAngleShift(hdg);
 
-  if (hdg >= 0 && hdg <= 360) {
+  if (!_radar_stabilised && hdg >= 0 && hdg <= 360) {
     _radarEngine->shiftNorth(static_cast<uint>((hdg*_radarEngine->pelengCount())/360.f));
+    _magnifierEngine->shiftNorth(static_cast<uint>((hdg*_radarEngine->pelengCount())/360.f));
+  }
+}
+
+void RLIDisplayWidget::onRadarStabilised(bool on) {
+  _radar_stabilised = on;
+  if (on) {
+    _radarEngine->shiftNorth(0);
+    _magnifierEngine->shiftNorth(0);
   }
 }
 
@@ -284,7 +295,7 @@ void RLIDisplayWidget::paintGL() {
 
   QRectF radarRect(-radar_rad, -radar_rad, 2*radar_rad, 2*radar_rad);
 
-  fillRectWithTexture(radarRect, _chartEngine->getTextureId());
+  fillRectWithTexture(radarRect, _chartEngine->getTextureId(), _chartEngine->getTextureRect());
   fillRectWithTexture(radarRect, _radarEngine->getTextureId());
 
   glMatrixMode( GL_MODELVIEW );
@@ -345,7 +356,14 @@ void RLIDisplayWidget::paintGL() {
   _maskEngine->update();
 
   _menuEngine->update();
-  _magnifierEngine->update();
+
+  // Magnified region under the cursor, from the polar data
+  _magnifierEngine->readRing();
+  if (_is_magnifier_visible) {
+    QPointF cursor = _controlsEngine->getCursorPos() - _controlsEngine->getCenterPos();
+    _magnifierEngine->setCursor(cursor, _maskEngine->getRadius());
+    _magnifierEngine->update();
+  }
 
   _infoEngine->update();
 
@@ -356,6 +374,10 @@ void RLIDisplayWidget::paintGL() {
 }
 
 void RLIDisplayWidget::fillRectWithTexture(const QRectF& rect, GLuint texId) {
+  fillRectWithTexture(rect, texId, QRectF(0.f, 0.f, 1.f, 1.f));
+}
+
+void RLIDisplayWidget::fillRectWithTexture(const QRectF& rect, GLuint texId, const QRectF& texRect) {
   glShadeModel( GL_FLAT );
 
   glActiveTexture(GL_TEXTURE0);
@@ -364,10 +386,10 @@ void RLIDisplayWidget::fillRectWithTexture(const QRectF& rect, GLuint texId) {
   // Draw The Quad
   glBegin(GL_QUADS);
   glColor3f(1.f, 1.f, 1.f);
-  glTexCoord2f(0.0f, 0.0f); glVertex3f(rect.left(), rect.bottom(), 0.0f);
-  glTexCoord2f(1.0f, 0.0f); glVertex3f(rect.right(), rect.bottom(), 0.0f);
-  glTexCoord2f(1.0f, 1.0f); glVertex3f(rect.right(), rect.top(), 0.0f);
-  glTexCoord2f(0.0f, 1.0f); glVertex3f(rect.left(), rect.top(), 0.0f);
+  glTexCoord2f(texRect.left(), texRect.top()); glVertex3f(rect.left(), rect.bottom(), 0.0f);
+  glTexCoord2f(texRect.right(), texRect.top()); glVertex3f(rect.right(), rect.bottom(), 0.0f);
+  glTexCoord2f(texRect.right(), texRect.bottom()); glVertex3f(rect.right(), rect.top(), 0.0f);
+  glTexCoord2f(texRect.left(), texRect.bottom()); glVertex3f(rect.left(), rect.top(), 0.0f);
   glEnd();
 
   glBindTexture(GL_TEXTURE_2D, 0);
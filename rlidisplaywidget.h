@@ -74,6 +74,7 @@ public slots:
 
   void onCoordsChanged(const QVector2D& new_coords);
   void onHeadingChanged(float hdg);
+  void onRadarStabilised(bool on);
   void onBandMenu(const QByteArray band);
   void onScaleChanged(RadarScale scale);
 
@@ -94,6 +95,7 @@ protected slots:
 
 private:
   void fillRectWithTexture(const QRectF& rect, GLuint texId);
+  void fillRectWithTexture(const QRectF& rect, GLuint texId, const QRectF& texRect);
   void fillWithTexture(GLuint texId);
 
   void moveCoursor(const QPoint &pos, bool repaint = true, RadarScale* curscale = NULL);
@@ -102,6 +104,7 @@ private:
 
   bool _route_edition;
   bool _is_magnifier_visible;
+  bool _radar_stabilised;   // Radar bearings come north-referenced, no picture shift
 
   int  _last_second;
   rli_scale_t _rli_scale;
@@ -0,0 +1,220 @@
+#include "chartcache.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <gdal_version.h>
+
+
+// Start of every cache file, the payload follows
+struct ChartCacheHeader {
+  uint32_t magic;
+  uint32_t header_size;    // Also tells a different layout apart
+  ChartCacheKey key;
+  uint64_t payload_size;
+  uint64_t payload_hash;
+};
+
+static uint64_t fnv1a(const uchar* p, size_t n, uint64_t h = 0xcbf29ce484222325ull) {
+  for (size_t i = 0; i < n; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+static bool hashFile(const QString& path, uint64_t* hash) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  if (file.size() == 0)
+    return true;
+
+  uchar* p = file.map(0, file.size());
+  if (p == NULL)
+    return false;
+
+  *hash = fnv1a(p, file.size(), *hash);
+  file.unmap(p);
+  return true;
+}
+
+QString chartUpdatePath(const QString& chart_path, int update) {
+  QFileInfo info(chart_path);
+  return info.dir().filePath(QString("%1.%2").arg(info.completeBaseName()).arg(update, 3, 10, QChar('0')));
+}
+
+bool chartCacheHash(const QString& path, uint64_t* hash) {
+  uint64_t h = fnv1a(NULL, 0);
+  if (!hashFile(path, &h))
+    return false;
+
+  // The S-57 reader applies .001, .002, ... up to the first one missing
+  if (QFileInfo(path).suffix() == "000") {
+    for (int i = 1; i < 1000; i++) {
+      QString update_path = chartUpdatePath(path, i);
+      if (!QFile::exists(update_path))
+        break;
+
+      QByteArray name = QFileInfo(update_path).fileName().toUtf8();
+      h = fnv1a(reinterpret_cast<const uchar*>(name.constData()), name.size(), h);
+      if (!hashFile(update_path, &h))
+        return false;
+    }
+  }
+
+  *hash = h;
+  return true;
+}
+
+bool chartCacheKey(const QString& chart_path, uint64_t refs_hash, ChartCacheKey* key) {
+  memset(key, 0, sizeof(ChartCacheKey));
+  key->version      = CC_VERSION;
+  key->gdal_version = GDAL_VERSION_NUM;
+  key->refs_hash    = refs_hash;
+  return chartCacheHash(chart_path, &key->chart_hash);
+}
+
+QString chartCachePath(const QString& chart_path) {
+  QFileInfo info(chart_path);
+  return info.dir().filePath(QString(CC_DIR) + "/" + info.fileName() + CC_SUFFIX);
+}
+
+
+ChartCacheWriter::ChartCacheWriter(const ChartCacheKey& key) {
+  ChartCacheHeader hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic       = CC_MAGIC;
+  hdr.header_size = sizeof(ChartCacheHeader);
+  hdr.key         = key;
+
+  putBytes(&hdr, sizeof(hdr));
+}
+
+void ChartCacheWriter::putBytes(const void* p, size_t n) {
+  const char* c = static_cast<const char*>(p);
+  _buf.insert(_buf.end(), c, c + n);
+}
+
+void ChartCacheWriter::putString(const QString& s) {
+  put<uint32_t>(s.size());
+  putBytes(s.utf16(), s.size() * sizeof(ushort));
+}
+
+void ChartCacheWriter::putStrings(const std::vector<QString>& v) {
+  put<uint32_t>(v.size());
+  for (size_t i = 0; i < v.size(); i++)
+    putString(v[i]);
+}
+
+bool ChartCacheWriter::save(const QString& path) {
+  ChartCacheHeader* hdr = reinterpret_cast<ChartCacheHeader*>(&_buf[0]);
+  hdr->payload_size = _buf.size() - sizeof(ChartCacheHeader);
+  hdr->payload_hash = fnv1a(reinterpret_cast<const uchar*>(&_buf[sizeof(ChartCacheHeader)]), hdr->payload_size);
+
+  QFileInfo info(path);
+  if (!QDir().mkpath(info.path()))
+    return false;
+
+  // Unique per writer, charts of the same file may be cached concurrently
+  QString tmp = path + QString(".%1.tmp").arg(reinterpret_cast<quintptr>(this));
+  QFile file(tmp);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  bool ok = file.write(&_buf[0], _buf.size()) == static_cast<qint64>(_buf.size());
+  file.close();
+
+  if (ok) {
+    QFile::remove(path);
+    ok = QFile::rename(tmp, path);
+  }
+  if (!ok)
+    QFile::remove(tmp);
+
+  return ok;
+}
+
+
+ChartCacheReader::ChartCacheReader() {
+  _map = NULL;
+  _pos = 0;
+  _end = 0;
+  _ok  = false;
+}
+
+ChartCacheReader::~ChartCacheReader() {
+  if (_map != NULL)
+    _file.unmap(const_cast<uchar*>(_map));
+}
+
+bool ChartCacheReader::open(const QString& path, const ChartCacheKey& key) {
+  _file.setFileName(path);
+  if (!_file.open(QIODevice::ReadOnly))
+    return false;
+
+  qint64 size = _file.size();
+  if (size < static_cast<qint64>(sizeof(ChartCacheHeader)))
+    return false;
+
+  _map = _file.map(0, size);
+  if (_map == NULL)
+    return false;
+
+  ChartCacheHeader hdr;
+  memcpy(&hdr, _map, sizeof(hdr));
+
+  if (hdr.magic != CC_MAGIC || hdr.header_size != sizeof(ChartCacheHeader)
+   || hdr.key.version != key.version || hdr.key.gdal_version != key.gdal_version
+   || hdr.key.chart_hash != key.chart_hash || hdr.key.refs_hash != key.refs_hash
+   || hdr.payload_size != static_cast<uint64_t>(size) - sizeof(ChartCacheHeader))
+    return false;
+
+  if (fnv1a(_map + sizeof(ChartCacheHeader), hdr.payload_size) != hdr.payload_hash)
+    return false;
+
+  _pos = sizeof(ChartCacheHeader);
+  _end = size;
+  _ok  = true;
+  return true;
+}
+
+void ChartCacheReader::getBytes(void* p, size_t n) {
+  if (!_ok || n > _end - _pos) {
+    _ok = false;
+    memset(p, 0, n);
+    return;
+  }
+
+  memcpy(p, _map + _pos, n);
+  _pos += n;
+}
+
+QString ChartCacheReader::getString() {
+  uint32_t n = get<uint32_t>();
+  if (!_ok || n > (_end - _pos) / sizeof(ushort)) {
+    _ok = false;
+    return QString();
+  }
+
+  QString s;
+  s.resize(n);
+  getBytes(s.data(), n * sizeof(ushort));
+  return s;
+}
+
+void ChartCacheReader::getStrings(std::vector<QString>& v) {
+  uint32_t n = get<uint32_t>();
+
+  // Every string takes at least its length
+  if (!_ok || n > (_end - _pos) / sizeof(uint32_t)) {
+    _ok = false;
+    v.clear();
+    return;
+  }
+
+  v.resize(n);
+  for (uint32_t i = 0; i < n; i++)
+    v[i] = getString();
+}
@@ -0,0 +1,106 @@
+#ifndef CHARTCACHE_H
+#define CHARTCACHE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+#define CC_MAGIC    0x43494C52u  // "RLIC"
+#define CC_VERSION  2            // Bump on any change of the format or of the chart processing
+#define CC_DIR      "cache"      // Cache folder inside the chart folder
+#define CC_SUFFIX   ".rlic"
+
+// What a cached chart was built from. A cache is only used when all of it
+// matches, anything else means a full ingest
+struct ChartCacheKey {
+  uint32_t version;        // CC_VERSION
+  uint32_t gdal_version;   // GDAL_VERSION_NUM of the reader
+  uint64_t chart_hash;     // Of the .000 file and its update files
+  uint64_t refs_hash;      // Of the S-52 references the colour indices come from
+};
+
+// FNV-1a of a file mapped into memory, false if unreadable. A .000 cell
+// is hashed on with the names and contents of its update files in order
+bool chartCacheHash(const QString& path, uint64_t* hash);
+
+// Update file of a cell: <cell>.001 for update 1 and so on
+QString chartUpdatePath(const QString& chart_path, int update);
+
+// Key of a chart file for references with the given hash
+bool chartCacheKey(const QString& chart_path, uint64_t refs_hash, ChartCacheKey* key);
+
+// Cache file of a chart file: <chart folder>/cache/<chart file name>.rlic
+QString chartCachePath(const QString& chart_path);
+
+
+// Cache file contents, written to a temporary file and renamed into place
+// so a reader never sees a partial cache
+class ChartCacheWriter {
+public:
+  explicit ChartCacheWriter(const ChartCacheKey& key);
+
+  template <typename T> void put(const T& v) { putBytes(&v, sizeof(T)); }
+  template <typename T> void putVector(const std::vector<T>& v) {
+    put<uint32_t>(v.size());
+    if (!v.empty())
+      putBytes(&v[0], v.size() * sizeof(T));
+  }
+  void putString(const QString& s);
+  void putStrings(const std::vector<QString>& v);
+
+  bool save(const QString& path);
+
+private:
+  void putBytes(const void* p, size_t n);
+
+  std::vector<char> _buf;
+};
+
+
+// Cache file mapped into memory. Everything is validated before use: the
+// header, the key, the size and the checksum of the payload. Reads past the
+// end leave the reader failed with zeroed values
+class ChartCacheReader {
+public:
+  ChartCacheReader();
+  ~ChartCacheReader();
+
+  bool open(const QString& path, const ChartCacheKey& key);
+  inline bool ok() const { return _ok; }
+
+  template <typename T> T get() {
+    T v;
+    getBytes(&v, sizeof(T));
+    return v;
+  }
+  template <typename T> void getVector(std::vector<T>& v) {
+    uint32_t n = get<uint32_t>();
+    if (!_ok || n > (_end - _pos) / sizeof(T)) {
+      _ok = false;
+      v.clear();
+      return;
+    }
+    v.resize(n);
+    if (n > 0)
+      getBytes(&v[0], n * sizeof(T));
+  }
+  QString getString();
+  void getStrings(std::vector<QString>& v);
+
+  // Payload fully consumed without errors
+  inline bool finished() const { return _ok && _pos == _end; }
+
+private:
+  void getBytes(void* p, size_t n);
+
+  QFile _file;
+  const uchar* _map;
+  size_t _pos;
+  size_t _end;
+  bool _ok;
+};
+
+#endif // CHARTCACHE_H
@@ -3,46 +3,115 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QRunnable>
+#include <QThread>
 
 #include <QtConcurrentRun>
+#include <ogrsf_frmts.h>
+
+#include "chartcache.h"
+
+
+class ChartLoadTask : public QRunnable {
+public:
+  ChartLoadTask(ChartManager* mngr, const QString& name, const QString& path) : _mngr(mngr), _name(name), _path(path) { }
+  void run() { _mngr->loadChart(_name, _path); }
+
+private:
+  ChartManager* _mngr;
+  QString _name;
+  QString _path;
+};
+
 
 ChartManager::ChartManager(QObject *parent) : QObject(parent) {
-  _s52_refs = new S52References("res//s52data//chartsymbols.xml");
+  _s52_refs = new S52References(CM_REFS_FILE);
   _s52_refs->setColorScheme("DAY_BRIGHT");
+
+  _refs_hash = 0;
+  chartCacheHash(CM_REFS_FILE, &_refs_hash);
+  _use_cache = true;
+
+  _stop = false;
+  _loaded = 0;
+  _first_ms = -1;
 }
 
 ChartManager::~ChartManager() {
+  // Charts being read are finished, the queued ones skipped
+  _stop = true;
+  _loading.waitForFinished();
+
   qDeleteAll(_charts);
 }
 
 void ChartManager::loadCharts() {
   qDebug() << "Max number of threads: " << QThreadPool::globalInstance()->maxThreadCount();
-  QtConcurrent::run(this, &ChartManager::chartLoadingWorker);
+  _loading = QtConcurrent::run(this, &ChartManager::chartLoadingWorker);
 }
 
 void ChartManager::chartLoadingWorker() {
-  qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Charts loading started";
-
   QDir dir("res/charts");
   dir.setNameFilters(QStringList("*.000"));
   dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
 
   QStringList fileList = dir.entryList();
-  for (int i = 0; i < fileList.count(); i++) {
-    qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Loading: " << fileList[i];
+  QStringList paths;
+  for (int i = 0; i < fileList.count(); i++)
+    paths << dir.path() + "/" + fileList[i];
+
+  loadFiles(fileList, paths, qMin(CM_MAX_LOADERS, QThread::idealThreadCount()));
+}
 
-    QString chart_path(dir.path() + "/" + fileList[i]);
-    char* c_chart_path = new char[chart_path.size() + 1];
-    for (int j = 0; j < chart_path.size(); j++)
-      c_chart_path[j] = chart_path[j].toLatin1();
-    c_chart_path[chart_path.size()] = '\0';
+void ChartManager::loadFiles(const QStringList& names, const QStringList& paths, int loaders) {
+  qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Charts loading started, " << qMax(1, loaders) << " loaders";
 
-    _charts.insert(fileList[i], new S52Chart(c_chart_path, _s52_refs));
-    delete[] c_chart_path;
+  // The driver is registered here once rather than by the charts concurrently
+  RegisterOGRS57();
+
+  _load_clock.start();
+  _loaded = 0;
+  _first_ms = -1;
+
+  // Every chart reads its own dataset, OGR datasets are not shared between threads
+  _loaders.setMaxThreadCount(qMax(1, loaders));
+  for (int i = 0; i < names.count(); i++)
+    _loaders.start(new ChartLoadTask(this, names[i], paths[i]));
+  _loaders.waitForDone();
+
+  qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Charts loading finished: " << _loaded
+           << " charts in " << _load_clock.elapsed() << " ms, first after " << _first_ms << " ms";
+}
+
+void ChartManager::loadChart(const QString& name, const QString& path) {
+  if (_stop)
+    return;
+
+  qDebug() << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": " << "Loading: " << name;
+
+  // An unchanged chart is read from its cache, any other is ingested and cached
+  ChartCacheKey key;
+  QString cache_path = chartCachePath(path);
+  bool keyed = _use_cache && chartCacheKey(path, _refs_hash, &key);
+
+  S52Chart* chart = keyed ? S52Chart::fromCache(cache_path, key, _s52_refs) : NULL;
+  if (chart == NULL) {
+    QByteArray c_chart_path = path.toLatin1();
+    chart = new S52Chart(c_chart_path.data(), _s52_refs);
+
+    if (keyed && !chart->saveCache(cache_path, key))
+      qDebug() << "Chart cache not written: " << cache_path;
+  } else {
+    qDebug() << "From cache: " << name;
+  }
 
-    qDebug()  << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": "<< "Loaded: " << fileList[i];
-    emit new_chart_available(fileList[i]);
+  {
+    QMutexLocker locker(&_chartsMutex);
+    _charts.insert(name, chart);
+    if (_loaded++ == 0)
+      _first_ms = _load_clock.elapsed();
   }
 
-  qDebug()  << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": "<< "Charts loading finished";
+  qDebug()  << QDateTime::currentDateTime().toString("hh:mm:ss zzz") << ": "<< "Loaded: " << name;
+  emit new_chart_available(name);
 }
@@ -2,10 +2,20 @@
 #define CHARTMANAGER_H
 
 #include <QMap>
+#include <QMutex>
+#include <QFuture>
+#include <QStringList>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+#include <atomic>
 
 #include "s52chart.h"
 #include "s52references.h"
 
+#define CM_MAX_LOADERS  4    // Charts read at once, each holds its whole dataset while reading
+#define CM_REFS_FILE    "res//s52data//chartsymbols.xml"
+
 class ChartManager : public QObject
 {
   Q_OBJECT
@@ -16,18 +26,44 @@ public:
   void loadCharts();
 
   inline S52References* refs() {return _s52_refs; }
-  inline int chartCount() { return _charts.size(); }
-  inline QList<QString> chartNames() { return _charts.keys(); }
-  inline S52Chart* getChart(const QString& name) { if (!_charts.contains(name)) return NULL; return _charts[name]; }
+  inline int chartCount() { QMutexLocker locker(&_chartsMutex); return _charts.size(); }
+  inline QList<QString> chartNames() { QMutexLocker locker(&_chartsMutex); return _charts.keys(); }
+  inline S52Chart* getChart(const QString& name) { QMutexLocker locker(&_chartsMutex); return _charts.value(name, NULL); }
+
+  // Off to time a full ingest, charts are then neither read from nor written to the cache
+  inline void setUseCache(bool use_cache) { _use_cache = use_cache; }
+
+  // Reads up to loaders files at once, returns when all are loaded
+  void loadFiles(const QStringList& names, const QStringList& paths, int loaders);
+
+  // Progress of the current or last loading
+  inline int loadedCount() { QMutexLocker locker(&_chartsMutex); return _loaded; }
+  inline qint64 firstChartMs() { QMutexLocker locker(&_chartsMutex); return _first_ms; }
+  inline qint64 loadingMs() const { return _load_clock.elapsed(); }
 
 signals:
+  // Emitted from a loader thread as soon as the chart is ready
   void new_chart_available(const QString& name);
 
 private:
+  friend class ChartLoadTask;
+
   void chartLoadingWorker();
+  void loadChart(const QString& name, const QString& path);
 
+  QMutex _chartsMutex;
   QMap<QString, S52Chart*> _charts;
   S52References* _s52_refs;
+  uint64_t _refs_hash;        // Part of the chart cache key
+  bool _use_cache;
+
+  QThreadPool _loaders;
+  QFuture<void> _loading;
+  std::atomic<bool> _stop;    // Queued charts are skipped
+
+  QElapsedTimer _load_clock;
+  int _loaded;
+  qint64 _first_ms;
 };
 
 #endif // CHARTMANAGER_H
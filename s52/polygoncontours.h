@@ -0,0 +1,17 @@
+#ifndef POLYGONCONTOURS_H
+#define POLYGONCONTOURS_H
+
+#include <vector>
+
+class OGRPolygon;
+
+// Vertex in chart coordinates, laid out as the double[2] the triangulator takes
+struct ContourPoint {
+  double x, y;
+};
+
+// Contours of a polygon as the triangulator takes them: exterior ring ccw,
+// interior rings cw, no repeated points, vertex 0 unused
+bool polygonContours(OGRPolygon* poGeom, std::vector<int>& cntr, std::vector<ContourPoint>& geoPt);
+
+#endif // POLYGONCONTOURS_H
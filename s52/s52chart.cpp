@@ -3,7 +3,13 @@
 #include <QDebug>
 #include <ogrsf_frmts.h>
 
-#include "../common/triangulate.h"
+#include <stdint.h>
+#include <time.h>
+
+#include "chartcache.h"
+#include "polygoncontours.h"
+#include "../common/earclip.h"
+#include "../common/simplify.h"
 #include "../common/rlimath.h"
 
 using namespace RLIMath;
@@ -15,6 +21,9 @@ S52Chart::S52Chart(char* file_name, S52References* ref) {
   isOk = false;
   _ref = ref;
   sndg_layer = NULL;
+  _tri = new EarClipper();
+  _simp = new Simplifier();
+  _lod_ns = 0;
   //qDebug() << file_name;
 
   // Open OGR data source
@@ -26,6 +35,12 @@ S52Chart::S52Chart(char* file_name, S52References* ref) {
     return;
   }
 
+  // Everything is copied out of the dataset, it is closed on any return
+  struct DataSourceCloser {
+    OGRDataSource* ds;
+    ~DataSourceCloser() { OGRDataSource::DestroyDataSource(ds); }
+  } closer = { poDS };
+
   // iterate through
   for( int iLayer = 0; iLayer < poDS->GetLayerCount(); iLayer++ ) {
     OGRLayer* poLayer = poDS->GetLayer(iLayer);
@@ -70,8 +85,22 @@ S52Chart::S52Chart(char* file_name, S52References* ref) {
 }
 
 
+S52Chart::S52Chart(S52References* ref) {
+  isOk = false;
+  _ref = ref;
+  sndg_layer = NULL;
+  _tri = NULL;
+  _simp = NULL;
+  _lod_ns = 0;
+
+  min_lat = max_lat = 0;
+  min_lon = max_lon = 0;
+}
+
 S52Chart::~S52Chart() {
   clear();
+  delete _tri;
+  delete _simp;
 }
 
 bool S52Chart::readTextLayer(OGRLayer* poLayer) {
@@ -183,6 +212,219 @@ float S52Chart::getMaxLon() {
 }
 
 
+// Layer lookups by unknown names leave NULL entries in the maps
+template <typename T> static uint32_t layerCount(const QMap<QString, T*>& layers) {
+  uint32_t n = 0;
+  for (typename QMap<QString, T*>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+    if (it.value() != NULL)
+      n++;
+  return n;
+}
+
+bool S52Chart::saveCache(const QString& cache_path, const ChartCacheKey& key) const {
+  if (!isOk)
+    return false;
+
+  ChartCacheWriter w(key);
+
+  w.put(min_lat);
+  w.put(max_lat);
+  w.put(min_lon);
+  w.put(max_lon);
+
+  w.put(layerCount(area_layers));
+  for (QMap<QString, S52AreaLayer*>::const_iterator it = area_layers.begin(); it != area_layers.end(); ++it) {
+    const S52AreaLayer* l = it.value();
+    if (l == NULL)
+      continue;
+
+    w.putString(it.key());
+    w.put<uint8_t>(l->is_pattern_uniform);
+    w.put<uint8_t>(l->is_color_uniform);
+    w.putString(l->pattern_ref);
+    w.put<int32_t>(l->color_ind);
+    w.putStrings(l->pattern_refs);
+    w.putVector(l->color_inds);
+    w.putVector(l->start_inds);
+    w.putVector(l->triangles);
+
+    w.put<uint32_t>(l->lods.size());
+    for (size_t k = 0; k < l->lods.size(); k++) {
+      w.put(l->lods[k].min_scale);
+      w.putVector(l->lods[k].start_inds);
+      w.putVector(l->lods[k].triangles);
+    }
+  }
+
+  w.put(layerCount(line_layers));
+  for (QMap<QString, S52LineLayer*>::const_iterator it = line_layers.begin(); it != line_layers.end(); ++it) {
+    const S52LineLayer* l = it.value();
+    if (l == NULL)
+      continue;
+
+    w.putString(it.key());
+    w.put<uint8_t>(l->is_pattern_uniform);
+    w.put<uint8_t>(l->is_color_uniform);
+    w.putString(l->pattern_ref);
+    w.put<int32_t>(l->color_ind);
+    w.putStrings(l->pattern_refs);
+    w.putVector(l->color_inds);
+    w.putVector(l->start_inds);
+    w.putVector(l->points);
+    w.putVector(l->distances);
+
+    w.put<uint32_t>(l->lods.size());
+    for (size_t k = 0; k < l->lods.size(); k++) {
+      w.put(l->lods[k].min_scale);
+      w.putVector(l->lods[k].start_inds);
+      w.putVector(l->lods[k].points);
+      w.putVector(l->lods[k].distances);
+    }
+  }
+
+  w.put(layerCount(mark_layers));
+  for (QMap<QString, S52MarkLayer*>::const_iterator it = mark_layers.begin(); it != mark_layers.end(); ++it) {
+    const S52MarkLayer* l = it.value();
+    if (l == NULL)
+      continue;
+
+    w.putString(it.key());
+    w.put<uint8_t>(l->is_symbol_uniform);
+    w.putString(l->symbol_ref);
+    w.putStrings(l->symbol_refs);
+    w.putVector(l->points);
+  }
+
+  w.put(layerCount(text_layers));
+  for (QMap<QString, S52TextLayer*>::const_iterator it = text_layers.begin(); it != text_layers.end(); ++it) {
+    const S52TextLayer* l = it.value();
+    if (l == NULL)
+      continue;
+
+    w.putString(it.key());
+    w.putStrings(l->texts);
+    w.putVector(l->points);
+  }
+
+  w.put<uint8_t>(sndg_layer != NULL);
+  if (sndg_layer != NULL) {
+    w.putVector(sndg_layer->depths);
+    w.putVector(sndg_layer->points);
+  }
+
+  return w.save(cache_path);
+}
+
+S52Chart* S52Chart::fromCache(const QString& cache_path, const ChartCacheKey& key, S52References* ref) {
+  ChartCacheReader r;
+  if (!r.open(cache_path, key))
+    return NULL;
+
+  S52Chart* chart = new S52Chart(ref);
+
+  chart->min_lat = r.get<float>();
+  chart->max_lat = r.get<float>();
+  chart->min_lon = r.get<float>();
+  chart->max_lon = r.get<float>();
+
+  uint32_t n = r.get<uint32_t>();
+  for (uint32_t i = 0; i < n && r.ok(); i++) {
+    QString name = r.getString();
+    S52AreaLayer* l = new S52AreaLayer();
+    chart->area_layers.insert(name, l);
+
+    l->is_pattern_uniform = r.get<uint8_t>() != 0;
+    l->is_color_uniform   = r.get<uint8_t>() != 0;
+    l->pattern_ref        = r.getString();
+    l->color_ind          = r.get<int32_t>();
+    r.getStrings(l->pattern_refs);
+    r.getVector(l->color_inds);
+    r.getVector(l->start_inds);
+    r.getVector(l->triangles);
+
+    uint32_t levels = r.get<uint32_t>();
+    if (levels > CHART_LOD_LEVELS) {
+      delete chart;
+      return NULL;
+    }
+
+    l->lods.resize(levels);
+    for (uint32_t k = 0; k < levels; k++) {
+      l->lods[k].min_scale = r.get<float>();
+      r.getVector(l->lods[k].start_inds);
+      r.getVector(l->lods[k].triangles);
+    }
+  }
+
+  n = r.get<uint32_t>();
+  for (uint32_t i = 0; i < n && r.ok(); i++) {
+    QString name = r.getString();
+    S52LineLayer* l = new S52LineLayer();
+    chart->line_layers.insert(name, l);
+
+    l->is_pattern_uniform = r.get<uint8_t>() != 0;
+    l->is_color_uniform   = r.get<uint8_t>() != 0;
+    l->pattern_ref        = r.getString();
+    l->color_ind          = r.get<int32_t>();
+    r.getStrings(l->pattern_refs);
+    r.getVector(l->color_inds);
+    r.getVector(l->start_inds);
+    r.getVector(l->points);
+    r.getVector(l->distances);
+
+    uint32_t levels = r.get<uint32_t>();
+    if (levels > CHART_LOD_LEVELS) {
+      delete chart;
+      return NULL;
+    }
+
+    l->lods.resize(levels);
+    for (uint32_t k = 0; k < levels; k++) {
+      l->lods[k].min_scale = r.get<float>();
+      r.getVector(l->lods[k].start_inds);
+      r.getVector(l->lods[k].points);
+      r.getVector(l->lods[k].distances);
+    }
+  }
+
+  n = r.get<uint32_t>();
+  for (uint32_t i = 0; i < n && r.ok(); i++) {
+    QString name = r.getString();
+    S52MarkLayer* l = new S52MarkLayer();
+    chart->mark_layers.insert(name, l);
+
+    l->is_symbol_uniform = r.get<uint8_t>() != 0;
+    l->symbol_ref        = r.getString();
+    r.getStrings(l->symbol_refs);
+    r.getVector(l->points);
+  }
+
+  n = r.get<uint32_t>();
+  for (uint32_t i = 0; i < n && r.ok(); i++) {
+    QString name = r.getString();
+    S52TextLayer* l = new S52TextLayer();
+    chart->text_layers.insert(name, l);
+
+    r.getStrings(l->texts);
+    r.getVector(l->points);
+  }
+
+  if (r.get<uint8_t>() != 0) {
+    chart->sndg_layer = new S52SndgLayer();
+    r.getVector(chart->sndg_layer->depths);
+    r.getVector(chart->sndg_layer->points);
+  }
+
+  if (!r.finished()) {
+    delete chart;
+    return NULL;
+  }
+
+  chart->isOk = true;
+  return chart;
+}
+
+
 void S52Chart::clear() {
   for (int i = 0; i < area_layers.keys().size(); i++)
     delete area_layers[area_layers.keys()[i]];
@@ -193,9 +435,42 @@ void S52Chart::clear() {
   for (int i = 0; i < mark_layers.keys().size(); i++)
     delete mark_layers[mark_layers.keys()[i]];
 
+  for (int i = 0; i < text_layers.keys().size(); i++)
+    delete text_layers[text_layers.keys()[i]];
+
   delete sndg_layer;
 }
 
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// m/px level k of detail is drawn from
+static float lodScale(int k) {
+  return CHART_LOD_SCALE * (1 << (2 * k));
+}
+
+// Simplification tolerance of level k in degrees of latitude
+static double lodTolerance(int k) {
+  return degrees(CHART_LOD_TOLERANCE * lodScale(k) / EARTH_RADIUS);
+}
+
+// Levels saving too little over the finer geometry are dropped
+template <typename Lod> static void pruneLods(std::vector<Lod>& lods, std::vector<float> Lod::*data, size_t full) {
+  size_t finer = full;
+  for (size_t k = 0; k < lods.size(); ) {
+    size_t size = (lods[k].*data).size();
+    if (size > CHART_LOD_MIN_GAIN * finer) {
+      lods.erase(lods.begin() + k);
+      continue;
+    }
+    finer = size;
+    k++;
+  }
+}
+
 bool S52Chart::readLayer(OGRLayer* poLayer) {
   QString layer_name = QString(poLayer->GetName());
   //qDebug() << layer_name;
@@ -215,6 +490,10 @@ bool S52Chart::readLayer(OGRLayer* poLayer) {
     area_layer->is_pattern_uniform = isAreaPatternUniform(layer_name);
     area_layer->pattern_ref = "-";
     area_layer->color_ind = -1;
+
+    area_layer->lods.resize(CHART_LOD_LEVELS);
+    for (int k = 0; k < CHART_LOD_LEVELS; k++)
+      area_layer->lods[k].min_scale = lodScale(k);
   }
 
   if (line_layers.contains(layer_name))
@@ -246,13 +525,12 @@ bool S52Chart::readLayer(OGRLayer* poLayer) {
         fillLineParams(layer_name, line_layer, poFeature);
         line_layer->start_inds.push_back(line_layer->points.size());
 
-        if (!readOGRPolygon((OGRPolygon*) geom, line_layer->points, line_layer->distances, true))
+        if (!readOGRContour((OGRPolygon*) geom, line_layer->points, line_layer->distances))
           return false;
 
         fillAreaParams(layer_name, area_layer, poFeature);
-        area_layer->start_inds.push_back(area_layer->triangles.size());
 
-        if (!readOGRPolygon((OGRPolygon*) geom, area_layer->triangles, area_layer->triangles, false))
+        if (!readOGRArea((OGRPolygon*) geom, area_layer))
           return false;
       }
 
@@ -275,11 +553,15 @@ bool S52Chart::readLayer(OGRLayer* poLayer) {
     OGRFeature::DestroyFeature( poFeature );
   }
 
-  if (area_layer->triangles.size() > 0)
+  if (area_layer->triangles.size() > 0) {
+    pruneLods(area_layer->lods, &S52AreaLod::triangles, area_layer->triangles.size());
     area_layers[layer_name] = area_layer;
+  }
 
-  if (line_layer->points.size() > 0)
+  if (line_layer->points.size() > 0) {
+    buildLineLods(line_layer);
     line_layers[layer_name] = line_layer;
+  }
 
   if (mark_layer->points.size() > 0)
     mark_layers[layer_name] = mark_layer;
@@ -318,13 +600,7 @@ void S52Chart::fillMarkParams(QString& layer_name, S52MarkLayer* layer, OGRFeatu
     layer->symbol_refs.push_back(getMarkSymbolRef(layer_name, poFeature));
 }
 
-// !!!!
-// TODO: add hole support
-bool S52Chart::readOGRPolygon(OGRPolygon* poGeom, std::vector<float> &points, std::vector<float> &distances, bool contour) {
-  if (contour) {
-    return readOGRLine((OGRLineString*)poGeom->getExteriorRing(), points, distances);
-  }
-
+bool polygonContours(OGRPolygon* poGeom, std::vector<int>& cntr, std::vector<ContourPoint>& geoPt) {
   // Make a quick sanity check of the polygon coherence
   // ----------------------------------------------------------------
   bool b_ok = true;
@@ -365,8 +641,7 @@ bool S52Chart::readOGRPolygon(OGRPolygon* poGeom, std::vector<float> &points, st
   int nint = poGeom->getNumInteriorRings();   // interior rings
   m_ncnt += nint;
 
-  // Allocate cntr array
-  int *cntr = (int *)malloc(m_ncnt * sizeof(int));
+  cntr.assign(m_ncnt, 0);
 
   // Get total number of points(vertices)
   int npta  = poGeom->getExteriorRing()->getNumPoints();
@@ -377,7 +652,7 @@ bool S52Chart::readOGRPolygon(OGRPolygon* poGeom, std::vector<float> &points, st
     npta += nptr + 2;
   }
 
-  point_t *geoPt = (point_t*)calloc((npta + 1) * sizeof(point_t), 1);     // vertex array
+  geoPt.assign(npta + 1, ContourPoint());     // vertex array
 
   // Create input structures
 
@@ -385,7 +660,7 @@ bool S52Chart::readOGRPolygon(OGRPolygon* poGeom, std::vector<float> &points, st
   int npte  = poGeom->getExteriorRing()->getNumPoints();
   cntr[0] = npte;
 
-  point_t *ppt = geoPt;
+  ContourPoint *ppt = &geoPt[0];
   ppt->x = 0.; ppt->y = 0.;
   ppt++;                            // vertex 0 is unused
 
@@ -471,31 +746,151 @@ bool S52Chart::readOGRPolygon(OGRPolygon* poGeom, std::vector<float> &points, st
     }
   }
 
-  polyout* polys = triangulate_polygon(m_ncnt, cntr, (double (*)[2])geoPt);
-  polyout* pck = polys;
+  return true;
+}
+
+bool S52Chart::readOGRContour(OGRPolygon* poGeom, std::vector<float> &points, std::vector<float> &distances) {
+  return readOGRLine((OGRLineString*)poGeom->getExteriorRing(), points, distances);
+}
+
+// Triangles of the contours appended as (lat, lon), unusable rings leave none
+static void appendTriangles(EarClipper* tri, const std::vector<int>& cntr, const std::vector<ContourPoint>& geoPt
+                          , std::vector<float>& triangles) {
+  std::vector<int> tris;
+  tri->triangulate(cntr.size(), &cntr[0], (const double (*)[2])&geoPt[0], tris);
+
+  for (size_t i = 0; i < tris.size(); i++) {
+    triangles.push_back(geoPt[tris[i]].y);
+    triangles.push_back(geoPt[tris[i]].x);
+  }
+}
+
+bool S52Chart::readOGRArea(OGRPolygon* poGeom, S52AreaLayer* layer) {
+  std::vector<int> cntr;
+  std::vector<ContourPoint> geoPt;
+  if (!polygonContours(poGeom, cntr, geoPt))
+    return false;
+
+  layer->start_inds.push_back(layer->triangles.size());
+  appendTriangles(_tri, cntr, geoPt, layer->triangles);
 
-  while(pck != NULL) {
-    if(pck->is_valid) {
-      int *ivs = pck->vertex_index_list;
+  uint64_t t0 = nowNs();
 
-      if (pck->nvert != 3)
-        continue;
+  // Each level is simplified from the one before, in degrees of latitude
+  // against longitude shortened to the same length
+  double lon_scale = cos(radians(geoPt[1].y));
+  std::vector<double> xy;
+  std::vector<char> keep;
+  std::vector<int> lod_cntr;
+  std::vector<ContourPoint> lod_pt;
+
+  for (size_t k = 0; k < layer->lods.size(); k++) {
+    S52AreaLod& lod = layer->lods[k];
+    lod.start_inds.push_back(lod.triangles.size());
+    if (cntr.empty())
+      continue;
+
+    int total = 0;
+    for (size_t c = 0; c < cntr.size(); c++)
+      total += cntr[c];
+
+    xy.resize(2 * total);
+    for (int i = 0; i < total; i++) {
+      xy[2*i+0] = geoPt[i+1].x * lon_scale;
+      xy[2*i+1] = geoPt[i+1].y;
+    }
 
-      for(int i = 0 ; i < 3 ; i++) {
-        int ivp = ivs[i];
-        points.push_back(geoPt[ivp].y);
-        points.push_back(geoPt[ivp].x);
+    _simp->simplify(cntr.size(), &cntr[0], (const double (*)[2])&xy[0], true, lodTolerance(k), keep);
+
+    // Dropped holes are filled, a dropped exterior ring drops the polygon
+    lod_cntr.clear();
+    lod_pt.assign(1, ContourPoint());
+    for (size_t c = 0, first = 0; c < cntr.size(); first += cntr[c], c++) {
+      int kept = 0;
+      for (int i = 0; i < cntr[c]; i++) {
+        if (keep[first + i]) {
+          lod_pt.push_back(geoPt[first + i + 1]);
+          kept++;
+        }
       }
+
+      if (kept > 0)
+        lod_cntr.push_back(kept);
+      else if (c == 0)
+        break;
     }
 
-    pck = (polyout *)pck->poly_next;
+    if (lod_cntr.empty()) {
+      cntr.clear();
+      continue;
+    }
+
+    cntr.swap(lod_cntr);
+    geoPt.swap(lod_pt);
+    appendTriangles(_tri, cntr, geoPt, lod.triangles);
   }
 
-  if (polys != NULL)
-    delete polys;
+  _lod_ns += nowNs() - t0;
   return true;
 }
 
+void S52Chart::buildLineLods(S52LineLayer* layer) {
+  uint64_t t0 = nowNs();
+
+  // Features as chains of points, each level simplified from the one before
+  std::vector<int> len;
+  std::vector<float> points = layer->points;
+  for (size_t i = 0; i < layer->start_inds.size(); i++) {
+    size_t end = (i + 1 < layer->start_inds.size()) ? layer->start_inds[i+1] : points.size();
+    len.push_back((end - layer->start_inds[i]) / 2);
+  }
+
+  double lon_scale = cos(radians(points[0]));
+  std::vector<double> xy;
+  std::vector<char> keep;
+
+  layer->lods.resize(CHART_LOD_LEVELS);
+  for (int k = 0; k < CHART_LOD_LEVELS; k++) {
+    S52LineLod& lod = layer->lods[k];
+    lod.min_scale = lodScale(k);
+
+    xy.resize(points.size());
+    for (size_t i = 0; i < points.size(); i += 2) {
+      xy[i+0] = points[i+1] * lon_scale;
+      xy[i+1] = points[i+0];
+    }
+
+    _simp->simplify(len.size(), &len[0], (const double (*)[2])&xy[0], false, lodTolerance(k), keep);
+
+    // Distances are those of the segments ending at each point, as read
+    size_t first = 0;
+    for (size_t c = 0; c < len.size(); first += len[c], c++) {
+      lod.start_inds.push_back(lod.points.size());
+
+      int kept = 0;
+      for (int i = 0; i < len[c]; i++) {
+        if (!keep[first + i])
+          continue;
+
+        lod.points.push_back(points[2*(first + i) + 0]);
+        lod.points.push_back(points[2*(first + i) + 1]);
+        if (kept++ == 0)
+          lod.distances.push_back(0);
+        else
+          lod.distances.push_back(geo_distance(lod.points[lod.points.size() - 4], lod.points[lod.points.size() - 3]
+                                              ,lod.points[lod.points.size() - 2], lod.points[lod.points.size() - 1]));
+      }
+
+      len[c] = kept;
+    }
+
+    points = lod.points;
+  }
+
+  pruneLods(layer->lods, &S52LineLod::points, layer->points.size());
+  _lod_ns += nowNs() - t0;
+}
+
 bool S52Chart::readOGRLine(OGRLineString* poGeom, std::vector<float> &points, std::vector<float> &distances) {
   int point_count = poGeom->getNumPoints();
 
@@ -671,4 +1066,3 @@ bool S52Chart::isMarkSymbolUniform(QString& /*layer_name*/) {
   //Default
   return true;
 }
-
@@ -5,9 +5,18 @@
 #include <QRectF>
 #include <QString>
 
+#include <stdint.h>
 #include <vector>
 #include "s52references.h"
 
+#define CHART_LOD_LEVELS     4      // Simplified copies of the area and line layers
+#define CHART_LOD_SCALE      8.f    // m/px the first copy is drawn from, each next one from 4 times more
+#define CHART_LOD_TOLERANCE  0.5f   // Simplification error in pixels at the scale a copy is drawn from
+#define CHART_LOD_MIN_GAIN   0.8f   // A copy with more of the vertices of the finer geometry is dropped
+
+struct ChartCacheKey;
+class EarClipper;
+class Simplifier;
 class OGRLayer;
 class OGRPoint;
 class OGRFeature;
@@ -15,6 +24,22 @@ class OGRPolygon;
 class OGRLineString;
 
 
+// Area geometry simplified for views from min_scale m/px on, the features
+// are those of the layer, features too small to show have no triangles
+struct S52AreaLod {
+  float min_scale;
+  std::vector<int>    start_inds;
+  std::vector<float>  triangles;
+};
+
+// Line geometry simplified for views from min_scale m/px on
+struct S52LineLod {
+  float min_scale;
+  std::vector<int>    start_inds;
+  std::vector<float>  points;
+  std::vector<float>  distances;
+};
+
 struct S52AreaLayer {
   bool is_pattern_uniform;
   bool is_color_uniform;
@@ -31,6 +56,8 @@ struct S52AreaLayer {
   std::vector<int>    start_inds;
   // sequence of coords representing triangulated polygon
   std::vector<float>  triangles;
+  // coarser levels of detail, finest first
+  std::vector<S52AreaLod> lods;
 };
 
 struct S52LineLayer {
@@ -51,6 +78,8 @@ struct S52LineLayer {
   std::vector<float>  points;
   // length of the line up to current point
   std::vector<float>  distances;
+  // coarser levels of detail, finest first
+  std::vector<S52LineLod> lods;
 };
 
 struct S52MarkLayer {
@@ -83,6 +112,11 @@ public:
   S52Chart(char* file_name, S52References* ref);
   ~S52Chart();
 
+  // Chart read back from a cache file, NULL if the cache is missing, stale or damaged
+  static S52Chart* fromCache(const QString& cache_path, const ChartCacheKey& key, S52References* ref);
+  // Writes the chart for fromCache(), only charts read without errors are cached
+  bool saveCache(const QString& cache_path, const ChartCacheKey& key) const;
+
   QList<QString> getAreaLayerNames();
   QList<QString> getLineLayerNames();
   QList<QString> getMarkLayerNames();
@@ -99,9 +133,17 @@ public:
   float getMinLon();
   float getMaxLon();
 
+  // Spent on the levels of detail while reading
+  inline uint64_t lodNs() const { return _lod_ns; }
+
 private:
+  explicit S52Chart(S52References* ref);   // Empty chart filled from a cache
+
   bool isOk;
   S52References* _ref;
+  EarClipper* _tri;   // Triangulation scratch reused over the chart polygons
+  Simplifier* _simp;  // Level of detail scratch
+  uint64_t _lod_ns;   // Spent on the levels of detail while reading
   void clear();
 
   // Chart dimension
@@ -120,8 +162,12 @@ private:
   bool readSoundingLayer(OGRLayer* poLayer);
   bool readTextLayer(OGRLayer* poLayer);
 
-  // Reading and tesselating OGRPolygon, append result to triangles
-  bool readOGRPolygon(OGRPolygon* poGeom, std::vector<float> &points, std::vector<float> &distances, bool contour);
+  // Reading the outline of OGRPolygon, append result to points
+  bool readOGRContour(OGRPolygon* poGeom, std::vector<float> &points, std::vector<float> &distances);
+  // Reading and tesselating OGRPolygon with its levels of detail, append a feature to the layer
+  bool readOGRArea(OGRPolygon* poGeom, S52AreaLayer* layer);
+  // Levels of detail of the whole layer, simplified together so lines do not cross
+  void buildLineLods(S52LineLayer* layer);
   // Reading OGRLine, append result to points
   bool readOGRLine(OGRLineString* poGeom, std::vector<float> &points, std::vector<float> &distances);
 
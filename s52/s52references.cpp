@@ -41,11 +41,9 @@ S52References::S52References(QString file_name) {
   fillColorTables2();
 }
 
+// Read-only, charts loading concurrently share the references
 int S52References::getColorIndex(const QString& color_ref) {
-  if (color_indices.contains(color_ref))
-    return color_indices[color_ref];
-
-  return -1;
+  return color_indices.value(color_ref, -1);
 }
 
 std::vector<float> S52References::getColorTable() {